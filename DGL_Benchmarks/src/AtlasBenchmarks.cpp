@@ -0,0 +1,121 @@
+//-------------------------------------------------------------------------------------------------
+// file:    AtlasBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for how quickly and how tightly textures are packed into atlas pages
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <algorithm>
+#include <d3d11.h>
+#include <stdio.h>
+#include <vector>
+
+import Atlas;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of textures packed
+const unsigned texture_count{ 10000 };
+// The size of each page
+const int page_size{ 2048 };
+
+struct TextureSize
+{
+    int mWidth;
+    int mHeight;
+};
+
+//*************************************************************************************************
+// Returns a repeatable value from 0 up to but not including the limit
+int NextRandom(unsigned& seed, int limit)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (int)((seed >> 8) % (unsigned)limit);
+}
+
+//*************************************************************************************************
+// Returns sprite-sized textures from 8 to 128 pixels on a side, mostly smaller ones
+std::vector<TextureSize> MakeTextures()
+{
+    std::vector<TextureSize> textures(texture_count);
+    unsigned seed = 12345;
+    for (TextureSize& texture : textures)
+    {
+        int limit = NextRandom(seed, 4) ? 40 : 120;
+        texture.mWidth = 8 + NextRandom(seed, limit);
+        texture.mHeight = 8 + NextRandom(seed, limit);
+    }
+    return textures;
+}
+
+//*************************************************************************************************
+// Packs the textures with padding the same way the atlas does, adding a page whenever one
+// doesn't fit in any of the pages so far, and prints how much of the pages is used
+void RunPacking(const char* label, const std::vector<TextureSize>& textures)
+{
+    const int padding = AtlasManager::padding;
+    std::vector<SkylinePacker> pages;
+    unsigned long long textureArea = 0;
+
+    Timer timer;
+    for (const TextureSize& texture : textures)
+    {
+        int paddedWidth = texture.mWidth + padding * 2;
+        int paddedHeight = texture.mHeight + padding * 2;
+        int x, y;
+        bool found = false;
+        for (SkylinePacker& page : pages)
+        {
+            if (page.Pack(paddedWidth, paddedHeight, x, y))
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            pages.emplace_back();
+            pages.back().Reset(page_size, page_size);
+            pages.back().Pack(paddedWidth, paddedHeight, x, y);
+        }
+        textureArea += (unsigned long long)texture.mWidth * texture.mHeight;
+    }
+    Report(label, timer.GetSeconds(), (unsigned)textures.size());
+
+    // The last page is only partly filled, so how well the packer does is shown by the pages
+    // before it. The used area counts the padding.
+    unsigned long long fullArea = 0;
+    for (size_t i = 0; i + 1 < pages.size(); ++i)
+        fullArea += pages[i].GetUsedArea();
+    double pageArea = (double)page_size * page_size;
+    printf("    %s: %zu pages, %.1f%% used in full pages, %.1f%% used in the last page, "
+        "%.1f%% of all pages used by textures\n", label, pages.size(),
+        pages.size() > 1 ? fullArea * 100.0 / (pageArea * (pages.size() - 1)) : 0.0,
+        pages.back().GetUsedArea() * 100.0 / pageArea,
+        textureArea * 100.0 / (pageArea * pages.size()));
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(Atlas_Pack)
+{
+    std::vector<TextureSize> textures = MakeTextures();
+    RunPacking("Load order", textures);
+
+    // Packing the tallest textures first, which an atlas can do when textures are loaded
+    // together, leaves fewer gaps under the skyline
+    std::sort(textures.begin(), textures.end(),
+        [](const TextureSize& first, const TextureSize& second)
+        {
+            return first.mHeight > second.mHeight;
+        });
+    RunPacking("Tallest first", textures);
+}
@@ -0,0 +1,58 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Benchmark.h
+// author:  Andy Ellinger
+// brief:   Defining and timing benchmarks for the library parts that don't need a graphics device
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+
+namespace DGLBenchmark
+{
+
+// A benchmark function and its name. Each benchmark adds itself to a list when the program starts.
+struct BenchmarkCase
+{
+    BenchmarkCase(const char* name, void (*function)());
+
+    const char* mName;
+    void (*mFunction)();
+    BenchmarkCase* mNext{ nullptr };
+};
+
+// Measures the time since it was created or last restarted
+class Timer
+{
+public:
+    Timer() : mStart(std::chrono::steady_clock::now()) {}
+
+    // Starts measuring again from now
+    void Restart() { mStart = std::chrono::steady_clock::now(); }
+
+    // Returns the time since the start in seconds
+    double GetSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point mStart;
+};
+
+// Prints one measured time for the current benchmark. When the count isn't zero the time for
+// each of the counted items is printed as well.
+void Report(const char* label, double seconds, unsigned count = 0);
+
+// Keeps the compiler from removing work whose result is otherwise unused
+void Consume(const void* value);
+
+} // namespace DGLBenchmark
+
+// Defines a benchmark function which is run by BenchmarkMain
+#define BENCHMARK(name) \
+    static void name(); \
+    static DGLBenchmark::BenchmarkCase name##_case(#name, name); \
+    static void name()
@@ -0,0 +1,77 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BenchmarkMain.cpp
+// author:  Andy Ellinger
+// brief:   Running the benchmarks and printing their times
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "Benchmark.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace DGLBenchmark
+{
+
+namespace
+{
+
+// The benchmarks in the order they were added
+BenchmarkCase* gFirst{ nullptr };
+BenchmarkCase* gLast{ nullptr };
+// Written by Consume so the values passed to it are always used
+const void* volatile gSink{ nullptr };
+
+} // namespace
+
+//*************************************************************************************************
+BenchmarkCase::BenchmarkCase(const char* name, void (*function)()) :
+    mName(name),
+    mFunction(function)
+{
+    // The pointers are zero before any constructors run, so the order benchmarks are added in
+    // doesn't matter
+    if (gLast)
+        gLast->mNext = this;
+    else
+        gFirst = this;
+    gLast = this;
+}
+
+//*************************************************************************************************
+void Report(const char* label, double seconds, unsigned count)
+{
+    if (count)
+        printf("    %-40s %10.3f ms %10.2f ns each\n", label, seconds * 1000.0,
+            seconds * 1.0e9 / count);
+    else
+        printf("    %-40s %10.3f ms\n", label, seconds * 1000.0);
+}
+
+//*************************************************************************************************
+void Consume(const void* value)
+{
+    gSink = value;
+}
+
+} // namespace DGLBenchmark
+
+//*************************************************************************************************
+// Runs every benchmark, or only the ones whose names contain the first argument. The times are
+// only meaningful in a Release build.
+int main(int argc, char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    for (DGLBenchmark::BenchmarkCase* benchmark = DGLBenchmark::gFirst; benchmark;
+        benchmark = benchmark->mNext)
+    {
+        if (filter && !strstr(benchmark->mName, filter))
+            continue;
+
+        printf("%s\n", benchmark->mName);
+        benchmark->mFunction();
+    }
+
+    return 0;
+}
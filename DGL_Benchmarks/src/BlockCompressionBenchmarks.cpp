@@ -0,0 +1,93 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BlockCompressionBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for compressing textures into BC1 and BC3 blocks on the CPU
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <d3d11.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+import BlockCompression;
+import Mipmap;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The width and height of the texture compressed
+const int texture_size{ 1024 };
+
+//*************************************************************************************************
+// Returns a texture with gradients, noise, and a soft alpha edge, like a large sprite. BC1 can't
+// store the band of half alpha around the edge, so its PSNR is much lower than BC3's.
+MipLevel MakeTexture()
+{
+    MipLevel level;
+    level.mWidth = texture_size;
+    level.mHeight = texture_size;
+    level.mPixels.resize((size_t)texture_size * texture_size * 4);
+    unsigned seed = 12345;
+    for (int y = 0; y < texture_size; ++y)
+    {
+        for (int x = 0; x < texture_size; ++x)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            int noise = (int)(seed >> 28);
+            unsigned char* pixel = &level.mPixels[((size_t)y * texture_size + x) * 4];
+            pixel[0] = (unsigned char)(x / 4 + noise);
+            pixel[1] = (unsigned char)(y / 4 + noise);
+            pixel[2] = (unsigned char)((x + y) / 8);
+            int edge = (x - texture_size / 2) * (x - texture_size / 2) +
+                (y - texture_size / 2) * (y - texture_size / 2);
+            pixel[3] = (unsigned char)(edge < 400 * 400 ? 255 : (edge < 450 * 450 ? 128 : 0));
+        }
+    }
+    return level;
+}
+
+//*************************************************************************************************
+void RunFormat(const MipLevel& texture, DXGI_FORMAT format, const char* name)
+{
+    double megapixels = (double)texture_size * texture_size / 1000000.0;
+    char label[64];
+
+    // The last run uses one thread per core
+    unsigned cores = std::thread::hardware_concurrency();
+    const unsigned threadCounts[] = { 1, cores ? cores : 1 };
+    std::vector<MipLevel> levels;
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        levels = { texture };
+        Timer timer;
+        unsigned threads = BlockCompressor::Compress(levels, format, threadCounts[i]);
+        double seconds = timer.GetSeconds();
+
+        snprintf(label, sizeof(label), "%s, %u thread%s", name, threads, threads == 1 ? "" : "s");
+        Report(label, seconds, 1);
+        printf("    %s: %.1f megapixels a second\n", label, megapixels / seconds);
+    }
+
+    Timer timer;
+    BlockCompressor::Decompress(levels, format);
+    snprintf(label, sizeof(label), "%s, decompress", name);
+    Report(label, timer.GetSeconds(), 1);
+    printf("    %s: %.1f dB PSNR\n", name, BlockCompressor::GetPSNR(texture, levels[0]));
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(BlockCompression_Compress)
+{
+    MipLevel texture = MakeTexture();
+    RunFormat(texture, DXGI_FORMAT_BC1_UNORM, "1024x1024 BC1");
+    RunFormat(texture, DXGI_FORMAT_BC3_UNORM, "1024x1024 BC3");
+}
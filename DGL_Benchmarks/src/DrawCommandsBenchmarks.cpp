@@ -0,0 +1,112 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DrawCommandsBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for recording, sorting, and replaying a frame of draw commands
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <d3d11.h>
+#include <stdio.h>
+#include <vector>
+
+import D3DInterface;
+import DrawCommands;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of draws recorded each frame
+const unsigned commands_per_frame{ 100000 };
+// The number of frames to time
+const unsigned frame_count{ 10 };
+
+// Counts the draws and how often the texture changes between them instead of drawing
+class CountingBackend : public CommandBackend
+{
+public:
+    void ExecuteCommand(const DrawCommand&, const DrawState& state) override
+    {
+        if (mCommands == 0 || state.mTexture != mTexture)
+            ++mTextureChanges;
+        mTexture = state.mTexture;
+        ++mCommands;
+    }
+
+    const DGL_Texture* mTexture{ nullptr };
+    unsigned mCommands{ 0 };
+    unsigned mTextureChanges{ 0 };
+};
+
+// The meshes and textures are only compared, so any distinct addresses will do
+int gMeshObjects[16];
+int gTextureObjects[64];
+
+//*************************************************************************************************
+// Returns the states for one frame of sprites using a mix of textures, Z values, and blend modes,
+// in a repeatable random order
+std::vector<DrawState> MakeFrame()
+{
+    std::vector<DrawState> states(commands_per_frame);
+    unsigned seed = 12345;
+    for (DrawState& state : states)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        state.mTexture = (const DGL_Texture*)&gTextureObjects[(seed >> 8) % 64];
+        state.mBlendMode = (seed >> 20) % 4 == 0 ? DGL_BM_BLEND : DGL_BM_NONE;
+        state.mConstantBuffer.mTransformMatrix.m[0][3] = (float)(seed % 1280);
+        state.mConstantBuffer.mTransformMatrix.m[1][3] = (float)((seed >> 4) % 720);
+        state.mConstantBuffer.mTransformMatrix.m[2][3] = (float)((seed >> 12) % 8);
+    }
+    return states;
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(DrawCommands_100kPerFrame)
+{
+    std::vector<DrawState> states = MakeFrame();
+    DrawCommandBuffer commands;
+    double recordSeconds = 0.0, sortSeconds = 0.0, replaySeconds = 0.0;
+    unsigned unsortedChanges = 0, sortedChanges = 0;
+
+    for (unsigned frame = 0; frame < frame_count; ++frame)
+    {
+        // Clearing keeps the memory, so every frame after the first records without allocating
+        commands.Clear();
+
+        Timer timer;
+        for (unsigned i = 0; i < commands_per_frame; ++i)
+            commands.Record((const DGL_Mesh*)&gMeshObjects[i % 16], DGL_DM_TRIANGLELIST,
+                states[i]);
+        recordSeconds += timer.GetSeconds();
+
+        CountingBackend unsorted;
+        commands.Replay(unsorted);
+        unsortedChanges = unsorted.mTextureChanges;
+
+        timer.Restart();
+        commands.Sort();
+        sortSeconds += timer.GetSeconds();
+
+        CountingBackend sorted;
+        timer.Restart();
+        commands.Replay(sorted);
+        replaySeconds += timer.GetSeconds();
+        sortedChanges = sorted.mTextureChanges;
+    }
+
+    Report("Record", recordSeconds / frame_count, commands_per_frame);
+    Report("Sort", sortSeconds / frame_count, commands_per_frame);
+    Report("Replay", replaySeconds / frame_count, commands_per_frame);
+    Report("Frame", (recordSeconds + sortSeconds + replaySeconds) / frame_count,
+        commands_per_frame);
+    printf("    %u commands, %u states, texture changes %u recorded order, %u sorted\n",
+        commands.GetCommandCount(), commands.GetStateCount(), unsortedChanges, sortedChanges);
+}
@@ -0,0 +1,92 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DynamicMeshBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for the CPU work of updating dynamic meshes
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <d3d11.h>
+#include <vector>
+
+import Mesh;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of vertices in the mesh
+const unsigned vertex_count{ 10000 };
+// The number of times the mesh is updated in each benchmark, like one update a frame
+const unsigned update_count{ 1000 };
+
+// Writes into memory instead of a vertex buffer, so only the CPU work is measured
+class MemoryMapContext : public MapContext
+{
+public:
+    MemoryMapContext() : mMemory((size_t)vertex_count * MeshManager::dynamic_copies) {}
+
+    HRESULT Map(ID3D11Buffer* buffer, D3D11_MAP mapType,
+        D3D11_MAPPED_SUBRESOURCE* mappedResource) override
+    {
+        mappedResource->pData = mMemory.data();
+        return S_OK;
+    }
+
+    void Unmap(ID3D11Buffer* buffer) override {}
+
+    std::vector<VertexData> mMemory;
+};
+
+//*************************************************************************************************
+// Returns repeatable positions in a grid
+std::vector<DGL_Vec2> MakePositions()
+{
+    std::vector<DGL_Vec2> positions(vertex_count);
+    for (unsigned i = 0; i < vertex_count; ++i)
+        positions[i] = { (float)(i % 100), (float)(i / 100) };
+    return positions;
+}
+
+//*************************************************************************************************
+// Updates the mesh with the positions starting at the offset, one update at a time
+double TimeUpdates(const std::vector<DGL_Vec2>& positions, unsigned offset)
+{
+    DGL_Mesh mesh;
+    mesh.mDynamicCapacity = vertex_count;
+    mesh.mDynamicCopy = MeshManager::dynamic_copies - 1;
+    mesh.mVertexList = new VertexData[vertex_count];
+    MemoryMapContext context;
+    MeshManager::UpdateMesh(&mesh, positions.data(), nullptr, nullptr, vertex_count, 0, &context);
+
+    Timer timer;
+    for (unsigned update = 0; update < update_count; ++update)
+    {
+        MeshManager::UpdateMesh(&mesh, positions.data() + offset, nullptr, nullptr,
+            vertex_count - offset, offset, &context);
+    }
+    double seconds = timer.GetSeconds();
+
+    Consume(context.mMemory.data());
+    delete[] mesh.mVertexList;
+    return seconds;
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(DynamicMesh_Update)
+{
+    std::vector<DGL_Vec2> positions = MakePositions();
+
+    Report("UpdateMesh, every vertex", TimeUpdates(positions, 0), update_count);
+
+    // The whole mesh is still written into the next copy and its bounds are found again, so
+    // replacing a few vertices costs about the same as replacing all of them
+    Report("UpdateMesh, last 1% of vertices", TimeUpdates(positions, vertex_count / 100 * 99),
+        update_count);
+}
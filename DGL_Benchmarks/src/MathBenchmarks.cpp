@@ -0,0 +1,107 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MathBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for building draw transforms
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <math.h>
+#include <vector>
+
+import Math;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of transforms built in each benchmark
+const unsigned transform_count{ 1000000 };
+
+// The values for one draw
+struct DrawValues
+{
+    DGL_Vec2 mPosition;
+    DGL_Vec2 mScale;
+    float mAngle;
+};
+
+//*************************************************************************************************
+// Returns draws with repeatable positions, scales, and angles. Every draw in a group of the
+// provided size has the same angle, like sprites which aren't rotating.
+std::vector<DrawValues> MakeDraws(unsigned sameAngleCount)
+{
+    std::vector<DrawValues> draws(transform_count);
+    for (unsigned i = 0; i < transform_count; ++i)
+    {
+        draws[i].mPosition = { (float)(i % 1280), (float)(i % 720) };
+        draws[i].mScale = { 16.0f + i % 7, 16.0f + i % 5 };
+        draws[i].mAngle = (float)(i / sameAngleCount) * 0.01f;
+    }
+    return draws;
+}
+
+//*************************************************************************************************
+// Builds each transform from translation, rotation, and scale matrices, the way draws did
+// before Affine_Compose
+double TimeMatrices(const std::vector<DrawValues>& draws, std::vector<DGL_Mat4>& results)
+{
+    Timer timer;
+    for (unsigned i = 0; i < transform_count; ++i)
+    {
+        const DrawValues& draw = draws[i];
+        DGL_Mat4 scaleMatrix;
+        Matrix_SetToIdentity(scaleMatrix);
+        scaleMatrix.m[0][0] = draw.mScale.x;
+        scaleMatrix.m[1][1] = draw.mScale.y;
+
+        DGL_Mat4 translationMatrix;
+        Matrix_SetToIdentity(translationMatrix);
+        translationMatrix.m[0][3] = draw.mPosition.x;
+        translationMatrix.m[1][3] = draw.mPosition.y;
+
+        results[i] = Matrix_Multiply(Matrix_Multiply(translationMatrix,
+            Matrix_RotateZ(draw.mAngle)), scaleMatrix);
+    }
+    return timer.GetSeconds();
+}
+
+//*************************************************************************************************
+// Builds each transform directly, only calculating the sine and cosine when the angle changes
+double TimeAffine(const std::vector<DrawValues>& draws, std::vector<DGL_Mat4>& results)
+{
+    Timer timer;
+    CachedRotation rotation;
+    for (unsigned i = 0; i < transform_count; ++i)
+    {
+        const DrawValues& draw = draws[i];
+        rotation.SetAngle(draw.mAngle);
+        results[i] = Affine_ToMatrix(Affine_Compose(draw.mPosition, draw.mScale,
+            rotation.GetSin(), rotation.GetCos()), 0.0f);
+    }
+    return timer.GetSeconds();
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(Math_ComposeTransforms)
+{
+    std::vector<DGL_Mat4> results(transform_count);
+
+    // Every draw has its own angle, so the rotation is always calculated
+    std::vector<DrawValues> draws = MakeDraws(1);
+    Report("Matrix_Multiply, new angles", TimeMatrices(draws, results), transform_count);
+    Report("Affine_Compose, new angles", TimeAffine(draws, results), transform_count);
+
+    // Most draws have the same angle as the one before
+    draws = MakeDraws(64);
+    Report("Matrix_Multiply, repeated angles", TimeMatrices(draws, results), transform_count);
+    Report("Affine_Compose, repeated angles", TimeAffine(draws, results), transform_count);
+
+    Consume(results.data());
+}
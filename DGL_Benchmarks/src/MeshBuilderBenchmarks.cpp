@@ -0,0 +1,138 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshBuilderBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for filling mesh builders with large numbers of vertices
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <vector>
+
+import Mesh;
+import MeshBuilder;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of vertices added in each benchmark
+const unsigned vertex_count{ 1000000 };
+
+// The values for one vertex stored together, like a game's own vertex struct
+struct GameVertex
+{
+    DGL_Vec2 mPosition;
+    DGL_Color mColor;
+    DGL_Vec2 mTexCoord;
+};
+
+//*************************************************************************************************
+// Returns vertices with repeatable values
+std::vector<GameVertex> MakeVertices()
+{
+    std::vector<GameVertex> vertices(vertex_count);
+    for (unsigned i = 0; i < vertex_count; ++i)
+    {
+        float value = (float)(i % 1024) / 1024.0f;
+        vertices[i] = { { (float)(i % 1280), (float)(i % 720) },
+            { value, 1.0f - value, 0.5f, 1.0f }, { value, 1.0f - value } };
+    }
+    return vertices;
+}
+
+//*************************************************************************************************
+// Adds each vertex on its own, the way DGL_MeshBuilder_AddVertex does
+double TimeSingleVertices(const std::vector<GameVertex>& vertices, DGL_MeshBuilder& builder)
+{
+    Timer timer;
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    for (const GameVertex& vertex : vertices)
+        builder.mVertexList.push_back({ vertex.mPosition, vertex.mColor, vertex.mTexCoord });
+    return timer.GetSeconds();
+}
+
+//*************************************************************************************************
+// Adds all of the vertices at once, reading each value from inside the game's vertices
+double TimeStridedVertices(const std::vector<GameVertex>& vertices, DGL_MeshBuilder& builder)
+{
+    Timer timer;
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    MeshBuilder::AddVertices(builder, &vertices[0].mPosition, sizeof(GameVertex),
+        &vertices[0].mColor, sizeof(GameVertex), &vertices[0].mTexCoord, sizeof(GameVertex),
+        vertex_count);
+    return timer.GetSeconds();
+}
+
+//*************************************************************************************************
+// Writes two triangles for each group of four vertices one vertex at a time
+double TimeSingleQuads(const std::vector<GameVertex>& vertices, DGL_MeshBuilder& builder)
+{
+    const unsigned corners[6] = { 0, 1, 2, 0, 2, 3 };
+
+    Timer timer;
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    for (unsigned quad = 0; quad < vertex_count / 4; ++quad)
+    {
+        for (unsigned corner : corners)
+        {
+            const GameVertex& vertex = vertices[quad * 4 + corner];
+            builder.mVertexList.push_back({ vertex.mPosition, vertex.mColor, vertex.mTexCoord });
+        }
+    }
+    return timer.GetSeconds();
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(MeshBuilder_AddVertices)
+{
+    std::vector<GameVertex> vertices = MakeVertices();
+    DGL_MeshBuilder builder;
+
+    // The builder's memory is freed between runs so each one grows the list from nothing
+    Report("One vertex at a time", TimeSingleVertices(vertices, builder), vertex_count);
+    builder.mVertexList = std::vector<VertexData>();
+    Report("AddVertices with strides", TimeStridedVertices(vertices, builder), vertex_count);
+    Consume(builder.mVertexList.data());
+
+    // With the memory kept, only the copying is measured
+    Report("One vertex at a time, reused builder", TimeSingleVertices(vertices, builder),
+        vertex_count);
+    Report("AddVertices with strides, reused builder", TimeStridedVertices(vertices, builder),
+        vertex_count);
+    Consume(builder.mVertexList.data());
+}
+
+//*************************************************************************************************
+BENCHMARK(MeshBuilder_AddQuads)
+{
+    std::vector<GameVertex> vertices = MakeVertices();
+
+    // AddQuads takes separate arrays, so split the values up first
+    std::vector<DGL_Vec2> positions(vertex_count), texCoords(vertex_count);
+    std::vector<DGL_Color> colors(vertex_count);
+    for (unsigned i = 0; i < vertex_count; ++i)
+    {
+        positions[i] = vertices[i].mPosition;
+        colors[i] = vertices[i].mColor;
+        texCoords[i] = vertices[i].mTexCoord;
+    }
+
+    DGL_MeshBuilder builder;
+    unsigned quadVertexCount = vertex_count / 4 * 6;
+    Report("One vertex at a time", TimeSingleQuads(vertices, builder), quadVertexCount);
+    Consume(builder.mVertexList.data());
+
+    builder.mVertexList = std::vector<VertexData>();
+    Timer timer;
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    MeshBuilder::AddQuads(builder, positions.data(), colors.data(), texCoords.data(),
+        vertex_count / 4);
+    Report("AddQuads", timer.GetSeconds(), quadVertexCount);
+    Consume(builder.mVertexList.data());
+}
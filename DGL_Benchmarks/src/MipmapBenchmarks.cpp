@@ -0,0 +1,96 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MipmapBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for building the smaller levels of textures with each filter
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <d3d11.h>
+#include <stdio.h>
+#include <vector>
+
+import Mipmap;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of times each texture's levels are built
+const unsigned build_count{ 4 };
+
+//*************************************************************************************************
+// Returns a level with repeatable colors and some transparent areas
+MipLevel MakeLevel(int width, int height)
+{
+    MipLevel level;
+    level.mWidth = width;
+    level.mHeight = height;
+    level.mPixels.resize((size_t)width * height * 4);
+    unsigned seed = 12345;
+    for (size_t i = 0; i < level.mPixels.size(); i += 4)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        level.mPixels[i] = (unsigned char)(seed >> 24);
+        level.mPixels[i + 1] = (unsigned char)(seed >> 16);
+        level.mPixels[i + 2] = (unsigned char)(i / 4 % width);
+        level.mPixels[i + 3] = (unsigned char)((seed >> 8) % 4 == 0 ? 0 : 255);
+    }
+    return level;
+}
+
+//*************************************************************************************************
+void RunSize(int width, int height)
+{
+    MipLevel first = MakeLevel(width, height);
+    double megapixels = (double)width * height / 1000000.0;
+    const DGL_MipmapMode modes[2] = { DGL_MM_BOX, DGL_MM_KAISER };
+    const char* names[2] = { "Box", "Kaiser" };
+    char label[64];
+    for (unsigned mode = 0; mode < 2; ++mode)
+    {
+        std::vector<MipLevel> levels = { first };
+        Timer timer;
+        for (unsigned i = 0; i < build_count; ++i)
+            MipmapGenerator::BuildLevels(levels, modes[mode]);
+        double seconds = timer.GetSeconds();
+        Consume(levels.back().mPixels.data());
+
+        snprintf(label, sizeof(label), "%dx%d: %s", width, height, names[mode]);
+        Report(label, seconds, build_count);
+        printf("    %s: %.1f megapixels a second\n", label, megapixels * build_count / seconds);
+    }
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(Mipmap_BuildLevels)
+{
+    RunSize(1024, 1024);
+    RunSize(2048, 2048);
+
+    // Sizes that aren't powers of two use more taps, since the ranges don't line up
+    RunSize(1000, 600);
+}
+
+//*************************************************************************************************
+BENCHMARK(Mipmap_BuildFilter)
+{
+    // The filters are built again for every level of every texture
+    MipmapGenerator::Filter filter;
+    const DGL_MipmapMode modes[2] = { DGL_MM_BOX, DGL_MM_KAISER };
+    const char* labels[2] = { "2048 to 1024: Box", "2048 to 1024: Kaiser" };
+    for (unsigned mode = 0; mode < 2; ++mode)
+    {
+        Timer timer;
+        for (unsigned i = 0; i < 100; ++i)
+            MipmapGenerator::BuildFilter(2048, 1024, modes[mode], filter);
+        Report(labels[mode], timer.GetSeconds(), 100);
+        Consume(filter.mWeights.data());
+    }
+}
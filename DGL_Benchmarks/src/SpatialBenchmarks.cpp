@@ -0,0 +1,110 @@
+//-------------------------------------------------------------------------------------------------
+// file:    SpatialBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for building, updating, and searching the spatial grid
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+import Mesh;
+import Spatial;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of camera-sized areas searched in each level
+const unsigned query_count{ 1000 };
+
+//*************************************************************************************************
+// Returns a repeatable value between 0 and 1
+float NextRandom(unsigned& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0f;
+}
+
+//*************************************************************************************************
+// Returns sprite-sized objects spread over a level with room for about 100 per screen
+std::vector<DGL_SpatialObject> MakeLevel(const DGL_Mesh* mesh, unsigned count)
+{
+    float levelSize = 1280.0f * sqrtf(count / 100.0f);
+    std::vector<DGL_SpatialObject> objects(count);
+    unsigned seed = 12345;
+    for (DGL_SpatialObject& object : objects)
+    {
+        object = {};
+        object.mMesh = mesh;
+        object.mDrawMode = DGL_DM_TRIANGLELIST;
+        object.mPosition = { NextRandom(seed) * levelSize, NextRandom(seed) * levelSize };
+        object.mScale = { 16.0f + NextRandom(seed) * 48.0f, 16.0f + NextRandom(seed) * 48.0f };
+        object.mRotation = NextRandom(seed) * 6.0f;
+    }
+    return objects;
+}
+
+//*************************************************************************************************
+void RunLevel(const DGL_Mesh* mesh, unsigned count)
+{
+    std::vector<DGL_SpatialObject> objects = MakeLevel(mesh, count);
+    std::vector<unsigned> ids(count);
+    float levelSize = 1280.0f * sqrtf(count / 100.0f);
+    char label[64];
+
+    SpatialGrid grid;
+    Timer timer;
+    for (unsigned i = 0; i < count; ++i)
+        ids[i] = grid.Add(objects[i]);
+    snprintf(label, sizeof(label), "%u objects: Add", count);
+    Report(label, timer.GetSeconds(), count);
+
+    // Search areas the size of a 1280 by 720 view
+    std::vector<unsigned> results;
+    unsigned found = 0;
+    unsigned seed = 54321;
+    timer.Restart();
+    for (unsigned i = 0; i < query_count; ++i)
+    {
+        DGL_Vec2 areaMin = { NextRandom(seed) * levelSize, NextRandom(seed) * levelSize };
+        results.clear();
+        grid.Query(areaMin, { areaMin.x + 1280.0f, areaMin.y + 720.0f }, results);
+        found += (unsigned)results.size();
+    }
+    snprintf(label, sizeof(label), "%u objects: Query", count);
+    Report(label, timer.GetSeconds(), query_count);
+
+    // Move every object a little, so most stay in the same cells
+    timer.Restart();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        objects[i].mPosition.x += 3.0f;
+        grid.Update(ids[i], objects[i]);
+    }
+    snprintf(label, sizeof(label), "%u objects: Update", count);
+    Report(label, timer.GetSeconds(), count);
+
+    printf("    %u objects: %.1f found per query, %.1f MB, %.1f bytes per object\n", count,
+        (double)found / query_count, grid.GetMemoryBytes() / (1024.0 * 1024.0),
+        (double)grid.GetMemoryBytes() / count);
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(Spatial_GridSizes)
+{
+    DGL_Mesh mesh;
+    mesh.mBounds = { { -0.5f, -0.5f }, { 0.5f, 0.5f }, { 0.0f, 0.0f }, 0.7072f };
+
+    RunLevel(&mesh, 10000);
+    RunLevel(&mesh, 100000);
+    RunLevel(&mesh, 1000000);
+}
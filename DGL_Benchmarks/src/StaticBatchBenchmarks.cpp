@@ -0,0 +1,91 @@
+//-------------------------------------------------------------------------------------------------
+// file:    StaticBatchBenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for building static batches on one or several threads
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+import Mesh;
+import StaticBatch;
+import Texture;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of objects in the batch, each with four vertices
+const unsigned object_count{ 250000 };
+
+//*************************************************************************************************
+// Times building the batch, returning the fastest of a few builds
+double TimeBuild(const std::vector<const DGL_Mesh*>& meshes,
+    const std::vector<DGL_InstanceData>& instances, const std::vector<unsigned>& objects,
+    unsigned threadCount)
+{
+    std::vector<VertexData> vertices;
+    std::vector<unsigned> indices;
+    double fastest = 0.0;
+    for (unsigned run = 0; run < 3; ++run)
+    {
+        Timer timer;
+        StaticBatchBuilder::Build(meshes.data(), nullptr, instances.data(), objects, vertices,
+            indices, threadCount);
+        double seconds = timer.GetSeconds();
+        if (run == 0 || seconds < fastest)
+            fastest = seconds;
+        Consume(vertices.data());
+    }
+    return fastest;
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(StaticBatch_Build)
+{
+    // An indexed square
+    DGL_Mesh square;
+    square.mVertexCount = 4;
+    square.mVertexList = new VertexData[4]{
+        { { -0.5f, -0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 1.0f } },
+        { { 0.5f, -0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f } },
+        { { 0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
+        { { -0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f } } };
+    square.mIndexCount = 6;
+    square.mIndices = new unsigned[6]{ 0, 1, 2, 0, 2, 3 };
+
+    std::vector<const DGL_Mesh*> meshes(object_count, &square);
+    std::vector<DGL_InstanceData> instances(object_count);
+    std::vector<unsigned> objects(object_count);
+    for (unsigned i = 0; i < object_count; ++i)
+    {
+        DGL_InstanceData& instance = instances[i];
+        instance.mPosition = { (float)(i % 500) * 8.0f, (float)(i / 500) * 8.0f };
+        instance.mScale = { 6.0f, 6.0f };
+        instance.mRotation = (float)(i % 64) * 0.1f;
+        instance.mTintColor = { 1.0f, 0.0f, 0.0f, (float)(i % 3) * 0.25f };
+        instance.mTextureOffset = { 0.0f, 0.0f };
+        objects[i] = i;
+    }
+
+    unsigned vertexCount = object_count * 4;
+    Report("1 thread", TimeBuild(meshes, instances, objects, 1), vertexCount);
+    Report("2 threads", TimeBuild(meshes, instances, objects, 2), vertexCount);
+    Report("4 threads", TimeBuild(meshes, instances, objects, 4), vertexCount);
+
+    char label[64];
+    snprintf(label, sizeof(label), "One thread per core (%u)", std::thread::hardware_concurrency());
+    Report(label, TimeBuild(meshes, instances, objects, 0), vertexCount);
+
+    delete[] square.mVertexList;
+    delete[] square.mIndices;
+}
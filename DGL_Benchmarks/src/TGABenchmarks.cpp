@@ -0,0 +1,127 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TGABenchmarks.cpp
+// author:  Andy Ellinger
+// brief:   Benchmarks for decoding TGA files on one or several threads
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Benchmark.h"
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+import Mipmap;
+import TGA;
+
+using namespace DGL;
+using namespace DGLBenchmark;
+
+namespace
+{
+
+// The number of files decoded in each run
+const unsigned file_count{ 64 };
+// The width and height of each file
+const int file_size{ 512 };
+
+//*************************************************************************************************
+// Returns the encoded files, each a sprite sheet with flat areas and gradients
+std::vector<std::vector<unsigned char>> MakeFiles(bool runLength)
+{
+    std::vector<std::vector<unsigned char>> files(file_count);
+    MipLevel level;
+    level.mWidth = file_size;
+    level.mHeight = file_size;
+    level.mPixels.resize((size_t)file_size * file_size * 4);
+    for (unsigned i = 0; i < file_count; ++i)
+    {
+        for (int y = 0; y < file_size; ++y)
+        {
+            for (int x = 0; x < file_size; ++x)
+            {
+                unsigned char* pixel = &level.mPixels[((size_t)y * file_size + x) * 4];
+                bool flat = ((x / 64) + (y / 64) + i) % 2 == 0;
+                pixel[0] = (unsigned char)(flat ? i * 4 : x);
+                pixel[1] = (unsigned char)(flat ? 128 : y);
+                pixel[2] = (unsigned char)(flat ? 64 : x + y);
+                pixel[3] = (unsigned char)(flat ? 0 : 255);
+            }
+        }
+        TGAFile::Encode(level, runLength, files[i]);
+    }
+    return files;
+}
+
+//*************************************************************************************************
+// Decodes every file with the threads each taking the next file left, the same way the texture
+// loader's workers take jobs, and returns the fastest of a few runs
+double TimeDecode(const std::vector<std::vector<unsigned char>>& files, unsigned threadCount)
+{
+    std::vector<MipLevel> levels(files.size());
+    double fastest = 0.0;
+    for (unsigned run = 0; run < 3; ++run)
+    {
+        std::atomic<unsigned> next{ 0 };
+        auto decode = [&]()
+        {
+            for (unsigned i = next++; i < files.size(); i = next++)
+                TGAFile::Decode(files[i].data(), files[i].size(), levels[i]);
+        };
+
+        Timer timer;
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < threadCount; ++i)
+            threads.emplace_back(decode);
+        decode();
+        for (std::thread& thread : threads)
+            thread.join();
+        double seconds = timer.GetSeconds();
+
+        if (run == 0 || seconds < fastest)
+            fastest = seconds;
+        Consume(levels[0].mPixels.data());
+    }
+    return fastest;
+}
+
+//*************************************************************************************************
+void RunFiles(const char* name, bool runLength)
+{
+    std::vector<std::vector<unsigned char>> files = MakeFiles(runLength);
+    size_t fileBytes = 0;
+    for (const std::vector<unsigned char>& file : files)
+        fileBytes += file.size();
+
+    // The last run uses one thread per core
+    unsigned cores = std::thread::hardware_concurrency();
+    const unsigned threadCounts[] = { 1, 2, 4, cores ? cores : 1 };
+    char label[64];
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        unsigned threadCount = threadCounts[i];
+        if (i == 3)
+            snprintf(label, sizeof(label), "%s, one thread per core (%u)", name, threadCount);
+        else
+        {
+            snprintf(label, sizeof(label), "%s, %u thread%s", name, threadCount,
+                threadCount == 1 ? "" : "s");
+        }
+        double seconds = TimeDecode(files, threadCount);
+        Report(label, seconds, file_count);
+        printf("    %s: %.0f MB of pixels a second\n", label,
+            (double)file_size * file_size * 4 * file_count / seconds / (1024.0 * 1024.0));
+    }
+    printf("    %s: %.1f MB of files\n", name, fileBytes / (1024.0 * 1024.0));
+}
+
+} // namespace
+
+//*************************************************************************************************
+BENCHMARK(TGA_Decode)
+{
+    RunFiles("Uncompressed", false);
+    RunFiles("Run-length", true);
+}
@@ -0,0 +1,148 @@
+//-------------------------------------------------------------------------------------------------
+// file:    AtlasTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for where the skyline packer places rectangles on an atlas page
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <vector>
+
+import Atlas;
+
+using namespace DGL;
+
+namespace
+{
+
+struct Rect
+{
+    int mX{ 0 };
+    int mY{ 0 };
+    int mWidth{ 0 };
+    int mHeight{ 0 };
+};
+
+//*************************************************************************************************
+bool Overlap(const Rect& first, const Rect& second)
+{
+    return first.mX < second.mX + second.mWidth && second.mX < first.mX + first.mWidth &&
+        first.mY < second.mY + second.mHeight && second.mY < first.mY + first.mHeight;
+}
+
+//*************************************************************************************************
+// Packs textures of different sizes with padding around them, the same way the atlas does,
+// until one doesn't fit. Returns where each texture went, not counting its padding.
+std::vector<Rect> PackTextures(SkylinePacker& packer)
+{
+    const int padding = AtlasManager::padding;
+    std::vector<Rect> textures;
+    for (unsigned i = 0; ; ++i)
+    {
+        Rect texture;
+        texture.mWidth = 5 + (int)(i * 37 % 60);
+        texture.mHeight = 3 + (int)(i * 53 % 45);
+
+        int x, y;
+        if (!packer.Pack(texture.mWidth + padding * 2, texture.mHeight + padding * 2, x, y))
+            break;
+
+        texture.mX = x + padding;
+        texture.mY = y + padding;
+        textures.push_back(texture);
+    }
+    return textures;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(Atlas_PackedRectsDontOverlap)
+{
+    SkylinePacker packer;
+    packer.Reset(512, 256);
+
+    std::vector<Rect> textures = PackTextures(packer);
+    CHECK(textures.size() > 20);
+
+    const int padding = AtlasManager::padding;
+    unsigned long long area = 0;
+    for (unsigned i = 0; i < textures.size(); ++i)
+    {
+        const Rect& texture = textures[i];
+
+        // The padding around each texture is inside the page
+        CHECK(texture.mX - padding >= 0 && texture.mY - padding >= 0);
+        CHECK(texture.mX + texture.mWidth + padding <= packer.GetWidth());
+        CHECK(texture.mY + texture.mHeight + padding <= packer.GetHeight());
+
+        // The padding around each texture doesn't overlap any other texture or its padding
+        Rect padded = { texture.mX - padding, texture.mY - padding,
+            texture.mWidth + padding * 2, texture.mHeight + padding * 2 };
+        for (unsigned j = i + 1; j < textures.size(); ++j)
+        {
+            const Rect& other = textures[j];
+            Rect otherPadded = { other.mX - padding, other.mY - padding,
+                other.mWidth + padding * 2, other.mHeight + padding * 2 };
+            CHECK(!Overlap(padded, otherPadded));
+        }
+
+        area += (unsigned long long)padded.mWidth * padded.mHeight;
+    }
+
+    CHECK(packer.GetUsedArea() == area);
+}
+
+//*************************************************************************************************
+TEST(Atlas_FullPageRejected)
+{
+    SkylinePacker packer;
+    packer.Reset(128, 128);
+
+    // Rectangles larger than the page never fit
+    int x = -1, y = -1;
+    CHECK(!packer.Pack(129, 1, x, y));
+    CHECK(!packer.Pack(1, 129, x, y));
+    CHECK(packer.GetUsedArea() == 0);
+
+    // Four quarters fill the page exactly
+    for (int i = 0; i < 4; ++i)
+    {
+        CHECK(packer.Pack(64, 64, x, y));
+        CHECK(x % 64 == 0 && y % 64 == 0);
+    }
+    CHECK(packer.GetUsedArea() == 128 * 128);
+
+    // Nothing else fits, and a failed pack doesn't change the used area
+    CHECK(!packer.Pack(1, 1, x, y));
+    CHECK(packer.GetUsedArea() == 128 * 128);
+
+    // Resetting makes the whole page available again
+    packer.Reset(128, 128);
+    CHECK(packer.Pack(128, 128, x, y));
+    CHECK(x == 0 && y == 0);
+}
+
+//*************************************************************************************************
+TEST(Atlas_LowestPlacementFirst)
+{
+    SkylinePacker packer;
+    packer.Reset(100, 100);
+
+    // A tall rectangle on the left leaves a lower spot on the right, which is used next
+    int x, y;
+    CHECK(packer.Pack(40, 80, x, y));
+    CHECK(x == 0 && y == 0);
+    CHECK(packer.Pack(60, 30, x, y));
+    CHECK(x == 40 && y == 0);
+    CHECK(packer.Pack(60, 30, x, y));
+    CHECK(x == 40 && y == 30);
+
+    // This is too wide to fit next to the tall rectangle, so it goes above both
+    CHECK(packer.Pack(100, 20, x, y));
+    CHECK(x == 0 && y == 80);
+    CHECK(!packer.Pack(50, 10, x, y));
+}
@@ -0,0 +1,258 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BatchTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for when the sprite batcher starts a new batch
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <vector>
+
+import D3DInterface;
+import Mesh;
+import Batch;
+import Texture;
+
+using namespace DGL;
+
+namespace
+{
+
+// Records the size of each batch instead of drawing it
+class CountingBackend : public BatchBackend
+{
+public:
+    void DrawBatch(const BatchState& state, const VertexData*, unsigned vertexCount) override
+    {
+        mStates.push_back(state);
+        mVertexCounts.push_back(vertexCount);
+    }
+
+    std::vector<BatchState> mStates;
+    std::vector<unsigned> mVertexCounts;
+};
+
+// A mesh which keeps its vertices on the CPU and has no D3D buffers
+struct TestMesh
+{
+    explicit TestMesh(unsigned vertexCount) :
+        mVertices(vertexCount, VertexData{ { 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } })
+    {
+        mMesh.mVertexList = mVertices.data();
+        mMesh.mVertexCount = vertexCount;
+    }
+
+    std::vector<VertexData> mVertices;
+    DGL_Mesh mMesh;
+};
+
+// The shaders and textures are only compared, so any distinct addresses will do
+int gShaderObjects[4];
+ID3D11VertexShader* const gVertexShader1 = (ID3D11VertexShader*)&gShaderObjects[0];
+ID3D11VertexShader* const gVertexShader2 = (ID3D11VertexShader*)&gShaderObjects[1];
+ID3D11PixelShader* const gPixelShader1 = (ID3D11PixelShader*)&gShaderObjects[2];
+ID3D11PixelShader* const gPixelShader2 = (ID3D11PixelShader*)&gShaderObjects[3];
+
+//*************************************************************************************************
+cbPerObject MakeConstants()
+{
+    cbPerObject constants;
+    for (int i = 0; i < 4; ++i)
+        constants.mTransformMatrix.m[i][i] = 1.0f;
+    return constants;
+}
+
+//*************************************************************************************************
+bool AddMesh(SpriteBatcher& batcher, const TestMesh& mesh, DGL_DrawMode mode,
+    const DGL_Texture* texture)
+{
+    return batcher.Add(&mesh.mMesh, mode, texture, gVertexShader1, gPixelShader1,
+        MakeConstants());
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(Batch_SameStateSharesBatch)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    TestMesh quad(6);
+    for (int i = 0; i < 3; ++i)
+        CHECK(AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, nullptr));
+    batcher.Flush();
+
+    CHECK(backend.mVertexCounts.size() == 1);
+    CHECK(backend.mVertexCounts[0] == 18);
+    CHECK(batcher.GetBatchCount() == 1);
+    CHECK(batcher.GetMeshCount() == 3);
+}
+
+//*************************************************************************************************
+TEST(Batch_TextureChangeStartsBatch)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    DGL_Texture texture1, texture2;
+    TestMesh quad(6);
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, &texture1);
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, &texture1);
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, &texture2);
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, nullptr);
+    batcher.Flush();
+
+    CHECK(backend.mVertexCounts.size() == 3);
+    CHECK(backend.mVertexCounts[0] == 12);
+    CHECK(backend.mStates[0].mTexture == &texture1);
+    CHECK(backend.mStates[1].mTexture == &texture2);
+    CHECK(backend.mStates[2].mTexture == nullptr);
+}
+
+//*************************************************************************************************
+TEST(Batch_ShaderChangeStartsBatch)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    TestMesh quad(6);
+    const DGL_Mesh* mesh = &quad.mMesh;
+    cbPerObject constants = MakeConstants();
+    batcher.Add(mesh, DGL_DM_TRIANGLELIST, nullptr, gVertexShader1, gPixelShader1, constants);
+    batcher.Add(mesh, DGL_DM_TRIANGLELIST, nullptr, gVertexShader2, gPixelShader1, constants);
+    batcher.Add(mesh, DGL_DM_TRIANGLELIST, nullptr, gVertexShader2, gPixelShader2, constants);
+    batcher.Add(mesh, DGL_DM_TRIANGLELIST, nullptr, gVertexShader2, gPixelShader2, constants);
+    batcher.Flush();
+
+    CHECK(backend.mVertexCounts.size() == 3);
+    CHECK(backend.mStates[1].mVertexShader == gVertexShader2);
+    CHECK(backend.mStates[2].mPixelShader == gPixelShader2);
+    CHECK(backend.mVertexCounts[2] == 12);
+}
+
+//*************************************************************************************************
+TEST(Batch_DrawModeChangeStartsBatch)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    TestMesh quad(6);
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, nullptr);
+    AddMesh(batcher, quad, DGL_DM_LINELIST, nullptr);
+    AddMesh(batcher, quad, DGL_DM_POINTLIST, nullptr);
+    batcher.Flush();
+
+    CHECK(backend.mVertexCounts.size() == 3);
+
+    // Strips can't be joined, so they are drawn normally
+    CHECK(!AddMesh(batcher, quad, DGL_DM_TRIANGLESTRIP, nullptr));
+    CHECK(!AddMesh(batcher, quad, DGL_DM_LINESTRIP, nullptr));
+}
+
+//*************************************************************************************************
+TEST(Batch_BlendChangeFlushes)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    TestMesh quad(6);
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, nullptr);
+
+    // Setting the current values doesn't draw anything
+    batcher.SetDrawSettings(DGL_BM_NONE, DGL_TSM_LINEAR, DGL_AM_WRAP);
+    CHECK(backend.mVertexCounts.empty());
+
+    // The batch is drawn before the new blend mode is used
+    batcher.SetDrawSettings(DGL_BM_BLEND, DGL_TSM_LINEAR, DGL_AM_WRAP);
+    CHECK(backend.mVertexCounts.size() == 1);
+
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, nullptr);
+    batcher.SetDrawSettings(DGL_BM_ADD, DGL_TSM_LINEAR, DGL_AM_WRAP);
+    CHECK(backend.mVertexCounts.size() == 2);
+
+    // Nothing is drawn for an empty batch
+    batcher.SetDrawSettings(DGL_BM_MULTIPLY, DGL_TSM_LINEAR, DGL_AM_WRAP);
+    CHECK(backend.mVertexCounts.size() == 2);
+}
+
+//*************************************************************************************************
+TEST(Batch_SamplerChangeFlushes)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    DGL_Texture texture;
+    TestMesh quad(6);
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, &texture);
+    batcher.SetDrawSettings(DGL_BM_NONE, DGL_TSM_POINT, DGL_AM_WRAP);
+    CHECK(backend.mVertexCounts.size() == 1);
+
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, &texture);
+    batcher.SetDrawSettings(DGL_BM_NONE, DGL_TSM_POINT, DGL_AM_CLAMP);
+    CHECK(backend.mVertexCounts.size() == 2);
+
+    AddMesh(batcher, quad, DGL_DM_TRIANGLELIST, &texture);
+    batcher.SetDrawSettings(DGL_BM_NONE, DGL_TSM_POINT, DGL_AM_CLAMP);
+    CHECK(backend.mVertexCounts.size() == 2);
+}
+
+//*************************************************************************************************
+TEST(Batch_MeshVertexLimit)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    TestMesh largest(SpriteBatcher::max_mesh_vertices);
+    TestMesh tooLarge(SpriteBatcher::max_mesh_vertices + 1);
+    CHECK(AddMesh(batcher, largest, DGL_DM_POINTLIST, nullptr));
+    CHECK(!AddMesh(batcher, tooLarge, DGL_DM_POINTLIST, nullptr));
+
+    // A mesh drawn normally doesn't change the current batch
+    CHECK(backend.mVertexCounts.empty());
+    CHECK(batcher.GetMeshCount() == 1);
+
+    // Indexed meshes are limited by their index count
+    std::vector<unsigned> indices(SpriteBatcher::max_mesh_vertices + 1, 0);
+    TestMesh indexed(3);
+    indexed.mMesh.mIndices = indices.data();
+    indexed.mMesh.mIndexCount = (unsigned)indices.size();
+    CHECK(!AddMesh(batcher, indexed, DGL_DM_POINTLIST, nullptr));
+
+    // So are meshes that didn't keep their vertices
+    TestMesh noVertices(6);
+    noVertices.mMesh.mVertexList = nullptr;
+    CHECK(!AddMesh(batcher, noVertices, DGL_DM_TRIANGLELIST, nullptr));
+}
+
+//*************************************************************************************************
+TEST(Batch_BatchVertexLimit)
+{
+    CountingBackend backend;
+    SpriteBatcher batcher;
+    batcher.SetBackend(&backend);
+
+    // These fill a batch exactly, so the next mesh starts a new one
+    TestMesh mesh(SpriteBatcher::max_mesh_vertices);
+    unsigned meshesPerBatch = SpriteBatcher::max_batch_vertices / SpriteBatcher::max_mesh_vertices;
+    for (unsigned i = 0; i < meshesPerBatch; ++i)
+        AddMesh(batcher, mesh, DGL_DM_POINTLIST, nullptr);
+    CHECK(backend.mVertexCounts.empty());
+
+    AddMesh(batcher, mesh, DGL_DM_POINTLIST, nullptr);
+    batcher.Flush();
+
+    CHECK(backend.mVertexCounts.size() == 2);
+    CHECK(backend.mVertexCounts[0] == SpriteBatcher::max_batch_vertices);
+    CHECK(backend.mVertexCounts[1] == SpriteBatcher::max_mesh_vertices);
+}
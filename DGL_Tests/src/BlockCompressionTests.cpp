@@ -0,0 +1,248 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BlockCompressionTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for the quality and layout of BC1 and BC3 blocks compressed on the CPU
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+import BlockCompression;
+import Mipmap;
+
+using namespace DGL;
+
+namespace
+{
+
+// The lowest PSNR allowed for each kind of texture, in decibels
+const float gradient_psnr{ 36.0f };
+const float alpha_edge_psnr{ 42.0f };
+
+//*************************************************************************************************
+// Returns a level with the pixel from the function at each position
+template <typename PixelFunction>
+MipLevel MakeLevel(int width, int height, PixelFunction pixelFunction)
+{
+    MipLevel level;
+    level.mWidth = width;
+    level.mHeight = height;
+    level.mPixels.resize((size_t)width * height * 4);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+            pixelFunction(x, y, &level.mPixels[((size_t)y * width + x) * 4]);
+    }
+    return level;
+}
+
+//*************************************************************************************************
+// Smooth opaque gradients in different directions for each channel
+MipLevel MakeGradient()
+{
+    return MakeLevel(64, 64, [](int x, int y, unsigned char* pixel)
+        {
+            pixel[0] = (unsigned char)(x * 4);
+            pixel[1] = (unsigned char)(y * 4);
+            pixel[2] = (unsigned char)(255 - (x + y) * 2);
+            pixel[3] = 255;
+        });
+}
+
+//*************************************************************************************************
+// A gradient with a circle cut out of it by alpha, like a sprite, with the edge crossing blocks
+MipLevel MakeAlphaEdge()
+{
+    return MakeLevel(64, 64, [](int x, int y, unsigned char* pixel)
+        {
+            int dx = x - 30;
+            int dy = y - 34;
+            bool inside = dx * dx + dy * dy < 25 * 25;
+            pixel[0] = (unsigned char)(128 + x);
+            pixel[1] = (unsigned char)(64 + y * 2);
+            pixel[2] = 40;
+            pixel[3] = inside ? 255 : 0;
+        });
+}
+
+//*************************************************************************************************
+// Compresses and decompresses a copy of the level, and returns the PSNR of the result
+float RoundTrip(const MipLevel& level, DXGI_FORMAT format)
+{
+    std::vector<MipLevel> levels = { level };
+    BlockCompressor::Compress(levels, format, 1);
+    CHECK(levels[0].mPixels.size() ==
+        MipmapGenerator::GetLevelBytes(format, level.mWidth, level.mHeight));
+    BlockCompressor::Decompress(levels, format);
+    return BlockCompressor::GetPSNR(level, levels[0]);
+}
+
+//*************************************************************************************************
+// Returns the 2 bit color index of the pixel in a BC1 block, or the color part of a BC3 block
+unsigned GetColorIndex(const unsigned char* block, unsigned pixel)
+{
+    uint32_t bits;
+    memcpy(&bits, block + 4, sizeof(bits));
+    return (bits >> (pixel * 2)) & 3;
+}
+
+//*************************************************************************************************
+// Returns one of the 565 end colors of the color block
+uint16_t GetEndColor(const unsigned char* block, unsigned end)
+{
+    uint16_t color;
+    memcpy(&color, block + end * 2, sizeof(color));
+    return color;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(BlockCompression_GradientQuality)
+{
+    MipLevel gradient = MakeGradient();
+    CHECK(RoundTrip(gradient, DXGI_FORMAT_BC1_UNORM) > gradient_psnr);
+    CHECK(RoundTrip(gradient, DXGI_FORMAT_BC3_UNORM) > gradient_psnr);
+}
+
+//*************************************************************************************************
+TEST(BlockCompression_AlphaEdgeQuality)
+{
+    // BC1 only has on or off alpha, which is all this edge needs, and BC3 stores alpha apart
+    // from the colors
+    MipLevel edge = MakeAlphaEdge();
+    CHECK(RoundTrip(edge, DXGI_FORMAT_BC1_UNORM) > alpha_edge_psnr);
+    CHECK(RoundTrip(edge, DXGI_FORMAT_BC3_UNORM) > alpha_edge_psnr);
+
+    // A smooth fade in alpha can only be kept by BC3
+    MipLevel fade = MakeLevel(16, 16, [](int x, int y, unsigned char* pixel)
+        {
+            pixel[0] = pixel[1] = pixel[2] = 200;
+            pixel[3] = (unsigned char)(x * 16 + y);
+        });
+    CHECK(RoundTrip(fade, DXGI_FORMAT_BC3_UNORM) > gradient_psnr);
+    CHECK(RoundTrip(fade, DXGI_FORMAT_BC1_UNORM) < RoundTrip(fade, DXGI_FORMAT_BC3_UNORM));
+}
+
+//*************************************************************************************************
+TEST(BlockCompression_SolidBlocks)
+{
+    // A color that 565 stores exactly comes back unchanged
+    MipLevel solid = MakeLevel(8, 8, [](int x, int y, unsigned char* pixel)
+        {
+            pixel[0] = 255;
+            pixel[1] = 0;
+            pixel[2] = 132;
+            pixel[3] = 255;
+        });
+    CHECK(isinf(RoundTrip(solid, DXGI_FORMAT_BC1_UNORM)));
+    CHECK(isinf(RoundTrip(solid, DXGI_FORMAT_BC3_UNORM)));
+
+    // BC3 stores a block of one alpha value without indices
+    MipLevel translucent = solid;
+    for (size_t i = 3; i < translucent.mPixels.size(); i += 4)
+        translucent.mPixels[i] = 77;
+    std::vector<MipLevel> levels = { translucent };
+    BlockCompressor::Compress(levels, DXGI_FORMAT_BC3_UNORM, 1);
+    const unsigned char* block = levels[0].mPixels.data();
+    CHECK(block[0] == 77);
+    BlockCompressor::Decompress(levels, DXGI_FORMAT_BC3_UNORM);
+    CHECK(isinf(BlockCompressor::GetPSNR(translucent, levels[0])));
+}
+
+//*************************************************************************************************
+TEST(BlockCompression_TransparentPixelsUseIndex3)
+{
+    // The left half of the block is transparent, and the right is two colors
+    MipLevel level = MakeLevel(4, 4, [](int x, int y, unsigned char* pixel)
+        {
+            pixel[0] = x == 3 ? 250 : 20;
+            pixel[1] = 100;
+            pixel[2] = (unsigned char)(y * 60);
+            pixel[3] = x < 2 ? 10 : 255;
+        });
+    std::vector<MipLevel> levels = { level };
+    BlockCompressor::Compress(levels, DXGI_FORMAT_BC1_UNORM, 1);
+    const unsigned char* block = levels[0].mPixels.data();
+
+    // The first end color isn't larger, so the block uses three colors and transparent black
+    CHECK(GetEndColor(block, 0) <= GetEndColor(block, 1));
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        if (i % 4 < 2)
+            CHECK(GetColorIndex(block, i) == 3);
+        else
+            CHECK(GetColorIndex(block, i) != 3);
+    }
+
+    BlockCompressor::Decompress(levels, DXGI_FORMAT_BC1_UNORM);
+    for (unsigned i = 0; i < 16; ++i)
+        CHECK(levels[0].mPixels[i * 4 + 3] == (i % 4 < 2 ? 0 : 255));
+
+    // A block with no visible pixels doesn't need any colors
+    MipLevel clear = MakeLevel(4, 4, [](int x, int y, unsigned char* pixel)
+        {
+            pixel[0] = pixel[1] = pixel[2] = 200;
+            pixel[3] = 0;
+        });
+    levels = { clear };
+    BlockCompressor::Compress(levels, DXGI_FORMAT_BC1_UNORM, 1);
+    for (unsigned i = 0; i < 16; ++i)
+        CHECK(GetColorIndex(levels[0].mPixels.data(), i) == 3);
+}
+
+//*************************************************************************************************
+TEST(BlockCompression_EqualEndColors)
+{
+    // These colors are different, but all round to the same 565 color, so both end colors are
+    // the same. Equal end colors are read as a three color block, so index 3 would be
+    // transparent black, and every pixel has to use the first color instead.
+    MipLevel level = MakeLevel(4, 4, [](int x, int y, unsigned char* pixel)
+        {
+            pixel[0] = (unsigned char)(99 + x % 2);
+            pixel[1] = (unsigned char)(50 + y % 2);
+            pixel[2] = 200;
+            pixel[3] = 255;
+        });
+    const DXGI_FORMAT formats[2] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM };
+    for (DXGI_FORMAT format : formats)
+    {
+        std::vector<MipLevel> levels = { level };
+        BlockCompressor::Compress(levels, format, 1);
+        const unsigned char* block = levels[0].mPixels.data() +
+            (format == DXGI_FORMAT_BC3_UNORM ? 8 : 0);
+        CHECK(GetEndColor(block, 0) == GetEndColor(block, 1));
+        for (unsigned i = 0; i < 16; ++i)
+            CHECK(GetColorIndex(block, i) == 0);
+
+        BlockCompressor::Decompress(levels, format);
+        for (unsigned i = 0; i < 16; ++i)
+            CHECK(levels[0].mPixels[i * 4 + 3] == 255);
+        CHECK(RoundTrip(level, format) > gradient_psnr);
+    }
+}
+
+//*************************************************************************************************
+TEST(BlockCompression_ThreadsMatchOneThread)
+{
+    // Large levels are split between threads by rows of blocks, with the same result
+    MipLevel gradient = MakeLevel(256, 256, [](int x, int y, unsigned char* pixel)
+        {
+            pixel[0] = (unsigned char)x;
+            pixel[1] = (unsigned char)(x ^ y);
+            pixel[2] = (unsigned char)y;
+            pixel[3] = (unsigned char)(x + y);
+        });
+    std::vector<MipLevel> single = { gradient };
+    std::vector<MipLevel> threaded = { gradient };
+    CHECK(BlockCompressor::Compress(single, DXGI_FORMAT_BC3_UNORM, 1) == 1);
+    CHECK(BlockCompressor::Compress(threaded, DXGI_FORMAT_BC3_UNORM, 4) == 4);
+    CHECK(single[0].mPixels == threaded[0].mPixels);
+}
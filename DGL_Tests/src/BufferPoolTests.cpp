@@ -0,0 +1,215 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BufferPoolTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for where the offset allocator places blocks and how it joins freed space
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <utility>
+#include <vector>
+
+import BufferPool;
+
+using namespace DGL;
+
+namespace
+{
+
+// A block returned by the allocator, as its offset and size
+typedef std::pair<unsigned, unsigned> Block;
+
+//*************************************************************************************************
+// Returns true if no two blocks use the same space, and every block is inside the range
+bool BlocksSeparate(const std::vector<Block>& blocks, unsigned capacity)
+{
+    std::vector<bool> used(capacity, false);
+    for (const Block& block : blocks)
+    {
+        if (block.first + block.second > capacity)
+            return false;
+        for (unsigned i = block.first; i < block.first + block.second; ++i)
+        {
+            if (used[i])
+                return false;
+            used[i] = true;
+        }
+    }
+    return true;
+}
+
+//*************************************************************************************************
+// Finds the runs of space not used by any block, which are the free blocks the allocator
+// should have if it always joins freed space with its neighbors
+void FindFreeRuns(const std::vector<Block>& blocks, unsigned capacity, unsigned& runCount,
+    unsigned& largestRun)
+{
+    std::vector<bool> used(capacity, false);
+    for (const Block& block : blocks)
+    {
+        for (unsigned i = block.first; i < block.first + block.second; ++i)
+            used[i] = true;
+    }
+
+    runCount = 0;
+    largestRun = 0;
+    unsigned run = 0;
+    for (unsigned i = 0; i <= capacity; ++i)
+    {
+        if (i < capacity && !used[i])
+            ++run;
+        else if (run)
+        {
+            ++runCount;
+            if (run > largestRun)
+                largestRun = run;
+            run = 0;
+        }
+    }
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(BufferPool_SmallestBlockThatFits)
+{
+    OffsetAllocator allocator;
+    allocator.Reset(110);
+
+    CHECK(allocator.Allocate(10) == 0);
+    CHECK(allocator.Allocate(20) == 10);
+    CHECK(allocator.Allocate(30) == 30);
+    CHECK(allocator.Allocate(10) == 60);
+    CHECK(allocator.GetUsed() == 70);
+
+    // This leaves free blocks of 10, 30, and 40 with used space between them
+    allocator.Free(0, 10);
+    allocator.Free(30, 30);
+    CHECK(allocator.GetFreeBlockCount() == 3);
+    CHECK(allocator.GetLargestFreeBlock() == 40);
+
+    // Each block comes from the smallest free block it fits in, and the rest stays free
+    CHECK(allocator.Allocate(25) == 30);
+    CHECK(allocator.Allocate(8) == 0);
+    CHECK(allocator.Allocate(35) == 70);
+    CHECK(allocator.GetFreeBlockCount() == 3);
+    CHECK(allocator.GetLargestFreeBlock() == 5);
+    CHECK(allocator.GetUsed() == 110 - 2 - 5 - 5);
+}
+
+//*************************************************************************************************
+TEST(BufferPool_FreeJoinsNeighbors)
+{
+    OffsetAllocator allocator;
+    allocator.Reset(64);
+    for (unsigned i = 0; i < 4; ++i)
+        CHECK(allocator.Allocate(16) == i * 16);
+    CHECK(allocator.GetFreeBlockCount() == 0);
+    CHECK(allocator.GetLargestFreeBlock() == 0);
+
+    // Blocks that don't touch stay separate
+    allocator.Free(16, 16);
+    allocator.Free(48, 16);
+    CHECK(allocator.GetFreeBlockCount() == 2);
+    CHECK(allocator.GetLargestFreeBlock() == 16);
+
+    // A block between two free blocks joins both of them
+    allocator.Free(32, 16);
+    CHECK(allocator.GetFreeBlockCount() == 1);
+    CHECK(allocator.GetLargestFreeBlock() == 48);
+
+    allocator.Free(0, 16);
+    CHECK(allocator.GetFreeBlockCount() == 1);
+    CHECK(allocator.GetLargestFreeBlock() == 64);
+    CHECK(allocator.GetUsed() == 0);
+    CHECK(allocator.Allocate(64) == 0);
+}
+
+//*************************************************************************************************
+TEST(BufferPool_FailedAllocations)
+{
+    OffsetAllocator allocator;
+    allocator.Reset(100);
+    CHECK(allocator.Allocate(60) == 0);
+
+    // A failed allocation doesn't use any space
+    CHECK(allocator.Allocate(0) == OffsetAllocator::invalid_offset);
+    CHECK(allocator.Allocate(41) == OffsetAllocator::invalid_offset);
+    CHECK(allocator.GetUsed() == 60);
+    CHECK(allocator.Allocate(40) == 60);
+
+    // Resetting forgets every block, and an empty range has no free blocks
+    allocator.Reset(0);
+    CHECK(allocator.GetCapacity() == 0);
+    CHECK(allocator.GetUsed() == 0);
+    CHECK(allocator.GetFreeBlockCount() == 0);
+    CHECK(allocator.GetLargestFreeBlock() == 0);
+    CHECK(allocator.Allocate(1) == OffsetAllocator::invalid_offset);
+}
+
+//*************************************************************************************************
+TEST(BufferPool_RandomAllocateAndFree)
+{
+    const unsigned capacity = 4096;
+    OffsetAllocator allocator;
+    allocator.Reset(capacity);
+
+    std::vector<Block> blocks;
+    unsigned used = 0;
+    unsigned seed = 12345;
+    bool passed = true;
+
+    for (unsigned step = 0; step < 2000; ++step)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        unsigned random = seed >> 8;
+
+        // Allocate more often than freeing early on, so the range fills up and fragments
+        if (blocks.empty() || random % 10 < (step < 1000 ? 6u : 4u))
+        {
+            unsigned size = 1 + (random >> 4) % 64;
+            unsigned offset = allocator.Allocate(size);
+            if (offset != OffsetAllocator::invalid_offset)
+            {
+                blocks.push_back({ offset, size });
+                used += size;
+            }
+            // A failed allocation means no free block was large enough
+            else if (allocator.GetLargestFreeBlock() >= size)
+                passed = false;
+        }
+        else
+        {
+            unsigned index = (random >> 4) % blocks.size();
+            allocator.Free(blocks[index].first, blocks[index].second);
+            used -= blocks[index].second;
+            blocks[index] = blocks.back();
+            blocks.pop_back();
+        }
+
+        // Check the free blocks against the space the blocks don't cover
+        unsigned runCount, largestRun;
+        FindFreeRuns(blocks, capacity, runCount, largestRun);
+        if (!BlocksSeparate(blocks, capacity) || allocator.GetUsed() != used
+            || allocator.GetFreeBlockCount() != runCount
+            || allocator.GetLargestFreeBlock() != largestRun)
+            passed = false;
+    }
+    CHECK(passed);
+
+    // Freeing everything joins all of the space back into one block
+    while (!blocks.empty())
+    {
+        seed = seed * 1664525u + 1013904223u;
+        unsigned index = (seed >> 8) % blocks.size();
+        allocator.Free(blocks[index].first, blocks[index].second);
+        blocks[index] = blocks.back();
+        blocks.pop_back();
+    }
+    CHECK(allocator.GetUsed() == 0);
+    CHECK(allocator.GetFreeBlockCount() == 1);
+    CHECK(allocator.GetLargestFreeBlock() == capacity);
+    CHECK(allocator.Allocate(capacity) == 0);
+}
@@ -0,0 +1,145 @@
+//-------------------------------------------------------------------------------------------------
+// file:    ConstantTrackerTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for when the per-frame and per-object constant data is uploaded
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+
+import D3DInterface;
+
+using namespace DGL;
+
+namespace
+{
+
+//*************************************************************************************************
+// Checks the data the same way D3DInterface::UpdateConstantBuffer does, counting an upload for
+// each buffer that would be updated
+void Update(ConstantTracker& tracker, const cbPerObject& data, bool storedData)
+{
+    if (tracker.CheckPerFrame(data, storedData))
+        tracker.CountUpload(per_frame_size);
+    if (tracker.CheckPerObject(data, storedData))
+        tracker.CountUpload(per_object_size);
+    tracker.FinishUpdate(storedData);
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(ConstantTracker_StoredDataUploadedWhenChanged)
+{
+    ConstantTracker tracker;
+    cbPerObject stored;
+
+    // Nothing has been uploaded yet
+    CHECK(tracker.CheckPerFrame(stored, true));
+    CHECK(tracker.CheckPerObject(stored, true));
+    tracker.FinishUpdate(true);
+
+    // Nothing was set, so nothing is compared or uploaded
+    CHECK(!tracker.CheckPerFrame(stored, true));
+    CHECK(!tracker.CheckPerObject(stored, true));
+
+    // Setting the same values doesn't upload them again
+    tracker.SetPerObjectDirty();
+    CHECK(!tracker.CheckPerFrame(stored, true));
+    CHECK(!tracker.CheckPerObject(stored, true));
+    tracker.FinishUpdate(true);
+
+    // Changing the transform only uploads the per-object data
+    stored.mTransformMatrix.m[0][3] = 10.0f;
+    tracker.SetPerObjectDirty();
+    CHECK(!tracker.CheckPerFrame(stored, true));
+    CHECK(tracker.CheckPerObject(stored, true));
+    tracker.FinishUpdate(true);
+
+    // Changing the world matrix only uploads the per-frame data
+    stored.mWorldMatrix.m[0][0] = 2.0f;
+    tracker.SetPerFrameDirty();
+    CHECK(tracker.CheckPerFrame(stored, true));
+    CHECK(!tracker.CheckPerObject(stored, true));
+    tracker.FinishUpdate(true);
+
+    // Stored data that wasn't marked as changed isn't compared
+    stored.mAlpha = 0.5f;
+    CHECK(!tracker.CheckPerObject(stored, true));
+}
+
+//*************************************************************************************************
+TEST(ConstantTracker_OtherDataComparedEveryTime)
+{
+    ConstantTracker tracker;
+    cbPerObject stored;
+    Update(tracker, stored, true);
+
+    // A copy of the uploaded data, such as a batch's, is compared even though nothing was set
+    cbPerObject copy = stored;
+    CHECK(!tracker.CheckPerFrame(copy, false));
+    CHECK(!tracker.CheckPerObject(copy, false));
+    tracker.FinishUpdate(false);
+
+    copy.mTintColor.r = 1.0f;
+    CHECK(!tracker.CheckPerFrame(copy, false));
+    CHECK(tracker.CheckPerObject(copy, false));
+    tracker.FinishUpdate(false);
+
+    // After other data was uploaded the stored data is compared again, and only the part that
+    // differs is uploaded
+    CHECK(!tracker.CheckPerFrame(stored, true));
+    CHECK(tracker.CheckPerObject(stored, true));
+}
+
+//*************************************************************************************************
+TEST(ConstantTracker_ForgetUploadsAgain)
+{
+    ConstantTracker tracker;
+    cbPerObject stored;
+    Update(tracker, stored, true);
+
+    // Per-object data written into the dynamic buffer is reused after a few frames, so it is
+    // forgotten and written again even when it hasn't changed
+    tracker.ForgetPerObject();
+    CHECK(!tracker.CheckPerFrame(stored, true));
+    CHECK(tracker.CheckPerObject(stored, true));
+    tracker.FinishUpdate(true);
+
+    // New buffers have nothing in them
+    tracker.Reset();
+    CHECK(tracker.CheckPerFrame(stored, true));
+    CHECK(tracker.CheckPerObject(stored, true));
+}
+
+//*************************************************************************************************
+TEST(ConstantTracker_Counters)
+{
+    ConstantTracker tracker;
+    cbPerObject stored;
+
+    // A frame of draws with the same world matrix, where every other draw moves the object
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        if (i % 2 == 0)
+        {
+            stored.mTransformMatrix.m[0][3] = (float)i;
+            tracker.SetPerObjectDirty();
+        }
+        Update(tracker, stored, true);
+    }
+
+    CHECK(tracker.GetUploadCount() == 1 + 50);
+    CHECK(tracker.GetUploadBytes() == per_frame_size + 50 * per_object_size);
+
+    tracker.ResetCounters();
+    CHECK(tracker.GetUploadCount() == 0);
+    CHECK(tracker.GetUploadBytes() == 0);
+
+    // Resetting the counters doesn't forget the uploaded data
+    Update(tracker, stored, true);
+    CHECK(tracker.GetUploadCount() == 0);
+}
@@ -0,0 +1,140 @@
+//-------------------------------------------------------------------------------------------------
+// file:    CullingTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for mesh bounds and which boxes the camera can see
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <math.h>
+#include <vector>
+
+import Camera;
+import Math;
+import Mesh;
+
+using namespace DGL;
+
+namespace
+{
+
+// A box the size of one unit, centered on the origin like the default square mesh
+const DGL_Vec2 unit_min = { -0.5f, -0.5f };
+const DGL_Vec2 unit_max = { 0.5f, 0.5f };
+
+const float half_pi{ 1.5707964f };
+
+//*************************************************************************************************
+// Returns a camera at the origin which shows an 800 by 600 area
+CameraObject MakeCamera()
+{
+    CameraObject camera;
+    camera.SetViewSize({ 800.0f, 600.0f });
+    return camera;
+}
+
+//*************************************************************************************************
+// Returns true if the camera can see the unit box after it is scaled, rotated, and moved
+bool CanSee(const CameraObject& camera, const DGL_Vec2& position, const DGL_Vec2& scale,
+    float angle)
+{
+    return camera.IsVisible(unit_min, unit_max,
+        Affine_Compose(position, scale, sinf(angle), cosf(angle)));
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(Culling_CalculateBounds)
+{
+    std::vector<VertexData> vertices(5);
+    const DGL_Vec2 positions[] = { { 1.0f, 2.0f }, { -3.0f, 0.5f }, { 4.0f, -1.0f },
+        { 0.0f, 6.0f }, { 2.0f, 2.0f } };
+    for (unsigned i = 0; i < vertices.size(); ++i)
+        vertices[i].mPosition = positions[i];
+
+    DGL_MeshBounds bounds;
+    MeshManager::CalculateBounds(vertices.data(), (unsigned)vertices.size(), bounds);
+
+    CHECK(bounds.mMin.x == -3.0f && bounds.mMin.y == -1.0f);
+    CHECK(bounds.mMax.x == 4.0f && bounds.mMax.y == 6.0f);
+    CHECK(bounds.mCenter.x == 0.5f && bounds.mCenter.y == 2.5f);
+
+    // The circle reaches the farthest vertex and contains all of them
+    float farthest = 0.0f;
+    for (const VertexData& vertex : vertices)
+    {
+        float x = vertex.mPosition.x - bounds.mCenter.x;
+        float y = vertex.mPosition.y - bounds.mCenter.y;
+        farthest = fmaxf(farthest, sqrtf(x * x + y * y));
+    }
+    CHECK(bounds.mRadius == farthest);
+
+    // A single vertex has no size
+    MeshManager::CalculateBounds(vertices.data(), 1, bounds);
+    CHECK(bounds.mMin.x == 1.0f && bounds.mMax.x == 1.0f);
+    CHECK(bounds.mMin.y == 2.0f && bounds.mMax.y == 2.0f);
+    CHECK(bounds.mRadius == 0.0f);
+}
+
+//*************************************************************************************************
+TEST(Culling_VisibleAtEdges)
+{
+    CameraObject camera = MakeCamera();
+
+    // The camera shows X values from -400 to 400 and Y values from -300 to 300. A box which
+    // only touches the edge counts as visible.
+    CHECK(CanSee(camera, { 0.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(CanSee(camera, { 405.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(!CanSee(camera, { 406.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(CanSee(camera, { 0.0f, -305.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(!CanSee(camera, { 0.0f, -306.0f }, { 10.0f, 10.0f }, 0.0f));
+
+    // A box larger than the view is visible even though none of its corners are
+    CHECK(CanSee(camera, { 0.0f, 0.0f }, { 5000.0f, 5000.0f }, 0.0f));
+
+    // Moving the camera moves the visible area
+    camera.SetCameraPosition({ 1000.0f, 0.0f });
+    CHECK(!CanSee(camera, { 0.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(CanSee(camera, { 1300.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+}
+
+//*************************************************************************************************
+TEST(Culling_VisibleWithZoom)
+{
+    CameraObject camera = MakeCamera();
+
+    // Zooming out shows a larger area
+    camera.SetCameraZoom(2.0f);
+    CHECK(CanSee(camera, { 790.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(!CanSee(camera, { 810.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+
+    // Zooming in shows a smaller area
+    camera.SetCameraZoom(0.5f);
+    CHECK(CanSee(camera, { 0.0f, 140.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(!CanSee(camera, { 0.0f, 160.0f }, { 10.0f, 10.0f }, 0.0f));
+}
+
+//*************************************************************************************************
+TEST(Culling_VisibleWithRotation)
+{
+    CameraObject camera = MakeCamera();
+
+    // A long, thin box just past the top edge is only visible once it is turned to stand up
+    CHECK(!CanSee(camera, { 0.0f, 310.0f }, { 400.0f, 2.0f }, 0.0f));
+    CHECK(CanSee(camera, { 0.0f, 310.0f }, { 400.0f, 2.0f }, half_pi));
+
+    // Turning the camera swaps the width and height of the visible area, so a box which is
+    // inside the view horizontally is outside it vertically
+    CHECK(CanSee(camera, { 350.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+    camera.SetCameraRotation(half_pi);
+    CHECK(!CanSee(camera, { 350.0f, 0.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(CanSee(camera, { 0.0f, 350.0f }, { 10.0f, 10.0f }, 0.0f));
+
+    // The camera rotates around its own position
+    camera.SetCameraPosition({ 1000.0f, 1000.0f });
+    CHECK(CanSee(camera, { 1000.0f, 1350.0f }, { 10.0f, 10.0f }, 0.0f));
+    CHECK(!CanSee(camera, { 1350.0f, 1000.0f }, { 10.0f, 10.0f }, 0.0f));
+}
@@ -0,0 +1,127 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DDSTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for writing DDS files and reading them back
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <stdio.h>
+#include <vector>
+
+import DDS;
+import Mipmap;
+
+using namespace DGL;
+
+namespace
+{
+
+// The file written by the tests, which is deleted afterward
+const char* const test_file = "DDSTests.dds";
+
+//*************************************************************************************************
+// Returns levels for a full chain of the format starting at the size, with repeatable bytes
+std::vector<MipLevel> MakeLevels(DXGI_FORMAT format, int width, int height)
+{
+    std::vector<MipLevel> levels(MipmapGenerator::GetLevelCount(width, height));
+    unsigned char value = 0;
+    for (MipLevel& level : levels)
+    {
+        level.mWidth = width;
+        level.mHeight = height;
+        level.mPixels.resize(MipmapGenerator::GetLevelBytes(format, width, height));
+        for (unsigned char& byte : level.mPixels)
+            byte = value++;
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return levels;
+}
+
+//*************************************************************************************************
+// Writes the levels and reads them back, returning true if they match
+bool WriteAndRead(const std::vector<MipLevel>& levels, DXGI_FORMAT format)
+{
+    if (FAILED(DDSFile::Write(test_file, levels, format)))
+        return false;
+
+    std::vector<MipLevel> read;
+    DXGI_FORMAT readFormat = DXGI_FORMAT_UNKNOWN;
+    HRESULT result = DDSFile::Read(test_file, read, readFormat);
+    remove(test_file);
+    if (FAILED(result) || readFormat != format || read.size() != levels.size())
+        return false;
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        if (read[i].mWidth != levels[i].mWidth || read[i].mHeight != levels[i].mHeight ||
+            read[i].mPixels != levels[i].mPixels)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(DDS_IsDDSFile)
+{
+    CHECK(DDSFile::IsDDSFile("Assets/sprite.dds"));
+    CHECK(DDSFile::IsDDSFile("SPRITE.DDS"));
+    CHECK(!DDSFile::IsDDSFile("sprite.png"));
+    CHECK(!DDSFile::IsDDSFile("dds"));
+}
+
+//*************************************************************************************************
+TEST(DDS_WriteAndRead)
+{
+    // RGBA, BC1, and BC3 use the original header, and BC7 adds the DX10 header
+    const DXGI_FORMAT formats[4] = { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM,
+        DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC7_UNORM };
+    for (DXGI_FORMAT format : formats)
+    {
+        CHECK(WriteAndRead(MakeLevels(format, 16, 8), format));
+
+        // A single level without the mipmap count
+        std::vector<MipLevel> levels = MakeLevels(format, 4, 4);
+        levels.resize(1);
+        CHECK(WriteAndRead(levels, format));
+    }
+
+    // The smallest block compressed levels are still whole blocks
+    std::vector<MipLevel> levels = MakeLevels(DXGI_FORMAT_BC1_UNORM, 8, 4);
+    CHECK(levels.back().mWidth == 1 && levels.back().mPixels.size() == 8);
+    CHECK(WriteAndRead(levels, DXGI_FORMAT_BC1_UNORM));
+}
+
+//*************************************************************************************************
+TEST(DDS_ReadChecksHeader)
+{
+    std::vector<MipLevel> levels = MakeLevels(DXGI_FORMAT_R8G8B8A8_UNORM, 4, 4);
+    CHECK(SUCCEEDED(DDSFile::Write(test_file, levels, DXGI_FORMAT_R8G8B8A8_UNORM)));
+
+    // Change the magic number at the start of the file
+    FILE* file = fopen(test_file, "r+b");
+    CHECK(file);
+    if (file)
+    {
+        fputc('X', file);
+        fclose(file);
+    }
+
+    std::vector<MipLevel> read;
+    DXGI_FORMAT format;
+    CHECK(FAILED(DDSFile::Read(test_file, read, format)));
+    remove(test_file);
+
+    // The file is missing
+    CHECK(FAILED(DDSFile::Read(test_file, read, format)));
+
+    // There are no levels to write
+    CHECK(FAILED(DDSFile::Write(test_file, {}, DXGI_FORMAT_R8G8B8A8_UNORM)));
+}
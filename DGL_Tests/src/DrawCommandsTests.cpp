@@ -0,0 +1,112 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DrawCommandsTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for the order recorded draws are replayed in
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <vector>
+
+import D3DInterface;
+import DrawCommands;
+
+using namespace DGL;
+
+namespace
+{
+
+// Records the mesh of each command instead of drawing it
+class RecordingBackend : public CommandBackend
+{
+public:
+    void ExecuteCommand(const DrawCommand& command, const DrawState&) override
+    {
+        mMeshes.push_back(command.mMesh);
+    }
+
+    std::vector<const DGL_Mesh*> mMeshes;
+};
+
+// The meshes and textures are only compared, so any distinct addresses will do
+int gObjects[8];
+const DGL_Mesh* const gMeshes[4] = {
+    (const DGL_Mesh*)&gObjects[0], (const DGL_Mesh*)&gObjects[1],
+    (const DGL_Mesh*)&gObjects[2], (const DGL_Mesh*)&gObjects[3] };
+const DGL_Texture* const gTexture1 = (const DGL_Texture*)&gObjects[4];
+const DGL_Texture* const gTexture2 = (const DGL_Texture*)&gObjects[5];
+
+//*************************************************************************************************
+DrawState MakeState(const DGL_Texture* texture, DGL_BlendMode blendMode, float zValue)
+{
+    DrawState state;
+    state.mTexture = texture;
+    state.mBlendMode = blendMode;
+    state.mConstantBuffer.mTransformMatrix.m[2][3] = zValue;
+    return state;
+}
+
+//*************************************************************************************************
+std::vector<const DGL_Mesh*> SortAndReplay(DrawCommandBuffer& commands)
+{
+    RecordingBackend backend;
+    commands.Sort();
+    commands.Replay(backend);
+    return backend.mMeshes;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(DrawCommands_SameZGroupedByTexture)
+{
+    DrawCommandBuffer commands;
+    commands.Record(gMeshes[0], DGL_DM_TRIANGLELIST, MakeState(gTexture1, DGL_BM_NONE, 0.0f));
+    commands.Record(gMeshes[1], DGL_DM_TRIANGLELIST, MakeState(gTexture2, DGL_BM_NONE, 0.0f));
+    commands.Record(gMeshes[2], DGL_DM_TRIANGLELIST, MakeState(gTexture1, DGL_BM_NONE, 0.0f));
+
+    std::vector<const DGL_Mesh*> order = SortAndReplay(commands);
+    CHECK(order.size() == 3);
+    CHECK(order[0] == gMeshes[0]);
+    CHECK(order[1] == gMeshes[2]);
+    CHECK(order[2] == gMeshes[1]);
+}
+
+//*************************************************************************************************
+TEST(DrawCommands_OpaqueFrontToBack)
+{
+    // The texture would put these in the opposite order if it came before the Z value
+    DrawCommandBuffer commands;
+    commands.Record(gMeshes[0], DGL_DM_TRIANGLELIST, MakeState(gTexture2, DGL_BM_NONE, 0.5f));
+    commands.Record(gMeshes[1], DGL_DM_TRIANGLELIST, MakeState(gTexture1, DGL_BM_NONE, 0.5f));
+    commands.Record(gMeshes[2], DGL_DM_TRIANGLELIST, MakeState(gTexture2, DGL_BM_NONE, -0.5f));
+    commands.Record(gMeshes[3], DGL_DM_TRIANGLELIST, MakeState(gTexture1, DGL_BM_NONE, 0.0f));
+
+    std::vector<const DGL_Mesh*> order = SortAndReplay(commands);
+    CHECK(order.size() == 4);
+    CHECK(order[0] == gMeshes[2]);
+    CHECK(order[1] == gMeshes[3]);
+    CHECK(order[2] == gMeshes[0]);
+    CHECK(order[3] == gMeshes[1]);
+}
+
+//*************************************************************************************************
+TEST(DrawCommands_TransparentBackToFront)
+{
+    DrawCommandBuffer commands;
+    commands.Record(gMeshes[0], DGL_DM_TRIANGLELIST, MakeState(gTexture1, DGL_BM_BLEND, 0.0f));
+    commands.Record(gMeshes[1], DGL_DM_TRIANGLELIST, MakeState(gTexture1, DGL_BM_BLEND, 0.5f));
+    commands.Record(gMeshes[2], DGL_DM_TRIANGLELIST, MakeState(gTexture2, DGL_BM_BLEND, 0.0f));
+    commands.Record(gMeshes[3], DGL_DM_TRIANGLELIST, MakeState(gTexture1, DGL_BM_NONE, 1.0f));
+
+    // Opaque draws come first, and blended draws with the same Z value keep their order
+    std::vector<const DGL_Mesh*> order = SortAndReplay(commands);
+    CHECK(order.size() == 4);
+    CHECK(order[0] == gMeshes[3]);
+    CHECK(order[1] == gMeshes[1]);
+    CHECK(order[2] == gMeshes[0]);
+    CHECK(order[3] == gMeshes[2]);
+}
@@ -0,0 +1,181 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DynamicMeshTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for which copy of a dynamic mesh each update writes, and how updates are checked
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <string.h>
+#include <vector>
+
+import Mesh;
+
+using namespace DGL;
+
+namespace
+{
+
+// The number of vertices each copy of the test mesh can hold
+const unsigned test_capacity{ 8 };
+
+// Writes into memory instead of a vertex buffer, and records how it was mapped
+class RecordingMapContext : public MapContext
+{
+public:
+    RecordingMapContext() : mMemory((size_t)test_capacity * MeshManager::dynamic_copies) {}
+
+    HRESULT Map(ID3D11Buffer* buffer, D3D11_MAP mapType,
+        D3D11_MAPPED_SUBRESOURCE* mappedResource) override
+    {
+        mMapTypes.push_back(mapType);
+        ++mMapped;
+        mappedResource->pData = mMemory.data();
+        mappedResource->RowPitch = 0;
+        mappedResource->DepthPitch = 0;
+        return S_OK;
+    }
+
+    void Unmap(ID3D11Buffer* buffer) override
+    {
+        --mMapped;
+    }
+
+    // The vertex buffer, holding every copy
+    std::vector<VertexData> mMemory;
+    // The way each Map call asked for the buffer
+    std::vector<D3D11_MAP> mMapTypes;
+    // The number of Map calls without an Unmap
+    int mMapped{ 0 };
+};
+
+//*************************************************************************************************
+// Sets up the mesh the same way CreateDynamicMesh does, without a vertex buffer
+void FillDynamicMesh(DGL_Mesh& mesh)
+{
+    mesh.mDynamicCapacity = test_capacity;
+    mesh.mDynamicCopy = MeshManager::dynamic_copies - 1;
+    mesh.mVertexList = new VertexData[test_capacity];
+}
+
+//*************************************************************************************************
+DGL_Vec2 TestPosition(unsigned i)
+{
+    return { (float)i, (float)i * -2.0f };
+}
+
+//*************************************************************************************************
+// Returns true if the copy in the buffer holds the mesh's vertices
+bool CopyMatches(const RecordingMapContext& context, const DGL_Mesh& mesh, unsigned copy)
+{
+    return memcmp(&context.mMemory[(size_t)copy * test_capacity], mesh.mVertexList,
+        sizeof(VertexData) * mesh.mVertexCount) == 0;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(DynamicMesh_CopiesRotate)
+{
+    DGL_Mesh mesh;
+    FillDynamicMesh(mesh);
+    RecordingMapContext context;
+
+    DGL_Vec2 positions[test_capacity];
+    for (unsigned update = 0; update < 7; ++update)
+    {
+        for (unsigned i = 0; i < test_capacity; ++i)
+            positions[i] = TestPosition(i + update);
+        CHECK(MeshManager::UpdateMesh(&mesh, positions, nullptr, nullptr, test_capacity, 0,
+            &context));
+
+        // Each update writes the next copy and draws from it. Only wrapping around to the
+        // first copy discards the buffer, so the copies the graphics card might still be
+        // reading are never written over.
+        unsigned copy = update % MeshManager::dynamic_copies;
+        CHECK(mesh.mDynamicCopy == copy);
+        CHECK(mesh.mBaseVertex == copy * test_capacity);
+        CHECK(context.mMapTypes[update]
+            == (copy == 0 ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE));
+        CHECK(CopyMatches(context, mesh, copy));
+        CHECK(context.mMapped == 0);
+    }
+    CHECK(context.mMapTypes.size() == 7);
+
+    delete[] mesh.mVertexList;
+}
+
+//*************************************************************************************************
+TEST(DynamicMesh_PartialUpdates)
+{
+    DGL_Mesh mesh;
+    FillDynamicMesh(mesh);
+    RecordingMapContext context;
+
+    DGL_Vec2 positions[4] = { TestPosition(0), TestPosition(1), TestPosition(2), TestPosition(3) };
+    DGL_Color colors[4] = { { 1, 0, 0, 1 }, { 0, 1, 0, 1 }, { 0, 0, 1, 1 }, { 1, 1, 0, 1 } };
+    MeshManager::UpdateMesh(&mesh, positions, colors, nullptr, 4, 0, &context);
+    CHECK(mesh.mVertexCount == 4);
+
+    // Vertices before the offset are kept, and the whole mesh is written into the next copy
+    DGL_Vec2 newPositions[2] = { TestPosition(10), TestPosition(11) };
+    MeshManager::UpdateMesh(&mesh, newPositions, nullptr, nullptr, 2, 2, &context);
+    CHECK(mesh.mVertexCount == 4);
+    CHECK(mesh.mVertexList[1].mPosition.x == TestPosition(1).x);
+    CHECK(mesh.mVertexList[1].mColor.g == 1.0f);
+    CHECK(mesh.mVertexList[2].mPosition.x == TestPosition(10).x);
+    CHECK(mesh.mVertexList[2].mColor.r == MeshManager::default_color.r);
+    CHECK(CopyMatches(context, mesh, 1));
+
+    // The bounds cover the new positions
+    CHECK(mesh.mBounds.mMax.x == TestPosition(11).x);
+    CHECK(mesh.mBounds.mMin.y == TestPosition(11).y);
+
+    // Vertices after the new ones are removed
+    MeshManager::UpdateMesh(&mesh, newPositions, nullptr, nullptr, 1, 1, &context);
+    CHECK(mesh.mVertexCount == 2);
+    CHECK(mesh.mBounds.mMax.x == TestPosition(10).x);
+
+    // Removing every vertex clears the bounds
+    MeshManager::UpdateMesh(&mesh, nullptr, nullptr, nullptr, 0, 0, &context);
+    CHECK(mesh.mVertexCount == 0);
+    CHECK(mesh.mBounds.mRadius == 0.0f);
+    CHECK(mesh.mBounds.mMax.x == 0.0f);
+
+    delete[] mesh.mVertexList;
+}
+
+//*************************************************************************************************
+TEST(DynamicMesh_CheckUpdate)
+{
+    DGL_Mesh mesh;
+    FillDynamicMesh(mesh);
+    mesh.mVertexCount = 4;
+    DGL_Vec2 positions[test_capacity] = {};
+
+    // Updates can replace any vertices, add to the end, or fill the whole capacity
+    CHECK(!MeshManager::CheckUpdate(&mesh, positions, 4, 0));
+    CHECK(!MeshManager::CheckUpdate(&mesh, positions, 2, 4));
+    CHECK(!MeshManager::CheckUpdate(&mesh, positions, test_capacity, 0));
+    CHECK(!MeshManager::CheckUpdate(&mesh, positions, test_capacity - 4, 4));
+
+    // Removing everything doesn't need any positions
+    CHECK(!MeshManager::CheckUpdate(&mesh, nullptr, 0, 0));
+    CHECK(MeshManager::CheckUpdate(&mesh, nullptr, 1, 0));
+    CHECK(MeshManager::CheckUpdate(nullptr, positions, 1, 0));
+
+    // An offset past the last vertex would leave a gap, and vertices can't go past the capacity
+    CHECK(MeshManager::CheckUpdate(&mesh, positions, 1, 5));
+    CHECK(MeshManager::CheckUpdate(&mesh, positions, test_capacity - 3, 4));
+    CHECK(MeshManager::CheckUpdate(&mesh, positions, test_capacity + 1, 0));
+    CHECK(MeshManager::CheckUpdate(&mesh, positions, 0xFFFFFFFF, 4));
+
+    // Only dynamic meshes can be updated
+    mesh.mDynamicCapacity = 0;
+    CHECK(MeshManager::CheckUpdate(&mesh, positions, 1, 0));
+
+    delete[] mesh.mVertexList;
+}
@@ -0,0 +1,144 @@
+//-------------------------------------------------------------------------------------------------
+// file:    InstancingTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for packing instance data and growing the instance buffer
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <math.h>
+#include <stddef.h>
+#include <vector>
+
+import Instancing;
+
+using namespace DGL;
+
+namespace
+{
+
+// SinCos_Array is an approximation, so the packed values are compared with a tolerance
+constexpr float tolerance{ 0.0001f };
+
+//*************************************************************************************************
+bool Near(float value, float expected)
+{
+    return fabsf(value - expected) <= tolerance * (1.0f + fabsf(expected));
+}
+
+//*************************************************************************************************
+DGL_InstanceData MakeInstance(float value)
+{
+    DGL_InstanceData instance;
+    instance.mPosition = { value * 3.0f, -value };
+    instance.mScale = { 2.0f + value, 5.0f };
+    instance.mRotation = value * 0.37f - 10.0f;
+    instance.mZValue = value * 0.01f;
+    instance.mTintColor = { 0.1f, 0.2f, 0.3f, value };
+    instance.mTextureOffset = { value * 0.5f, 0.25f };
+    instance.mAlpha = 0.75f;
+    instance.mShaderData = value + 100.0f;
+    return instance;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(Instancing_CapacityGrowth)
+{
+    // The buffer is kept while it is large enough
+    CHECK(GetInstanceCapacity(0, 0) == 0);
+    CHECK(GetInstanceCapacity(256, 1) == 256);
+    CHECK(GetInstanceCapacity(512, 512) == 512);
+
+    // A new buffer starts at the minimum size
+    CHECK(GetInstanceCapacity(0, 1) == InstanceBuffer::min_capacity);
+    CHECK(GetInstanceCapacity(0, InstanceBuffer::min_capacity) == InstanceBuffer::min_capacity);
+
+    // Then doubles until it fits, whatever the current size is
+    CHECK(GetInstanceCapacity(0, 257) == 512);
+    CHECK(GetInstanceCapacity(256, 257) == 512);
+    CHECK(GetInstanceCapacity(512, 1000) == 1024);
+    CHECK(GetInstanceCapacity(300, 5000) == 8192);
+    CHECK(GetInstanceCapacity(1024, 65537) == 131072);
+}
+
+//*************************************************************************************************
+TEST(Instancing_PackedLayout)
+{
+    // This must match the instance input layout in D3DInterface and VertexShaderInstanced.hlsl
+    CHECK(sizeof(InstanceVertexData) == 64);
+    CHECK(offsetof(InstanceVertexData, mTransformX) == 0);
+    CHECK(offsetof(InstanceVertexData, mTransformY) == 16);
+    CHECK(offsetof(InstanceVertexData, mTintColor) == 32);
+    CHECK(offsetof(InstanceVertexData, mTexOffset) == 48);
+    CHECK(offsetof(InstanceVertexData, mShaderData) == 56);
+}
+
+//*************************************************************************************************
+TEST(Instancing_PackTransform)
+{
+    // No rotation leaves just the scale and position
+    DGL_InstanceData instance = MakeInstance(1.0f);
+    instance.mRotation = 0.0f;
+    InstanceVertexData packed;
+    PackInstances(&instance, 1, &packed);
+
+    CHECK(Near(packed.mTransformX[0], 3.0f));
+    CHECK(Near(packed.mTransformX[1], 0.0f));
+    CHECK(packed.mTransformX[2] == 3.0f);
+    CHECK(packed.mTransformX[3] == 0.01f);
+    CHECK(Near(packed.mTransformY[0], 0.0f));
+    CHECK(Near(packed.mTransformY[1], 5.0f));
+    CHECK(packed.mTransformY[2] == -1.0f);
+    CHECK(packed.mTransformY[3] == 0.75f);
+
+    // A quarter turn moves X onto Y and Y onto -X
+    instance.mRotation = 1.570796327f;
+    PackInstances(&instance, 1, &packed);
+
+    CHECK(Near(packed.mTransformX[0], 0.0f));
+    CHECK(Near(packed.mTransformX[1], -5.0f));
+    CHECK(Near(packed.mTransformY[0], 3.0f));
+    CHECK(Near(packed.mTransformY[1], 0.0f));
+}
+
+//*************************************************************************************************
+TEST(Instancing_PackMatchesInstances)
+{
+    // Enough instances to use more than one group of angles, with a partial last group
+    std::vector<DGL_InstanceData> instances;
+    for (unsigned i = 0; i < 150; ++i)
+        instances.push_back(MakeInstance((float)i));
+
+    std::vector<InstanceVertexData> packed(instances.size());
+    PackInstances(instances.data(), (unsigned)instances.size(), packed.data());
+
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        const DGL_InstanceData& instance = instances[i];
+        const InstanceVertexData& result = packed[i];
+        float sinAngle = sinf(instance.mRotation);
+        float cosAngle = cosf(instance.mRotation);
+
+        CHECK(Near(result.mTransformX[0], cosAngle * instance.mScale.x));
+        CHECK(Near(result.mTransformX[1], -sinAngle * instance.mScale.y));
+        CHECK(result.mTransformX[2] == instance.mPosition.x);
+        CHECK(result.mTransformX[3] == instance.mZValue);
+        CHECK(Near(result.mTransformY[0], sinAngle * instance.mScale.x));
+        CHECK(Near(result.mTransformY[1], cosAngle * instance.mScale.y));
+        CHECK(result.mTransformY[2] == instance.mPosition.y);
+        CHECK(result.mTransformY[3] == instance.mAlpha);
+
+        CHECK(result.mTintColor.r == instance.mTintColor.r);
+        CHECK(result.mTintColor.g == instance.mTintColor.g);
+        CHECK(result.mTintColor.b == instance.mTintColor.b);
+        CHECK(result.mTintColor.a == instance.mTintColor.a);
+        CHECK(result.mTexOffset.x == instance.mTextureOffset.x);
+        CHECK(result.mTexOffset.y == instance.mTextureOffset.y);
+        CHECK(result.mShaderData == instance.mShaderData);
+        CHECK(result.mPadding == 0.0f);
+    }
+}
@@ -0,0 +1,601 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MathTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests comparing each version of the array math functions to plain C++
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+import Math;
+import Mesh;
+
+using namespace DGL;
+
+namespace
+{
+
+// Every instruction set, so each test runs once for each one the CPU supports
+const MathKernelLevel gLevels[] = { MathKernelLevel::Scalar, MathKernelLevel::SSE2,
+    MathKernelLevel::AVX };
+
+// Lengths which cover empty arrays, arrays shorter than one SIMD register, and every
+// number of values left over after the SIMD loops
+const unsigned gCounts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 100 };
+
+//*************************************************************************************************
+// Goes back to the fastest instruction set, like the library does on its own
+void UseBestLevel()
+{
+    if (!Math_SetKernelLevel(MathKernelLevel::AVX))
+        Math_SetKernelLevel(MathKernelLevel::SSE2);
+}
+
+//*************************************************************************************************
+// Returns a repeatable value between -range and range
+float TestValue(unsigned i, float range)
+{
+    return range * sinf(i * 12.9898f + 78.233f);
+}
+
+//*************************************************************************************************
+bool Near(float value, float expected, float tolerance)
+{
+    return fabsf(value - expected) <= tolerance * (1.0f + fabsf(expected));
+}
+
+//*************************************************************************************************
+DGL_Mat4 MakeMatrix(unsigned seed)
+{
+    DGL_Mat4 matrix;
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int column = 0; column < 4; ++column)
+            matrix.m[row][column] = TestValue(seed + row * 4 + column, 10.0f);
+    }
+    return matrix;
+}
+
+//*************************************************************************************************
+// Builds the draw transform the way it was built before Affine_Compose, by multiplying
+// translation, rotation, and scale matrices
+DGL_Mat4 MultiplyTransform(const DGL_Vec2& position, const DGL_Vec2& scale, float angle,
+    float zValue)
+{
+    DGL_Mat4 scaleMatrix;
+    Matrix_SetToIdentity(scaleMatrix);
+    scaleMatrix.m[0][0] = scale.x;
+    scaleMatrix.m[1][1] = scale.y;
+
+    DGL_Mat4 translationMatrix;
+    Matrix_SetToIdentity(translationMatrix);
+    translationMatrix.m[0][3] = position.x;
+    translationMatrix.m[1][3] = position.y;
+    translationMatrix.m[2][3] = zValue;
+
+    return Matrix_Multiply(Matrix_Multiply(translationMatrix, Matrix_RotateZ(angle)), scaleMatrix);
+}
+
+//*************************************************************************************************
+// Returns the float for the bits of a 16-bit float
+float DecodeHalf(uint32_t bits)
+{
+    uint32_t exponent = (bits >> 10) & 0x1f;
+    float mantissa = (float)(bits & 0x3ff);
+    float value = exponent ? ldexpf(1024.0f + mantissa, (int)exponent - 25) :
+        ldexpf(mantissa, -24);
+    return (bits & 0x8000) ? -value : value;
+}
+
+//*************************************************************************************************
+// Returns the 8-bit channel of the packed color, as a value between 0 and 1
+float DecodeUnorm8(uint32_t color, int channel)
+{
+    return ((color >> (channel * 8)) & 0xff) / 255.0f;
+}
+
+//*************************************************************************************************
+float Saturate(float value)
+{
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+//*************************************************************************************************
+// Returns vertices with a mix of colors, including channels outside of 0 to 1, and texture
+// coordinates between -range and range. An odd count leaves values after the SIMD loops.
+std::vector<VertexData> MakeVertices(float texCoordRange)
+{
+    std::vector<VertexData> vertices(37);
+    for (unsigned i = 0; i < vertices.size(); ++i)
+    {
+        vertices[i].mPosition = { TestValue(i, 100.0f), TestValue(i + 50, 100.0f) };
+        vertices[i].mColor = { TestValue(i * 4, 0.7f) + 0.5f, TestValue(i * 4 + 1, 0.5f) + 0.5f,
+            TestValue(i * 4 + 2, 0.5f) + 0.5f, TestValue(i * 4 + 3, 0.5f) + 0.5f };
+        vertices[i].mTexCoord = { TestValue(i * 2, texCoordRange),
+            TestValue(i * 2 + 1, texCoordRange) };
+    }
+
+    // Values at the edges of each format
+    vertices[0].mColor = { 0.0f, 1.0f, 0.5f, 1.0f / 510.0f };
+    vertices[1].mTexCoord = { 0.0f, texCoordRange };
+    vertices[2].mTexCoord = { 0.00001f, 1.0f / 3.0f };
+    return vertices;
+}
+
+//*************************************************************************************************
+// Checks that each packed color is within half of an 8-bit step of the clamped color
+void CheckColors(const std::vector<VertexData>& vertices, const uint32_t* colors, unsigned stride)
+{
+    for (unsigned i = 0; i < vertices.size(); ++i)
+    {
+        uint32_t color;
+        memcpy(&color, (const char*)colors + i * stride, sizeof(color));
+        const DGL_Color& expected = vertices[i].mColor;
+        CHECK(fabsf(DecodeUnorm8(color, 0) - Saturate(expected.r)) <= 0.5f / 255.0f + 1e-6f);
+        CHECK(fabsf(DecodeUnorm8(color, 1) - Saturate(expected.g)) <= 0.5f / 255.0f + 1e-6f);
+        CHECK(fabsf(DecodeUnorm8(color, 2) - Saturate(expected.b)) <= 0.5f / 255.0f + 1e-6f);
+        CHECK(fabsf(DecodeUnorm8(color, 3) - Saturate(expected.a)) <= 0.5f / 255.0f + 1e-6f);
+    }
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(Math_MatrixMultiply)
+{
+    DGL_Mat4 first = MakeMatrix(0);
+    DGL_Mat4 second = MakeMatrix(16);
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        DGL_Mat4 result = Matrix_Multiply(first, second);
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                float expected = 0.0f;
+                for (int i = 0; i < 4; ++i)
+                    expected += first.m[row][i] * second.m[i][column];
+                CHECK(Near(result.m[row][column], expected, 1e-5f));
+            }
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_AffineComposeMatchesMatrices)
+{
+    // Angles in every quadrant, and scales that are negative, zero, and uneven
+    const float angles[] = { 0.0f, 0.5f, 1.5707964f, 3.0f, -2.0f, 10.0f };
+    const DGL_Vec2 scales[] = { { 1.0f, 1.0f }, { 40.0f, 10.0f }, { -3.0f, 0.25f },
+        { 0.0f, 5.0f } };
+    const DGL_Vec2 position = { -120.0f, 75.5f };
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        for (float angle : angles)
+        {
+            for (const DGL_Vec2& scale : scales)
+            {
+                DGL_Mat4 expected = MultiplyTransform(position, scale, angle, 3.0f);
+                DGL_Mat4 result = Affine_ToMatrix(
+                    Affine_Compose(position, scale, sinf(angle), cosf(angle)), 3.0f);
+
+                for (int row = 0; row < 4; ++row)
+                {
+                    for (int column = 0; column < 4; ++column)
+                        CHECK(Near(result.m[row][column], expected.m[row][column], 1e-5f));
+                }
+            }
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_CachedRotation)
+{
+    CachedRotation rotation;
+    CHECK(rotation.GetSin() == 0.0f);
+    CHECK(rotation.GetCos() == 1.0f);
+
+    rotation.SetAngle(1.0f);
+    CHECK(rotation.GetSin() == sinf(1.0f));
+    CHECK(rotation.GetCos() == cosf(1.0f));
+
+    rotation.SetAngle(-2.5f);
+    CHECK(rotation.GetSin() == sinf(-2.5f));
+    CHECK(rotation.GetCos() == cosf(-2.5f));
+
+    // -0 compares equal to the starting angle of 0, so the values aren't calculated again.
+    // If they were, the sine would be -0.
+    CachedRotation unchanged;
+    unchanged.SetAngle(-0.0f);
+    CHECK(!signbit(unchanged.GetSin()));
+    CHECK(unchanged.GetCos() == 1.0f);
+}
+
+//*************************************************************************************************
+TEST(Math_TransformPoints)
+{
+    DGL_Mat4 matrix = MakeMatrix(0);
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        for (unsigned count : gCounts)
+        {
+            // Start one point in so the arrays aren't aligned to the SIMD registers
+            std::vector<DGL_Vec2> points(count + 1);
+            for (unsigned i = 0; i <= count; ++i)
+                points[i] = { TestValue(i * 2, 100.0f), TestValue(i * 2 + 1, 100.0f) };
+            std::vector<DGL_Vec2> results(count + 1, { 0.0f, 0.0f });
+
+            DGL_Math_TransformPoints(&matrix, points.data() + 1, results.data() + 1, count);
+
+            CHECK(results[0].x == 0.0f && results[0].y == 0.0f);
+            for (unsigned i = 1; i <= count; ++i)
+            {
+                const DGL_Vec2& point = points[i];
+                CHECK(Near(results[i].x, matrix.m[0][0] * point.x + matrix.m[0][1] * point.y +
+                    matrix.m[0][3], 1e-5f));
+                CHECK(Near(results[i].y, matrix.m[1][0] * point.x + matrix.m[1][1] * point.y +
+                    matrix.m[1][3], 1e-5f));
+            }
+
+            // Transforming in place gives the same results
+            DGL_Math_TransformPoints(&matrix, points.data() + 1, points.data() + 1, count);
+            for (unsigned i = 1; i <= count; ++i)
+                CHECK(points[i].x == results[i].x && points[i].y == results[i].y);
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_TransformPointsSoA)
+{
+    DGL_Mat4 matrix = MakeMatrix(32);
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        for (unsigned count : gCounts)
+        {
+            // One extra value keeps the arrays from being null when the count is 0
+            std::vector<float> xValues(count + 1), yValues(count + 1), xResults(count + 1),
+                yResults(count + 1);
+            for (unsigned i = 0; i < count; ++i)
+            {
+                xValues[i] = TestValue(i * 2, 100.0f);
+                yValues[i] = TestValue(i * 2 + 1, 100.0f);
+            }
+
+            DGL_Math_TransformPointsSoA(&matrix, xValues.data(), yValues.data(), xResults.data(),
+                yResults.data(), count);
+
+            for (unsigned i = 0; i < count; ++i)
+            {
+                CHECK(Near(xResults[i], matrix.m[0][0] * xValues[i] + matrix.m[0][1] * yValues[i] +
+                    matrix.m[0][3], 1e-5f));
+                CHECK(Near(yResults[i], matrix.m[1][0] * xValues[i] + matrix.m[1][1] * yValues[i] +
+                    matrix.m[1][3], 1e-5f));
+            }
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_SinCos)
+{
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        for (unsigned count : gCounts)
+        {
+            std::vector<float> angles(count + 1), sinResults(count + 1), cosResults(count + 1);
+            for (unsigned i = 0; i < count; ++i)
+                angles[i] = TestValue(i, 1000.0f);
+
+            DGL_Math_SinCos(angles.data(), sinResults.data(), cosResults.data(), count);
+
+            for (unsigned i = 0; i < count; ++i)
+            {
+                CHECK(fabs(sinResults[i] - sin((double)angles[i])) < 2e-6);
+                CHECK(fabs(cosResults[i] - cos((double)angles[i])) < 2e-6);
+            }
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_AddScaledAndResample)
+{
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        for (unsigned count : gCounts)
+        {
+            std::vector<float> values(count), results(count);
+            for (unsigned i = 0; i < count; ++i)
+            {
+                values[i] = TestValue(i, 10.0f);
+                results[i] = TestValue(i + count, 10.0f);
+            }
+            std::vector<float> expected(results);
+            for (unsigned i = 0; i < count; ++i)
+                expected[i] += values[i] * 0.75f;
+
+            Array_AddScaled(values.data(), 0.75f, results.data(), count);
+
+            for (unsigned i = 0; i < count; ++i)
+                CHECK(Near(results[i], expected[i], 1e-6f));
+
+            // Each group of four results is a weighted sum of three groups of values
+            const unsigned taps = 3;
+            std::vector<float> pixels((count + taps) * 4);
+            for (unsigned i = 0; i < pixels.size(); ++i)
+                pixels[i] = TestValue(i, 1.0f);
+            std::vector<unsigned> firsts(count);
+            std::vector<float> weights(count * taps);
+            for (unsigned i = 0; i < count; ++i)
+            {
+                firsts[i] = i;
+                for (unsigned tap = 0; tap < taps; ++tap)
+                    weights[i * taps + tap] = TestValue(i * taps + tap, 0.5f);
+            }
+            std::vector<float> resampled(count * 4);
+
+            Array_Resample4(pixels.data(), firsts.data(), weights.data(), taps, resampled.data(),
+                count);
+
+            for (unsigned i = 0; i < count; ++i)
+            {
+                for (unsigned channel = 0; channel < 4; ++channel)
+                {
+                    float sum = 0.0f;
+                    for (unsigned tap = 0; tap < taps; ++tap)
+                        sum += pixels[(firsts[i] + tap) * 4 + channel] * weights[i * taps + tap];
+                    CHECK(Near(resampled[i * 4 + channel], sum, 1e-6f));
+                }
+            }
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_VertexFormatColor8)
+{
+    std::vector<VertexData> vertices = MakeVertices(4.0f);
+    std::vector<VertexDataColor8> scalarResults(vertices.size());
+    Math_SetKernelLevel(MathKernelLevel::Scalar);
+    MeshManager::ConvertVertices(vertices.data(), (unsigned)vertices.size(), DGL_VF_COLOR8,
+        scalarResults.data());
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        std::vector<VertexDataColor8> results(vertices.size());
+        MeshManager::ConvertVertices(vertices.data(), (unsigned)vertices.size(), DGL_VF_COLOR8,
+            results.data());
+
+        // The positions and texture coordinates are copied as they are
+        for (unsigned i = 0; i < vertices.size(); ++i)
+        {
+            CHECK(results[i].mPosition.x == vertices[i].mPosition.x);
+            CHECK(results[i].mPosition.y == vertices[i].mPosition.y);
+            CHECK(results[i].mTexCoord.x == vertices[i].mTexCoord.x);
+            CHECK(results[i].mTexCoord.y == vertices[i].mTexCoord.y);
+            CHECK(results[i].mColor == scalarResults[i].mColor);
+        }
+        CheckColors(vertices, &results[0].mColor, sizeof(VertexDataColor8));
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_VertexFormatHalf)
+{
+    std::vector<VertexData> vertices = MakeVertices(4.0f);
+    std::vector<VertexDataCompact> scalarResults(vertices.size());
+    Math_SetKernelLevel(MathKernelLevel::Scalar);
+    MeshManager::ConvertVertices(vertices.data(), (unsigned)vertices.size(), DGL_VF_COLOR8_UVHALF,
+        scalarResults.data());
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        std::vector<VertexDataCompact> results(vertices.size());
+        MeshManager::ConvertVertices(vertices.data(), (unsigned)vertices.size(),
+            DGL_VF_COLOR8_UVHALF, results.data());
+
+        for (unsigned i = 0; i < vertices.size(); ++i)
+        {
+            CHECK(results[i].mPosition.x == vertices[i].mPosition.x);
+            CHECK(results[i].mTexCoord == scalarResults[i].mTexCoord);
+
+            // Rounding to the nearest 16-bit float is off by at most half of the last bit, or
+            // half of the smallest step for values too small to be normal
+            const DGL_Vec2& expected = vertices[i].mTexCoord;
+            float x = DecodeHalf(results[i].mTexCoord & 0xffff);
+            float y = DecodeHalf(results[i].mTexCoord >> 16);
+            CHECK(fabsf(x - expected.x) <= fmaxf(fabsf(expected.x) / 2048.0f, ldexpf(1.0f, -25)));
+            CHECK(fabsf(y - expected.y) <= fmaxf(fabsf(expected.y) / 2048.0f, ldexpf(1.0f, -25)));
+        }
+        CheckColors(vertices, &results[0].mColor, sizeof(VertexDataCompact));
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_VertexFormatUnorm16)
+{
+    std::vector<VertexData> vertices = MakeVertices(1.0f);
+    for (VertexData& vertex : vertices)
+        vertex.mTexCoord = { fabsf(vertex.mTexCoord.x), fabsf(vertex.mTexCoord.y) };
+    std::vector<VertexDataCompact> scalarResults(vertices.size());
+    Math_SetKernelLevel(MathKernelLevel::Scalar);
+    MeshManager::ConvertVertices(vertices.data(), (unsigned)vertices.size(),
+        DGL_VF_COLOR8_UVUNORM16, scalarResults.data());
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        std::vector<VertexDataCompact> results(vertices.size());
+        MeshManager::ConvertVertices(vertices.data(), (unsigned)vertices.size(),
+            DGL_VF_COLOR8_UVUNORM16, results.data());
+
+        for (unsigned i = 0; i < vertices.size(); ++i)
+        {
+            CHECK(results[i].mPosition.y == vertices[i].mPosition.y);
+            CHECK(results[i].mTexCoord == scalarResults[i].mTexCoord);
+
+            const DGL_Vec2& expected = vertices[i].mTexCoord;
+            float x = (results[i].mTexCoord & 0xffff) / 65535.0f;
+            float y = (results[i].mTexCoord >> 16) / 65535.0f;
+            CHECK(fabsf(x - expected.x) <= 0.5f / 65535.0f + 1e-7f);
+            CHECK(fabsf(y - expected.y) <= 0.5f / 65535.0f + 1e-7f);
+        }
+        CheckColors(vertices, &results[0].mColor, sizeof(VertexDataCompact));
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_IndexFindMax)
+{
+    // Largest values on both sides of the 16-bit limit, and values with the top bit set, which
+    // the signed SSE2 compare has to handle
+    const unsigned largest[] = { 0xFFFE, 0xFFFF, 0x10000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        CHECK(Index_FindMax(nullptr, 0) == 0);
+
+        for (unsigned count : gCounts)
+        {
+            std::vector<unsigned> indices(count);
+            for (unsigned i = 0; i < count; ++i)
+                indices[i] = (i * 7919) % 0xFFFE;
+
+            // Put the largest value at every position, including the ones after the SIMD loop
+            for (unsigned position = 0; position < count; ++position)
+            {
+                for (unsigned value : largest)
+                {
+                    unsigned saved = indices[position];
+                    indices[position] = value;
+                    CHECK(Index_FindMax(indices.data(), count) == value);
+                    indices[position] = saved;
+                }
+            }
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_IndexFindMax16)
+{
+    const uint16_t largest[] = { 0x7FFF, 0x8000, 0xFFFE, 0xFFFF };
+
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        CHECK(Index_FindMax16(nullptr, 0) == 0);
+
+        for (unsigned count : gCounts)
+        {
+            std::vector<uint16_t> indices(count);
+            for (unsigned i = 0; i < count; ++i)
+                indices[i] = (uint16_t)((i * 7919) % 0x7FFF);
+
+            for (unsigned position = 0; position < count; ++position)
+            {
+                for (uint16_t value : largest)
+                {
+                    uint16_t saved = indices[position];
+                    indices[position] = value;
+                    CHECK(Index_FindMax16(indices.data(), count) == value);
+                    indices[position] = saved;
+                }
+            }
+        }
+    }
+
+    UseBestLevel();
+}
+
+//*************************************************************************************************
+TEST(Math_IndexNarrow)
+{
+    for (MathKernelLevel level : gLevels)
+    {
+        if (!Math_SetKernelLevel(level))
+            continue;
+
+        for (unsigned count : gCounts)
+        {
+            // Values up to the largest 16-bit index, including ones with the top bit set, which
+            // the signed SSE2 pack has to keep as they are
+            std::vector<unsigned> indices(count);
+            for (unsigned i = 0; i < count; ++i)
+                indices[i] = 0xFFFF - (i * 4099) % 0x10000;
+
+            // One extra result checks that nothing is written past the end
+            std::vector<uint16_t> results(count + 1, 0x1234);
+            Index_Narrow(indices.data(), results.data(), count);
+
+            for (unsigned i = 0; i < count; ++i)
+                CHECK(results[i] == indices[i]);
+            CHECK(results[count] == 0x1234);
+        }
+    }
+
+    UseBestLevel();
+}
@@ -0,0 +1,307 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshBuilderTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for copying vertex arrays and filling mesh builders
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <string.h>
+#include <vector>
+
+import Mesh;
+import MeshBuilder;
+
+using namespace DGL;
+
+namespace
+{
+
+// The values for one vertex stored together, with extra data between vertices like a game's
+// own vertex struct might have
+struct GameVertex
+{
+    DGL_Vec2 mPosition;
+    DGL_Color mColor;
+    DGL_Vec2 mTexCoord;
+    int mExtra;
+};
+
+//*************************************************************************************************
+DGL_Vec2 TestPosition(unsigned i)
+{
+    return { (float)i, (float)i * 2.0f + 1.0f };
+}
+
+//*************************************************************************************************
+DGL_Color TestColor(unsigned i)
+{
+    return { (float)i * 0.125f, 0.25f, 0.5f, 1.0f - (float)i * 0.0625f };
+}
+
+//*************************************************************************************************
+DGL_Vec2 TestTexCoord(unsigned i)
+{
+    return { (float)i * 0.25f, 1.0f - (float)i * 0.25f };
+}
+
+//*************************************************************************************************
+bool SameVec2(const DGL_Vec2& first, const DGL_Vec2& second)
+{
+    return first.x == second.x && first.y == second.y;
+}
+
+//*************************************************************************************************
+bool SameColor(const DGL_Color& first, const DGL_Color& second)
+{
+    return memcmp(&first, &second, sizeof(DGL_Color)) == 0;
+}
+
+//*************************************************************************************************
+// Returns true if the vertex has the test values for the index
+bool IsTestVertex(const VertexData& vertex, unsigned i)
+{
+    return SameVec2(vertex.mPosition, TestPosition(i)) && SameColor(vertex.mColor, TestColor(i))
+        && SameVec2(vertex.mTexCoord, TestTexCoord(i));
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(MeshBuilder_CopyVerticesPacked)
+{
+    const unsigned count = 4;
+    DGL_Vec2 positions[count];
+    DGL_Color colors[count];
+    DGL_Vec2 texCoords[count];
+    for (unsigned i = 0; i < count; ++i)
+    {
+        positions[i] = TestPosition(i);
+        colors[i] = TestColor(i);
+        texCoords[i] = TestTexCoord(i);
+    }
+
+    // A stride of 0 reads the values right next to each other, the same as their own size
+    VertexData vertices[count];
+    MeshManager::CopyVertices(vertices, positions, 0, colors, 0, texCoords, 0, count);
+    for (unsigned i = 0; i < count; ++i)
+        CHECK(IsTestVertex(vertices[i], i));
+
+    VertexData sized[count];
+    MeshManager::CopyVertices(sized, positions, sizeof(DGL_Vec2), colors, sizeof(DGL_Color),
+        texCoords, sizeof(DGL_Vec2), count);
+    CHECK(memcmp(vertices, sized, sizeof(vertices)) == 0);
+}
+
+//*************************************************************************************************
+TEST(MeshBuilder_CopyVerticesStrided)
+{
+    const unsigned count = 5;
+    GameVertex gameVertices[count];
+    for (unsigned i = 0; i < count; ++i)
+        gameVertices[i] = { TestPosition(i), TestColor(i), TestTexCoord(i), -1 };
+
+    // Each value is read from inside the game's vertices
+    VertexData vertices[count];
+    MeshManager::CopyVertices(vertices, &gameVertices[0].mPosition, sizeof(GameVertex),
+        &gameVertices[0].mColor, sizeof(GameVertex), &gameVertices[0].mTexCoord,
+        sizeof(GameVertex), count);
+    for (unsigned i = 0; i < count; ++i)
+        CHECK(IsTestVertex(vertices[i], i));
+
+    // Each array can have its own stride. This uses every other position with packed colors.
+    DGL_Color colors[2] = { TestColor(0), TestColor(1) };
+    MeshManager::CopyVertices(vertices, &gameVertices[0].mPosition, sizeof(GameVertex) * 2,
+        colors, 0, nullptr, 0, 2);
+    CHECK(SameVec2(vertices[0].mPosition, TestPosition(0)));
+    CHECK(SameVec2(vertices[1].mPosition, TestPosition(2)));
+    CHECK(SameColor(vertices[1].mColor, TestColor(1)));
+}
+
+//*************************************************************************************************
+TEST(MeshBuilder_CopyVerticesDefaults)
+{
+    const unsigned count = 3;
+    DGL_Vec2 positions[count];
+    DGL_Color colors[count];
+    for (unsigned i = 0; i < count; ++i)
+    {
+        positions[i] = TestPosition(i);
+        colors[i] = TestColor(i);
+    }
+
+    // Missing colors and texture coordinates use the defaults for every vertex, and the
+    // strides passed in for them are ignored
+    VertexData vertices[count];
+    MeshManager::CopyVertices(vertices, positions, 0, nullptr, 64, nullptr, 64, count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        CHECK(SameVec2(vertices[i].mPosition, TestPosition(i)));
+        CHECK(SameColor(vertices[i].mColor, MeshManager::default_color));
+        CHECK(SameVec2(vertices[i].mTexCoord, MeshManager::default_tex_coord));
+    }
+
+    // Only the missing array uses the default
+    MeshManager::CopyVertices(vertices, positions, 0, colors, 0, nullptr, 0, count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        CHECK(SameColor(vertices[i].mColor, TestColor(i)));
+        CHECK(SameVec2(vertices[i].mTexCoord, MeshManager::default_tex_coord));
+    }
+}
+
+//*************************************************************************************************
+TEST(MeshBuilder_AddQuadsExpands)
+{
+    const unsigned quadCount = 2;
+    DGL_Vec2 positions[quadCount * 4];
+    DGL_Color colors[quadCount * 4];
+    DGL_Vec2 texCoords[quadCount * 4];
+    for (unsigned i = 0; i < quadCount * 4; ++i)
+    {
+        positions[i] = TestPosition(i);
+        colors[i] = TestColor(i);
+        texCoords[i] = TestTexCoord(i);
+    }
+
+    DGL_MeshBuilder builder;
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    MeshBuilder::AddVertices(builder, positions, 0, colors, 0, texCoords, 0, 1);
+    MeshBuilder::AddQuads(builder, positions, colors, texCoords, quadCount);
+
+    // The quads are added after the existing vertex, as the triangles 0, 1, 2 and 0, 2, 3
+    const unsigned corners[6] = { 0, 1, 2, 0, 2, 3 };
+    CHECK(builder.mVertexList.size() == 1 + quadCount * 6);
+    CHECK(IsTestVertex(builder.mVertexList[0], 0));
+    for (unsigned quad = 0; quad < quadCount; ++quad)
+    {
+        for (unsigned i = 0; i < 6; ++i)
+            CHECK(IsTestVertex(builder.mVertexList[1 + quad * 6 + i], quad * 4 + corners[i]));
+    }
+    CHECK(builder.mIndices.empty());
+    CHECK(!builder.mError);
+
+    // Missing colors and texture coordinates use the defaults, the same as AddVertices
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    MeshBuilder::AddQuads(builder, positions, nullptr, nullptr, 1);
+    CHECK(builder.mVertexList.size() == 6);
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        const VertexData& vertex = builder.mVertexList[i];
+        CHECK(SameVec2(vertex.mPosition, TestPosition(corners[i])));
+        CHECK(SameColor(vertex.mColor, MeshManager::default_color));
+        CHECK(SameVec2(vertex.mTexCoord, MeshManager::default_tex_coord));
+    }
+}
+
+//*************************************************************************************************
+TEST(MeshBuilder_CreateChecksFormat)
+{
+    DGL_MeshBuilder* builder = DGL_MeshBuilder_Create(DGL_VF_COLOR8);
+    CHECK(builder->mVertexFormat == DGL_VF_COLOR8);
+    CHECK(!builder->mError);
+    DGL_MeshBuilder_Free(&builder);
+    CHECK(!builder);
+
+    // An invalid format is saved as an error and the default format is used instead
+    builder = DGL_MeshBuilder_Create((DGL_VertexFormat)99);
+    CHECK(builder->mVertexFormat == DGL_VF_DEFAULT);
+    CHECK(builder->mError && strstr(builder->mError, "DGL_MeshBuilder_Create"));
+
+    // Clearing removes the error and keeps the format
+    DGL_MeshBuilder_Clear(builder);
+    CHECK(!builder->mError);
+    CHECK(builder->mVertexFormat == DGL_VF_DEFAULT);
+    DGL_MeshBuilder_Free(&builder);
+}
+
+//*************************************************************************************************
+TEST(MeshBuilder_NullParametersSaveFirstError)
+{
+    DGL_MeshBuilder* builder = DGL_MeshBuilder_Create(DGL_VF_DEFAULT);
+    DGL_Vec2 position = { 1.0f, 2.0f };
+    DGL_Color color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    DGL_Vec2 positions[4] = {};
+    unsigned indices[3] = { 0, 1, 2 };
+
+    // Missing data is saved as an error on the builder instead of being reported right away,
+    // and nothing is added
+    DGL_MeshBuilder_AddVertex(builder, &position, &color, nullptr);
+    CHECK(builder->mVertexList.empty());
+    CHECK(builder->mError && strstr(builder->mError, "DGL_MeshBuilder_AddVertex"));
+
+    // Later problems don't replace the first one, and later data is still added
+    const char* firstError = builder->mError;
+    DGL_MeshBuilder_AddVertices(builder, nullptr, nullptr, nullptr, 4);
+    DGL_MeshBuilder_AddQuads(builder, nullptr, nullptr, nullptr, 1);
+    DGL_MeshBuilder_AddIndices(builder, nullptr, 3);
+    DGL_MeshBuilder_AddQuads(builder, positions, nullptr, nullptr, 1);
+    CHECK(builder->mError == firstError);
+    CHECK(builder->mVertexList.size() == 6);
+    CHECK(builder->mIndices.empty());
+
+    // Each function saves its own message
+    const char* names[] = { "DGL_MeshBuilder_AddVertices", "DGL_MeshBuilder_AddQuads",
+        "DGL_MeshBuilder_AddIndices" };
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        DGL_MeshBuilder_Clear(builder);
+        if (i == 0)
+            DGL_MeshBuilder_AddVerticesStrided(builder, nullptr, 0, &color, 0, nullptr, 0, 1);
+        else if (i == 1)
+            DGL_MeshBuilder_AddQuads(builder, nullptr, &color, nullptr, 1);
+        else
+            DGL_MeshBuilder_AddIndices(builder, nullptr, 3);
+        CHECK(builder->mError && strstr(builder->mError, names[i]));
+    }
+
+    // Null data is fine when nothing would be read from it
+    DGL_MeshBuilder_Clear(builder);
+    DGL_MeshBuilder_AddVertex(builder, &position, &color, &position);
+    DGL_MeshBuilder_AddIndices(builder, indices, 3);
+    CHECK(!builder->mError);
+
+    // A null builder is ignored
+    DGL_MeshBuilder_AddVertex(nullptr, &position, &color, &position);
+    DGL_MeshBuilder_Clear(nullptr);
+    DGL_MeshBuilder_Optimize(nullptr, nullptr);
+    DGL_MeshBuilder_Free(nullptr);
+
+    DGL_MeshBuilder_Free(&builder);
+}
+
+//*************************************************************************************************
+TEST(MeshBuilder_OptimizeChecksIndices)
+{
+    DGL_Vec2 positions[8] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { 1, 0 }, { 2, 0 },
+        { 2, 1 }, { 1, 1 } };
+
+    // An index past the last vertex is saved as an error and the lists aren't changed
+    DGL_MeshBuilder builder;
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    MeshBuilder::AddVertices(builder, positions, 0, nullptr, 0, nullptr, 0, 4);
+    const unsigned badIndices[3] = { 0, 1, 4 };
+    MeshBuilder::AddIndices(builder, badIndices, 3);
+    MeshBuilder::Optimize(builder, nullptr);
+    CHECK(builder.mError && strstr(builder.mError, "optimize"));
+    CHECK(builder.mVertexList.size() == 4);
+    CHECK(builder.mIndices.size() == 3);
+
+    // An empty builder is left for creating the mesh to report
+    MeshBuilder::Reset(builder, DGL_VF_DEFAULT);
+    MeshBuilder::Optimize(builder, nullptr);
+    CHECK(!builder.mError);
+    CHECK(builder.mVertexList.empty());
+
+    // Two quads sharing an edge keep every corner once, with indices for each triangle
+    DGL_MeshOptimizeStats stats;
+    MeshBuilder::AddQuads(builder, positions, nullptr, nullptr, 2);
+    MeshBuilder::Optimize(builder, &stats);
+    CHECK(!builder.mError);
+    CHECK(stats.mVerticesBefore == 12);
+    CHECK(stats.mVerticesAfter == 6);
+    CHECK(builder.mVertexList.size() == 6);
+    CHECK(builder.mIndices.size() == 12);
+}
@@ -0,0 +1,201 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshOptimizerTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for welding and reordering a tessellated grid
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+import Mesh;
+import MeshOptimizer;
+
+using namespace DGL;
+
+namespace
+{
+
+// The number of cells along each side of the grid. A row is longer than the cache, so drawing
+// the grid row by row can't reuse the vertices from the row before.
+const unsigned grid_cells{ 40 };
+
+typedef std::array<VertexData, 3> Triangle;
+
+//*************************************************************************************************
+VertexData GridVertex(unsigned x, unsigned y)
+{
+    float u = (float)x / grid_cells;
+    float v = (float)y / grid_cells;
+    return { { u - 0.5f, v - 0.5f }, { u, v, 1.0f, 1.0f }, { u, v } };
+}
+
+//*************************************************************************************************
+// Returns the grid as a triangle list with no indices, so each shared vertex is repeated. The
+// triangles are shuffled so the order is bad for the vertex cache.
+std::vector<VertexData> MakeGrid()
+{
+    std::vector<Triangle> triangles;
+    for (unsigned y = 0; y < grid_cells; ++y)
+    {
+        for (unsigned x = 0; x < grid_cells; ++x)
+        {
+            triangles.push_back({ GridVertex(x, y), GridVertex(x + 1, y), GridVertex(x, y + 1) });
+            triangles.push_back({ GridVertex(x + 1, y), GridVertex(x + 1, y + 1),
+                GridVertex(x, y + 1) });
+        }
+    }
+
+    // A repeatable shuffle
+    unsigned seed = 12345;
+    for (unsigned i = (unsigned)triangles.size() - 1; i > 0; --i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        std::swap(triangles[i], triangles[(seed >> 8) % (i + 1)]);
+    }
+
+    std::vector<VertexData> vertices;
+    for (const Triangle& triangle : triangles)
+        vertices.insert(vertices.end(), triangle.begin(), triangle.end());
+    return vertices;
+}
+
+//*************************************************************************************************
+bool SameVertex(const VertexData& first, const VertexData& second)
+{
+    return memcmp(&first, &second, sizeof(VertexData)) == 0;
+}
+
+//*************************************************************************************************
+bool VertexLess(const VertexData& first, const VertexData& second)
+{
+    return memcmp(&first, &second, sizeof(VertexData)) < 0;
+}
+
+//*************************************************************************************************
+// Returns the triangles rotated so the smallest vertex is first without changing the winding,
+// in sorted order
+std::vector<Triangle> SortedTriangles(std::vector<Triangle> triangles)
+{
+    for (Triangle& triangle : triangles)
+        std::rotate(triangle.begin(),
+            std::min_element(triangle.begin(), triangle.end(), VertexLess), triangle.end());
+    std::sort(triangles.begin(), triangles.end(), [](const Triangle& first, const Triangle& second)
+        {
+            return memcmp(first.data(), second.data(), sizeof(Triangle)) < 0;
+        });
+    return triangles;
+}
+
+//*************************************************************************************************
+// Returns each triangle's indices, rotated so the smallest is first without changing the
+// winding, in sorted order. Two index lists with the same result draw the same triangles.
+std::vector<std::array<unsigned, 3>> SortedTriangles(const std::vector<unsigned>& indices)
+{
+    std::vector<std::array<unsigned, 3>> triangles;
+    for (unsigned i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<unsigned, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()),
+            triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(MeshOptimizer_WeldKeepsTriangles)
+{
+    std::vector<VertexData> vertices = MakeGrid();
+    std::vector<VertexData> welded;
+    std::vector<unsigned> indices;
+    MeshOptimizer::WeldVertices(vertices.data(), (unsigned)vertices.size(), welded, indices);
+
+    // Each grid point is kept once, and each original vertex maps to an exact copy of itself
+    CHECK(welded.size() == (grid_cells + 1) * (grid_cells + 1));
+    CHECK(indices.size() == vertices.size());
+    for (unsigned i = 0; i < indices.size(); ++i)
+    {
+        CHECK(indices[i] < welded.size());
+        CHECK(SameVertex(welded[indices[i]], vertices[i]));
+    }
+
+    // Vertices which differ in any value aren't combined
+    vertices[1] = vertices[0];
+    vertices[1].mColor.a = 0.5f;
+    MeshOptimizer::WeldVertices(vertices.data(), 2, welded, indices);
+    CHECK(welded.size() == 2);
+}
+
+//*************************************************************************************************
+TEST(MeshOptimizer_VertexCacheLowersACMR)
+{
+    std::vector<VertexData> vertices = MakeGrid();
+    std::vector<VertexData> welded;
+    std::vector<unsigned> indices;
+    MeshOptimizer::WeldVertices(vertices.data(), (unsigned)vertices.size(), welded, indices);
+
+    unsigned vertexCount = (unsigned)welded.size();
+    std::vector<unsigned> original(indices);
+    float before = MeshOptimizer::CalculateACMR(indices.data(), (unsigned)indices.size(),
+        vertexCount, MeshOptimizer::acmr_cache_size);
+
+    MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+
+    float after = MeshOptimizer::CalculateACMR(indices.data(), (unsigned)indices.size(),
+        vertexCount, MeshOptimizer::acmr_cache_size);
+
+    // The same triangles are drawn, with the same winding, in an order that reuses more
+    // vertices. A shuffled grid transforms most vertices more than once, and a good order
+    // gets close to the best possible value of 0.5.
+    CHECK(SortedTriangles(indices) == SortedTriangles(original));
+    CHECK(before > 1.5f);
+    CHECK(after < before);
+    CHECK(after < 0.8f);
+}
+
+//*************************************************************************************************
+TEST(MeshOptimizer_OptimizeKeepsVertices)
+{
+    std::vector<VertexData> vertices = MakeGrid();
+    std::vector<VertexData> optimized;
+    std::vector<unsigned> indices;
+    DGL_MeshOptimizeStats stats;
+    MeshOptimizer::Optimize(vertices.data(), (unsigned)vertices.size(), optimized, indices,
+        &stats);
+
+    CHECK(stats.mVerticesBefore == vertices.size());
+    CHECK(stats.mVerticesAfter == optimized.size());
+    CHECK(stats.mACMRAfter < stats.mACMRBefore);
+
+    // Every triangle still uses the same vertex values, and the vertices are in the order
+    // the indices first use them
+    CHECK(indices.size() == vertices.size());
+    std::vector<Triangle> expected, result;
+    for (unsigned i = 0; i + 2 < indices.size(); i += 3)
+    {
+        expected.push_back({ vertices[i], vertices[i + 1], vertices[i + 2] });
+        result.push_back({ optimized[indices[i]], optimized[indices[i + 1]],
+            optimized[indices[i + 2]] });
+    }
+    expected = SortedTriangles(expected);
+    result = SortedTriangles(result);
+    CHECK(memcmp(expected.data(), result.data(), sizeof(Triangle) * expected.size()) == 0);
+
+    unsigned nextNew = 0;
+    for (unsigned index : indices)
+    {
+        CHECK(index <= nextNew);
+        if (index == nextNew)
+            ++nextNew;
+    }
+    CHECK(nextNew == optimized.size());
+}
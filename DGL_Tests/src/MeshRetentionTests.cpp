@@ -0,0 +1,186 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshRetentionTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for trimming the CPU copy of mesh data and counting its size
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+
+import Mesh;
+
+using namespace DGL;
+
+namespace
+{
+
+const unsigned vertex_count{ 6 };
+const unsigned index_count{ 9 };
+
+//*************************************************************************************************
+DGL_Vec2 TestPosition(unsigned i)
+{
+    return { (float)i, 10.0f - (float)i };
+}
+
+//*************************************************************************************************
+// Fills in the CPU data a mesh that keeps everything would have. Nothing is created on the
+// graphics card, so only the static MeshManager functions can be used with it.
+void FillMesh(DGL_Mesh& mesh, bool indexed)
+{
+    mesh.mVertexCount = vertex_count;
+    mesh.mVertexList = new VertexData[vertex_count];
+    for (unsigned i = 0; i < vertex_count; ++i)
+        mesh.mVertexList[i] = { TestPosition(i), { 1.0f, 0.5f, 0.25f, 1.0f }, { 0.0f, 1.0f } };
+
+    if (indexed)
+    {
+        mesh.mIndexCount = index_count;
+        mesh.mIndices = new unsigned[index_count];
+        for (unsigned i = 0; i < index_count; ++i)
+            mesh.mIndices[i] = (i * 5) % vertex_count;
+    }
+}
+
+//*************************************************************************************************
+// Deletes the lists the same way MeshManager::ReleaseMesh does
+void FreeMesh(DGL_Mesh& mesh)
+{
+    delete[] mesh.mVertexList;
+    delete[] mesh.mPositions;
+    delete[] mesh.mIndices;
+}
+
+//*************************************************************************************************
+// Returns true if the mesh gives back the positions it was filled with
+bool HasPositions(const DGL_Mesh& mesh)
+{
+    DGL_Vec2 positions[vertex_count];
+    if (MeshManager::GetPositions(&mesh, positions, vertex_count) != vertex_count)
+        return false;
+
+    for (unsigned i = 0; i < vertex_count; ++i)
+    {
+        DGL_Vec2 expected = TestPosition(i);
+        if (positions[i].x != expected.x || positions[i].y != expected.y)
+            return false;
+    }
+    return true;
+}
+
+//*************************************************************************************************
+// Returns true if the mesh gives back the indices it was filled with
+bool HasIndices(const DGL_Mesh& mesh)
+{
+    unsigned indices[index_count];
+    if (MeshManager::GetIndices(&mesh, indices, index_count) != index_count)
+        return false;
+
+    for (unsigned i = 0; i < index_count; ++i)
+    {
+        if (indices[i] != (i * 5) % vertex_count)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(MeshRetention_KeepAll)
+{
+    DGL_Mesh mesh;
+    FillMesh(mesh, true);
+
+    CHECK(MeshManager::GetCPUBytes(&mesh)
+        == sizeof(VertexData) * vertex_count + sizeof(unsigned) * index_count);
+    CHECK(HasPositions(mesh));
+    CHECK(HasIndices(mesh));
+
+    // Asking to keep everything doesn't change anything
+    MeshManager::TrimMesh(&mesh, DGL_MR_ALL);
+    CHECK(mesh.mRetention == DGL_MR_ALL);
+    CHECK(mesh.mVertexList);
+    CHECK(!mesh.mPositions);
+
+    FreeMesh(mesh);
+}
+
+//*************************************************************************************************
+TEST(MeshRetention_TrimToPositions)
+{
+    DGL_Mesh mesh;
+    FillMesh(mesh, true);
+
+    // The positions are copied out of the vertex data before it is deleted
+    MeshManager::TrimMesh(&mesh, DGL_MR_POSITIONS);
+    CHECK(mesh.mRetention == DGL_MR_POSITIONS);
+    CHECK(!mesh.mVertexList);
+    CHECK(MeshManager::GetCPUBytes(&mesh)
+        == sizeof(DGL_Vec2) * vertex_count + sizeof(unsigned) * index_count);
+    CHECK(HasPositions(mesh));
+    CHECK(HasIndices(mesh));
+
+    // Data that was deleted can't be brought back
+    MeshManager::TrimMesh(&mesh, DGL_MR_ALL);
+    CHECK(mesh.mRetention == DGL_MR_POSITIONS);
+    CHECK(!mesh.mVertexList);
+
+    // Trimming again removes everything else
+    MeshManager::TrimMesh(&mesh, DGL_MR_NONE);
+    CHECK(MeshManager::GetCPUBytes(&mesh) == 0);
+    CHECK(MeshManager::GetPositions(&mesh, nullptr, 0) == 0);
+    CHECK(MeshManager::GetIndices(&mesh, nullptr, 0) == 0);
+
+    FreeMesh(mesh);
+}
+
+//*************************************************************************************************
+TEST(MeshRetention_TrimToNone)
+{
+    DGL_Mesh mesh;
+    FillMesh(mesh, true);
+
+    // Going straight to keeping nothing doesn't make a copy of the positions
+    MeshManager::TrimMesh(&mesh, DGL_MR_NONE);
+    CHECK(mesh.mRetention == DGL_MR_NONE);
+    CHECK(!mesh.mVertexList);
+    CHECK(!mesh.mPositions);
+    CHECK(!mesh.mIndices);
+    CHECK(MeshManager::GetCPUBytes(&mesh) == 0);
+    CHECK(MeshManager::GetPositions(&mesh, nullptr, 0) == 0);
+
+    // The counts are still known, since the data on the graphics card doesn't change
+    CHECK(mesh.mVertexCount == vertex_count);
+    CHECK(mesh.mIndexCount == index_count);
+
+    MeshManager::TrimMesh(&mesh, DGL_MR_POSITIONS);
+    CHECK(mesh.mRetention == DGL_MR_NONE);
+    CHECK(!mesh.mPositions);
+
+    FreeMesh(mesh);
+}
+
+//*************************************************************************************************
+TEST(MeshRetention_CPUBytes)
+{
+    // A mesh without indices only counts its vertices
+    DGL_Mesh mesh;
+    FillMesh(mesh, false);
+    CHECK(MeshManager::GetCPUBytes(&mesh) == sizeof(VertexData) * vertex_count);
+    CHECK(MeshManager::GetIndices(&mesh, nullptr, 0) == 0);
+
+    MeshManager::TrimMesh(&mesh, DGL_MR_POSITIONS);
+    CHECK(MeshManager::GetCPUBytes(&mesh) == sizeof(DGL_Vec2) * vertex_count);
+    FreeMesh(mesh);
+
+    // A dynamic mesh's list holds its whole capacity, not just the vertices in use
+    DGL_Mesh dynamicMesh;
+    dynamicMesh.mVertexCount = 2;
+    dynamicMesh.mDynamicCapacity = 100;
+    dynamicMesh.mVertexList = new VertexData[dynamicMesh.mDynamicCapacity];
+    CHECK(MeshManager::GetCPUBytes(&dynamicMesh) == sizeof(VertexData) * 100);
+    FreeMesh(dynamicMesh);
+}
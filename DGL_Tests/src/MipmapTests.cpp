@@ -0,0 +1,215 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MipmapTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for the filters and levels built for textures on the CPU
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <math.h>
+#include <vector>
+
+import Mipmap;
+
+using namespace DGL;
+
+namespace
+{
+
+// The sizes filtered, including odd sizes and sizes that aren't powers of two
+const int filter_sizes[][2] = { { 2, 1 }, { 3, 1 }, { 4, 2 }, { 5, 2 }, { 7, 3 }, { 12, 6 },
+    { 100, 50 }, { 257, 128 }, { 1024, 512 } };
+
+//*************************************************************************************************
+// Returns true if each new pixel's range is inside the source and its weights add up to 1
+bool IsValidFilter(const MipmapGenerator::Filter& filter, int sourceSize, int newSize)
+{
+    if (filter.mFirsts.size() != (size_t)newSize ||
+        filter.mWeights.size() != (size_t)newSize * filter.mTaps)
+        return false;
+
+    for (int i = 0; i < newSize; ++i)
+    {
+        if (filter.mFirsts[i] + filter.mTaps > (unsigned)sourceSize)
+            return false;
+
+        float total = 0.0f;
+        for (unsigned tap = 0; tap < filter.mTaps; ++tap)
+            total += filter.mWeights[(size_t)i * filter.mTaps + tap];
+        if (fabsf(total - 1.0f) > 0.0001f)
+            return false;
+    }
+    return true;
+}
+
+//*************************************************************************************************
+// Returns a level with every pixel set to the color
+MipLevel MakeSolidLevel(int width, int height, const unsigned char color[4])
+{
+    MipLevel level;
+    level.mWidth = width;
+    level.mHeight = height;
+    for (int i = 0; i < width * height; ++i)
+        level.mPixels.insert(level.mPixels.end(), color, color + 4);
+    return level;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(Mipmap_FilterWeightsAddUpToOne)
+{
+    MipmapGenerator::Filter filter;
+    for (const int* sizes : filter_sizes)
+    {
+        MipmapGenerator::BuildFilter(sizes[0], sizes[1], DGL_MM_BOX, filter);
+        CHECK(IsValidFilter(filter, sizes[0], sizes[1]));
+
+        MipmapGenerator::BuildFilter(sizes[0], sizes[1], DGL_MM_KAISER, filter);
+        CHECK(IsValidFilter(filter, sizes[0], sizes[1]));
+    }
+}
+
+//*************************************************************************************************
+TEST(Mipmap_BoxFilterCoverage)
+{
+    // Halving an even size averages each pair of pixels
+    MipmapGenerator::Filter filter;
+    MipmapGenerator::BuildFilter(4, 2, DGL_MM_BOX, filter);
+    CHECK(filter.mTaps == 2);
+    CHECK(filter.mFirsts[0] == 0 && filter.mFirsts[1] == 2);
+    for (float weight : filter.mWeights)
+        CHECK(weight == 0.5f);
+
+    // Shrinking 7 pixels to 3 gives each new pixel 7/3 pixels, so it covers two whole pixels
+    // and a third of another
+    MipmapGenerator::BuildFilter(7, 3, DGL_MM_BOX, filter);
+    CHECK(filter.mTaps == 3);
+    const float* weights = filter.mWeights.data();
+    CHECK(filter.mFirsts[0] == 0);
+    CHECK(fabsf(weights[0] - 3.0f / 7.0f) < 0.0001f && fabsf(weights[2] - 1.0f / 7.0f) < 0.0001f);
+
+    // The middle pixel covers two thirds of pixel 2 and 4 and all of pixel 3
+    weights += filter.mTaps;
+    CHECK(filter.mFirsts[1] == 2);
+    CHECK(fabsf(weights[0] - 2.0f / 7.0f) < 0.0001f && fabsf(weights[1] - 3.0f / 7.0f) < 0.0001f);
+
+    // The last range is moved back to fit inside the source
+    CHECK(filter.mFirsts[2] == 4);
+    weights += filter.mTaps;
+    CHECK(fabsf(weights[0] - 1.0f / 7.0f) < 0.0001f && fabsf(weights[2] - 3.0f / 7.0f) < 0.0001f);
+}
+
+//*************************************************************************************************
+TEST(Mipmap_KaiserFilterClamps)
+{
+    // The Kaiser filter is wider than the source here, so pixels past the edges use the edge
+    // pixels and every tap is inside the source
+    MipmapGenerator::Filter filter;
+    MipmapGenerator::BuildFilter(3, 1, DGL_MM_KAISER, filter);
+    CHECK(filter.mTaps == 3);
+    CHECK(filter.mFirsts[0] == 0);
+
+    // Each edge pixel gets the weight of the pixels past it on its side
+    float expected[3] = {};
+    float total = 0.0f;
+    for (int j = -9; j < 12; ++j)
+    {
+        float weight = MipmapGenerator::KaiserWeight((j + 0.5f - 1.5f) / 3.0f);
+        expected[j < 0 ? 0 : (j > 2 ? 2 : j)] += weight;
+        total += weight;
+    }
+    for (int i = 0; i < 3; ++i)
+        CHECK(fabsf(filter.mWeights[i] - expected[i] / total) < 0.0001f);
+    CHECK(fabsf(filter.mWeights[0] - filter.mWeights[2]) < 0.0001f);
+
+    CHECK(MipmapGenerator::KaiserWeight(0.0f) == 1.0f);
+    CHECK(MipmapGenerator::KaiserWeight(MipmapGenerator::kaiser_radius) == 0.0f);
+    CHECK(MipmapGenerator::KaiserWeight(1.0f) == MipmapGenerator::KaiserWeight(-1.0f));
+}
+
+//*************************************************************************************************
+TEST(Mipmap_LevelSizes)
+{
+    // Each level is half the size of the one before, rounded down, until both sides are 1
+    const unsigned char color[4] = { 10, 200, 90, 255 };
+    std::vector<MipLevel> levels = { MakeSolidLevel(7, 5, color) };
+    CHECK(MipmapGenerator::GetLevelCount(7, 5) == 3);
+    MipmapGenerator::BuildLevels(levels, DGL_MM_BOX);
+    CHECK(levels.size() == 3);
+    CHECK(levels[1].mWidth == 3 && levels[1].mHeight == 2);
+    CHECK(levels[2].mWidth == 1 && levels[2].mHeight == 1);
+    CHECK(levels[2].mPixels.size() == 4);
+
+    levels.resize(1);
+    levels[0] = MakeSolidLevel(1, 6, color);
+    MipmapGenerator::BuildLevels(levels, DGL_MM_KAISER);
+    CHECK(levels.size() == 3);
+    CHECK(levels[1].mWidth == 1 && levels[1].mHeight == 3);
+}
+
+//*************************************************************************************************
+TEST(Mipmap_SolidColorStaysTheSame)
+{
+    // With the weights adding up to 1 and the edges clamped, a solid color doesn't change at any
+    // level, even with odd sizes and the Kaiser filter's negative weights
+    const unsigned char color[4] = { 10, 200, 90, 128 };
+    const DGL_MipmapMode modes[2] = { DGL_MM_BOX, DGL_MM_KAISER };
+    for (DGL_MipmapMode mode : modes)
+    {
+        std::vector<MipLevel> levels = { MakeSolidLevel(13, 6, color) };
+        MipmapGenerator::BuildLevels(levels, mode);
+        for (const MipLevel& level : levels)
+        {
+            for (size_t i = 0; i < level.mPixels.size(); ++i)
+                CHECK(abs(level.mPixels[i] - color[i % 4]) <= 1);
+        }
+    }
+}
+
+//*************************************************************************************************
+TEST(Mipmap_TransparentColorsDontBleed)
+{
+    // Columns of opaque green next to columns of transparent red
+    MipLevel first;
+    first.mWidth = 8;
+    first.mHeight = 8;
+    for (int i = 0; i < 64; ++i)
+    {
+        bool opaque = (i % 8) / 2 % 2 == 0;
+        const unsigned char green[4] = { 0, 255, 0, 255 };
+        const unsigned char red[4] = { 255, 0, 0, 0 };
+        first.mPixels.insert(first.mPixels.end(), opaque ? green : red, (opaque ? green : red) + 4);
+    }
+
+    // Alpha is blended, but the red of the transparent pixels never shows up
+    const DGL_MipmapMode modes[2] = { DGL_MM_BOX, DGL_MM_KAISER };
+    for (DGL_MipmapMode mode : modes)
+    {
+        std::vector<MipLevel> levels = { first };
+        MipmapGenerator::BuildLevels(levels, mode);
+        for (size_t level = 1; level < levels.size(); ++level)
+        {
+            const std::vector<unsigned char>& pixels = levels[level].mPixels;
+            for (size_t i = 0; i < pixels.size(); i += 4)
+            {
+                CHECK(pixels[i] == 0 && pixels[i + 2] == 0);
+                CHECK(pixels[i + 3] == 0 || pixels[i + 1] >= 254);
+            }
+        }
+
+        // The last level is half covered by green
+        const unsigned char* last = levels.back().mPixels.data();
+        CHECK(abs(last[3] - 128) <= 1);
+    }
+
+    // Pixels with no alpha left are black, not the color that was under them
+    const unsigned char red[4] = { 255, 0, 0, 0 };
+    std::vector<MipLevel> levels = { MakeSolidLevel(4, 4, red) };
+    MipmapGenerator::BuildLevels(levels, DGL_MM_BOX);
+    for (unsigned char value : levels[1].mPixels)
+        CHECK(value == 0);
+}
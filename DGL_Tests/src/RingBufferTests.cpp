@@ -0,0 +1,94 @@
+//-------------------------------------------------------------------------------------------------
+// file:    RingBufferTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for where the ring allocator places blocks and when it frees them
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include <d3d11_1.h>
+
+import RingBuffer;
+
+using namespace DGL;
+
+//*************************************************************************************************
+TEST(RingBuffer_Alignment)
+{
+    RingAllocator ring;
+    ring.Reset(1024);
+
+    CHECK(ring.Allocate(10, 256) == 0);
+    CHECK(ring.Allocate(10, 256) == 256);
+    CHECK(ring.Allocate(4, 4) == 268);
+
+    // The space skipped for the alignment counts as used
+    CHECK(ring.GetUsed() == 272);
+
+    CHECK(ring.Allocate(0, 16) == RingAllocator::invalid_offset);
+    CHECK(ring.Allocate(2048, 16) == RingAllocator::invalid_offset);
+}
+
+//*************************************************************************************************
+TEST(RingBuffer_WrapSkipsEnd)
+{
+    RingAllocator ring;
+    ring.Reset(1024);
+
+    CHECK(ring.Allocate(608, 16) == 0);
+    ring.EndFrame();
+    CHECK(ring.Allocate(304, 16) == 608);
+    for (unsigned i = 1; i < RingAllocator::frames_in_flight; ++i)
+        ring.EndFrame();
+
+    // This doesn't fit before the end, so it starts at the beginning of the freed first frame,
+    // and the space skipped at the end stays in use until this frame is freed
+    CHECK(ring.Allocate(208, 16) == 0);
+    CHECK(ring.GetUsed() == 304 + 112 + 208);
+
+    // The second frame's data is still in use, so only the space before it can be used
+    CHECK(ring.Allocate(500, 16) == RingAllocator::invalid_offset);
+    CHECK(ring.Allocate(400, 16) == 208);
+}
+
+//*************************************************************************************************
+TEST(RingBuffer_TailReleasedAfterFramesInFlight)
+{
+    RingAllocator ring;
+    ring.Reset(1024);
+
+    CHECK(ring.Allocate(1024, 16) == 0);
+    CHECK(ring.GetUsed() == 1024);
+
+    // The data stays in use until enough frames have ended that the graphics card is done with it
+    for (unsigned i = 1; i < RingAllocator::frames_in_flight; ++i)
+    {
+        ring.EndFrame();
+        CHECK(ring.Allocate(16, 16) == RingAllocator::invalid_offset);
+    }
+
+    ring.EndFrame();
+    CHECK(ring.GetUsed() == 0);
+    CHECK(ring.Allocate(16, 16) == 0);
+}
+
+//*************************************************************************************************
+TEST(RingBuffer_FullReturnsInvalid)
+{
+    RingAllocator ring;
+    ring.Reset(1024);
+
+    for (unsigned i = 0; i < 4; ++i)
+        CHECK(ring.Allocate(256, 256) == i * 256);
+
+    // A failed allocation doesn't use any space
+    CHECK(ring.Allocate(16, 16) == RingAllocator::invalid_offset);
+    CHECK(ring.GetUsed() == 1024);
+
+    // Resetting forgets everything, including the data from recent frames
+    ring.Reset(512);
+    CHECK(ring.GetCapacity() == 512);
+    CHECK(ring.GetUsed() == 0);
+    CHECK(ring.Allocate(512, 16) == 0);
+}
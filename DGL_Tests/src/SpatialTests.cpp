@@ -0,0 +1,241 @@
+//-------------------------------------------------------------------------------------------------
+// file:    SpatialTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for finding objects in the spatial grid
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+import Math;
+import Mesh;
+import Spatial;
+
+using namespace DGL;
+
+namespace
+{
+
+// A mesh with the bounds of the default square mesh. The grid only uses the bounds.
+struct UnitMesh
+{
+    UnitMesh()
+    {
+        mMesh.mBounds = { { -0.5f, -0.5f }, { 0.5f, 0.5f }, { 0.0f, 0.0f }, 0.7072f };
+    }
+
+    DGL_Mesh mMesh;
+};
+
+// The textures are only compared, so any distinct addresses will do
+int gTextureObjects[2];
+const DGL_Texture* const gTexture1 = (const DGL_Texture*)&gTextureObjects[0];
+const DGL_Texture* const gTexture2 = (const DGL_Texture*)&gTextureObjects[1];
+
+//*************************************************************************************************
+DGL_SpatialObject MakeObject(const DGL_Mesh* mesh, const DGL_Vec2& position,
+    const DGL_Vec2& scale, float rotation = 0.0f)
+{
+    DGL_SpatialObject object = {};
+    object.mMesh = mesh;
+    object.mTexture = gTexture1;
+    object.mDrawMode = DGL_DM_TRIANGLELIST;
+    object.mPosition = position;
+    object.mScale = scale;
+    object.mRotation = rotation;
+    return object;
+}
+
+//*************************************************************************************************
+// Returns a repeatable value between 0 and 1
+float NextRandom(unsigned& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0f;
+}
+
+//*************************************************************************************************
+// Returns the IDs the grid finds in the area, in order
+std::vector<unsigned> Query(SpatialGrid& grid, const DGL_Vec2& areaMin, const DGL_Vec2& areaMax)
+{
+    std::vector<unsigned> results;
+    grid.Query(areaMin, areaMax, results);
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+//*************************************************************************************************
+// Returns the IDs of the objects whose boxes overlap the area, found by checking every object
+std::vector<unsigned> QueryAll(const std::unordered_map<unsigned, DGL_SpatialObject>& objects,
+    const DGL_Vec2& areaMin, const DGL_Vec2& areaMax)
+{
+    std::vector<unsigned> results;
+    for (const auto& [id, object] : objects)
+    {
+        const DGL_MeshBounds& bounds = object.mMesh->mBounds;
+        DGL_Vec2 boxMin;
+        DGL_Vec2 boxMax;
+        Affine_TransformBox(Affine_Compose(object.mPosition, object.mScale,
+            sinf(object.mRotation), cosf(object.mRotation)), bounds.mMin, bounds.mMax,
+            boxMin, boxMax);
+
+        if (boxMin.x <= areaMax.x && boxMax.x >= areaMin.x &&
+            boxMin.y <= areaMax.y && boxMax.y >= areaMin.y)
+            results.push_back(id);
+    }
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(Spatial_QueryMatchesBruteForce)
+{
+    UnitMesh mesh;
+    SpatialGrid grid;
+    std::unordered_map<unsigned, DGL_SpatialObject> objects;
+
+    // Mostly objects smaller than a cell, some which cross several cells, and a few large
+    // enough to go in the large object list, spread around the origin
+    unsigned seed = 12345;
+    for (unsigned i = 0; i < 2000; ++i)
+    {
+        float size = i % 100 == 0 ? 4000.0f : (i % 10 == 0 ? 600.0f : 40.0f);
+        DGL_SpatialObject object = MakeObject(&mesh.mMesh,
+            { NextRandom(seed) * 10000.0f - 5000.0f, NextRandom(seed) * 10000.0f - 5000.0f },
+            { size * (0.5f + NextRandom(seed)), size * (0.5f + NextRandom(seed)) },
+            NextRandom(seed) * 6.0f);
+        unsigned id = grid.Add(object);
+        CHECK(id != 0);
+        objects[id] = object;
+    }
+
+    // Remove some objects, so the grid has unused entries
+    for (unsigned i = 0; i < 2000; i += 7)
+    {
+        auto removed = objects.begin();
+        CHECK(grid.Remove(removed->first));
+        objects.erase(removed);
+    }
+    CHECK(grid.GetObjectCount() == objects.size());
+
+    // Small areas look up each cell, and large areas go through the cells with objects
+    const float cellSizes[] = { SpatialGrid::default_cell_size, 97.0f, 2000.0f };
+    for (float cellSize : cellSizes)
+    {
+        grid.SetCellSize(cellSize);
+        for (unsigned i = 0; i < 200; ++i)
+        {
+            float size = i % 20 == 0 ? 20000.0f : NextRandom(seed) * 1500.0f;
+            DGL_Vec2 areaMin = { NextRandom(seed) * 12000.0f - 6000.0f,
+                NextRandom(seed) * 12000.0f - 6000.0f };
+            DGL_Vec2 areaMax = { areaMin.x + size, areaMin.y + size * 0.75f };
+            CHECK(Query(grid, areaMin, areaMax) == QueryAll(objects, areaMin, areaMax));
+        }
+    }
+}
+
+//*************************************************************************************************
+TEST(Spatial_UpdateMovesBetweenCells)
+{
+    UnitMesh mesh;
+    SpatialGrid grid;
+    unsigned id = grid.Add(MakeObject(&mesh.mMesh, { 100.0f, 100.0f }, { 10.0f, 10.0f }));
+
+    // Moving far away takes the object out of its old cells
+    CHECK(grid.Update(id, MakeObject(&mesh.mMesh, { 5000.0f, -3000.0f }, { 10.0f, 10.0f })));
+    CHECK(Query(grid, { 90.0f, 90.0f }, { 110.0f, 110.0f }).empty());
+    CHECK(Query(grid, { 4990.0f, -3010.0f }, { 5010.0f, -2990.0f }) ==
+        std::vector<unsigned>{ id });
+
+    // A small move inside the same cells still updates the box
+    CHECK(grid.Update(id, MakeObject(&mesh.mMesh, { 5020.0f, -3000.0f }, { 10.0f, 10.0f })));
+    CHECK(Query(grid, { 4990.0f, -3010.0f }, { 5010.0f, -2990.0f }).empty());
+    CHECK(Query(grid, { 5015.0f, -3010.0f }, { 5016.0f, -2990.0f }) ==
+        std::vector<unsigned>{ id });
+
+    // Growing into the large object list and shrinking back out of it
+    CHECK(grid.Update(id, MakeObject(&mesh.mMesh, { 0.0f, 0.0f }, { 5000.0f, 5000.0f })));
+    CHECK(Query(grid, { 2000.0f, 2000.0f }, { 2001.0f, 2001.0f }) ==
+        std::vector<unsigned>{ id });
+    CHECK(grid.Update(id, MakeObject(&mesh.mMesh, { 0.0f, 0.0f }, { 10.0f, 10.0f })));
+    CHECK(Query(grid, { 2000.0f, 2000.0f }, { 2001.0f, 2001.0f }).empty());
+    CHECK(Query(grid, { -1.0f, -1.0f }, { 1.0f, 1.0f }) == std::vector<unsigned>{ id });
+    CHECK(grid.GetObjectCount() == 1);
+}
+
+//*************************************************************************************************
+TEST(Spatial_LargeObjects)
+{
+    UnitMesh mesh;
+    SpatialGrid grid;
+
+    // This covers 40 by 40 cells, which is more than max_object_cells
+    float size = SpatialGrid::default_cell_size * 40.0f;
+    unsigned large = grid.Add(MakeObject(&mesh.mMesh, { 0.0f, 0.0f }, { size, size }));
+    unsigned small = grid.Add(MakeObject(&mesh.mMesh, { 100.0f, 100.0f }, { 10.0f, 10.0f }));
+
+    // The large object is found anywhere it overlaps, once, and not outside of its box
+    CHECK(Query(grid, { 90.0f, 90.0f }, { 110.0f, 110.0f }) ==
+        (std::vector<unsigned>{ std::min(large, small), std::max(large, small) }));
+    CHECK(Query(grid, { -5000.0f, 5000.0f }, { -4999.0f, 5001.0f }) ==
+        std::vector<unsigned>{ large });
+    CHECK(Query(grid, { size, 0.0f }, { size + 10.0f, 10.0f }).empty());
+
+    CHECK(grid.Remove(large));
+    CHECK(Query(grid, { -5000.0f, 5000.0f }, { -4999.0f, 5001.0f }).empty());
+}
+
+//*************************************************************************************************
+TEST(Spatial_RemovedIdsDontMatch)
+{
+    UnitMesh mesh;
+    UnitMesh otherMesh;
+    SpatialGrid grid;
+    DGL_SpatialObject object = MakeObject(&mesh.mMesh, { 0.0f, 0.0f }, { 10.0f, 10.0f });
+
+    // A new object reuses the removed object's entry with a different ID
+    unsigned first = grid.Add(object);
+    CHECK(grid.Remove(first));
+    unsigned second = grid.Add(object);
+    CHECK(second != 0 && second != first);
+    CHECK(!grid.GetObject(first));
+    CHECK(!grid.Update(first, object));
+    CHECK(!grid.Remove(first));
+    CHECK(grid.GetObject(second));
+
+    // Objects removed with their mesh or texture can't be changed through their old IDs
+    unsigned keep = grid.Add(MakeObject(&otherMesh.mMesh, { 0.0f, 0.0f }, { 10.0f, 10.0f }));
+    grid.RemoveObjectsUsing(&mesh.mMesh);
+    unsigned replacement = grid.Add(object);
+    CHECK(!grid.Update(second, object));
+    CHECK(grid.GetObject(replacement));
+    CHECK(grid.GetObject(keep));
+
+    DGL_SpatialObject textured = object;
+    textured.mTexture = gTexture2;
+    unsigned withTexture = grid.Add(textured);
+    grid.RemoveObjectsUsing(gTexture2);
+    CHECK(!grid.GetObject(withTexture));
+    CHECK(grid.GetObjectCount() == 2);
+
+    // Clearing doesn't make old IDs valid again
+    grid.Clear();
+    CHECK(grid.GetObjectCount() == 0);
+    unsigned afterClear = grid.Add(object);
+    CHECK(afterClear != keep && afterClear != replacement);
+    CHECK(!grid.GetObject(keep));
+    CHECK(!grid.Remove(replacement));
+    CHECK(Query(grid, { -1.0f, -1.0f }, { 1.0f, 1.0f }) == std::vector<unsigned>{ afterClear });
+
+    // IDs which were never given out aren't valid
+    CHECK(!grid.GetObject(0));
+    CHECK(!grid.GetObject(12345));
+}
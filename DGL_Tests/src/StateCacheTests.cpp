@@ -0,0 +1,200 @@
+//-------------------------------------------------------------------------------------------------
+// file:    StateCacheTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for which state changes the state cache passes along
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include <d3d11_1.h>
+#include <string.h>
+#include <vector>
+
+import StateCache;
+
+using namespace DGL;
+
+namespace
+{
+
+// Records the name of each call instead of sending it to a device context
+class RecordingContext : public StateContext
+{
+public:
+    void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY) override { Record("Topology"); }
+    void SetInputLayout(ID3D11InputLayout*) override { Record("InputLayout"); }
+    void SetVertexBuffer(UINT, ID3D11Buffer*, UINT, UINT) override { Record("VertexBuffer"); }
+    void SetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) override { Record("IndexBuffer"); }
+    void SetVertexShader(ID3D11VertexShader*) override { Record("VertexShader"); }
+    void SetVertexConstantBuffer(UINT, ID3D11Buffer*) override { Record("ConstantBuffer"); }
+    void SetVertexConstantBufferRange(UINT, ID3D11Buffer*, UINT, UINT) override
+    {
+        Record("ConstantBufferRange");
+    }
+    void SetPixelShader(ID3D11PixelShader*) override { Record("PixelShader"); }
+    void SetPixelShaderResource(ID3D11ShaderResourceView*) override { Record("Resource"); }
+    void SetPixelSampler(ID3D11SamplerState*) override { Record("Sampler"); }
+    void SetBlendState(ID3D11BlendState*) override { Record("BlendState"); }
+
+    void Draw(UINT, UINT) override { Record("Draw"); }
+    void DrawIndexed(UINT, UINT, INT) override { Record("DrawIndexed"); }
+    void DrawInstanced(UINT, UINT, UINT) override { Record("DrawInstanced"); }
+    void DrawIndexedInstanced(UINT, UINT, UINT, INT) override { Record("DrawIndexedInstanced"); }
+
+    // Returns the number of recorded calls with the name
+    unsigned Count(const char* name) const
+    {
+        unsigned count = 0;
+        for (const char* call : mCalls)
+            count += strcmp(call, name) == 0 ? 1 : 0;
+        return count;
+    }
+
+    std::vector<const char*> mCalls;
+
+private:
+    void Record(const char* name)
+    {
+        mCalls.push_back(name);
+    }
+};
+
+// The cache only compares the D3D objects, so any distinct addresses will do
+int gObjects[4];
+
+//*************************************************************************************************
+template <typename T>
+T* FakeObject(int index)
+{
+    return (T*)&gObjects[index];
+}
+
+//*************************************************************************************************
+// Sets one of every kind of state, using the objects at the index
+void SetEverything(StateCache& cache, int index)
+{
+    cache.SetPrimitiveTopology(index ? D3D11_PRIMITIVE_TOPOLOGY_LINELIST :
+        D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    cache.SetInputLayout(FakeObject<ID3D11InputLayout>(index));
+    cache.SetVertexBuffer(0, FakeObject<ID3D11Buffer>(index), 32, 0);
+    cache.SetIndexBuffer(FakeObject<ID3D11Buffer>(index), DXGI_FORMAT_R16_UINT, 0);
+    cache.SetVertexShader(FakeObject<ID3D11VertexShader>(index));
+    cache.SetVertexConstantBuffer(0, FakeObject<ID3D11Buffer>(index));
+    cache.SetVertexConstantBufferRange(1, FakeObject<ID3D11Buffer>(index), 16, 16);
+    cache.SetPixelShader(FakeObject<ID3D11PixelShader>(index));
+    cache.SetPixelShaderResource(FakeObject<ID3D11ShaderResourceView>(index));
+    cache.SetPixelSampler(FakeObject<ID3D11SamplerState>(index));
+    cache.SetBlendState(FakeObject<ID3D11BlendState>(index));
+}
+
+// The number of calls made by SetEverything
+constexpr unsigned state_count{ 11 };
+
+} // namespace
+
+//*************************************************************************************************
+TEST(StateCache_RepeatedSetsSkipped)
+{
+    RecordingContext context;
+    StateCache cache;
+    cache.Initialize(&context);
+
+    SetEverything(cache, 0);
+    SetEverything(cache, 0);
+    SetEverything(cache, 0);
+
+    CHECK(context.mCalls.size() == state_count);
+    CHECK(cache.GetCallsIssued() == state_count);
+    CHECK(cache.GetCallsSkipped() == state_count * 2);
+
+    // Changed values are sent again, including going back to an earlier value
+    SetEverything(cache, 1);
+    SetEverything(cache, 0);
+    CHECK(context.mCalls.size() == state_count * 3);
+}
+
+//*************************************************************************************************
+TEST(StateCache_BindingsCompareEveryValue)
+{
+    RecordingContext context;
+    StateCache cache;
+    cache.Initialize(&context);
+
+    ID3D11Buffer* buffer = FakeObject<ID3D11Buffer>(0);
+
+    // The stride and offset are part of a vertex buffer binding
+    cache.SetVertexBuffer(0, buffer, 32, 0);
+    cache.SetVertexBuffer(0, buffer, 16, 0);
+    cache.SetVertexBuffer(0, buffer, 16, 64);
+    CHECK(context.Count("VertexBuffer") == 3);
+
+    // Each slot is tracked separately, and untracked slots are always sent
+    cache.SetVertexBuffer(1, buffer, 16, 64);
+    cache.SetVertexBuffer(StateCache::max_slots, buffer, 16, 64);
+    cache.SetVertexBuffer(StateCache::max_slots, buffer, 16, 64);
+    CHECK(context.Count("VertexBuffer") == 6);
+
+    // Binding part of a constant buffer is different from binding all of it
+    cache.SetVertexConstantBuffer(1, buffer);
+    cache.SetVertexConstantBufferRange(1, buffer, 0, 16);
+    cache.SetVertexConstantBufferRange(1, buffer, 16, 16);
+    cache.SetVertexConstantBufferRange(1, buffer, 16, 16);
+    cache.SetVertexConstantBuffer(1, buffer);
+    CHECK(context.Count("ConstantBuffer") == 2);
+    CHECK(context.Count("ConstantBufferRange") == 2);
+
+    // The index format is part of an index buffer binding
+    cache.SetIndexBuffer(buffer, DXGI_FORMAT_R16_UINT, 0);
+    cache.SetIndexBuffer(buffer, DXGI_FORMAT_R32_UINT, 0);
+    cache.SetIndexBuffer(buffer, DXGI_FORMAT_R32_UINT, 0);
+    CHECK(context.Count("IndexBuffer") == 2);
+}
+
+//*************************************************************************************************
+TEST(StateCache_ResetSendsEverythingAgain)
+{
+    RecordingContext context;
+    StateCache cache;
+    cache.Initialize(&context);
+
+    SetEverything(cache, 0);
+    cache.Reset();
+    SetEverything(cache, 0);
+    CHECK(context.mCalls.size() == state_count * 2);
+
+    // Starting with a new context forgets the state set on the old one
+    RecordingContext newContext;
+    cache.Initialize(&newContext);
+    SetEverything(cache, 0);
+    CHECK(newContext.mCalls.size() == state_count);
+    CHECK(context.mCalls.size() == state_count * 2);
+
+    // Nothing else is forgotten after the first calls
+    SetEverything(cache, 0);
+    CHECK(newContext.mCalls.size() == state_count);
+}
+
+//*************************************************************************************************
+TEST(StateCache_DrawsAlwaysSent)
+{
+    RecordingContext context;
+    StateCache cache;
+    cache.Initialize(&context);
+
+    cache.Draw(6, 0);
+    cache.Draw(6, 0);
+    cache.DrawIndexed(6, 0, 0);
+    cache.DrawInstanced(6, 10, 0);
+    cache.DrawIndexedInstanced(6, 10, 0, 0);
+
+    CHECK(context.mCalls.size() == 5);
+    CHECK(cache.GetDrawCalls() == 5);
+
+    // Draws don't count as state changes
+    CHECK(cache.GetCallsIssued() == 0);
+    CHECK(cache.GetCallsSkipped() == 0);
+
+    cache.ResetCounters();
+    CHECK(cache.GetDrawCalls() == 0);
+}
@@ -0,0 +1,192 @@
+//-------------------------------------------------------------------------------------------------
+// file:    StaticBatchTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for the vertices and indices built for static batches
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+import Mesh;
+import StaticBatch;
+import Texture;
+
+using namespace DGL;
+
+namespace
+{
+
+// Two meshes for a unit square, one with indices and one without
+struct TestMeshes
+{
+    TestMeshes()
+    {
+        const DGL_Vec2 corners[4] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f },
+            { -0.5f, 0.5f } };
+        const unsigned order[6] = { 0, 1, 2, 0, 2, 3 };
+
+        mIndexed.mVertexCount = 4;
+        mIndexed.mVertexList = new VertexData[4];
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            mIndexed.mVertexList[i] = { corners[i], { 1.0f, 0.5f, 0.25f, 1.0f },
+                { corners[i].x + 0.5f, 0.5f - corners[i].y } };
+        }
+        mIndexed.mIndexCount = 6;
+        mIndexed.mIndices = new unsigned[6];
+        memcpy(mIndexed.mIndices, order, sizeof(order));
+
+        mList.mVertexCount = 6;
+        mList.mVertexList = new VertexData[6];
+        for (unsigned i = 0; i < 6; ++i)
+            mList.mVertexList[i] = mIndexed.mVertexList[order[i]];
+    }
+
+    ~TestMeshes()
+    {
+        delete[] mIndexed.mVertexList;
+        delete[] mIndexed.mIndices;
+        delete[] mList.mVertexList;
+    }
+
+    DGL_Mesh mIndexed;
+    DGL_Mesh mList;
+};
+
+// A set of objects using the test meshes with different transforms, tints, and textures
+struct TestScene
+{
+    TestScene(const TestMeshes& testMeshes, unsigned count)
+    {
+        mAtlasTexture.page = &mAtlasPage;
+        mAtlasTexture.uvOffset = { 0.25f, 0.5f };
+        mAtlasTexture.uvScale = { 0.5f, 0.25f };
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            mMeshes.push_back(i % 3 ? &testMeshes.mIndexed : &testMeshes.mList);
+            mTextures.push_back(i % 4 == 0 ? &mAtlasTexture : i % 4 == 1 ? &mTexture : nullptr);
+
+            DGL_InstanceData instance;
+            instance.mPosition = { (float)(i % 200) * 10.0f, (float)(i / 200) * 10.0f };
+            instance.mScale = { 4.0f + i % 3, 4.0f + i % 5 };
+            instance.mRotation = (float)i * 0.1f;
+            instance.mTintColor = { 0.0f, 0.5f, 1.0f, (float)(i % 4) * 0.25f };
+            instance.mTextureOffset = { (float)(i % 2) * 0.5f, 0.0f };
+            mInstances.push_back(instance);
+        }
+    }
+
+    std::vector<const DGL_Mesh*> mMeshes;
+    std::vector<const DGL_Texture*> mTextures;
+    std::vector<DGL_InstanceData> mInstances;
+    DGL_Texture mTexture;
+    DGL_Texture mAtlasPage;
+    DGL_Texture mAtlasTexture;
+};
+
+} // namespace
+
+//*************************************************************************************************
+TEST(StaticBatch_BuildsTransformedObjects)
+{
+    TestMeshes testMeshes;
+    TestScene scene(testMeshes, 2);
+    scene.mInstances[0] = { { 10.0f, 20.0f }, { 2.0f, 4.0f }, 0.0f, 0.0f,
+        { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } };
+    scene.mInstances[1].mRotation = 0.0f;
+    scene.mInstances[1].mScale = { 1.0f, 1.0f };
+
+    // The objects are built in the listed order, not the order of the arrays
+    std::vector<VertexData> vertices;
+    std::vector<unsigned> indices;
+    StaticBatchBuilder::Build(scene.mMeshes.data(), scene.mTextures.data(),
+        scene.mInstances.data(), { 1, 0 }, vertices, indices, 1);
+    CHECK(vertices.size() == 10);
+    CHECK(indices.size() == 12);
+
+    // The indexed mesh's indices are kept, and the list gets one index for each vertex, moved
+    // to where its vertices are
+    const unsigned expected[12] = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 7, 8, 9 };
+    CHECK(memcmp(indices.data(), expected, sizeof(expected)) == 0);
+
+    // The first object listed is only moved, and its texture isn't in an atlas, so only the
+    // texture offset is added to the texture coordinates
+    const VertexData& corner = vertices[1];
+    DGL_Vec2 position = scene.mInstances[1].mPosition;
+    CHECK(corner.mPosition.x == position.x + 0.5f && corner.mPosition.y == position.y - 0.5f);
+    CHECK(corner.mTexCoord.x == 1.0f + 0.5f && corner.mTexCoord.y == 1.0f);
+
+    // The second is scaled and moved, and has no tint, so the color stays the same. Its
+    // texture coordinates are moved into the atlas texture's part of the page.
+    const VertexData& last = vertices[9];
+    CHECK(last.mPosition.x == 10.0f - 1.0f && last.mPosition.y == 20.0f + 2.0f);
+    CHECK(last.mColor.r == 1.0f && last.mColor.g == 0.5f && last.mColor.a == 1.0f);
+    CHECK(last.mTexCoord.x == 0.25f && last.mTexCoord.y == 0.5f);
+}
+
+//*************************************************************************************************
+TEST(StaticBatch_ThreadsMatchOneThread)
+{
+    TestMeshes testMeshes;
+    TestScene scene(testMeshes, 30000);
+
+    // Leave some objects out and build the rest in a shuffled order
+    std::vector<unsigned> objects;
+    for (unsigned i = 0; i < scene.mMeshes.size(); ++i)
+    {
+        if (i % 7)
+            objects.push_back(i);
+    }
+    unsigned seed = 12345;
+    for (unsigned i = (unsigned)objects.size() - 1; i > 0; --i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        std::swap(objects[i], objects[(seed >> 8) % (i + 1)]);
+    }
+
+    std::vector<VertexData> expectedVertices;
+    std::vector<unsigned> expectedIndices;
+    StaticBatchBuilder::Build(scene.mMeshes.data(), scene.mTextures.data(),
+        scene.mInstances.data(), objects, expectedVertices, expectedIndices, 1);
+    CHECK(expectedVertices.size() >= StaticBatchBuilder::parallel_min_vertices);
+
+    // The objects are split up differently for each number of threads, with each thread
+    // writing its own part of the lists
+    const unsigned threadCounts[] = { 2, 3, 8, 0 };
+    for (unsigned threadCount : threadCounts)
+    {
+        std::vector<VertexData> vertices;
+        std::vector<unsigned> indices;
+        StaticBatchBuilder::Build(scene.mMeshes.data(), scene.mTextures.data(),
+            scene.mInstances.data(), objects, vertices, indices, threadCount);
+        CHECK(vertices.size() == expectedVertices.size());
+        CHECK(indices == expectedIndices);
+        CHECK(memcmp(vertices.data(), expectedVertices.data(),
+            sizeof(VertexData) * vertices.size()) == 0);
+    }
+}
+
+//*************************************************************************************************
+TEST(StaticBatch_BakeColor)
+{
+    // With no tint the color doesn't change
+    DGL_Color color = { 0.25f, 0.5f, 0.75f, 0.5f };
+    DGL_Color baked = StaticBatchBuilder::BakeColor(color, { 1.0f, 1.0f, 1.0f, 0.0f });
+    CHECK(fabsf(baked.r - color.r) < 0.0001f && fabsf(baked.b - color.b) < 0.0001f);
+    CHECK(fabsf(baked.a - color.a) < 0.0001f);
+
+    // A fully tinted transparent color becomes the tint
+    baked = StaticBatchBuilder::BakeColor({ 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+    CHECK(baked.r == 0.0f && baked.g == 1.0f && baked.a == 1.0f);
+
+    // Nothing visible stays invisible
+    baked = StaticBatchBuilder::BakeColor({ 1.0f, 1.0f, 1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f });
+    CHECK(baked.r == 0.0f && baked.a == 0.0f);
+}
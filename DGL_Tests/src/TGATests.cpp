@@ -0,0 +1,180 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TGATests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for decoding and encoding TGA files without WIC
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <vector>
+
+import Mipmap;
+import TGA;
+
+using namespace DGL;
+
+namespace
+{
+
+//*************************************************************************************************
+// Returns a header for a file of the type with the size and pixel layout
+std::vector<unsigned char> MakeHeader(unsigned char type, int width, int height,
+    unsigned char bitsPerPixel, unsigned char descriptor)
+{
+    std::vector<unsigned char> data(18, 0);
+    data[2] = type;
+    data[12] = (unsigned char)width;
+    data[14] = (unsigned char)height;
+    data[16] = bitsPerPixel;
+    data[17] = descriptor;
+    return data;
+}
+
+//*************************************************************************************************
+// Returns a level with flat areas, which run-length encoding shrinks, and areas that change on
+// every pixel
+MipLevel MakeLevel(int width, int height)
+{
+    MipLevel level;
+    level.mWidth = width;
+    level.mHeight = height;
+    level.mPixels.resize((size_t)width * height * 4);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            unsigned char* pixel = &level.mPixels[((size_t)y * width + x) * 4];
+            bool flat = y < height / 2;
+            pixel[0] = (unsigned char)(flat ? x / 10 : x * 7 + y);
+            pixel[1] = (unsigned char)(flat ? y : x * 3);
+            pixel[2] = (unsigned char)(flat ? 50 : y * 11);
+            pixel[3] = (unsigned char)(flat ? 255 : x + y);
+        }
+    }
+    return level;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(TGA_IsTGAFile)
+{
+    CHECK(TGAFile::IsTGAFile("Assets/sprite.tga"));
+    CHECK(TGAFile::IsTGAFile("SPRITE.TGA"));
+    CHECK(!TGAFile::IsTGAFile("sprite.png"));
+    CHECK(!TGAFile::IsTGAFile("tga"));
+}
+
+//*************************************************************************************************
+TEST(TGA_EncodeDecode)
+{
+    MipLevel level = MakeLevel(300, 20);
+
+    // Both kinds of file decode to the same pixels, including rows longer than one packet
+    std::vector<unsigned char> raw, runLength;
+    TGAFile::Encode(level, false, raw);
+    TGAFile::Encode(level, true, runLength);
+    CHECK(raw.size() == 18 + level.mPixels.size());
+    CHECK(runLength.size() < raw.size());
+
+    MipLevel decoded;
+    CHECK(TGAFile::Decode(raw.data(), raw.size(), decoded));
+    CHECK(decoded.mWidth == 300 && decoded.mHeight == 20);
+    CHECK(decoded.mPixels == level.mPixels);
+
+    decoded = MipLevel();
+    CHECK(TGAFile::Decode(runLength.data(), runLength.size(), decoded));
+    CHECK(decoded.mPixels == level.mPixels);
+
+    // A single pixel is a list with one entry
+    MipLevel single = MakeLevel(1, 1);
+    TGAFile::Encode(single, true, runLength);
+    CHECK(runLength.size() == 18 + 1 + 4);
+    CHECK(TGAFile::Decode(runLength.data(), runLength.size(), decoded));
+    CHECK(decoded.mPixels == single.mPixels);
+}
+
+//*************************************************************************************************
+TEST(TGA_PixelOrder)
+{
+    // A 2x2 24 bit file stored from the bottom up, with pixels as BGR
+    std::vector<unsigned char> data = MakeHeader(2, 2, 2, 24, 0);
+    const unsigned char pixels[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    data.insert(data.end(), pixels, pixels + 12);
+
+    // The last row in the file is the top row, and pixels without alpha are opaque
+    MipLevel level;
+    CHECK(TGAFile::Decode(data.data(), data.size(), level));
+    const unsigned char expected[16] = { 9, 8, 7, 255, 12, 11, 10, 255, 3, 2, 1, 255,
+        6, 5, 4, 255 };
+    CHECK(level.mPixels == std::vector<unsigned char>(expected, expected + 16));
+
+    // Files can also be stored from right to left
+    data[17] = 0x30;
+    CHECK(TGAFile::Decode(data.data(), data.size(), level));
+    const unsigned char flipped[16] = { 6, 5, 4, 255, 3, 2, 1, 255, 12, 11, 10, 255,
+        9, 8, 7, 255 };
+    CHECK(level.mPixels == std::vector<unsigned char>(flipped, flipped + 16));
+
+    // The image ID and an unused color map are skipped
+    data[0] = 2;
+    data[1] = 1;
+    data[5] = 1;
+    data[7] = 24;
+    const unsigned char extra[5] = { 99, 99, 99, 99, 99 };
+    data.insert(data.begin() + 18, extra, extra + 5);
+    CHECK(TGAFile::Decode(data.data(), data.size(), level));
+    CHECK(level.mPixels == std::vector<unsigned char>(flipped, flipped + 16));
+}
+
+//*************************************************************************************************
+TEST(TGA_Grayscale)
+{
+    // A run-length encoded 3x1 grayscale file with alpha, as a run of two then a list of one
+    std::vector<unsigned char> data = MakeHeader(11, 3, 1, 16, 0x20);
+    const unsigned char packets[6] = { 0x81, 40, 200, 0x00, 90, 10 };
+    data.insert(data.end(), packets, packets + 6);
+
+    MipLevel level;
+    CHECK(TGAFile::Decode(data.data(), data.size(), level));
+    const unsigned char expected[12] = { 40, 40, 40, 200, 40, 40, 40, 200, 90, 90, 90, 10 };
+    CHECK(level.mPixels == std::vector<unsigned char>(expected, expected + 12));
+}
+
+//*************************************************************************************************
+TEST(TGA_RejectsBadFiles)
+{
+    MipLevel level;
+    std::vector<unsigned char> data = MakeHeader(2, 2, 2, 32, 0);
+    CHECK(!TGAFile::Decode(data.data(), 10, level));
+
+    // The pixels end early
+    data.resize(18 + 15);
+    CHECK(!TGAFile::Decode(data.data(), data.size(), level));
+    data.resize(18 + 16);
+    CHECK(TGAFile::Decode(data.data(), data.size(), level));
+
+    // Color mapped files, 16 bit color, and empty images aren't supported
+    data[2] = 1;
+    CHECK(!TGAFile::Decode(data.data(), data.size(), level));
+    data[2] = 2;
+    data[16] = 16;
+    CHECK(!TGAFile::Decode(data.data(), data.size(), level));
+    data[16] = 32;
+    data[12] = 0;
+    CHECK(!TGAFile::Decode(data.data(), data.size(), level));
+
+    // A run-length packet can't go past the last pixel or the end of the data
+    std::vector<unsigned char> runLength = MakeHeader(10, 2, 1, 32, 0);
+    const unsigned char tooLong[5] = { 0x82, 1, 2, 3, 4 };
+    runLength.insert(runLength.end(), tooLong, tooLong + 5);
+    CHECK(!TGAFile::Decode(runLength.data(), runLength.size(), level));
+    runLength[18] = 0x01;
+    CHECK(!TGAFile::Decode(runLength.data(), runLength.size(), level));
+    runLength[18] = 0x81;
+    CHECK(TGAFile::Decode(runLength.data(), runLength.size(), level));
+
+    CHECK(!TGAFile::Read("file that doesn't exist.tga", level));
+}
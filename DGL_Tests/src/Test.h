@@ -0,0 +1,37 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Test.h
+// author:  Andy Ellinger
+// brief:   Defining and checking tests for the library parts that don't need a graphics device
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace DGLTest
+{
+
+// A test function and its name. Each test adds itself to a list when the program starts.
+struct TestCase
+{
+    TestCase(const char* name, void (*function)());
+
+    const char* mName;
+    void (*mFunction)();
+    TestCase* mNext{ nullptr };
+};
+
+// Prints the failed check and marks the current test as failed
+void Fail(const char* expression, const char* file, int line);
+
+} // namespace DGLTest
+
+// Defines a test function which is run by TestMain
+#define TEST(name) \
+    static void name(); \
+    static DGLTest::TestCase name##_case(#name, name); \
+    static void name()
+
+// Fails the current test if the expression is false, and keeps running it
+#define CHECK(expression) \
+    ((expression) ? (void)0 : DGLTest::Fail(#expression, __FILE__, __LINE__))
@@ -0,0 +1,73 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TestMain.cpp
+// author:  Andy Ellinger
+// brief:   Running every test and reporting the results
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include <stdio.h>
+
+namespace DGLTest
+{
+
+namespace
+{
+
+// The tests in the order they were added
+TestCase* gFirst{ nullptr };
+TestCase* gLast{ nullptr };
+// The number of checks that failed in the current test
+unsigned gFailures{ 0 };
+
+} // namespace
+
+//*************************************************************************************************
+TestCase::TestCase(const char* name, void (*function)()) :
+    mName(name),
+    mFunction(function)
+{
+    // The pointers are zero before any constructors run, so the order tests are added in
+    // doesn't matter
+    if (gLast)
+        gLast->mNext = this;
+    else
+        gFirst = this;
+    gLast = this;
+}
+
+//*************************************************************************************************
+void Fail(const char* expression, const char* file, int line)
+{
+    printf("    %s(%d): CHECK(%s) failed\n", file, line, expression);
+    ++gFailures;
+}
+
+} // namespace DGLTest
+
+//*************************************************************************************************
+int main()
+{
+    unsigned tests = 0;
+    unsigned failedTests = 0;
+    for (DGLTest::TestCase* test = DGLTest::gFirst; test; test = test->mNext)
+    {
+        DGLTest::gFailures = 0;
+        test->mFunction();
+
+        ++tests;
+        if (DGLTest::gFailures)
+        {
+            ++failedTests;
+            printf("FAILED  %s\n", test->mName);
+        }
+        else
+            printf("passed  %s\n", test->mName);
+    }
+
+    printf("%u of %u tests passed\n", tests - failedTests, tests);
+
+    // A non-zero result fails the post-build step
+    return failedTests ? 1 : 0;
+}
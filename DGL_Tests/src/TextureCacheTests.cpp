@@ -0,0 +1,213 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TextureCacheTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for sharing, keeping, and releasing textures in the texture cache
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <vector>
+
+import Texture;
+import TextureCache;
+
+using namespace DGL;
+
+namespace
+{
+
+// The cache only stores and compares the textures, so they are never created
+DGL_Texture fake_textures[4];
+
+//*************************************************************************************************
+// Returns the cache's counters
+DGL_TextureCacheStats GetStats(const TextureCache& cache)
+{
+    DGL_TextureCacheStats stats;
+    cache.GetStats(&stats);
+    return stats;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(TextureCache_HitSharesTexture)
+{
+    TextureCache cache;
+    TextureLoadSettings settings;
+    std::vector<DGL_Texture*> released;
+    cache.SetEnabled(true, released);
+    cache.SetRetainedBytes(1000, released);
+    DGL_Texture* texture = &fake_textures[0];
+
+    CHECK(!cache.Find("Assets/Hero.png", settings));
+    cache.Add("Assets/Hero.png", settings, texture, 100);
+
+    // The same file with a different case is the same texture, and each load is a reference
+    CHECK(cache.Find("Assets/Hero.png", settings) == texture);
+    CHECK(cache.Find("assets/HERO.PNG", settings) == texture);
+
+    // Different settings make a different texture
+    TextureLoadSettings mipmapped;
+    mipmapped.mMipmapMode = DGL_MM_BOX;
+    CHECK(!cache.Find("Assets/Hero.png", mipmapped));
+
+    DGL_TextureCacheStats stats = GetStats(cache);
+    CHECK(stats.mHits == 2);
+    CHECK(stats.mMisses == 2);
+    CHECK(stats.mTextures == 1);
+    CHECK(stats.mResidentBytes == 100);
+
+    // The texture is only kept when the last reference is released
+    CHECK(cache.Release(texture, released) == 2);
+    CHECK(cache.Release(texture, released) == 1);
+    CHECK(GetStats(cache).mRetainedTextures == 0);
+    CHECK(cache.Release(texture, released) == 0);
+    CHECK(released.empty());
+    CHECK(cache.Contains(texture));
+
+    stats = GetStats(cache);
+    CHECK(stats.mTextures == 0);
+    CHECK(stats.mRetainedTextures == 1);
+    CHECK(stats.mRetainedBytes == 100);
+    CHECK(stats.mResidentBytes == 100);
+
+    // Loading it again uses the kept texture
+    CHECK(cache.Find("Assets/Hero.png", settings) == texture);
+    stats = GetStats(cache);
+    CHECK(stats.mHits == 3);
+    CHECK(stats.mTextures == 1);
+    CHECK(stats.mRetainedTextures == 0);
+    CHECK(stats.mRetainedBytes == 0);
+}
+
+//*************************************************************************************************
+TEST(TextureCache_TrimsOldestFirst)
+{
+    TextureCache cache;
+    TextureLoadSettings settings;
+    std::vector<DGL_Texture*> released;
+    cache.SetEnabled(true, released);
+    cache.SetRetainedBytes(250, released);
+
+    const char* names[3] = { "a.png", "b.png", "c.png" };
+    for (unsigned i = 0; i < 3; ++i)
+        cache.Add(names[i], settings, &fake_textures[i], 100);
+
+    // Only two fit in the budget, so the first one released goes when the third is released
+    cache.Release(&fake_textures[0], released);
+    cache.Release(&fake_textures[1], released);
+    CHECK(released.empty());
+    cache.Release(&fake_textures[2], released);
+    CHECK(released.size() == 1 && released[0] == &fake_textures[0]);
+    CHECK(!cache.Contains(&fake_textures[0]));
+    CHECK(!cache.Find("a.png", settings));
+
+    DGL_TextureCacheStats stats = GetStats(cache);
+    CHECK(stats.mEvictions == 1);
+    CHECK(stats.mRetainedTextures == 2);
+    CHECK(stats.mRetainedBytes == 200);
+    CHECK(stats.mResidentBytes == 200);
+
+    // Lowering the budget releases the oldest of the rest
+    cache.SetRetainedBytes(100, released);
+    CHECK(released.size() == 2 && released[1] == &fake_textures[1]);
+    CHECK(cache.Contains(&fake_textures[2]));
+
+    stats = GetStats(cache);
+    CHECK(stats.mEvictions == 2);
+    CHECK(stats.mRetainedTextures == 1);
+    CHECK(stats.mRetainedBytes == 100);
+}
+
+//*************************************************************************************************
+TEST(TextureCache_ReleasesTextureLargerThanBudget)
+{
+    TextureCache cache;
+    TextureLoadSettings settings;
+    std::vector<DGL_Texture*> released;
+    cache.SetEnabled(true, released);
+    cache.SetRetainedBytes(150, released);
+
+    cache.Add("small.png", settings, &fake_textures[0], 100);
+    cache.Add("large.png", settings, &fake_textures[1], 200);
+    cache.Release(&fake_textures[0], released);
+
+    // The large texture is released at once, and the smaller one kept before it stays
+    cache.Release(&fake_textures[1], released);
+    CHECK(released.size() == 1 && released[0] == &fake_textures[1]);
+    CHECK(!cache.Contains(&fake_textures[1]));
+    CHECK(cache.Contains(&fake_textures[0]));
+
+    DGL_TextureCacheStats stats = GetStats(cache);
+    CHECK(stats.mEvictions == 1);
+    CHECK(stats.mRetainedTextures == 1);
+    CHECK(stats.mRetainedBytes == 100);
+    CHECK(stats.mResidentBytes == 100);
+}
+
+//*************************************************************************************************
+TEST(TextureCache_DisablingClearsRetained)
+{
+    TextureCache cache;
+    TextureLoadSettings settings;
+    std::vector<DGL_Texture*> released;
+    cache.SetEnabled(true, released);
+    cache.SetRetainedBytes(1000, released);
+
+    cache.Add("kept.png", settings, &fake_textures[0], 100);
+    cache.Add("used.png", settings, &fake_textures[1], 50);
+    cache.Release(&fake_textures[0], released);
+
+    // Only the texture with no references is released, since the other one is still used
+    cache.SetEnabled(false, released);
+    CHECK(released.size() == 1 && released[0] == &fake_textures[0]);
+    CHECK(cache.Contains(&fake_textures[1]));
+
+    DGL_TextureCacheStats stats = GetStats(cache);
+    CHECK(stats.mRetainedTextures == 0);
+    CHECK(stats.mRetainedBytes == 0);
+    CHECK(stats.mResidentBytes == 50);
+
+    // Nothing is found or counted while caching is off, and the last release of a texture
+    // loaded before it was turned off releases it at once
+    CHECK(!cache.Find("used.png", settings));
+    CHECK(GetStats(cache).mHits == 0 && GetStats(cache).mMisses == 0);
+    cache.Release(&fake_textures[1], released);
+    CHECK(released.size() == 2 && released[1] == &fake_textures[1]);
+
+    stats = GetStats(cache);
+    CHECK(stats.mEvictions == 2);
+    CHECK(stats.mTextures == 0);
+    CHECK(stats.mResidentBytes == 0);
+}
+
+//*************************************************************************************************
+TEST(TextureCache_ResetClearsCounters)
+{
+    TextureCache cache;
+    TextureLoadSettings settings;
+    std::vector<DGL_Texture*> released;
+    cache.SetEnabled(true, released);
+    cache.SetRetainedBytes(1000, released);
+
+    cache.Find("a.png", settings);
+    cache.Add("a.png", settings, &fake_textures[0], 100);
+    cache.Find("a.png", settings);
+    cache.Release(&fake_textures[0], released);
+    cache.Release(&fake_textures[0], released);
+
+    cache.Reset(released);
+    CHECK(released.size() == 1 && released[0] == &fake_textures[0]);
+
+    DGL_TextureCacheStats stats = GetStats(cache);
+    CHECK(stats.mHits == 0);
+    CHECK(stats.mMisses == 0);
+    CHECK(stats.mEvictions == 0);
+    CHECK(stats.mTextures == 0);
+    CHECK(stats.mRetainedTextures == 0);
+    CHECK(stats.mResidentBytes == 0);
+    CHECK(stats.mRetainedBytes == 0);
+}
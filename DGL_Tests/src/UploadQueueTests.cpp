@@ -0,0 +1,243 @@
+//-------------------------------------------------------------------------------------------------
+// file:    UploadQueueTests.cpp
+// author:  Andy Ellinger
+// brief:   Tests for which copies the upload queue makes, in what order, and which it combines
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+#include "DGL.h"
+#include "Test.h"
+#include <d3d11.h>
+#include <map>
+#include <vector>
+
+import UploadQueue;
+
+using namespace DGL;
+
+namespace
+{
+
+// One call made to the context
+struct Call
+{
+    // The resource copied into, or null for generating mipmaps
+    ID3D11Resource* mResource;
+    // The view mipmaps were generated for, or null for a copy
+    ID3D11ShaderResourceView* mMipView;
+    // The area copied into, or all zero if no box was passed
+    D3D11_BOX mBox;
+    UINT mRowPitch;
+    // The first bytes of the data, up to the size of the box for buffers
+    std::vector<char> mData;
+};
+
+// Records the calls instead of copying anything, and counts the references the queue holds
+class RecordingUploadContext : public UploadContext
+{
+public:
+    void UpdateSubresource(ID3D11Resource* resource, const D3D11_BOX* box, const void* data,
+        UINT rowPitch) override
+    {
+        Call call = { resource, nullptr, box ? *box : D3D11_BOX{ 0 }, rowPitch };
+        unsigned size = box && !rowPitch ? box->right - box->left : rowPitch;
+        call.mData.assign((const char*)data, (const char*)data + size);
+        mCalls.push_back(call);
+    }
+
+    void GenerateMips(ID3D11ShaderResourceView* view) override
+    {
+        mCalls.push_back({ nullptr, view });
+    }
+
+    void AddRef(IUnknown* object) override
+    {
+        ++mReferences[object];
+    }
+
+    void Release(IUnknown* object) override
+    {
+        --mReferences[object];
+    }
+
+    // Returns the number of references the queue holds to the object
+    int GetReferences(IUnknown* object)
+    {
+        return mReferences[object];
+    }
+
+    std::vector<Call> mCalls;
+    std::map<IUnknown*, int> mReferences;
+};
+
+// Stands in for the D3D objects, which are only compared and never used
+char fake_objects[4];
+
+//*************************************************************************************************
+template <typename T>
+T* FakeObject(unsigned i)
+{
+    return reinterpret_cast<T*>(&fake_objects[i]);
+}
+
+//*************************************************************************************************
+// Returns true if the call is a copy into the buffer covering the bytes
+bool IsBufferCopy(const Call& call, ID3D11Buffer* buffer, unsigned start, unsigned end)
+{
+    return call.mResource == buffer && !call.mMipView && call.mRowPitch == 0
+        && call.mBox.left == start && call.mBox.right == end && call.mBox.bottom == 1
+        && call.mBox.back == 1;
+}
+
+} // namespace
+
+//*************************************************************************************************
+TEST(UploadQueue_CopiesRightAwayWithoutBatching)
+{
+    RecordingUploadContext context;
+    UploadQueue queue;
+    queue.Initialize(&context);
+    ID3D11Buffer* buffer = FakeObject<ID3D11Buffer>(0);
+
+    char data[16] = { 1, 2, 3 };
+    queue.UploadBuffer(buffer, 32, data, 16);
+    CHECK(context.mCalls.size() == 1);
+    CHECK(IsBufferCopy(context.mCalls[0], buffer, 32, 48));
+    CHECK(context.mCalls[0].mData[2] == 3);
+
+    // Nothing waits, so no references are kept and flushing does nothing
+    CHECK(context.mReferences.empty());
+    queue.Flush();
+    CHECK(context.mCalls.size() == 1);
+
+    DGL_UploadStats stats;
+    queue.GetStats(&stats);
+    CHECK(stats.mFlushes == 0);
+    CHECK(stats.mTotalBytes == 16);
+}
+
+//*************************************************************************************************
+TEST(UploadQueue_CombinesTouchingBufferUploads)
+{
+    RecordingUploadContext context;
+    UploadQueue queue;
+    queue.Initialize(&context);
+    queue.SetBatching(true);
+    ID3D11Buffer* first = FakeObject<ID3D11Buffer>(0);
+    ID3D11Buffer* second = FakeObject<ID3D11Buffer>(1);
+
+    char data[32];
+    for (char i = 0; i < 32; ++i)
+        data[i] = i;
+
+    // Only an upload that starts where the last one in the same buffer ended is combined
+    queue.UploadBuffer(first, 0, data, 16);
+    queue.UploadBuffer(first, 16, data + 16, 8);
+    queue.UploadBuffer(first, 32, data, 8);
+    queue.UploadBuffer(second, 40, data, 4);
+    queue.UploadBuffer(first, 40, data, 4);
+    CHECK(context.mCalls.empty());
+
+    // Each copy waiting holds a reference to its buffer
+    CHECK(context.GetReferences(first) == 3);
+    CHECK(context.GetReferences(second) == 1);
+
+    queue.Flush();
+    CHECK(context.mCalls.size() == 4);
+    CHECK(IsBufferCopy(context.mCalls[0], first, 0, 24));
+    CHECK(IsBufferCopy(context.mCalls[1], first, 32, 40));
+    CHECK(IsBufferCopy(context.mCalls[2], second, 40, 44));
+    CHECK(IsBufferCopy(context.mCalls[3], first, 40, 44));
+
+    // The combined copy has both uploads' data in order
+    CHECK(context.mCalls[0].mData == std::vector<char>(data, data + 24));
+
+    CHECK(context.GetReferences(first) == 0);
+    CHECK(context.GetReferences(second) == 0);
+
+    DGL_UploadStats stats;
+    queue.GetStats(&stats);
+    CHECK(stats.mFlushes == 1);
+    CHECK(stats.mLastFlushUploads == 5);
+    CHECK(stats.mLastFlushCopies == 4);
+    CHECK(stats.mLastFlushBytes == 40);
+    CHECK(stats.mPendingUploads == 0);
+    CHECK(stats.mPendingBytes == 0);
+}
+
+//*************************************************************************************************
+TEST(UploadQueue_MipsAfterCopies)
+{
+    RecordingUploadContext context;
+    UploadQueue queue;
+    queue.Initialize(&context);
+    queue.SetBatching(true);
+    ID3D11Texture2D* texture = FakeObject<ID3D11Texture2D>(0);
+    ID3D11ShaderResourceView* view = FakeObject<ID3D11ShaderResourceView>(1);
+    ID3D11Buffer* buffer = FakeObject<ID3D11Buffer>(2);
+
+    char pixels[64] = {};
+    char data[16] = {};
+    queue.UploadBuffer(buffer, 0, data, 8);
+    queue.UploadTexture(texture, pixels, 16, 4);
+    queue.GenerateMips(view);
+    queue.UploadTextureRegion(texture, 1, 2, 2, 1, pixels, 8);
+
+    // The buffer upload touches the first one, but the texture uploads are between them
+    queue.UploadBuffer(buffer, 8, data, 8);
+
+    // Everything is done in the order it was asked for, so the smaller levels are made from
+    // the first level after it is filled in, and the later region isn't in them
+    queue.Flush();
+    CHECK(context.mCalls.size() == 5);
+    CHECK(IsBufferCopy(context.mCalls[0], buffer, 0, 8));
+
+    const Call& whole = context.mCalls[1];
+    CHECK(whole.mResource == texture);
+    CHECK(whole.mRowPitch == 16);
+    CHECK(whole.mBox.right == 0);
+
+    CHECK(!context.mCalls[2].mResource);
+    CHECK(context.mCalls[2].mMipView == view);
+
+    const Call& region = context.mCalls[3];
+    CHECK(region.mResource == texture);
+    CHECK(region.mRowPitch == 8);
+    CHECK(region.mBox.left == 1 && region.mBox.right == 3);
+    CHECK(region.mBox.top == 2 && region.mBox.bottom == 3);
+
+    CHECK(IsBufferCopy(context.mCalls[4], buffer, 8, 16));
+
+    CHECK(context.GetReferences(texture) == 0);
+    CHECK(context.GetReferences(view) == 0);
+    CHECK(context.GetReferences(buffer) == 0);
+}
+
+//*************************************************************************************************
+TEST(UploadQueue_TurningBatchingOffFlushes)
+{
+    RecordingUploadContext context;
+    UploadQueue queue;
+    queue.Initialize(&context);
+    queue.SetBatching(true);
+    ID3D11Buffer* buffer = FakeObject<ID3D11Buffer>(0);
+    ID3D11ShaderResourceView* view = FakeObject<ID3D11ShaderResourceView>(1);
+
+    char data[8] = {};
+    queue.UploadBuffer(buffer, 0, data, 8);
+    queue.SetBatching(false);
+    CHECK(context.mCalls.size() == 1);
+    CHECK(!queue.IsBatching());
+
+    // Releasing the queue drops waiting uploads without copying them
+    queue.SetBatching(true);
+    queue.UploadBuffer(buffer, 8, data, 8);
+    queue.GenerateMips(view);
+    CHECK(context.GetReferences(buffer) == 1);
+    CHECK(context.GetReferences(view) == 1);
+    queue.Release();
+    CHECK(context.mCalls.size() == 1);
+    CHECK(context.GetReferences(buffer) == 0);
+    CHECK(context.GetReferences(view) == 0);
+}
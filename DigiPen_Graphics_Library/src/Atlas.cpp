@@ -0,0 +1,377 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Atlas.cpp
+// author:  Andy Ellinger
+// brief:   Packing many textures into a few large atlas pages
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include "WICTextureLoader11.h"
+#include <d3d11.h>
+#include <sstream>
+#include <string.h>
+#include <vector>
+
+module Atlas;
+
+import Errors;
+import Texture;
+import UploadQueue;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- SkylinePacker
+
+//*************************************************************************************************
+void SkylinePacker::Reset(int width, int height)
+{
+    mSkyline.clear();
+    mSkyline.push_back({ 0, 0, width });
+    mWidth = width;
+    mHeight = height;
+    mUsedArea = 0;
+}
+
+//*************************************************************************************************
+bool SkylinePacker::Pack(int width, int height, int& x, int& y)
+{
+    if (width <= 0 || height <= 0)
+        return false;
+
+    // Find the segment where the top of the rectangle would be lowest
+    size_t best = mSkyline.size();
+    int bestTop = 0;
+    int bestWidth = 0;
+    for (size_t i = 0; i < mSkyline.size(); ++i)
+    {
+        int segmentY = FindY(i, width, height);
+        if (segmentY < 0)
+            continue;
+
+        int top = segmentY + height;
+        if (best == mSkyline.size() || top < bestTop ||
+            (top == bestTop && mSkyline[i].mWidth < bestWidth))
+        {
+            best = i;
+            bestTop = top;
+            bestWidth = mSkyline[i].mWidth;
+            y = segmentY;
+        }
+    }
+
+    if (best == mSkyline.size())
+        return false;
+
+    x = mSkyline[best].mX;
+
+    // Add a segment for the top of the rectangle, then cut the segments it covers
+    mSkyline.insert(mSkyline.begin() + best, { x, y + height, width });
+    size_t next = best + 1;
+    while (next < mSkyline.size() && mSkyline[next].mX < x + width)
+    {
+        Segment& segment = mSkyline[next];
+        int covered = x + width - segment.mX;
+        if (covered < segment.mWidth)
+        {
+            segment.mX += covered;
+            segment.mWidth -= covered;
+            break;
+        }
+
+        mSkyline.erase(mSkyline.begin() + next);
+    }
+
+    // Join segments with the same height
+    for (size_t i = 0; i + 1 < mSkyline.size();)
+    {
+        if (mSkyline[i].mY == mSkyline[i + 1].mY)
+        {
+            mSkyline[i].mWidth += mSkyline[i + 1].mWidth;
+            mSkyline.erase(mSkyline.begin() + i + 1);
+        }
+        else
+            ++i;
+    }
+
+    mUsedArea += (unsigned long long)width * height;
+
+    return true;
+}
+
+//*************************************************************************************************
+int SkylinePacker::GetWidth() const
+{
+    return mWidth;
+}
+
+//*************************************************************************************************
+int SkylinePacker::GetHeight() const
+{
+    return mHeight;
+}
+
+//*************************************************************************************************
+unsigned long long SkylinePacker::GetUsedArea() const
+{
+    return mUsedArea;
+}
+
+//*************************************************************************************************
+int SkylinePacker::FindY(size_t segment, int width, int height) const
+{
+    if (mSkyline[segment].mX + width > mWidth)
+        return -1;
+
+    // The rectangle has to sit on the highest segment it covers
+    int y = 0;
+    int remaining = width;
+    for (size_t i = segment; remaining > 0; ++i)
+    {
+        if (mSkyline[i].mY > y)
+            y = mSkyline[i].mY;
+        if (y + height > mHeight)
+            return -1;
+
+        remaining -= mSkyline[i].mWidth;
+    }
+
+    return y;
+}
+
+//------------------------------------------------------------------------------------ AtlasManager
+
+//*************************************************************************************************
+DGL_Atlas* AtlasManager::CreateAtlas(int pageWidth, int pageHeight)
+{
+    DGL_Atlas* atlas = new DGL_Atlas;
+    atlas->mPageWidth = pageWidth;
+    atlas->mPageHeight = pageHeight;
+
+    return atlas;
+}
+
+//*************************************************************************************************
+DGL_Texture* AtlasManager::AddTexture(DGL_Atlas* atlas, const char* pFileName,
+    ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+{
+    if (!device || !deviceContext)
+    {
+        gError->SetError("Trying to load texture when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    // Translate the file name to wide char
+    std::wstring wideFileName;
+    size_t fileNameSize = strlen(pFileName);
+    for (unsigned i = 0; i < fileNameSize; ++i)
+        wideFileName += (wchar_t)pFileName[i];
+
+    // Load the file into a temporary texture with the same format as the pages
+    ID3D11Resource* temp = nullptr;
+    HRESULT hr = DirectX::CreateWICTextureFromFileEx(
+        device,
+        wideFileName.c_str(),
+        0,
+        D3D11_USAGE_DEFAULT,
+        0,
+        0,
+        0,
+        DirectX::WIC_LOADER_IGNORE_SRGB | DirectX::WIC_LOADER_FORCE_RGBA32,
+        &temp,
+        nullptr
+    );
+    if (FAILED(hr))
+    {
+        std::stringstream stream;
+        stream << "Failed to load texture from file \"" << pFileName << "\". ";
+        gError->SetError(stream.str(), hr);
+        return nullptr;
+    }
+
+    D3D11_TEXTURE2D_DESC texInfo{ 0 };
+    ((ID3D11Texture2D*)temp)->GetDesc(&texInfo);
+    int width = (int)texInfo.Width;
+    int height = (int)texInfo.Height;
+
+    unsigned page;
+    int x, y;
+    if (!FindSpace(atlas, width, height, device, page, x, y))
+    {
+        temp->Release();
+        return nullptr;
+    }
+
+    // Copy the texture into the page, then copy its edges into the padding around it
+    ID3D11Resource* pageTexture = atlas->mPages[page].mTexture->texture;
+    auto copy = [&](UINT left, UINT top, UINT right, UINT bottom, int destX, int destY)
+    {
+        D3D11_BOX box = { left, top, 0, right, bottom, 1 };
+        deviceContext->CopySubresourceRegion(pageTexture, 0, destX, destY, 0, temp, 0, &box);
+    };
+    UINT w = texInfo.Width;
+    UINT h = texInfo.Height;
+    copy(0, 0, w, h, x, y);
+    for (int i = 1; i <= padding; ++i)
+    {
+        copy(0, 0, 1, h, x - i, y);
+        copy(w - 1, 0, w, h, x + width - 1 + i, y);
+        copy(0, 0, w, 1, x, y - i);
+        copy(0, h - 1, w, h, x, y + height - 1 + i);
+
+        for (int j = 1; j <= padding; ++j)
+        {
+            copy(0, 0, 1, 1, x - i, y - j);
+            copy(w - 1, 0, w, 1, x + width - 1 + i, y - j);
+            copy(0, h - 1, 1, h, x - i, y + height - 1 + j);
+            copy(w - 1, h - 1, w, h, x + width - 1 + i, y + height - 1 + j);
+        }
+    }
+
+    temp->Release();
+
+    return AddSubTexture(atlas, page, x, y, width, height);
+}
+
+//*************************************************************************************************
+DGL_Texture* AtlasManager::AddTextureFromMemory(DGL_Atlas* atlas, const unsigned char* data,
+    int width, int height, ID3D11Device* device, UploadQueue* uploads)
+{
+    if (!device)
+    {
+        gError->SetError("Trying to load texture when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    unsigned page;
+    int x, y;
+    if (!FindSpace(atlas, width, height, device, page, x, y))
+        return nullptr;
+
+    // Build the pixels with the padding around them, repeating the edge pixels
+    int paddedWidth = width + padding * 2;
+    int paddedHeight = height + padding * 2;
+    std::vector<unsigned char> pixels((size_t)paddedWidth * paddedHeight * 4);
+    for (int row = 0; row < paddedHeight; ++row)
+    {
+        int sourceRow = row < padding ? 0 : row - padding;
+        if (sourceRow >= height)
+            sourceRow = height - 1;
+
+        const unsigned char* source = data + (size_t)sourceRow * width * 4;
+        unsigned char* dest = pixels.data() + (size_t)row * paddedWidth * 4;
+        for (int i = 0; i < padding; ++i)
+        {
+            memcpy(dest + i * 4, source, 4);
+            memcpy(dest + (padding + width + i) * 4, source + (width - 1) * 4, 4);
+        }
+        memcpy(dest + padding * 4, source, (size_t)width * 4);
+    }
+
+    uploads->UploadTextureRegion(atlas->mPages[page].mTexture->texture, x - padding, y - padding,
+        paddedWidth, paddedHeight, pixels.data(), paddedWidth * 4);
+
+    return AddSubTexture(atlas, page, x, y, width, height);
+}
+
+//*************************************************************************************************
+void AtlasManager::GetStats(const DGL_Atlas* atlas, DGL_AtlasStats* stats)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    stats->mPages = (unsigned)atlas->mPages.size();
+    stats->mTextures = (unsigned)atlas->mTextures.size();
+    stats->mPagePixels = (unsigned long long)atlas->mPageWidth * atlas->mPageHeight *
+        atlas->mPages.size();
+    stats->mUsedPixels = atlas->mUsedPixels;
+    stats->mPackSeconds = (double)atlas->mPackTicks / frequency.QuadPart;
+}
+
+//*************************************************************************************************
+void AtlasManager::ReleaseAtlas(DGL_Atlas* atlas)
+{
+    if (!atlas)
+        return;
+
+    // The atlas textures don't have their own D3D objects, so this just deletes them
+    for (DGL_Texture* texture : atlas->mTextures)
+        TextureManager::ReleaseTexture(texture);
+
+    for (DGL_Atlas::Page& page : atlas->mPages)
+        TextureManager::ReleaseTexture(page.mTexture);
+
+    delete atlas;
+}
+
+//*************************************************************************************************
+bool AtlasManager::FindSpace(DGL_Atlas* atlas, int width, int height, ID3D11Device* device,
+    unsigned& page, int& x, int& y)
+{
+    int paddedWidth = width + padding * 2;
+    int paddedHeight = height + padding * 2;
+    if (paddedWidth > atlas->mPageWidth || paddedHeight > atlas->mPageHeight)
+    {
+        gError->SetError("Couldn't add texture to atlas, it is larger than the atlas pages.");
+        return false;
+    }
+
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+
+    // Use the first page with space, since earlier pages are the most full
+    bool found = false;
+    for (page = 0; page < atlas->mPages.size() && !found; ++page)
+        found = atlas->mPages[page].mPacker.Pack(paddedWidth, paddedHeight, x, y);
+
+    QueryPerformanceCounter(&end);
+    atlas->mPackTicks += end.QuadPart - start.QuadPart;
+
+    if (found)
+        --page;
+    else
+    {
+        // None of the pages had space, so add a new one
+        DGL_Texture* texture = TextureManager::CreateTexture(nullptr, atlas->mPageWidth,
+            atlas->mPageHeight, device);
+        if (!texture)
+            return false;
+
+        atlas->mPages.push_back({ texture });
+        page = (unsigned)atlas->mPages.size() - 1;
+
+        SkylinePacker& packer = atlas->mPages[page].mPacker;
+        packer.Reset(atlas->mPageWidth, atlas->mPageHeight);
+        packer.Pack(paddedWidth, paddedHeight, x, y);
+    }
+
+    // The texture goes inside its padding
+    x += padding;
+    y += padding;
+
+    return true;
+}
+
+//*************************************************************************************************
+DGL_Texture* AtlasManager::AddSubTexture(DGL_Atlas* atlas, unsigned page, int x, int y,
+    int width, int height)
+{
+    float pageWidth = (float)atlas->mPageWidth;
+    float pageHeight = (float)atlas->mPageHeight;
+
+    DGL_Texture* texture = new DGL_Texture;
+    texture->page = atlas->mPages[page].mTexture;
+    texture->textureSize = { (float)width, (float)height };
+    texture->uvOffset = { x / pageWidth, y / pageHeight };
+    texture->uvScale = { width / pageWidth, height / pageHeight };
+
+    atlas->mTextures.push_back(texture);
+    atlas->mUsedPixels += (unsigned long long)width * height;
+
+    return texture;
+}
+
+} // namespace DGL
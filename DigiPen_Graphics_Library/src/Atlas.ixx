@@ -0,0 +1,138 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Atlas.ixx
+// author:  Andy Ellinger
+// brief:   Header for packing many textures into a few large atlas pages
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <vector>
+
+export module Atlas;
+
+import Texture;
+import UploadQueue;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- SkylinePacker
+
+// Finds places for rectangles in a fixed size area. The packer keeps the skyline, the top edge of
+// the rectangles placed so far, and puts each new rectangle where its top will be lowest, using
+// the narrowest spot when there is a tie. It only works with sizes and positions, so it can be
+// used without a graphics device.
+export class SkylinePacker
+{
+public:
+    // Sets the size of the area and removes all placed rectangles
+    void Reset(int width, int height);
+
+    // Finds a place for a rectangle of the provided size, setting x and y to its top left corner.
+    // Returns false if there is no space for it.
+    bool Pack(int width, int height, int& x, int& y);
+
+    // Returns the width of the area
+    int GetWidth() const;
+
+    // Returns the height of the area
+    int GetHeight() const;
+
+    // Returns the total area of the placed rectangles
+    unsigned long long GetUsedArea() const;
+
+private:
+    // A part of the skyline with the same height
+    struct Segment
+    {
+        int mX{ 0 };
+        int mY{ 0 };
+        int mWidth{ 0 };
+    };
+
+    // Returns the lowest position a rectangle can be placed at with its left edge at the start of
+    // the segment, or -1 if it doesn't fit there
+    int FindY(size_t segment, int width, int height) const;
+
+    // The segments from left to right, covering the whole width
+    std::vector<Segment> mSkyline;
+    // The size of the area
+    int mWidth{ 0 };
+    int mHeight{ 0 };
+    // The total area of the placed rectangles
+    unsigned long long mUsedArea{ 0 };
+};
+
+} // namespace DGL
+
+export typedef struct DGL_Atlas
+{
+    // A D3D texture which holds many of the atlas textures
+    struct Page
+    {
+        DGL_Texture* mTexture{ nullptr };
+        DGL::SkylinePacker mPacker;
+    };
+
+    // The pages, in the order they were created
+    std::vector<Page> mPages;
+    // The textures added to the atlas, which are deleted with it
+    std::vector<DGL_Texture*> mTextures;
+    // The size of each page
+    int mPageWidth{ 0 };
+    int mPageHeight{ 0 };
+    // The number of page pixels covered by the textures, not counting padding
+    unsigned long long mUsedPixels{ 0 };
+    // The performance counter ticks spent finding places for the textures
+    long long mPackTicks{ 0 };
+} DGL_Atlas;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------ AtlasManager
+
+// Adds textures to atlases. Each texture is copied into part of a page, and the DGL_Texture
+// returned for it holds the page and the texture coordinate offset and scale for its part.
+export class AtlasManager
+{
+public:
+    // Creates a new atlas with no pages
+    static DGL_Atlas* CreateAtlas(int pageWidth, int pageHeight);
+
+    // Loads the file and copies it into one of the atlas pages. The copy is done right away.
+    static DGL_Texture* AddTexture(DGL_Atlas* atlas, const char* pFileName, ID3D11Device* device,
+        ID3D11DeviceContext* deviceContext);
+
+    // Copies the RGBA pixel data into one of the atlas pages. While the upload queue is
+    // batching, the pixels are copied when the queue is flushed.
+    static DGL_Texture* AddTextureFromMemory(DGL_Atlas* atlas, const unsigned char* data,
+        int width, int height, ID3D11Device* device, UploadQueue* uploads);
+
+    // Fills in the stats for the atlas
+    static void GetStats(const DGL_Atlas* atlas, DGL_AtlasStats* stats);
+
+    // Releases the pages and deletes the atlas and all of its textures
+    static void ReleaseAtlas(DGL_Atlas* atlas);
+
+    // The number of pixels around each texture, which are filled with copies of its edge
+    // pixels so linear filtering doesn't blend in the texture next to it
+    static constexpr int padding{ 1 };
+
+private:
+    // Finds space for a texture of the provided size plus padding, adding a page if none of the
+    // current pages have space. Sets the page and the top left corner of the texture, not
+    // counting the padding. Returns false if there was a problem.
+    static bool FindSpace(DGL_Atlas* atlas, int width, int height, ID3D11Device* device,
+        unsigned& page, int& x, int& y);
+
+    // Creates the texture for a part of a page
+    static DGL_Texture* AddSubTexture(DGL_Atlas* atlas, unsigned page, int x, int y, int width,
+        int height);
+};
+
+} // namespace DGL
@@ -0,0 +1,297 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Batch.cpp
+// author:  Andy Ellinger
+// brief:   Combining consecutive mesh draws into batches
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <vector>
+
+module Batch;
+
+import Errors;
+import Math;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- SpriteBatcher
+
+//*************************************************************************************************
+void SpriteBatcher::SetBackend(BatchBackend* backend)
+{
+    mBackend = backend;
+}
+
+//*************************************************************************************************
+bool SpriteBatcher::Add(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+    ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+    const cbPerObject& constantBuffer)
+{
+    const DGL_Mat4& transform = constantBuffer.mTransformMatrix;
+
+    if (!CanBatch(mesh, mode, transform))
+        return false;
+
+    // Set up the state for this draw. The transform, texture offset, and texture rect will be
+    // applied to the vertices, so only the Z layer is left on the constant buffer. This lets
+    // textures from the same atlas page share a batch.
+    BatchState state;
+    state.mMode = mode;
+    state.mTexture = texture;
+    state.mVertexShader = vertexShader;
+    state.mPixelShader = pixelShader;
+    state.mConstantBuffer = constantBuffer;
+    Matrix_SetToIdentity(state.mConstantBuffer.mTransformMatrix);
+    state.mConstantBuffer.mTransformMatrix.m[2][3] = transform.m[2][3];
+    state.mConstantBuffer.mTexOffset = { 0.0f, 0.0f };
+    state.mConstantBuffer.mTexRectOffset = { 0.0f, 0.0f };
+    state.mConstantBuffer.mTexRectScale = { 1.0f, 1.0f };
+
+    unsigned vertexCount = mesh->mIndexCount ? mesh->mIndexCount : mesh->mVertexCount;
+
+    // Start a new batch if the state changed or this batch would get too large
+    if (!mVertices.empty() &&
+        (!MatchesCurrentState(state) || mVertices.size() + vertexCount > max_batch_vertices))
+        Flush();
+
+    if (mVertices.empty())
+        mState = state;
+
+    // Transform each vertex and add it to the batch
+    const DGL_Vec2& texOffset = constantBuffer.mTexOffset;
+    const DGL_Vec2& rectOffset = constantBuffer.mTexRectOffset;
+    const DGL_Vec2& rectScale = constantBuffer.mTexRectScale;
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        const VertexData& vertex = mesh->mIndexCount ?
+            mesh->mVertexList[mesh->mIndices[i]] : mesh->mVertexList[i];
+
+        mVertices.push_back({
+            {
+                transform.m[0][0] * vertex.mPosition.x + transform.m[0][1] * vertex.mPosition.y + transform.m[0][3],
+                transform.m[1][0] * vertex.mPosition.x + transform.m[1][1] * vertex.mPosition.y + transform.m[1][3]
+            },
+            vertex.mColor,
+            {
+                rectOffset.x + (vertex.mTexCoord.x + texOffset.x) * rectScale.x,
+                rectOffset.y + (vertex.mTexCoord.y + texOffset.y) * rectScale.y
+            }
+        });
+    }
+
+    ++mMeshCount;
+
+    return true;
+}
+
+//*************************************************************************************************
+void SpriteBatcher::SetDrawSettings(DGL_BlendMode blendMode, DGL_TextureSampleMode sampleMode,
+    DGL_TextureAddressMode addressMode)
+{
+    if (blendMode != mBlendMode || sampleMode != mSampleMode || addressMode != mAddressMode)
+        Flush();
+
+    mBlendMode = blendMode;
+    mSampleMode = sampleMode;
+    mAddressMode = addressMode;
+}
+
+//*************************************************************************************************
+void SpriteBatcher::Flush()
+{
+    if (mVertices.empty())
+        return;
+
+    // Send the vertices to the backend
+    if (mBackend)
+        mBackend->DrawBatch(mState, mVertices.data(), (unsigned)mVertices.size());
+
+    ++mBatchCount;
+
+    // Clear the list, keeping the memory for the next batch
+    mVertices.clear();
+}
+
+//*************************************************************************************************
+unsigned SpriteBatcher::GetBatchCount() const
+{
+    return mBatchCount;
+}
+
+//*************************************************************************************************
+unsigned SpriteBatcher::GetMeshCount() const
+{
+    return mMeshCount;
+}
+
+//*************************************************************************************************
+void SpriteBatcher::ResetCounters()
+{
+    mBatchCount = 0;
+    mMeshCount = 0;
+}
+
+//*************************************************************************************************
+bool SpriteBatcher::CanBatch(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Mat4& transform)
+{
+    // The vertices are transformed on the CPU, so meshes which didn't keep them can't be batched
+    if (!mesh || !mesh->mVertexList)
+        return false;
+
+    // Make sure this mesh is small enough that transforming it is cheaper than drawing it
+    unsigned vertexCount = mesh->mIndexCount ? mesh->mIndexCount : mesh->mVertexCount;
+    if (vertexCount == 0 || vertexCount > max_mesh_vertices)
+        return false;
+
+    // Strips can't be joined together, and lists must contain complete primitives so
+    // the next mesh in the batch starts on a new one
+    switch (mode)
+    {
+    case DGL_DM_TRIANGLELIST:
+        if (vertexCount % 3 != 0)
+            return false;
+        break;
+    case DGL_DM_LINELIST:
+        if (vertexCount % 2 != 0)
+            return false;
+        break;
+    case DGL_DM_POINTLIST:
+        break;
+    default:
+        return false;
+    }
+
+    // The vertices only have X and Y values, so the Z value and W value must be the same
+    // for every vertex after transforming
+    if (transform.m[2][0] != 0.0f || transform.m[2][1] != 0.0f ||
+        transform.m[3][0] != 0.0f || transform.m[3][1] != 0.0f || transform.m[3][3] != 1.0f)
+        return false;
+
+    // The indices don't need to be checked here, since meshes can't be created with indices
+    // that are out of range
+    return true;
+}
+
+//*************************************************************************************************
+bool SpriteBatcher::MatchesCurrentState(const BatchState& state) const
+{
+    return state.mMode == mState.mMode &&
+        state.mTexture == mState.mTexture &&
+        state.mVertexShader == mState.mVertexShader &&
+        state.mPixelShader == mState.mPixelShader &&
+        memcmp(&state.mConstantBuffer, &mState.mConstantBuffer, sizeof(cbPerObject)) == 0;
+}
+
+//--------------------------------------------------------------------------------- D3DBatchBackend
+
+//*************************************************************************************************
+void D3DBatchBackend::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext,
+    StateCache* stateCache)
+{
+    mDevice = device;
+    mDeviceContext = deviceContext;
+    mStateCache = stateCache;
+}
+
+//*************************************************************************************************
+void D3DBatchBackend::Release()
+{
+    if (mBatchMesh.mVertexBuffer)
+        mBatchMesh.mVertexBuffer->Release();
+
+    mBatchMesh.mVertexBuffer = nullptr;
+    mBatchMesh.mVertexCount = 0;
+    mBatchMesh.mBaseVertex = 0;
+    mCapacity = 0;
+    mWriteOffset = 0;
+    mDevice = nullptr;
+    mDeviceContext = nullptr;
+    mStateCache = nullptr;
+}
+
+//*************************************************************************************************
+void D3DBatchBackend::DrawBatch(const BatchState& state, const VertexData* vertices, unsigned vertexCount)
+{
+    if (!mDeviceContext)
+    {
+        gError->SetError("Trying to draw batch when Graphics is not initialized.");
+        return;
+    }
+
+    // Make sure the vertex buffer is large enough
+    if (!Reserve(vertexCount))
+        return;
+
+    // Add the vertices after the ones written by earlier batches, which the graphics card may
+    // still be using. A new buffer, or one the vertices don't fit in, is discarded and filled
+    // from the start.
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (mWriteOffset == 0 || mWriteOffset + vertexCount > mCapacity)
+    {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        mWriteOffset = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    HRESULT hr = mDeviceContext->Map(mBatchMesh.mVertexBuffer, 0, mapType, 0, &mappedResource);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem mapping batch vertex buffer. ", hr);
+        return;
+    }
+    memcpy((VertexData*)mappedResource.pData + mWriteOffset, vertices,
+        sizeof(VertexData) * vertexCount);
+    mDeviceContext->Unmap(mBatchMesh.mVertexBuffer, 0);
+
+    // Draw the batch like a normal mesh, starting at the vertices just written
+    mBatchMesh.mBaseVertex = mWriteOffset;
+    mBatchMesh.mVertexCount = vertexCount;
+    mWriteOffset += vertexCount;
+    MeshManager::Draw(&mBatchMesh, state.mMode, state.mTexture, state.mVertexShader,
+        state.mPixelShader, state.mConstantBuffer, mStateCache);
+}
+
+//*************************************************************************************************
+bool D3DBatchBackend::Reserve(unsigned vertexCount)
+{
+    if (vertexCount <= mCapacity)
+        return true;
+
+    // Release the old buffer
+    if (mBatchMesh.mVertexBuffer)
+        mBatchMesh.mVertexBuffer->Release();
+    mBatchMesh.mVertexBuffer = nullptr;
+    mCapacity = 0;
+    mWriteOffset = 0;
+
+    // Grow to at least double the size to avoid recreating the buffer too often
+    unsigned newCapacity = 1024;
+    while (newCapacity < vertexCount)
+        newCapacity *= 2;
+
+    // Set up the vertex buffer description struct
+    D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
+    vertexBufferDesc.ByteWidth = sizeof(VertexData) * newCapacity;
+    vertexBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    vertexBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    // Create the vertex buffer
+    HRESULT hr = mDevice->CreateBuffer(&vertexBufferDesc, NULL, &mBatchMesh.mVertexBuffer);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem creating batch vertex buffer. ", hr);
+        return false;
+    }
+
+    mCapacity = newCapacity;
+
+    return true;
+}
+
+} // namespace DGL
@@ -0,0 +1,148 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Batch.ixx
+// author:  Andy Ellinger
+// brief:   Header for combining consecutive mesh draws into batches
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <vector>
+
+export module Batch;
+
+import D3DInterface;
+import Mesh;
+import StateCache;
+
+namespace DGL
+{
+
+// The state that must match for two draws to be combined into the same batch
+export struct BatchState
+{
+    // The draw mode used for all vertices in the batch
+    DGL_DrawMode mMode{ DGL_DM_TRIANGLELIST };
+    // The texture to bind (null when drawing with color only)
+    const DGL_Texture* mTexture{ nullptr };
+    // The vertex shader to use
+    ID3D11VertexShader* mVertexShader{ nullptr };
+    // The pixel shader to use
+    ID3D11PixelShader* mPixelShader{ nullptr };
+    // The constant buffer data, with the transform reduced to the Z layer and no texture offset
+    // or texture rect
+    cbPerObject mConstantBuffer;
+};
+
+//------------------------------------------------------------------------------------ BatchBackend
+
+// Interface for whatever actually draws the batches. Keeping this separate from the
+// batcher means the merging rules don't depend on having a D3D device.
+export class BatchBackend
+{
+public:
+    virtual ~BatchBackend() = default;
+
+    // Draws the list of already transformed vertices with the provided state
+    virtual void DrawBatch(const BatchState& state, const VertexData* vertices, unsigned vertexCount) = 0;
+};
+
+//----------------------------------------------------------------------------------- SpriteBatcher
+
+export class SpriteBatcher
+{
+public:
+    // Sets the backend that flushed batches will be sent to
+    void SetBackend(BatchBackend* backend);
+
+    // Transforms the mesh's vertices and adds them to the current batch, flushing the batch
+    // first if the state doesn't match. Returns false if the mesh can't be batched, in which
+    // case it should be drawn normally.
+    bool Add(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+        ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+        const cbPerObject& constantBuffer);
+
+    // Sets the blend mode and sampler the next draws will use, flushing the current batch first
+    // if any of them changed, since it has to be drawn with the old ones
+    void SetDrawSettings(DGL_BlendMode blendMode, DGL_TextureSampleMode sampleMode,
+        DGL_TextureAddressMode addressMode);
+
+    // Sends any vertices in the current batch to the backend
+    void Flush();
+
+    // Returns the number of batches sent to the backend since the counters were reset
+    unsigned GetBatchCount() const;
+
+    // Returns the number of meshes added to batches since the counters were reset
+    unsigned GetMeshCount() const;
+
+    // Resets the batch and mesh counters
+    void ResetCounters();
+
+    // Meshes with more vertices than this are drawn normally
+    static constexpr unsigned max_mesh_vertices{ 4096 };
+    // The current batch is flushed when it would grow larger than this
+    static constexpr unsigned max_batch_vertices{ 65536 };
+
+private:
+    // Returns true if the mesh and transform can be combined with other draws
+    static bool CanBatch(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Mat4& transform);
+
+    // Returns true if the state matches the state of the current batch
+    bool MatchesCurrentState(const BatchState& state) const;
+
+    // The transformed vertices in the current batch
+    std::vector<VertexData> mVertices;
+    // The state shared by everything in the current batch
+    BatchState mState;
+    // Where flushed batches are sent
+    BatchBackend* mBackend{ nullptr };
+    // The blend mode and sampler set on the device, which match the defaults until changed
+    DGL_BlendMode mBlendMode{ DGL_BM_NONE };
+    DGL_TextureSampleMode mSampleMode{ DGL_TSM_LINEAR };
+    DGL_TextureAddressMode mAddressMode{ DGL_AM_WRAP };
+    // The number of batches flushed
+    unsigned mBatchCount{ 0 };
+    // The number of meshes added to batches
+    unsigned mMeshCount{ 0 };
+};
+
+//--------------------------------------------------------------------------------- D3DBatchBackend
+
+// Draws batches from a dynamic vertex buffer
+export class D3DBatchBackend : public BatchBackend
+{
+public:
+    // Saves the D3D objects to use when drawing
+    void Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext,
+        StateCache* stateCache);
+
+    // Releases the vertex buffer
+    void Release();
+
+    // Appends the vertices to the vertex buffer and draws them. The buffer is only discarded
+    // when the vertices don't fit after the ones already written.
+    void DrawBatch(const BatchState& state, const VertexData* vertices, unsigned vertexCount) override;
+
+private:
+    // Makes sure the vertex buffer can hold the provided number of vertices
+    bool Reserve(unsigned vertexCount);
+
+    // The D3D device object
+    ID3D11Device* mDevice{ nullptr };
+    // The D3D device context object
+    ID3D11DeviceContext* mDeviceContext{ nullptr };
+    // The state cache used to bind the batch for drawing
+    StateCache* mStateCache{ nullptr };
+    // Mesh wrapping the dynamic vertex buffer so it can be drawn like any other mesh
+    DGL_Mesh mBatchMesh;
+    // The number of vertices the vertex buffer can hold
+    unsigned mCapacity{ 0 };
+    // The first vertex after the ones already written since the last discard
+    unsigned mWriteOffset{ 0 };
+};
+
+} // namespace DGL
@@ -0,0 +1,767 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BlockCompression.cpp
+// author:  Andy Ellinger
+// brief:   Compressing textures into blocks on the CPU
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <dxgiformat.h>
+#include <functional>
+#include <immintrin.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+module BlockCompression;
+
+import Math;
+import Mipmap;
+
+namespace DGL
+{
+
+namespace
+{
+
+// The pixels of one block as floats, with each color channel together so four pixels can be
+// compared at once. Pixels with a weight of 0 are transparent and don't count.
+struct BlockPixels
+{
+    alignas(16) float mRed[16];
+    alignas(16) float mGreen[16];
+    alignas(16) float mBlue[16];
+    alignas(16) float mWeights[16];
+};
+
+// The functions used by the compressor
+struct BlockKernels
+{
+    // Picks the closest palette color for each pixel and returns the total squared distance
+    float (*mFindColorIndices)(const BlockPixels& pixels, const float* palette,
+        unsigned paletteSize, unsigned char* indices);
+};
+
+// How much of the first end color is in each palette color, for four and three color blocks
+constexpr float four_color_weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+constexpr float three_color_weights[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+
+// The new index for each index when the two end colors of a block are swapped
+constexpr unsigned char four_color_swap[4] = { 1, 0, 3, 2 };
+constexpr unsigned char three_color_swap[4] = { 1, 0, 2, 3 };
+
+//------------------------------------------------------------------------------------------ Scalar
+
+//*************************************************************************************************
+float FindColorIndicesScalar(const BlockPixels& pixels, const float* palette,
+    unsigned paletteSize, unsigned char* indices)
+{
+    float total = 0.0f;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        float best = 0.0f;
+        for (unsigned entry = 0; entry < paletteSize; ++entry)
+        {
+            float red = pixels.mRed[i] - palette[entry * 3];
+            float green = pixels.mGreen[i] - palette[entry * 3 + 1];
+            float blue = pixels.mBlue[i] - palette[entry * 3 + 2];
+            float distance = red * red + green * green + blue * blue;
+            if (entry == 0 || distance < best)
+            {
+                best = distance;
+                indices[i] = (unsigned char)entry;
+            }
+        }
+
+        total += best * pixels.mWeights[i];
+    }
+
+    return total;
+}
+
+//-------------------------------------------------------------------------------------------- SSE2
+
+//*************************************************************************************************
+float FindColorIndicesSSE2(const BlockPixels& pixels, const float* palette,
+    unsigned paletteSize, unsigned char* indices)
+{
+    __m128 total = _mm_setzero_ps();
+    for (unsigned i = 0; i < 16; i += 4)
+    {
+        __m128 red = _mm_load_ps(pixels.mRed + i);
+        __m128 green = _mm_load_ps(pixels.mGreen + i);
+        __m128 blue = _mm_load_ps(pixels.mBlue + i);
+
+        // Keep the smallest distance and its index for each of the four pixels. Ties keep the
+        // earlier index, the same as the scalar version.
+        __m128 best = _mm_set1_ps(3.402823466e+38f);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (unsigned entry = 0; entry < paletteSize; ++entry)
+        {
+            __m128 dRed = _mm_sub_ps(red, _mm_set1_ps(palette[entry * 3]));
+            __m128 dGreen = _mm_sub_ps(green, _mm_set1_ps(palette[entry * 3 + 1]));
+            __m128 dBlue = _mm_sub_ps(blue, _mm_set1_ps(palette[entry * 3 + 2]));
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dRed, dRed),
+                _mm_mul_ps(dGreen, dGreen)), _mm_mul_ps(dBlue, dBlue));
+
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+            best = _mm_min_ps(distance, best);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex),
+                _mm_and_si128(closer, _mm_set1_epi32((int)entry)));
+        }
+
+        total = _mm_add_ps(total, _mm_mul_ps(best, _mm_load_ps(pixels.mWeights + i)));
+
+        // Narrow the four indices to bytes
+        __m128i packed = _mm_packs_epi32(bestIndex, bestIndex);
+        packed = _mm_packus_epi16(packed, packed);
+        int four = _mm_cvtsi128_si32(packed);
+        memcpy(indices + i, &four, sizeof(four));
+    }
+
+    total = _mm_add_ps(total, _mm_movehl_ps(total, total));
+    total = _mm_add_ss(total, _mm_shuffle_ps(total, total, 1));
+    return _mm_cvtss_f32(total);
+}
+
+//----------------------------------------------------------------------------------------- Dispatch
+
+//*************************************************************************************************
+BlockKernels SelectKernels()
+{
+    if (CPU_SupportsSSE2())
+        return { FindColorIndicesSSE2 };
+
+    return { FindColorIndicesScalar };
+}
+
+//*************************************************************************************************
+const BlockKernels& GetKernels()
+{
+    // Checks the CPU the first time this is called
+    static const BlockKernels kernels = SelectKernels();
+    return kernels;
+}
+
+//------------------------------------------------------------------------------------------ Colors
+
+//*************************************************************************************************
+float ClampChannel(float value)
+{
+    return value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+}
+
+//*************************************************************************************************
+uint16_t QuantizeColor(const float* color)
+{
+    int red = (int)(color[0] * (31.0f / 255.0f) + 0.5f);
+    int green = (int)(color[1] * (63.0f / 255.0f) + 0.5f);
+    int blue = (int)(color[2] * (31.0f / 255.0f) + 0.5f);
+    red = red < 0 ? 0 : (red > 31 ? 31 : red);
+    green = green < 0 ? 0 : (green > 63 ? 63 : green);
+    blue = blue < 0 ? 0 : (blue > 31 ? 31 : blue);
+    return (uint16_t)((red << 11) | (green << 5) | blue);
+}
+
+//*************************************************************************************************
+void ExpandColor(uint16_t color, int* result)
+{
+    // Repeat the high bits in the low bits, so 0 stays 0 and the largest value becomes 255
+    int red = (color >> 11) & 31;
+    int green = (color >> 5) & 63;
+    int blue = color & 31;
+    result[0] = (red << 3) | (red >> 2);
+    result[1] = (green << 2) | (green >> 4);
+    result[2] = (blue << 3) | (blue >> 2);
+}
+
+//*************************************************************************************************
+void BuildColorPalette(uint16_t color0, uint16_t color1, bool threeColors, float* palette)
+{
+    int end0[3], end1[3];
+    ExpandColor(color0, end0);
+    ExpandColor(color1, end1);
+
+    const float* weights = threeColors ? three_color_weights : four_color_weights;
+    for (unsigned entry = 0; entry < 4; ++entry)
+    {
+        for (unsigned channel = 0; channel < 3; ++channel)
+        {
+            palette[entry * 3 + channel] = end0[channel] * weights[entry] +
+                end1[channel] * (1.0f - weights[entry]);
+        }
+    }
+}
+
+//*************************************************************************************************
+bool FitColors(const BlockPixels& pixels, const unsigned char* indices, bool threeColors,
+    float* end0, float* end1)
+{
+    // Find the end colors which best match the pixels with their current indices, by least
+    // squares. Each pixel is a weighted blend of the two ends.
+    const float* weights = threeColors ? three_color_weights : four_color_weights;
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f };
+    float bx[3] = { 0.0f, 0.0f, 0.0f };
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        if (pixels.mWeights[i] == 0.0f)
+            continue;
+
+        float a = weights[indices[i]];
+        float b = 1.0f - a;
+        float color[3] = { pixels.mRed[i], pixels.mGreen[i], pixels.mBlue[i] };
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (unsigned channel = 0; channel < 3; ++channel)
+        {
+            ax[channel] += a * color[channel];
+            bx[channel] += b * color[channel];
+        }
+    }
+
+    // Every pixel using the same index doesn't give a single answer
+    float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) < 0.0001f)
+        return false;
+
+    for (unsigned channel = 0; channel < 3; ++channel)
+    {
+        end0[channel] = ClampChannel((ax[channel] * bb - bx[channel] * ab) / determinant);
+        end1[channel] = ClampChannel((bx[channel] * aa - ax[channel] * ab) / determinant);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------- Alpha
+
+//*************************************************************************************************
+void BuildAlphaPalette(unsigned char alpha0, unsigned char alpha1, unsigned char* palette)
+{
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+
+    // The order of the ends picks between six blended values, or four plus exact 0 and 255
+    if (alpha0 > alpha1)
+    {
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = (unsigned char)(((7 - i) * alpha0 + i * alpha1) / 7);
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+            palette[i + 1] = (unsigned char)(((5 - i) * alpha0 + i * alpha1) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+//*************************************************************************************************
+unsigned FindAlphaIndices(const unsigned char* alpha, const unsigned char* palette,
+    unsigned char* indices)
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        unsigned best = 0;
+        for (unsigned entry = 0; entry < 8; ++entry)
+        {
+            int difference = (int)alpha[i] - palette[entry];
+            unsigned distance = (unsigned)(difference * difference);
+            if (entry == 0 || distance < best)
+            {
+                best = distance;
+                indices[i] = (unsigned char)entry;
+            }
+        }
+
+        total += best;
+    }
+
+    return total;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------- BlockCompressor
+
+//*************************************************************************************************
+DXGI_FORMAT BlockCompressor::GetFormat(DGL_TextureCompression compression)
+{
+    switch (compression)
+    {
+    case DGL_TC_BC1:
+        return DXGI_FORMAT_BC1_UNORM;
+    case DGL_TC_BC3:
+        return DXGI_FORMAT_BC3_UNORM;
+    default:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+//*************************************************************************************************
+bool BlockCompressor::IsBlockFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC7_UNORM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//*************************************************************************************************
+bool BlockCompressor::CanCompress(int width, int height)
+{
+    return width > 0 && height > 0 && width % 4 == 0 && height % 4 == 0;
+}
+
+//*************************************************************************************************
+unsigned BlockCompressor::Compress(std::vector<MipLevel>& levels, DXGI_FORMAT format,
+    unsigned maxThreads)
+{
+    unsigned threadLimit = maxThreads ? maxThreads : std::thread::hardware_concurrency();
+    if (threadLimit == 0)
+        threadLimit = 1;
+
+    unsigned mostThreads = 0;
+    for (MipLevel& level : levels)
+    {
+        int blocksWide = (level.mWidth + 3) / 4;
+        int blocksHigh = (level.mHeight + 3) / 4;
+        std::vector<unsigned char> blocks(
+            MipmapGenerator::GetLevelBytes(format, level.mWidth, level.mHeight));
+
+        unsigned threadCount = (unsigned)(blocksWide * blocksHigh) / min_blocks_per_thread;
+        if (threadCount > threadLimit)
+            threadCount = threadLimit;
+        if (threadCount > (unsigned)blocksHigh)
+            threadCount = blocksHigh;
+
+        if (threadCount < 2)
+        {
+            CompressRows(level, format, 0, blocksHigh, blocks.data());
+            threadCount = 1;
+        }
+        else
+        {
+            // Give each thread about the same number of rows of blocks
+            std::vector<std::thread> threads;
+            for (unsigned thread = 0; thread < threadCount; ++thread)
+            {
+                int first = (int)((unsigned long long)blocksHigh * thread / threadCount);
+                int last = (int)((unsigned long long)blocksHigh * (thread + 1) / threadCount);
+                threads.emplace_back(CompressRows, std::cref(level), format, first, last,
+                    blocks.data());
+            }
+
+            for (std::thread& thread : threads)
+                thread.join();
+        }
+
+        level.mPixels.swap(blocks);
+        if (threadCount > mostThreads)
+            mostThreads = threadCount;
+    }
+
+    return mostThreads;
+}
+
+//*************************************************************************************************
+void BlockCompressor::Decompress(std::vector<MipLevel>& levels, DXGI_FORMAT format)
+{
+    bool hasAlpha = format == DXGI_FORMAT_BC3_UNORM;
+    unsigned blockBytes = hasAlpha ? 16 : 8;
+    for (MipLevel& level : levels)
+    {
+        int blocksWide = (level.mWidth + 3) / 4;
+        int blocksHigh = (level.mHeight + 3) / 4;
+        std::vector<unsigned char> pixels((size_t)level.mWidth * level.mHeight * 4);
+        unsigned char blockPixels[64];
+        for (int blockY = 0; blockY < blocksHigh; ++blockY)
+        {
+            for (int blockX = 0; blockX < blocksWide; ++blockX)
+            {
+                const unsigned char* block = level.mPixels.data() +
+                    ((size_t)blockY * blocksWide + blockX) * blockBytes;
+                if (hasAlpha)
+                {
+                    DecompressColorBlock(block + 8, false, blockPixels);
+                    DecompressAlphaBlock(block, blockPixels);
+                }
+                else
+                    DecompressColorBlock(block, true, blockPixels);
+
+                // Blocks past the edges of small levels have pixels which aren't used
+                for (int y = 0; y < 4 && blockY * 4 + y < level.mHeight; ++y)
+                {
+                    for (int x = 0; x < 4 && blockX * 4 + x < level.mWidth; ++x)
+                    {
+                        memcpy(pixels.data() + ((size_t)(blockY * 4 + y) * level.mWidth +
+                            blockX * 4 + x) * 4, blockPixels + (y * 4 + x) * 4, 4);
+                    }
+                }
+            }
+        }
+
+        level.mPixels.swap(pixels);
+    }
+}
+
+//*************************************************************************************************
+float BlockCompressor::GetPSNR(const MipLevel& original, const MipLevel& compressed)
+{
+    size_t count = original.mPixels.size() < compressed.mPixels.size() ?
+        original.mPixels.size() : compressed.mPixels.size();
+    if (count < 4)
+        return 0.0f;
+
+    double total = 0.0;
+    for (size_t i = 0; i + 3 < count; i += 4)
+    {
+        const unsigned char* pixel0 = original.mPixels.data() + i;
+        const unsigned char* pixel1 = compressed.mPixels.data() + i;
+        for (unsigned channel = 0; channel < 3; ++channel)
+        {
+            double difference = (pixel0[channel] * pixel0[3] - pixel1[channel] * pixel1[3]) /
+                255.0;
+            total += difference * difference;
+        }
+
+        double difference = (double)pixel0[3] - pixel1[3];
+        total += difference * difference;
+    }
+
+    double meanSquared = total / (double)(count / 4 * 4);
+    if (meanSquared == 0.0)
+        return INFINITY;
+
+    return (float)(10.0 * log10(255.0 * 255.0 / meanSquared));
+}
+
+//*************************************************************************************************
+void BlockCompressor::CompressRows(const MipLevel& level, DXGI_FORMAT format, int firstRow,
+    int lastRow, unsigned char* blocks)
+{
+    bool hasAlpha = format == DXGI_FORMAT_BC3_UNORM;
+    unsigned blockBytes = hasAlpha ? 16 : 8;
+    int blocksWide = (level.mWidth + 3) / 4;
+    unsigned char pixels[64];
+    for (int blockY = firstRow; blockY < lastRow; ++blockY)
+    {
+        for (int blockX = 0; blockX < blocksWide; ++blockX)
+        {
+            // Pixels past the edges of small levels repeat the edge pixels, so they don't pull
+            // the colors of the block away from the pixels which are used
+            for (int y = 0; y < 4; ++y)
+            {
+                int sourceY = blockY * 4 + y < level.mHeight ? blockY * 4 + y : level.mHeight - 1;
+                for (int x = 0; x < 4; ++x)
+                {
+                    int sourceX = blockX * 4 + x < level.mWidth ? blockX * 4 + x : level.mWidth - 1;
+                    memcpy(pixels + (y * 4 + x) * 4,
+                        level.mPixels.data() + ((size_t)sourceY * level.mWidth + sourceX) * 4, 4);
+                }
+            }
+
+            unsigned char* block = blocks + ((size_t)blockY * blocksWide + blockX) * blockBytes;
+            if (hasAlpha)
+            {
+                CompressAlphaBlock(pixels, block);
+                CompressColorBlock(pixels, false, block + 8);
+            }
+            else
+                CompressColorBlock(pixels, true, block);
+        }
+    }
+}
+
+//*************************************************************************************************
+void BlockCompressor::CompressColorBlock(const unsigned char* pixels, bool allowTransparent,
+    unsigned char* block)
+{
+    BlockPixels blockPixels;
+    bool hasTransparent = false;
+    unsigned used = 0;
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        const unsigned char* pixel = pixels + i * 4;
+        blockPixels.mRed[i] = pixel[0];
+        blockPixels.mGreen[i] = pixel[1];
+        blockPixels.mBlue[i] = pixel[2];
+
+        bool transparent = allowTransparent && pixel[3] < alpha_threshold;
+        blockPixels.mWeights[i] = transparent ? 0.0f : 1.0f;
+        hasTransparent |= transparent;
+        if (!transparent)
+        {
+            mean[0] += pixel[0];
+            mean[1] += pixel[1];
+            mean[2] += pixel[2];
+            ++used;
+        }
+    }
+
+    // With equal end colors the block uses three colors, so index 3 is transparent
+    if (used == 0)
+    {
+        memset(block, 0, 4);
+        memset(block + 4, 0xff, 4);
+        return;
+    }
+
+    for (unsigned channel = 0; channel < 3; ++channel)
+        mean[channel] /= used;
+
+    // Find the direction the colors are most spread out in, from their covariance. Multiplying
+    // by the covariance again and again turns any direction toward it.
+    float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        if (blockPixels.mWeights[i] == 0.0f)
+            continue;
+
+        float red = blockPixels.mRed[i] - mean[0];
+        float green = blockPixels.mGreen[i] - mean[1];
+        float blue = blockPixels.mBlue[i] - mean[2];
+        covariance[0] += red * red;
+        covariance[1] += red * green;
+        covariance[2] += red * blue;
+        covariance[3] += green * green;
+        covariance[4] += green * blue;
+        covariance[5] += blue * blue;
+    }
+
+    // Start with the row of the channel which varies the most, so the start isn't at right
+    // angles to the answer
+    float axis[3];
+    if (covariance[0] >= covariance[3] && covariance[0] >= covariance[5])
+        axis[0] = covariance[0], axis[1] = covariance[1], axis[2] = covariance[2];
+    else if (covariance[3] >= covariance[5])
+        axis[0] = covariance[1], axis[1] = covariance[3], axis[2] = covariance[4];
+    else
+        axis[0] = covariance[2], axis[1] = covariance[4], axis[2] = covariance[5];
+
+    for (unsigned pass = 0; pass < 8; ++pass)
+    {
+        float next[3] = {
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+        float largest = fabsf(next[0]) > fabsf(next[1]) ? fabsf(next[0]) : fabsf(next[1]);
+        largest = fabsf(next[2]) > largest ? fabsf(next[2]) : largest;
+        if (largest < 0.0001f)
+            break;
+
+        axis[0] = next[0] / largest;
+        axis[1] = next[1] / largest;
+        axis[2] = next[2] / largest;
+    }
+
+    // A block of one color has no direction, and any will do
+    float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (length < 0.0001f)
+        axis[0] = axis[1] = axis[2] = length = 1.0f;
+    axis[0] /= length;
+    axis[1] /= length;
+    axis[2] /= length;
+
+    // The end colors start at the farthest pixels along the direction, moved in a little
+    // since the ends are rarely the best match for the pixels between them
+    float lowest = 0.0f, highest = 0.0f;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        if (blockPixels.mWeights[i] == 0.0f)
+            continue;
+
+        float distance = (blockPixels.mRed[i] - mean[0]) * axis[0] +
+            (blockPixels.mGreen[i] - mean[1]) * axis[1] +
+            (blockPixels.mBlue[i] - mean[2]) * axis[2];
+        lowest = distance < lowest ? distance : lowest;
+        highest = distance > highest ? distance : highest;
+    }
+
+    float end0[3], end1[3];
+    for (unsigned channel = 0; channel < 3; ++channel)
+    {
+        float inset = axis[channel] * (highest - lowest) / 16.0f;
+        end0[channel] = ClampChannel(mean[channel] + axis[channel] * highest - inset);
+        end1[channel] = ClampChannel(mean[channel] + axis[channel] * lowest + inset);
+    }
+
+    // Blocks with transparent pixels use three colors so the fourth can be transparent
+    bool threeColors = hasTransparent;
+    unsigned paletteSize = threeColors ? 3 : 4;
+    uint16_t bestColor0 = 0, bestColor1 = 0;
+    unsigned char bestIndices[16] = { 0 };
+    float bestError = 0.0f;
+    for (unsigned pass = 0; pass <= refine_passes; ++pass)
+    {
+        uint16_t color0 = QuantizeColor(end0);
+        uint16_t color1 = QuantizeColor(end1);
+        float palette[12];
+        BuildColorPalette(color0, color1, threeColors, palette);
+
+        unsigned char indices[16];
+        float error = GetKernels().mFindColorIndices(blockPixels, palette, paletteSize, indices);
+        if (pass > 0 && error >= bestError)
+            break;
+
+        bestColor0 = color0;
+        bestColor1 = color1;
+        bestError = error;
+        memcpy(bestIndices, indices, sizeof(indices));
+
+        if (!FitColors(blockPixels, indices, threeColors, end0, end1))
+            break;
+    }
+
+    // The order of the end colors tells the device how many colors the block uses
+    const unsigned char* swap = nullptr;
+    if (threeColors ? bestColor0 > bestColor1 : bestColor0 < bestColor1)
+    {
+        uint16_t temp = bestColor0;
+        bestColor0 = bestColor1;
+        bestColor1 = temp;
+        swap = threeColors ? three_color_swap : four_color_swap;
+    }
+
+    uint32_t bits = 0;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        unsigned index = swap ? swap[bestIndices[i]] : bestIndices[i];
+        if (blockPixels.mWeights[i] == 0.0f)
+            index = 3;
+        // Equal end colors are read as three colors, so every pixel uses the first one
+        else if (!threeColors && bestColor0 == bestColor1)
+            index = 0;
+        bits |= index << (i * 2);
+    }
+
+    memcpy(block, &bestColor0, sizeof(bestColor0));
+    memcpy(block + 2, &bestColor1, sizeof(bestColor1));
+    memcpy(block + 4, &bits, sizeof(bits));
+}
+
+//*************************************************************************************************
+void BlockCompressor::CompressAlphaBlock(const unsigned char* pixels, unsigned char* block)
+{
+    unsigned char alpha[16];
+    unsigned char lowest = 255, highest = 0;
+    unsigned char innerLowest = 255, innerHighest = 0;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        alpha[i] = pixels[i * 4 + 3];
+        lowest = alpha[i] < lowest ? alpha[i] : lowest;
+        highest = alpha[i] > highest ? alpha[i] : highest;
+        if (alpha[i] != 0 && alpha[i] != 255)
+        {
+            innerLowest = alpha[i] < innerLowest ? alpha[i] : innerLowest;
+            innerHighest = alpha[i] > innerHighest ? alpha[i] : innerHighest;
+        }
+    }
+
+    // A block with one alpha value doesn't need indices, which is most blocks of opaque textures
+    if (lowest == highest)
+    {
+        block[0] = block[1] = lowest;
+        memset(block + 2, 0, 6);
+        return;
+    }
+
+    // Try six blended values across the whole range, and four across the values other than 0
+    // and 255, which that mode has exactly, then keep whichever is closer
+    unsigned char palette[8];
+    unsigned char indices[16];
+    BuildAlphaPalette(highest, lowest, palette);
+    unsigned error = FindAlphaIndices(alpha, palette, indices);
+    unsigned char alpha0 = highest, alpha1 = lowest;
+
+    if (innerLowest > innerHighest)
+        innerLowest = innerHighest = 0;
+    unsigned char innerIndices[16];
+    BuildAlphaPalette(innerLowest, innerHighest, palette);
+    if (FindAlphaIndices(alpha, palette, innerIndices) < error)
+    {
+        alpha0 = innerLowest;
+        alpha1 = innerHighest;
+        memcpy(indices, innerIndices, sizeof(indices));
+    }
+
+    uint64_t bits = 0;
+    for (unsigned i = 0; i < 16; ++i)
+        bits |= (uint64_t)indices[i] << (i * 3);
+
+    block[0] = alpha0;
+    block[1] = alpha1;
+    for (unsigned i = 0; i < 6; ++i)
+        block[i + 2] = (unsigned char)(bits >> (i * 8));
+}
+
+//*************************************************************************************************
+void BlockCompressor::DecompressColorBlock(const unsigned char* block, bool allowTransparent,
+    unsigned char* pixels)
+{
+    uint16_t color0, color1;
+    uint32_t bits;
+    memcpy(&color0, block, sizeof(color0));
+    memcpy(&color1, block + 2, sizeof(color1));
+    memcpy(&bits, block + 4, sizeof(bits));
+
+    int end0[3], end1[3];
+    ExpandColor(color0, end0);
+    ExpandColor(color1, end1);
+
+    unsigned char palette[4][4];
+    bool threeColors = allowTransparent && color0 <= color1;
+    for (unsigned channel = 0; channel < 3; ++channel)
+    {
+        palette[0][channel] = (unsigned char)end0[channel];
+        palette[1][channel] = (unsigned char)end1[channel];
+        if (threeColors)
+        {
+            palette[2][channel] = (unsigned char)((end0[channel] + end1[channel]) / 2);
+            palette[3][channel] = 0;
+        }
+        else
+        {
+            palette[2][channel] = (unsigned char)((2 * end0[channel] + end1[channel]) / 3);
+            palette[3][channel] = (unsigned char)((end0[channel] + 2 * end1[channel]) / 3);
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = threeColors ? 0 : 255;
+
+    for (unsigned i = 0; i < 16; ++i)
+        memcpy(pixels + i * 4, palette[(bits >> (i * 2)) & 3], 4);
+}
+
+//*************************************************************************************************
+void BlockCompressor::DecompressAlphaBlock(const unsigned char* block, unsigned char* pixels)
+{
+    unsigned char palette[8];
+    BuildAlphaPalette(block[0], block[1], palette);
+
+    uint64_t bits = 0;
+    for (unsigned i = 0; i < 6; ++i)
+        bits |= (uint64_t)block[i + 2] << (i * 8);
+
+    for (unsigned i = 0; i < 16; ++i)
+        pixels[i * 4 + 3] = palette[(bits >> (i * 3)) & 7];
+}
+
+} // namespace DGL
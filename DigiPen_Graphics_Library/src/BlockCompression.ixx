@@ -0,0 +1,85 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BlockCompression.ixx
+// author:  Andy Ellinger
+// brief:   Header for compressing textures into blocks on the CPU
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <dxgiformat.h>
+#include <vector>
+
+export module BlockCompression;
+
+import Mipmap;
+
+namespace DGL
+{
+
+//-------------------------------------------------------------------------------- BlockCompressor
+
+// Compresses RGBA levels into BC1 or BC3 blocks on the CPU. Each 4x4 block of pixels is stored
+// as two 565 colors and a 2 bit index for each pixel, which picks one of the colors or a blend
+// of them. BC3 adds a block of alpha values stored the same way with 3 bit indices. Nothing here
+// uses the graphics device, so it can be used on any thread.
+export class BlockCompressor
+{
+public:
+    // Returns the format used for the compression, or DXGI_FORMAT_R8G8B8A8_UNORM for none
+    static DXGI_FORMAT GetFormat(DGL_TextureCompression compression);
+
+    // Returns true if the format stores 4x4 blocks of pixels instead of single pixels
+    static bool IsBlockFormat(DXGI_FORMAT format);
+
+    // Returns true if a texture of the size can be compressed. The device needs the size of the
+    // first level to be a multiple of 4, although the smaller levels can be any size.
+    static bool CanCompress(int width, int height);
+
+    // Replaces the RGBA pixels of each level with BC1 or BC3 blocks. The blocks of large levels
+    // are split between up to maxThreads threads, or one for each core if it is 0. Returns the
+    // most threads used for one level.
+    static unsigned Compress(std::vector<MipLevel>& levels, DXGI_FORMAT format,
+        unsigned maxThreads);
+
+    // Replaces the BC1 or BC3 blocks of each level with RGBA pixels
+    static void Decompress(std::vector<MipLevel>& levels, DXGI_FORMAT format);
+
+    // Returns the peak signal to noise ratio of the compressed RGBA pixels compared to the
+    // original ones, in decibels. The colors are multiplied by alpha first, since the colors of
+    // transparent pixels can't be seen. Identical pixels return infinity.
+    static float GetPSNR(const MipLevel& original, const MipLevel& compressed);
+
+    // The fewest blocks given to each thread. Smaller levels are compressed on the calling
+    // thread, since starting threads would take longer than compressing them.
+    static constexpr unsigned min_blocks_per_thread{ 1024 };
+    // Pixels with less alpha than this are transparent in BC1 blocks
+    static constexpr unsigned char alpha_threshold{ 128 };
+    // The number of times the colors of each block are fitted to the pixels again
+    static constexpr unsigned refine_passes{ 2 };
+
+private:
+    // Compresses the rows of blocks from firstRow up to lastRow into the level's blocks
+    static void CompressRows(const MipLevel& level, DXGI_FORMAT format, int firstRow,
+        int lastRow, unsigned char* blocks);
+
+    // Compresses the 16 RGBA pixels into a color block. With allowTransparent the block can use
+    // its fourth color for pixels below the alpha threshold, as BC1 does.
+    static void CompressColorBlock(const unsigned char* pixels, bool allowTransparent,
+        unsigned char* block);
+
+    // Compresses the alpha of the 16 RGBA pixels into a BC3 alpha block
+    static void CompressAlphaBlock(const unsigned char* pixels, unsigned char* block);
+
+    // Decodes the color block into 16 RGBA pixels. Without allowTransparent the block always
+    // uses four colors, as BC3 does, and every pixel is opaque.
+    static void DecompressColorBlock(const unsigned char* block, bool allowTransparent,
+        unsigned char* pixels);
+
+    // Decodes the BC3 alpha block into the alpha of 16 RGBA pixels
+    static void DecompressAlphaBlock(const unsigned char* block, unsigned char* pixels);
+};
+
+} // namespace DGL
@@ -0,0 +1,311 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BufferPool.cpp
+// author:  Andy Ellinger
+// brief:   Sharing large vertex and index buffers between meshes
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <map>
+#include <vector>
+
+module BufferPool;
+
+import Errors;
+import UploadQueue;
+
+namespace DGL
+{
+
+//--------------------------------------------------------------------------------- OffsetAllocator
+
+//*************************************************************************************************
+void OffsetAllocator::Reset(unsigned capacity)
+{
+    mFreeByOffset.clear();
+    mFreeBySize.clear();
+    mCapacity = capacity;
+    mUsed = 0;
+
+    if (capacity)
+    {
+        mFreeByOffset.emplace(0, capacity);
+        mFreeBySize.emplace(capacity, 0);
+    }
+}
+
+//*************************************************************************************************
+unsigned OffsetAllocator::Allocate(unsigned size)
+{
+    if (size == 0)
+        return invalid_offset;
+
+    // Find the smallest free block that is large enough
+    auto fit = mFreeBySize.lower_bound(size);
+    if (fit == mFreeBySize.end())
+        return invalid_offset;
+
+    unsigned offset = fit->second;
+    unsigned blockSize = fit->first;
+    RemoveFreeBlock(mFreeByOffset.find(offset));
+
+    // Anything left over after the new block stays free
+    if (blockSize > size)
+    {
+        mFreeByOffset.emplace(offset + size, blockSize - size);
+        mFreeBySize.emplace(blockSize - size, offset + size);
+    }
+
+    mUsed += size;
+
+    return offset;
+}
+
+//*************************************************************************************************
+void OffsetAllocator::Free(unsigned offset, unsigned size)
+{
+    if (size == 0)
+        return;
+
+    mUsed -= size;
+
+    // Join the block with the free block after it, if they touch
+    auto next = mFreeByOffset.lower_bound(offset);
+    if (next != mFreeByOffset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        auto after = std::next(next);
+        RemoveFreeBlock(next);
+        next = after;
+    }
+
+    // Join the block with the free block before it, if they touch
+    if (next != mFreeByOffset.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            RemoveFreeBlock(previous);
+        }
+    }
+
+    mFreeByOffset.emplace(offset, size);
+    mFreeBySize.emplace(size, offset);
+}
+
+//*************************************************************************************************
+unsigned OffsetAllocator::GetCapacity() const
+{
+    return mCapacity;
+}
+
+//*************************************************************************************************
+unsigned OffsetAllocator::GetUsed() const
+{
+    return mUsed;
+}
+
+//*************************************************************************************************
+unsigned OffsetAllocator::GetLargestFreeBlock() const
+{
+    return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first;
+}
+
+//*************************************************************************************************
+unsigned OffsetAllocator::GetFreeBlockCount() const
+{
+    return (unsigned)mFreeByOffset.size();
+}
+
+//*************************************************************************************************
+void OffsetAllocator::RemoveFreeBlock(std::map<unsigned, unsigned>::iterator block)
+{
+    // Several blocks can have the same size, so find the one with the same offset
+    auto sizes = mFreeBySize.equal_range(block->second);
+    for (auto it = sizes.first; it != sizes.second; ++it)
+    {
+        if (it->second == block->first)
+        {
+            mFreeBySize.erase(it);
+            break;
+        }
+    }
+
+    mFreeByOffset.erase(block);
+}
+
+//-------------------------------------------------------------------------------------- BufferPool
+
+//*************************************************************************************************
+void BufferPool::Initialize(ID3D11Device* device, UploadQueue* uploads, UINT bindFlags,
+    unsigned elementSize, unsigned pageElements)
+{
+    mDevice = device;
+    mUploads = uploads;
+    mBindFlags = bindFlags;
+    mElementSize = elementSize;
+    mPageElements = pageElements;
+    mAllocations = 0;
+    mFrees = 0;
+    mAllocatorTicks = 0;
+}
+
+//*************************************************************************************************
+void BufferPool::Release()
+{
+    for (Page& page : mPages)
+    {
+        if (page.mBuffer)
+            page.mBuffer->Release();
+    }
+
+    mPages.clear();
+    mDevice = nullptr;
+    mUploads = nullptr;
+}
+
+//*************************************************************************************************
+bool BufferPool::Allocate(const void* data, unsigned count, unsigned& page, unsigned& offset,
+    ID3D11Buffer*& buffer)
+{
+    if (!mDevice)
+    {
+        gError->SetError("Trying to create mesh when Graphics is not initialized.");
+        return false;
+    }
+
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+
+    // Use the first page with a large enough free block
+    offset = OffsetAllocator::invalid_offset;
+    for (page = 0; page < mPages.size(); ++page)
+    {
+        if (!mPages[page].mBuffer)
+            continue;
+
+        offset = mPages[page].mAllocator.Allocate(count);
+        if (offset != OffsetAllocator::invalid_offset)
+            break;
+    }
+
+    QueryPerformanceCounter(&end);
+    mAllocatorTicks += end.QuadPart - start.QuadPart;
+
+    // If none of the pages had space, add a new one
+    if (offset == OffsetAllocator::invalid_offset)
+    {
+        page = AddPage(count);
+        if (page == no_page)
+            return false;
+
+        offset = mPages[page].mAllocator.Allocate(count);
+    }
+
+    ++mAllocations;
+    buffer = mPages[page].mBuffer;
+
+    // Copy the data into the block
+    mUploads->UploadBuffer(buffer, offset * mElementSize, data, count * mElementSize);
+
+    return true;
+}
+
+//*************************************************************************************************
+void BufferPool::Free(unsigned page, unsigned offset, unsigned count)
+{
+    // The pages are gone if Graphics has been shut down
+    if (page >= mPages.size() || !mPages[page].mBuffer)
+        return;
+
+    Page& pageData = mPages[page];
+
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    pageData.mAllocator.Free(offset, count);
+    QueryPerformanceCounter(&end);
+    mAllocatorTicks += end.QuadPart - start.QuadPart;
+
+    ++mFrees;
+
+    // Pages made for a single large block aren't likely to be reused, so release them when empty
+    if (pageData.mAllocator.GetUsed() == 0 && pageData.mAllocator.GetCapacity() > mPageElements)
+    {
+        pageData.mBuffer->Release();
+        pageData.mBuffer = nullptr;
+    }
+}
+
+//*************************************************************************************************
+void BufferPool::AddStats(DGL_MeshBufferStats& stats) const
+{
+    for (const Page& page : mPages)
+    {
+        if (!page.mBuffer)
+            continue;
+
+        const OffsetAllocator& allocator = page.mAllocator;
+        unsigned long long largest = (unsigned long long)allocator.GetLargestFreeBlock() * mElementSize;
+
+        ++stats.mBuffers;
+        stats.mBufferBytes += (unsigned long long)allocator.GetCapacity() * mElementSize;
+        stats.mUsedBytes += (unsigned long long)allocator.GetUsed() * mElementSize;
+        stats.mFreeBlocks += allocator.GetFreeBlockCount();
+        if (largest > stats.mLargestFreeBlockBytes)
+            stats.mLargestFreeBlockBytes = largest;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    stats.mAllocations += mAllocations;
+    stats.mFrees += mFrees;
+    stats.mAllocatorSeconds += (double)mAllocatorTicks / frequency.QuadPart;
+}
+
+//*************************************************************************************************
+unsigned BufferPool::AddPage(unsigned count)
+{
+    unsigned capacity = count > mPageElements ? count : mPageElements;
+
+    // Make sure the size of the buffer in bytes fits in the description
+    if (capacity > 0xFFFFFFFF / mElementSize)
+    {
+        gError->SetError("Couldn't create shared mesh buffer, the mesh is too large.");
+        return no_page;
+    }
+
+    // Set up the buffer description struct
+    D3D11_BUFFER_DESC bufferDesc = { 0 };
+    bufferDesc.ByteWidth = capacity * mElementSize;
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = mBindFlags;
+    // Create the buffer
+    ID3D11Buffer* buffer = nullptr;
+    HRESULT hr = mDevice->CreateBuffer(&bufferDesc, NULL, &buffer);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem creating shared mesh buffer. ", hr);
+        return no_page;
+    }
+
+    // Reuse a released page if there is one
+    unsigned page = 0;
+    while (page < mPages.size() && mPages[page].mBuffer)
+        ++page;
+    if (page == mPages.size())
+        mPages.push_back({});
+
+    mPages[page].mBuffer = buffer;
+    mPages[page].mAllocator.Reset(capacity);
+
+    return page;
+}
+
+} // namespace DGL
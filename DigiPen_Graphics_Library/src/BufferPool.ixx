@@ -0,0 +1,131 @@
+//-------------------------------------------------------------------------------------------------
+// file:    BufferPool.ixx
+// author:  Andy Ellinger
+// brief:   Header for sharing large vertex and index buffers between meshes
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <map>
+#include <vector>
+
+export module BufferPool;
+
+import UploadQueue;
+
+namespace DGL
+{
+
+//--------------------------------------------------------------------------------- OffsetAllocator
+
+// Hands out blocks from a fixed range of space. Freed blocks are joined with any free space
+// right before or after them, and new blocks come from the smallest free block that fits.
+export class OffsetAllocator
+{
+public:
+    // Sets the size of the range and frees all previous blocks
+    void Reset(unsigned capacity);
+
+    // Returns the offset of a new block of the provided size, or invalid_offset if no free
+    // block is large enough
+    unsigned Allocate(unsigned size);
+
+    // Frees a block returned by Allocate
+    void Free(unsigned offset, unsigned size);
+
+    // Returns the size of the range
+    unsigned GetCapacity() const;
+
+    // Returns the total size of the blocks in use
+    unsigned GetUsed() const;
+
+    // Returns the size of the largest free block
+    unsigned GetLargestFreeBlock() const;
+
+    // Returns the number of separate free blocks
+    unsigned GetFreeBlockCount() const;
+
+    static constexpr unsigned invalid_offset{ 0xffffffff };
+
+private:
+    // Removes the free block from both maps
+    void RemoveFreeBlock(std::map<unsigned, unsigned>::iterator block);
+
+    // The size of each free block, by offset, used to find the neighbors of a freed block
+    std::map<unsigned, unsigned> mFreeByOffset;
+    // The offset of each free block, by size, used to find the smallest block that fits
+    std::multimap<unsigned, unsigned> mFreeBySize;
+    // The size of the range
+    unsigned mCapacity{ 0 };
+    // The total size of the blocks in use
+    unsigned mUsed{ 0 };
+};
+
+//-------------------------------------------------------------------------------------- BufferPool
+
+// A set of large D3D buffers with the same bind flags and element size. Each mesh is given a
+// block of one of the buffers, so meshes in the same buffer can be drawn without binding a
+// different buffer. Offsets and sizes are counted in elements, not bytes.
+export class BufferPool
+{
+public:
+    // Saves the D3D device, the queue used to copy data into the buffers, and the type of
+    // buffers to create
+    void Initialize(ID3D11Device* device, UploadQueue* uploads, UINT bindFlags,
+        unsigned elementSize, unsigned pageElements);
+
+    // Releases all of the D3D buffers
+    void Release();
+
+    // Copies the elements into a new block and sets the page, offset, and buffer to use. The
+    // copy may wait for the upload queue to be flushed. Returns false if there was a problem.
+    bool Allocate(const void* data, unsigned count, unsigned& page, unsigned& offset,
+        ID3D11Buffer*& buffer);
+
+    // Frees a block returned by Allocate
+    void Free(unsigned page, unsigned offset, unsigned count);
+
+    // Adds this pool's buffers and counters to the stats
+    void AddStats(DGL_MeshBufferStats& stats) const;
+
+    // The page value for meshes that have their own buffer instead of a block of a shared one
+    static constexpr unsigned no_page{ 0xffffffff };
+
+private:
+    // One of the shared D3D buffers
+    struct Page
+    {
+        // The D3D buffer object, or null if this page has been released
+        ID3D11Buffer* mBuffer{ nullptr };
+        // Tracks which parts of the buffer are in use
+        OffsetAllocator mAllocator;
+    };
+
+    // Creates a new buffer that can hold at least the provided number of elements, returning
+    // its page or no_page if there was a problem
+    unsigned AddPage(unsigned count);
+
+    // The D3D device object
+    ID3D11Device* mDevice{ nullptr };
+    // Copies data into the buffers
+    UploadQueue* mUploads{ nullptr };
+    // The shared buffers. Released pages are kept so the other pages' numbers don't change.
+    std::vector<Page> mPages;
+    // The bind flags for each buffer
+    UINT mBindFlags{ 0 };
+    // The size of each element in bytes
+    unsigned mElementSize{ 0 };
+    // The number of elements in a normal page. Larger blocks get a page of their own size.
+    unsigned mPageElements{ 0 };
+    // The number of blocks allocated and freed
+    unsigned long long mAllocations{ 0 };
+    unsigned long long mFrees{ 0 };
+    // The performance counter ticks spent in the allocators
+    long long mAllocatorTicks{ 0 };
+};
+
+} // namespace DGL
@@ -56,7 +56,7 @@ void CameraObject::SetCameraPosition(const DGL_Vec2& position)
     // Set the new camera position
     mCameraPosition = position;
     // Update the world matrix on the constant buffer
-    gGraphics->D3D.mConstantBuffer.mWorldMatrix = GetWorldMatrix();
+    UpdateWorldMatrix();
 }
 
 //*************************************************************************************************
@@ -76,7 +76,7 @@ void CameraObject::SetCameraZoom(float zoom)
     // Set the new zoom factor
     mScale = zoom;
     // Update the world matrix on the constant buffer
-    gGraphics->D3D.mConstantBuffer.mWorldMatrix = GetWorldMatrix();
+    UpdateWorldMatrix();
 }
 
 //*************************************************************************************************
@@ -89,9 +89,10 @@ float CameraObject::GetCameraRotation() const
 void CameraObject::SetCameraRotation(float radians)
 {
     mRotation = radians;
+    mRotationCache.SetAngle(radians);
 
     // Update the world matrix on the constant buffer
-    gGraphics->D3D.mConstantBuffer.mWorldMatrix = GetWorldMatrix();
+    UpdateWorldMatrix();
 }
 
 //*************************************************************************************************
@@ -113,6 +114,12 @@ void CameraObject::ResetWindowSize()
     gGraphics->D3D.ResetOnSizeChange();
 }
 
+//*************************************************************************************************
+void CameraObject::SetViewSize(const DGL_Vec2& size)
+{
+    mWindowSize = size;
+}
+
 //*************************************************************************************************
 DGL_Mat4 CameraObject::GetWorldMatrix()
 {
@@ -172,4 +179,51 @@ DGL_Vec2 CameraObject::ScreenToWorld(const DGL_Vec2& screenPos) const
     };
 }
 
+//*************************************************************************************************
+bool CameraObject::IsVisible(const DGL_Vec2& boxMin, const DGL_Vec2& boxMax, 
+    const Affine2D& transform) const
+{
+    // Camera space is relative to the camera position and rotated by the camera rotation,
+    // the same as the view and rotation matrices in GetWorldMatrix
+    float sinAngle = mRotationCache.GetSin();
+    float cosAngle = mRotationCache.GetCos();
+    DGL_Vec2 offset = {
+        -(cosAngle * mCameraPosition.x - sinAngle * mCameraPosition.y),
+        -(sinAngle * mCameraPosition.x + cosAngle * mCameraPosition.y)
+    };
+    Affine2D view = Affine_Multiply(
+        Affine_Compose(offset, { 1.0f, 1.0f }, sinAngle, cosAngle), transform);
+
+    // Find the box around the transformed box in camera space
+    DGL_Vec2 viewMin;
+    DGL_Vec2 viewMax;
+    Affine_TransformBox(view, boxMin, boxMax, viewMin, viewMax);
+
+    // The visible area is the window size multiplied by the zoom, centered on the camera
+    DGL_Vec2 halfSize = { mWindowSize.x * mScale * 0.5f, mWindowSize.y * mScale * 0.5f };
+    return viewMin.x <= halfSize.x && viewMax.x >= -halfSize.x &&
+        viewMin.y <= halfSize.y && viewMax.y >= -halfSize.y;
+}
+
+//*************************************************************************************************
+void CameraObject::GetVisibleArea(DGL_Vec2& areaMin, DGL_Vec2& areaMax) const
+{
+    // Undo the camera rotation on the visible area and move it to the camera position
+    DGL_Vec2 halfSize = { mWindowSize.x * mScale * 0.5f, mWindowSize.y * mScale * 0.5f };
+    Affine2D world = Affine_Compose(mCameraPosition, { 1.0f, 1.0f }, -mRotationCache.GetSin(),
+        mRotationCache.GetCos());
+
+    Affine_TransformBox(world, { -halfSize.x, -halfSize.y }, halfSize, areaMin, areaMax);
+}
+
+//*************************************************************************************************
+void CameraObject::UpdateWorldMatrix()
+{
+    // A camera without a window isn't used by the graphics system
+    if (!mWindowHandle)
+        return;
+
+    gGraphics->D3D.SetWorldMatrix(GetWorldMatrix());
+}
+
 } // namespace DGL
@@ -13,6 +13,8 @@ module;
 
 export module Camera;
 
+import Math;
+
 namespace DGL
 {
 
@@ -46,6 +48,9 @@ public:
     // Resets with the current window size
     void ResetWindowSize();
 
+    // Sets the size of the area the camera shows at a zoom of 1, for a camera without a window
+    void SetViewSize(const DGL_Vec2& size);
+
     // Returns the world matrix based on the current camera position and window size
     DGL_Mat4 GetWorldMatrix();
 
@@ -54,13 +59,25 @@ public:
     // (window width, window height) in the bottom right corner
     DGL_Vec2 ScreenToWorld(const DGL_Vec2& screenPos) const;
 
+    // Returns false if the box will be completely outside the camera's view after being 
+    // transformed. Returns true if any part of it might be visible.
+    bool IsVisible(const DGL_Vec2& boxMin, const DGL_Vec2& boxMax, const Affine2D& transform) const;
+
+    // Finds the smallest box in world coordinates which contains everything the camera can see
+    void GetVisibleArea(DGL_Vec2& areaMin, DGL_Vec2& areaMax) const;
+
 private:
+    // Sends the new world matrix to the graphics system, if the camera belongs to a window
+    void UpdateWorldMatrix();
+
     // The current camera position
     DGL_Vec2 mCameraPosition{ 0.0f, 0.0f };
     // The Z value used when creating the world matrix
     float mCameraZ{ -10.0f };
     // The rotation value (in radians) applied to the camera
     float mRotation{ 0.0f };
+    // The sine and cosine of the camera rotation
+    CachedRotation mRotationCache;
     // The scale used to modify the window size for the world matrix
     float mScale{ 1.0f };
     // The current size of the window
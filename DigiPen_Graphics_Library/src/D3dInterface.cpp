@@ -10,7 +10,9 @@ module;
 
 #include "DGL.h"
 #include <d3d11.h>
+#include <string.h>
 #include "VShader.h"
+#include "VShaderInst.h"
 #include "PShader.h"
 #include "PTexShader.h"
 
@@ -32,6 +34,102 @@ void SafeRelease(RefType& pInterface)
     pInterface = nullptr;
 }
 
+//--------------------------------------------------------------------------------- ConstantTracker
+
+//*************************************************************************************************
+bool ConstantTracker::CheckPerFrame(const cbPerObject& data, bool storedData)
+{
+    if (storedData && !mPerFrameDirty)
+        return false;
+
+    const char* bytes = reinterpret_cast<const char*>(&data);
+    char* uploadedBytes = reinterpret_cast<char*>(&mUploadedData);
+    if (mPerFrameUploaded && memcmp(uploadedBytes, bytes, per_frame_size) == 0)
+        return false;
+
+    memcpy(uploadedBytes, bytes, per_frame_size);
+    mPerFrameUploaded = true;
+    return true;
+}
+
+//*************************************************************************************************
+bool ConstantTracker::CheckPerObject(const cbPerObject& data, bool storedData)
+{
+    if (storedData && !mPerObjectDirty)
+        return false;
+
+    const char* bytes = reinterpret_cast<const char*>(&data) + per_frame_size;
+    char* uploadedBytes = reinterpret_cast<char*>(&mUploadedData) + per_frame_size;
+    if (mPerObjectUploaded && memcmp(uploadedBytes, bytes, per_object_size) == 0)
+        return false;
+
+    memcpy(uploadedBytes, bytes, per_object_size);
+    mPerObjectUploaded = true;
+    return true;
+}
+
+//*************************************************************************************************
+void ConstantTracker::FinishUpdate(bool storedData)
+{
+    // After uploading other data, the stored data needs to be checked again on the next draw
+    mPerFrameDirty = !storedData;
+    mPerObjectDirty = !storedData;
+}
+
+//*************************************************************************************************
+void ConstantTracker::SetPerFrameDirty()
+{
+    mPerFrameDirty = true;
+}
+
+//*************************************************************************************************
+void ConstantTracker::SetPerObjectDirty()
+{
+    mPerObjectDirty = true;
+}
+
+//*************************************************************************************************
+void ConstantTracker::ForgetPerObject()
+{
+    mPerObjectUploaded = false;
+    mPerObjectDirty = true;
+}
+
+//*************************************************************************************************
+void ConstantTracker::Reset()
+{
+    mPerFrameUploaded = false;
+    mPerObjectUploaded = false;
+    mPerFrameDirty = true;
+    mPerObjectDirty = true;
+}
+
+//*************************************************************************************************
+void ConstantTracker::CountUpload(unsigned bytes)
+{
+    ++mUploadCount;
+    mUploadBytes += bytes;
+}
+
+//*************************************************************************************************
+unsigned ConstantTracker::GetUploadCount() const
+{
+    return mUploadCount;
+}
+
+//*************************************************************************************************
+unsigned ConstantTracker::GetUploadBytes() const
+{
+    return mUploadBytes;
+}
+
+//*************************************************************************************************
+void ConstantTracker::ResetCounters()
+{
+    mUploadCount = 0;
+    mUploadBytes = 0;
+}
+
 //------------------------------------------------------------------------------------ D3DInterface
 
 //*************************************************************************************************
@@ -49,7 +147,7 @@ void D3DInterface::StartUpdate()
     if (mDepthStencilView)
         mDeviceContext->ClearDepthStencilView(mDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
     // Set the input layout
-    mDeviceContext->IASetInputLayout(mInputLayout);
+    SetInputLayout(DGL_VF_DEFAULT, false);
 
     // Set the render target and depth stencil view
     mDeviceContext->OMSetRenderTargets(1, &mRenderTargetView, mDepthStencilView);
@@ -75,10 +173,22 @@ void D3DInterface::EndUpdate()
     // Send the current buffer of data to be displayed
     mSwapChain->Present(1, 0);
 
+    // Let the dynamic constant buffer reuse space from old frames. Data written in this frame
+    // will be reused eventually, so the next frame needs to write its own copy.
+    mConstantRing.EndFrame();
+    if (mPerObjectInRing)
+        mConstantTracker.ForgetPerObject();
+
     // Reset the tracking flag
     mUpdateStarted = false;
 }
 
+//*************************************************************************************************
+DGL_BlendMode D3DInterface::GetBlendMode() const
+{
+    return mCurrentBlendMode;
+}
+
 //*************************************************************************************************
 void D3DInterface::SetBlendMode(DGL_BlendMode mode)
 {
@@ -109,8 +219,23 @@ void D3DInterface::SetBlendMode(DGL_BlendMode mode)
         break;
     }
 
-    // Set the blend state on the D3D device context
-    mDeviceContext->OMSetBlendState(blendState, NULL, 0xffffffff);
+    // Set the blend state on the D3D device context, if it's not already set
+    mStateCache.SetBlendState(blendState);
+
+    // Save the blend mode
+    mCurrentBlendMode = mode;
+}
+
+//*************************************************************************************************
+DGL_TextureSampleMode D3DInterface::GetSampleMode() const
+{
+    return mCurrentSampleMode;
+}
+
+//*************************************************************************************************
+DGL_TextureAddressMode D3DInterface::GetAddressMode() const
+{
+    return mCurrentAddressMode;
 }
 
 //*************************************************************************************************
@@ -152,11 +277,15 @@ void D3DInterface::SetSamplerState(DGL_TextureSampleMode newSampleMode, DGL_Text
         break;
     default:
         gError->SetError("Passed in an invalid DGL_TextureAddressMode value to DGL_Graphics_SetTextureSamplerData.");
-        break;
+        return;
     }
 
-    // Set the sampler for the pixel shader on the D3D device context
-    mDeviceContext->PSSetSamplers(0, 1, samplerState);
+    // Set the sampler for the pixel shader on the D3D device context, if it's not already set
+    mStateCache.SetPixelSampler(*samplerState);
+
+    // Save the sampler settings
+    mCurrentSampleMode = newSampleMode;
+    mCurrentAddressMode = addressMode;
 }
 
 //*************************************************************************************************
@@ -249,8 +378,77 @@ ID3D11VertexShader* D3DInterface::GetCurrentVertexShader() const
     return nullptr;
 }
 
+//*************************************************************************************************
+void D3DInterface::SetInputLayout(DGL_VertexFormat format, bool instanced)
+{
+    mStateCache.SetInputLayout(instanced ? mInstanceInputLayouts[format] : mInputLayouts[format]);
+}
+
+//*************************************************************************************************
+void D3DInterface::SetWorldMatrix(const DGL_Mat4& matrix)
+{
+    mConstantBuffer.mWorldMatrix = matrix;
+    mConstantTracker.SetPerFrameDirty();
+}
+
+//*************************************************************************************************
+void D3DInterface::SetTransformMatrix(const DGL_Mat4& matrix)
+{
+    mConstantBuffer.mTransformMatrix = matrix;
+    mConstantTracker.SetPerObjectDirty();
+}
+
+//*************************************************************************************************
+void D3DInterface::SetTintColor(const DGL_Color& color)
+{
+    mConstantBuffer.mTintColor = color;
+    mConstantTracker.SetPerObjectDirty();
+}
+
+//*************************************************************************************************
+void D3DInterface::SetTexOffset(const DGL_Vec2& offset)
+{
+    mConstantBuffer.mTexOffset = offset;
+    mConstantTracker.SetPerObjectDirty();
+}
+
+//*************************************************************************************************
+void D3DInterface::SetTexRect(const DGL_Vec2& offset, const DGL_Vec2& scale)
+{
+    // This is set for every draw, so only mark the data as changed if it is different
+    DGL_Vec2& currentOffset = mConstantBuffer.mTexRectOffset;
+    DGL_Vec2& currentScale = mConstantBuffer.mTexRectScale;
+    if (currentOffset.x == offset.x && currentOffset.y == offset.y &&
+        currentScale.x == scale.x && currentScale.y == scale.y)
+        return;
+
+    currentOffset = offset;
+    currentScale = scale;
+    mConstantTracker.SetPerObjectDirty();
+}
+
+//*************************************************************************************************
+void D3DInterface::SetAlpha(float alpha)
+{
+    mConstantBuffer.mAlpha = alpha;
+    mConstantTracker.SetPerObjectDirty();
+}
+
+//*************************************************************************************************
+void D3DInterface::SetShaderData(float data)
+{
+    mConstantBuffer.mShaderData = data;
+    mConstantTracker.SetPerObjectDirty();
+}
+
 //*************************************************************************************************
 void D3DInterface::UpdateConstantBuffer()
+{
+    UpdateConstantBuffer(mConstantBuffer, GetCurrentVertexShader());
+}
+
+//*************************************************************************************************
+void D3DInterface::UpdateConstantBuffer(const cbPerObject& data, ID3D11VertexShader* vertexShader)
 {
     if (!mDeviceContext)
     {
@@ -258,10 +456,83 @@ void D3DInterface::UpdateConstantBuffer()
         return;
     }
 
-    // Update the constant buffer resource
-    mDeviceContext->UpdateSubresource(mPerObjectBuffer, 0, NULL, &mConstantBuffer, 0, 0);
-    // Set the constant buffer
-    mDeviceContext->VSSetConstantBuffers(0, 1, &mPerObjectBuffer);
+    // Custom vertex shaders use a single buffer with all of the data
+    if (vertexShader != mVertexShader && vertexShader != mInstanceVertexShader)
+    {
+        if (!mCombinedUploaded || memcmp(&mUploadedCombinedData, &data, sizeof(cbPerObject)) != 0)
+        {
+            UploadConstantData(mCombinedBuffer, &data, sizeof(cbPerObject));
+            mUploadedCombinedData = data;
+            mCombinedUploaded = true;
+        }
+
+        mStateCache.SetVertexConstantBuffer(0, mCombinedBuffer);
+        return;
+    }
+
+    // The stored data only needs to be checked if it was set since the last upload. Any other
+    // data (such as batches and recorded draws) is always checked against the uploaded data.
+    bool storedData = &data == &mConstantBuffer;
+    const char* bytes = reinterpret_cast<const char*>(&data);
+
+    // Update the per-frame buffer if the world matrix changed
+    if (mConstantTracker.CheckPerFrame(data, storedData))
+        UploadConstantData(mPerFrameBuffer, bytes, per_frame_size);
+
+    // Update the per-object buffer if anything else changed
+    if (mConstantTracker.CheckPerObject(data, storedData))
+    {
+        // Write the data into the next part of the dynamic buffer if possible, otherwise
+        // update the per-object buffer
+        mPerObjectInRing = mDynamicConstants && mConstantRing.Write(bytes + per_frame_size,
+            per_object_size, mPerObjectFirstConstant, mPerObjectConstantCount);
+        if (mPerObjectInRing)
+            mConstantTracker.CountUpload(per_object_size);
+        else
+            UploadConstantData(mPerObjectBuffer, bytes + per_frame_size, per_object_size);
+    }
+
+    mConstantTracker.FinishUpdate(storedData);
+
+    // Set the constant buffers
+    mStateCache.SetVertexConstantBuffer(0, mPerFrameBuffer);
+    if (mPerObjectInRing)
+    {
+        mStateCache.SetVertexConstantBufferRange(1, mConstantRing.GetBuffer(), 
+            mPerObjectFirstConstant, mPerObjectConstantCount);
+    }
+    else
+        mStateCache.SetVertexConstantBuffer(1, mPerObjectBuffer);
+}
+
+//*************************************************************************************************
+void D3DInterface::SetDynamicConstants(bool enabled)
+{
+    if (enabled == mDynamicConstants)
+        return;
+
+    mDynamicConstants = enabled;
+
+    // Make sure the next draw uploads its data to the right place
+    mConstantTracker.ForgetPerObject();
+}
+
+//*************************************************************************************************
+unsigned D3DInterface::GetConstantBufferUploads() const
+{
+    return mConstantTracker.GetUploadCount();
+}
+
+//*************************************************************************************************
+unsigned D3DInterface::GetConstantBufferBytes() const
+{
+    return mConstantTracker.GetUploadBytes();
+}
+
+//*************************************************************************************************
+void D3DInterface::ResetUploadCounters()
+{
+    mConstantTracker.ResetCounters();
 }
 
 //*************************************************************************************************
@@ -293,7 +564,7 @@ void D3DInterface::ResetOnSizeChange()
     SetViewport();
 
     // Get the updated world matrix for the constant buffer
-    mConstantBuffer.mWorldMatrix = gGraphics->Camera.GetWorldMatrix();
+    SetWorldMatrix(gGraphics->Camera.GetWorldMatrix());
 }
 
 //*************************************************************************************************
@@ -315,9 +586,28 @@ void D3DInterface::Release()
             SafeRelease(value2);
     }
 
+    // Forget the bound state, since these objects are about to be released
+    mStateCache.Initialize(nullptr);
+    mStateContext.Initialize(nullptr);
+
+    // Release the dynamic constant buffer
+    mConstantRing.Release();
+
+    // Nothing has been uploaded to the new buffers if D3D is initialized again
+    mPerObjectInRing = false;
+    mConstantTracker.Reset();
+    mCombinedUploaded = false;
+
     // Release all other D3D objects
+    SafeRelease(mPerFrameBuffer);
     SafeRelease(mPerObjectBuffer);
-    SafeRelease(mInputLayout);
+    SafeRelease(mCombinedBuffer);
+    for (unsigned i = 0; i < vertex_format_count; ++i)
+    {
+        SafeRelease(mInputLayouts[i]);
+        SafeRelease(mInstanceInputLayouts[i]);
+    }
+    SafeRelease(mInstanceVertexShader);
     SafeRelease(mPixelShader);
     SafeRelease(mPixelTextureShader);
     SafeRelease(mVertexShader);
@@ -343,6 +633,10 @@ int D3DInterface::InitializeD3D()
     if (CreateDevice() == 1)
         return 1;
 
+    // Send state changes through the state cache
+    mStateContext.Initialize(mDeviceContext);
+    mStateCache.Initialize(&mStateContext);
+
     if (CreateRenderTarget() == 1)
         return 1;
 
@@ -363,7 +657,7 @@ int D3DInterface::InitializeD3D()
 
     SetViewport();
 
-    mConstantBuffer.mWorldMatrix = gGraphics->Camera.GetWorldMatrix();
+    SetWorldMatrix(gGraphics->Camera.GetWorldMatrix());
 
     return 0;
 }
@@ -410,30 +704,90 @@ int D3DInterface::InitializeShaders()
         return 1;
     }
 
-    // Create input description struct
-    D3D11_INPUT_ELEMENT_DESC inputElementDesc[] = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEX", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    // The D3D formats of the color and texture coordinates for each vertex format. The input
+    // assembler converts them all to floats, so the same shaders work with every format.
+    const DXGI_FORMAT colorFormats[vertex_format_count] = {
+        DXGI_FORMAT_R32G32B32A32_FLOAT,     // DGL_VF_DEFAULT
+        DXGI_FORMAT_R8G8B8A8_UNORM,         // DGL_VF_COLOR8
+        DXGI_FORMAT_R8G8B8A8_UNORM,         // DGL_VF_COLOR8_UVHALF
+        DXGI_FORMAT_R8G8B8A8_UNORM,         // DGL_VF_COLOR8_UVUNORM16
     };
-    // Create and save input layout
-    hr = mDevice->CreateInputLayout(
-        inputElementDesc,
-        ARRAYSIZE(inputElementDesc),
-        gVShader,
-        sizeof(gVShader),
-        &mInputLayout
+    const DXGI_FORMAT texCoordFormats[vertex_format_count] = {
+        DXGI_FORMAT_R32G32_FLOAT,           // DGL_VF_DEFAULT
+        DXGI_FORMAT_R32G32_FLOAT,           // DGL_VF_COLOR8
+        DXGI_FORMAT_R16G16_FLOAT,           // DGL_VF_COLOR8_UVHALF
+        DXGI_FORMAT_R16G16_UNORM,           // DGL_VF_COLOR8_UVUNORM16
+    };
+
+    for (unsigned format = 0; format < vertex_format_count; ++format)
+    {
+        // Create input description struct
+        D3D11_INPUT_ELEMENT_DESC inputElementDesc[] = {
+            { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "COLOR", 0, colorFormats[format], 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "TEX", 0, texCoordFormats[format], 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        };
+        // Create and save input layout
+        hr = mDevice->CreateInputLayout(
+            inputElementDesc,
+            ARRAYSIZE(inputElementDesc),
+            gVShader,
+            sizeof(gVShader),
+            &mInputLayouts[format]
+        );
+        if (FAILED(hr))
+        {
+            gError->SetError("Problem creating shader input layout. ", hr);
+            return 1;
+        }
+    }
+
+    // Create instanced vertex shader from compiled header
+    hr = mDevice->CreateVertexShader(
+        gVShaderInst,
+        sizeof(gVShaderInst),
+        nullptr,
+        &mInstanceVertexShader
     );
     if (FAILED(hr))
     {
-        gError->SetError("Problem creating shader input layout. ", hr);
+        gError->SetError("Problem creating instanced vertex shader. ", hr);
         return 1;
     }
 
+    for (unsigned format = 0; format < vertex_format_count; ++format)
+    {
+        // Create input description struct for instanced drawing, 
+        // with the vertex data in slot 0 and the instance data in slot 1
+        D3D11_INPUT_ELEMENT_DESC instanceElementDesc[] = {
+            { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "COLOR", 0, colorFormats[format], 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "TEX", 0, texCoordFormats[format], 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "INSTANCE_TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "INSTANCE_TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "INSTANCE_TINT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "INSTANCE_TEXOFFSET", 0, DXGI_FORMAT_R32G32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "INSTANCE_DATA", 0, DXGI_FORMAT_R32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        };
+        // Create and save instanced input layout
+        hr = mDevice->CreateInputLayout(
+            instanceElementDesc,
+            ARRAYSIZE(instanceElementDesc),
+            gVShaderInst,
+            sizeof(gVShaderInst),
+            &mInstanceInputLayouts[format]
+        );
+        if (FAILED(hr))
+        {
+            gError->SetError("Problem creating instanced shader input layout. ", hr);
+            return 1;
+        }
+    }
+
     // Set the shaders and sampler to defaults
-    mDeviceContext->VSSetShader(mVertexShader, NULL, 0);
-    mDeviceContext->PSSetShader(mPixelTextureShader, NULL, 0);
-    mDeviceContext->PSSetSamplers(0, 1, &(mSamplerStates[SampleModes::Linear][TextureAddressModes::Wrap]));
+    mStateCache.SetVertexShader(mVertexShader);
+    mStateCache.SetPixelShader(mPixelTextureShader);
+    mStateCache.SetPixelSampler(mSamplerStates[SampleModes::Linear][TextureAddressModes::Wrap]);
 
     return 0;
 }
@@ -742,22 +1096,52 @@ int D3DInterface::CreateBlendStates()
 //*************************************************************************************************
 int D3DInterface::CreateConstantBuffer()
 {
-    // Create constant buffer descriptor struct
+    // Create constant buffer descriptor struct for the per-frame data
     D3D11_BUFFER_DESC cbBufferDesc = { 0 };
     cbBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    cbBufferDesc.ByteWidth = sizeof(cbPerObject);
+    cbBufferDesc.ByteWidth = per_frame_size;
     cbBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
     // Create and save constant buffer
-    HRESULT hr = mDevice->CreateBuffer(&cbBufferDesc, NULL, &mPerObjectBuffer);
+    HRESULT hr = mDevice->CreateBuffer(&cbBufferDesc, NULL, &mPerFrameBuffer);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem creating constant buffer. ", hr);
+        return 1;
+    }
+
+    // Create and save the constant buffer for the per-object data
+    cbBufferDesc.ByteWidth = per_object_size;
+    hr = mDevice->CreateBuffer(&cbBufferDesc, NULL, &mPerObjectBuffer);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem creating constant buffer. ", hr);
+        return 1;
+    }
+
+    // Create and save the constant buffer with all data for custom shaders
+    cbBufferDesc.ByteWidth = sizeof(cbPerObject);
+    hr = mDevice->CreateBuffer(&cbBufferDesc, NULL, &mCombinedBuffer);
     if (FAILED(hr))
     {
         gError->SetError("Problem creating constant buffer. ", hr);
         return 1;
     }
 
+    // Set up the dynamic buffer, which creates its D3D buffer the first time it's used
+    mConstantRing.Initialize(mDevice, mDeviceContext);
+
     return 0;
 }
 
+//*************************************************************************************************
+void D3DInterface::UploadConstantData(ID3D11Buffer* buffer, const void* data, UINT size)
+{
+    // Update the constant buffer resource
+    mDeviceContext->UpdateSubresource(buffer, 0, NULL, data, 0, 0);
+
+    mConstantTracker.CountUpload(size);
+}
+
 //*************************************************************************************************
 void D3DInterface::SetViewport()
 {
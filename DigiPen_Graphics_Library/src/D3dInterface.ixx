@@ -10,10 +10,14 @@ module;
 
 #include "DGL.h"
 #include <d3d11.h>
+#include <stddef.h>
 #include <unordered_map>
 
 export module D3DInterface;
 
+import RingBuffer;
+import StateCache;
+
 namespace DGL
 {
 
@@ -38,11 +42,83 @@ export struct cbPerObject
     float mAlpha{ 1.0f };
     // Extra data which can be used by custom shaders
     float mShaderData{ 0 };
+    // The part of the texture to use, for textures in an atlas. Texture coordinates (after the
+    // offset is added) are multiplied by the scale and added to the offset.
+    DGL_Vec2 mTexRectOffset{ 0.0f, 0.0f };
+    DGL_Vec2 mTexRectScale{ 1.0f, 1.0f };
 
     // Note: if adding any additional variables, you must account
     // for the valid constant buffer sizes
 };
 
+// The default shaders get the world matrix from a per-frame buffer in register b0 and the rest
+// of the data from a per-object buffer in register b1, so they can be uploaded separately.
+// Custom vertex shaders get all of the data in a single buffer in register b0.
+export constexpr UINT per_frame_size{ offsetof(cbPerObject, mTransformMatrix) };
+export constexpr UINT per_object_size{ sizeof(cbPerObject) - per_frame_size };
+
+// The number of values in DGL_VertexFormat
+export constexpr unsigned vertex_format_count{ 4 };
+
+//--------------------------------------------------------------------------------- ConstantTracker
+
+// Remembers the data most recently uploaded to the per-frame and per-object constant buffers and
+// decides which of them need to be uploaded again. This doesn't use D3D, so it can be checked
+// without a graphics device.
+export class ConstantTracker
+{
+public:
+    // Returns true if the world matrix in the data needs to be uploaded, and remembers it as
+    // uploaded. The stored data is only compared if it was changed since it was last checked.
+    bool CheckPerFrame(const cbPerObject& data, bool storedData);
+
+    // Returns true if the rest of the data needs to be uploaded, and remembers it as uploaded
+    bool CheckPerObject(const cbPerObject& data, bool storedData);
+
+    // Marks the stored data as checked after it was used, or as needing to be checked again
+    // after other data was used
+    void FinishUpdate(bool storedData);
+
+    // Marks the stored world matrix as changed
+    void SetPerFrameDirty();
+
+    // Marks the rest of the stored data as changed
+    void SetPerObjectDirty();
+
+    // Forgets the uploaded per-object data, so the next update uploads it again
+    void ForgetPerObject();
+
+    // Forgets all uploaded data
+    void Reset();
+
+    // Adds an upload of the provided size to the counters
+    void CountUpload(unsigned bytes);
+
+    // Returns the number of uploads since the counters were reset
+    unsigned GetUploadCount() const;
+
+    // Returns the number of bytes uploaded since the counters were reset
+    unsigned GetUploadBytes() const;
+
+    // Sets the upload counters back to zero
+    void ResetCounters();
+
+private:
+    // The data most recently uploaded to the per-frame and per-object buffers
+    cbPerObject mUploadedData;
+    // Tracks whether anything has been uploaded to each buffer yet
+    bool mPerFrameUploaded{ false };
+    bool mPerObjectUploaded{ false };
+    // Tracks whether the stored per-frame data might be different from the uploaded data
+    bool mPerFrameDirty{ true };
+    // Tracks whether the stored per-object data might be different from the uploaded data
+    bool mPerObjectDirty{ true };
+    // The number of constant buffer uploads
+    unsigned mUploadCount{ 0 };
+    // The number of bytes of constant buffer data uploaded
+    unsigned mUploadBytes{ 0 };
+};
+
 //------------------------------------------------------------------------------------ D3DInterface
 
 export class D3DInterface
@@ -55,9 +131,18 @@ public:
     // End the current drawing session and present the buffer
     void EndUpdate();
 
+    // Returns the current blend mode setting
+    DGL_BlendMode GetBlendMode() const;
+
     // Set the blend mode to use on the next draw
     void SetBlendMode(DGL_BlendMode mode);
 
+    // Returns the current texture sample mode setting
+    DGL_TextureSampleMode GetSampleMode() const;
+
+    // Returns the current texture address mode setting
+    DGL_TextureAddressMode GetAddressMode() const;
+
     // Set the sampler state to use on the next draw
     void SetSamplerState(DGL_TextureSampleMode sampleMode, DGL_TextureAddressMode addressMode);
 
@@ -85,15 +170,59 @@ public:
     // Get the current pixel shader, according to the shader mode
     ID3D11VertexShader* GetCurrentVertexShader() const;
 
-    // Update the D3D constant buffer with the current stored data
+    // Set the input layout for the vertex format, for either normal or instanced drawing
+    void SetInputLayout(DGL_VertexFormat format, bool instanced);
+
+    // Set the world matrix on the stored constant buffer data
+    void SetWorldMatrix(const DGL_Mat4& matrix);
+
+    // Set the transform matrix on the stored constant buffer data
+    void SetTransformMatrix(const DGL_Mat4& matrix);
+
+    // Set the tint color on the stored constant buffer data
+    void SetTintColor(const DGL_Color& color);
+
+    // Set the texture offset on the stored constant buffer data
+    void SetTexOffset(const DGL_Vec2& offset);
+
+    // Set the part of the texture to use on the stored constant buffer data
+    void SetTexRect(const DGL_Vec2& offset, const DGL_Vec2& scale);
+
+    // Set the alpha value on the stored constant buffer data
+    void SetAlpha(float alpha);
+
+    // Set the custom shader data on the stored constant buffer data
+    void SetShaderData(float data);
+
+    // Update the D3D constant buffers with the current stored data for the current vertex shader
     void UpdateConstantBuffer();
 
+    // Update the D3D constant buffers with the provided data for the provided vertex shader.
+    // Only the buffers whose data has changed since they were last uploaded are updated.
+    void UpdateConstantBuffer(const cbPerObject& data, ID3D11VertexShader* vertexShader);
+
+    // Turns writing per-object constant data into a shared dynamic buffer on or off
+    void SetDynamicConstants(bool enabled);
+
+    // Returns the number of constant buffer uploads since the counters were reset
+    unsigned GetConstantBufferUploads() const;
+
+    // Returns the number of bytes of constant buffer data uploaded since the counters were reset
+    unsigned GetConstantBufferBytes() const;
+
+    // Sets the upload counters back to zero
+    void ResetUploadCounters();
+
     // Adjust to a change in window size
     void ResetOnSizeChange();
 
-    // Stores the constant buffer data that will be applied 
+    // Stores the constant buffer data that will be applied. Change this through the set 
+    // functions so the changes are uploaded.
     cbPerObject mConstantBuffer;
 
+    // Filters out state changes that wouldn't change anything
+    StateCache mStateCache;
+
     // The color that will be used to clear the render target view
     float mBackgroundColor[4]{ 0.0f, 0.0f, 0.0f, 1.0f };
 
@@ -122,9 +251,12 @@ private:
     // Creates the blend states for all possible blend settings
     int CreateBlendStates();
 
-    // Creates the D3D constant buffer
+    // Creates the D3D constant buffers
     int CreateConstantBuffer();
 
+    // Copies the data into the D3D constant buffer and updates the upload counters
+    void UploadConstantData(ID3D11Buffer* buffer, const void* data, UINT size);
+
     // Sets the viewport data on the device context
     void SetViewport();
 
@@ -135,6 +267,8 @@ private:
     ID3D11Device* mDevice{ nullptr };
     // The D3D device context object
     ID3D11DeviceContext* mDeviceContext{ nullptr };
+    // Sends state changes from the state cache to the device context
+    D3DStateContext mStateContext;
     // The D3D swap chain object
     IDXGISwapChain* mSwapChain{ nullptr };
     // The D3D render target view object
@@ -153,14 +287,43 @@ private:
     ID3D11PixelShader* mPixelCustomShader{ nullptr };
     // The custom D3D vertex shader that a user gives us
     ID3D11VertexShader* mVertexCustomShader{ nullptr };
-    // The D3D input layout object
-    ID3D11InputLayout* mInputLayout{ nullptr };
-    // The D3D constant buffer object
+    // The D3D input layout objects for each vertex format
+    ID3D11InputLayout* mInputLayouts[vertex_format_count]{};
+    // The D3D vertex shader object for instanced drawing
+    ID3D11VertexShader* mInstanceVertexShader{ nullptr };
+    // The D3D input layout objects for instanced drawing with each vertex format
+    ID3D11InputLayout* mInstanceInputLayouts[vertex_format_count]{};
+    // The D3D constant buffer object with the world matrix
+    ID3D11Buffer* mPerFrameBuffer{ nullptr };
+    // The D3D constant buffer object with the per-object data
     ID3D11Buffer* mPerObjectBuffer{ nullptr };
+    // The D3D constant buffer object with all data, used by custom vertex shaders
+    ID3D11Buffer* mCombinedBuffer{ nullptr };
+    // The dynamic buffer the per-object data is written into when dynamic constants are on
+    ConstantRing mConstantRing;
+    // Tracks whether per-object data should be written into the dynamic buffer
+    bool mDynamicConstants{ false };
+    // Tracks whether the most recent per-object data is in the dynamic buffer
+    bool mPerObjectInRing{ false };
+    // The location of the most recent per-object data in the dynamic buffer
+    UINT mPerObjectFirstConstant{ 0 };
+    UINT mPerObjectConstantCount{ 0 };
+    // Decides when the per-frame and per-object buffers are uploaded, and counts all uploads
+    ConstantTracker mConstantTracker;
+    // The data most recently uploaded to the combined buffer
+    cbPerObject mUploadedCombinedData;
+    // Tracks whether anything has been uploaded to the combined buffer yet
+    bool mCombinedUploaded{ false };
     // The current pixel shader mode
     DGL_PixelShaderMode mCurrentPixelShaderMode{ DGL_PSM_COLOR };
     // The current vertex shader mode
     DGL_VertexShaderMode mCurrentVertexShaderMode{ DGL_VSM_DEFAULT };
+    // The current blend mode
+    DGL_BlendMode mCurrentBlendMode{ DGL_BM_NONE };
+    // The current texture sample mode
+    DGL_TextureSampleMode mCurrentSampleMode{ DGL_TSM_LINEAR };
+    // The current texture address mode
+    DGL_TextureAddressMode mCurrentAddressMode{ DGL_AM_WRAP };
     // Used to make sure StartUpdate is called before EndUpdate
     bool mUpdateStarted{ false };
 
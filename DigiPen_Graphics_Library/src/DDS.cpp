@@ -0,0 +1,365 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DDS.cpp
+// author:  Andy Ellinger
+// brief:   Reading and writing DDS texture files
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <ctype.h>
+#include <d3d11.h>
+#include <fstream>
+#include <string.h>
+#include <vector>
+
+module DDS;
+
+import BlockCompression;
+import Mipmap;
+
+namespace DGL
+{
+
+namespace
+{
+
+// Builds the four character codes used to identify formats
+constexpr unsigned MakeFourCC(char a, char b, char c, char d)
+{
+    return (unsigned)(unsigned char)a | ((unsigned)(unsigned char)b << 8) |
+        ((unsigned)(unsigned char)c << 16) | ((unsigned)(unsigned char)d << 24);
+}
+
+constexpr unsigned dds_magic{ MakeFourCC('D', 'D', 'S', ' ') };
+
+// The header flags
+constexpr unsigned header_caps{ 0x1 };
+constexpr unsigned header_height{ 0x2 };
+constexpr unsigned header_width{ 0x4 };
+constexpr unsigned header_pitch{ 0x8 };
+constexpr unsigned header_pixel_format{ 0x1000 };
+constexpr unsigned header_mip_count{ 0x20000 };
+constexpr unsigned header_linear_size{ 0x80000 };
+constexpr unsigned header_depth{ 0x800000 };
+
+// The pixel format flags
+constexpr unsigned pixel_alpha{ 0x1 };
+constexpr unsigned pixel_fourcc{ 0x4 };
+constexpr unsigned pixel_rgb{ 0x40 };
+
+// The caps flags
+constexpr unsigned caps_complex{ 0x8 };
+constexpr unsigned caps_texture{ 0x1000 };
+constexpr unsigned caps_mipmap{ 0x400000 };
+constexpr unsigned caps2_cubemap{ 0x200 };
+constexpr unsigned caps2_volume{ 0x200000 };
+
+// The DX10 header values
+constexpr unsigned dimension_texture2d{ 3 };
+constexpr unsigned misc_texture_cube{ 0x4 };
+
+struct DDSPixelFormat
+{
+    unsigned mSize;
+    unsigned mFlags;
+    unsigned mFourCC;
+    unsigned mBitCount;
+    unsigned mRedMask;
+    unsigned mGreenMask;
+    unsigned mBlueMask;
+    unsigned mAlphaMask;
+};
+
+struct DDSHeader
+{
+    unsigned mSize;
+    unsigned mFlags;
+    unsigned mHeight;
+    unsigned mWidth;
+    unsigned mPitchOrLinearSize;
+    unsigned mDepth;
+    unsigned mMipMapCount;
+    unsigned mReserved1[11];
+    DDSPixelFormat mPixelFormat;
+    unsigned mCaps;
+    unsigned mCaps2;
+    unsigned mCaps3;
+    unsigned mCaps4;
+    unsigned mReserved2;
+};
+
+struct DDSHeaderDX10
+{
+    unsigned mFormat;
+    unsigned mResourceDimension;
+    unsigned mMiscFlag;
+    unsigned mArraySize;
+    unsigned mMiscFlags2;
+};
+
+static_assert(sizeof(DDSPixelFormat) == 32);
+static_assert(sizeof(DDSHeader) == 124);
+static_assert(sizeof(DDSHeaderDX10) == 20);
+
+//*************************************************************************************************
+DXGI_FORMAT GetLegacyFormat(const DDSPixelFormat& pixelFormat, bool& swapRedBlue)
+{
+    swapRedBlue = false;
+    if (pixelFormat.mFlags & pixel_fourcc)
+    {
+        switch (pixelFormat.mFourCC)
+        {
+        case MakeFourCC('D', 'X', 'T', '1'):
+            return DXGI_FORMAT_BC1_UNORM;
+        case MakeFourCC('D', 'X', 'T', '2'):
+        case MakeFourCC('D', 'X', 'T', '3'):
+            return DXGI_FORMAT_BC2_UNORM;
+        case MakeFourCC('D', 'X', 'T', '4'):
+        case MakeFourCC('D', 'X', 'T', '5'):
+            return DXGI_FORMAT_BC3_UNORM;
+        case MakeFourCC('A', 'T', 'I', '1'):
+        case MakeFourCC('B', 'C', '4', 'U'):
+            return DXGI_FORMAT_BC4_UNORM;
+        case MakeFourCC('A', 'T', 'I', '2'):
+        case MakeFourCC('B', 'C', '5', 'U'):
+            return DXGI_FORMAT_BC5_UNORM;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    // 32 bit pixels with the channels in either order
+    if ((pixelFormat.mFlags & pixel_rgb) && pixelFormat.mBitCount == 32 &&
+        pixelFormat.mGreenMask == 0x0000ff00)
+    {
+        if (pixelFormat.mRedMask == 0x000000ff && pixelFormat.mBlueMask == 0x00ff0000)
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+
+        if (pixelFormat.mRedMask == 0x00ff0000 && pixelFormat.mBlueMask == 0x000000ff)
+        {
+            swapRedBlue = true;
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+//*************************************************************************************************
+DXGI_FORMAT GetDX10Format(unsigned format, bool& swapRedBlue)
+{
+    swapRedBlue = false;
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        swapRedBlue = true;
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        return DXGI_FORMAT_BC1_UNORM;
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+        return DXGI_FORMAT_BC2_UNORM;
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+        return DXGI_FORMAT_BC3_UNORM;
+    case DXGI_FORMAT_BC4_UNORM:
+        return DXGI_FORMAT_BC4_UNORM;
+    case DXGI_FORMAT_BC5_UNORM:
+        return DXGI_FORMAT_BC5_UNORM;
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return DXGI_FORMAT_BC7_UNORM;
+    default:
+        return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------------------- DDSFile
+
+//*************************************************************************************************
+bool DDSFile::IsDDSFile(const char* fileName)
+{
+    size_t length = strlen(fileName);
+    if (length < 4)
+        return false;
+
+    const char* extension = fileName + length - 4;
+    return extension[0] == '.' && tolower(extension[1]) == 'd' && tolower(extension[2]) == 'd' &&
+        tolower(extension[3]) == 's';
+}
+
+//*************************************************************************************************
+HRESULT DDSFile::Read(const char* fileName, std::vector<MipLevel>& levels, DXGI_FORMAT& format)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+    unsigned magic;
+    DDSHeader header;
+    if (!file.read((char*)&magic, sizeof(magic)) || !file.read((char*)&header, sizeof(header)))
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    if (magic != dds_magic || header.mSize != sizeof(DDSHeader) ||
+        header.mPixelFormat.mSize != sizeof(DDSPixelFormat))
+        return E_INVALIDARG;
+
+    bool swapRedBlue;
+    if ((header.mPixelFormat.mFlags & pixel_fourcc) &&
+        header.mPixelFormat.mFourCC == MakeFourCC('D', 'X', '1', '0'))
+    {
+        DDSHeaderDX10 header10;
+        if (!file.read((char*)&header10, sizeof(header10)))
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        if (header10.mResourceDimension != dimension_texture2d || header10.mArraySize > 1 ||
+            (header10.mMiscFlag & misc_texture_cube))
+            return E_INVALIDARG;
+
+        format = GetDX10Format(header10.mFormat, swapRedBlue);
+    }
+    else
+    {
+        if ((header.mFlags & header_depth) || (header.mCaps2 & (caps2_cubemap | caps2_volume)))
+            return E_INVALIDARG;
+
+        format = GetLegacyFormat(header.mPixelFormat, swapRedBlue);
+    }
+
+    // The device needs the first level of block compressed textures to be whole blocks
+    int width = (int)header.mWidth;
+    int height = (int)header.mHeight;
+    if (format == DXGI_FORMAT_UNKNOWN || width <= 0 || height <= 0 ||
+        width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+        height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+        (BlockCompressor::IsBlockFormat(format) && (width % 4 != 0 || height % 4 != 0)))
+        return E_INVALIDARG;
+
+    unsigned levelCount = (header.mFlags & header_mip_count) && header.mMipMapCount > 0 ?
+        header.mMipMapCount : 1;
+    if (levelCount > MipmapGenerator::GetLevelCount(width, height))
+        return E_INVALIDARG;
+
+    // Pixels without alpha are opaque
+    bool noAlpha = format == DXGI_FORMAT_R8G8B8A8_UNORM &&
+        !(header.mPixelFormat.mFlags & pixel_fourcc) && header.mPixelFormat.mAlphaMask == 0;
+
+    levels.clear();
+    levels.resize(levelCount);
+    for (MipLevel& level : levels)
+    {
+        level.mWidth = width;
+        level.mHeight = height;
+        level.mPixels.resize(MipmapGenerator::GetLevelBytes(format, width, height));
+        if (!file.read((char*)level.mPixels.data(), level.mPixels.size()))
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+        if (swapRedBlue || noAlpha)
+        {
+            for (size_t i = 0; i < level.mPixels.size(); i += 4)
+            {
+                if (swapRedBlue)
+                {
+                    unsigned char temp = level.mPixels[i];
+                    level.mPixels[i] = level.mPixels[i + 2];
+                    level.mPixels[i + 2] = temp;
+                }
+                if (noAlpha)
+                    level.mPixels[i + 3] = 255;
+            }
+        }
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    return S_OK;
+}
+
+//*************************************************************************************************
+HRESULT DDSFile::Write(const char* fileName, const std::vector<MipLevel>& levels,
+    DXGI_FORMAT format)
+{
+    if (levels.empty())
+        return E_INVALIDARG;
+
+    DDSHeader header;
+    memset(&header, 0, sizeof(header));
+    header.mSize = sizeof(DDSHeader);
+    header.mFlags = header_caps | header_height | header_width | header_pixel_format;
+    header.mHeight = levels[0].mHeight;
+    header.mWidth = levels[0].mWidth;
+    header.mMipMapCount = (unsigned)levels.size();
+    header.mPixelFormat.mSize = sizeof(DDSPixelFormat);
+    header.mCaps = caps_texture;
+    if (levels.size() > 1)
+    {
+        header.mFlags |= header_mip_count;
+        header.mCaps |= caps_complex | caps_mipmap;
+    }
+
+    // Block compressed files give the size of the first level, and others the size of a row
+    if (BlockCompressor::IsBlockFormat(format))
+    {
+        header.mFlags |= header_linear_size;
+        header.mPitchOrLinearSize = (unsigned)levels[0].mPixels.size();
+    }
+    else
+    {
+        header.mFlags |= header_pitch;
+        header.mPitchOrLinearSize = MipmapGenerator::GetRowPitch(format, levels[0].mWidth);
+    }
+
+    DDSHeaderDX10 header10{ (unsigned)format, dimension_texture2d, 0, 1, 0 };
+    bool useDX10 = false;
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+        header.mPixelFormat.mFlags = pixel_rgb | pixel_alpha;
+        header.mPixelFormat.mBitCount = 32;
+        header.mPixelFormat.mRedMask = 0x000000ff;
+        header.mPixelFormat.mGreenMask = 0x0000ff00;
+        header.mPixelFormat.mBlueMask = 0x00ff0000;
+        header.mPixelFormat.mAlphaMask = 0xff000000;
+        break;
+    case DXGI_FORMAT_BC1_UNORM:
+        header.mPixelFormat.mFlags = pixel_fourcc;
+        header.mPixelFormat.mFourCC = MakeFourCC('D', 'X', 'T', '1');
+        break;
+    case DXGI_FORMAT_BC2_UNORM:
+        header.mPixelFormat.mFlags = pixel_fourcc;
+        header.mPixelFormat.mFourCC = MakeFourCC('D', 'X', 'T', '3');
+        break;
+    case DXGI_FORMAT_BC3_UNORM:
+        header.mPixelFormat.mFlags = pixel_fourcc;
+        header.mPixelFormat.mFourCC = MakeFourCC('D', 'X', 'T', '5');
+        break;
+    default:
+        header.mPixelFormat.mFlags = pixel_fourcc;
+        header.mPixelFormat.mFourCC = MakeFourCC('D', 'X', '1', '0');
+        useDX10 = true;
+        break;
+    }
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return HRESULT_FROM_WIN32(ERROR_OPEN_FAILED);
+
+    file.write((const char*)&dds_magic, sizeof(dds_magic));
+    file.write((const char*)&header, sizeof(header));
+    if (useDX10)
+        file.write((const char*)&header10, sizeof(header10));
+    for (const MipLevel& level : levels)
+        file.write((const char*)level.mPixels.data(), level.mPixels.size());
+
+    return file ? S_OK : HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+}
+
+} // namespace DGL
@@ -0,0 +1,44 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DDS.ixx
+// author:  Andy Ellinger
+// brief:   Header for reading and writing DDS texture files
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <d3d11.h>
+#include <vector>
+
+export module DDS;
+
+import Mipmap;
+
+namespace DGL
+{
+
+//---------------------------------------------------------------------------------------- DDSFile
+
+// Reads and writes DDS files, which hold the levels of a texture already in the format the
+// device uses, so they can be copied to the device without decoding or compressing them. Only
+// single 2D textures are supported, not arrays, cube maps, or volumes. Nothing here uses the
+// graphics device or the error handler, so it can be used on any thread.
+export class DDSFile
+{
+public:
+    // Returns true if the file name ends with .dds
+    static bool IsDDSFile(const char* fileName);
+
+    // Reads the levels and format of the file. RGBA, BC1, BC2, BC3, BC4, BC5, and BC7 files are
+    // supported. sRGB formats are read as the matching UNORM format, since the colors of other
+    // textures aren't converted from sRGB either, and BGRA pixels are swapped to RGBA.
+    static HRESULT Read(const char* fileName, std::vector<MipLevel>& levels, DXGI_FORMAT& format);
+
+    // Writes the levels to the file with the format. RGBA, BC1, BC2, and BC3 files use the
+    // original header so older tools can read them, and other formats add the DX10 header.
+    static HRESULT Write(const char* fileName, const std::vector<MipLevel>& levels,
+        DXGI_FORMAT format);
+};
+
+} // namespace DGL
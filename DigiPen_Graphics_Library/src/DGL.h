@@ -96,12 +96,311 @@ typedef struct DGL_SysInitInfo
 
 } DGL_SysInitInfo;
 
+// This struct is used to pass the data for each copy of a mesh to DGL_Graphics_DrawMeshInstanced().
+typedef struct DGL_InstanceData
+{
+    // The position, scale, and rotation (in radians) of this instance.
+    DGL_Vec2 mPosition;
+    DGL_Vec2 mScale;
+    float mRotation;
+
+    // The Z layer value for this instance. 
+    // Smaller values will appear in front of instances with larger values.
+    float mZValue;
+
+    // The tint color to add to the mesh color for this instance.
+    DGL_Color mTintColor;
+
+    // The texture offset to add to the mesh texture coordinates for this instance.
+    DGL_Vec2 mTextureOffset;
+
+    // The transparency value to multiply with the alpha value of the mesh and texture.
+    float mAlpha;
+
+    // Extra data which is passed to the pixel shader for custom shaders.
+    float mShaderData;
+
+} DGL_InstanceData;
+
+// This struct is used to return the drawing counters from DGL_Graphics_GetDrawStats().
+// All values count from the most recent call to DGL_Graphics_StartDrawing().
+typedef struct DGL_DrawStats
+{
+    // The number of draw calls sent to the graphics card.
+    unsigned mDrawCalls;
+
+    // The number of pipeline state changes (shaders, textures, buffers, blend and sampler 
+    // settings) sent to the graphics card.
+    unsigned mStateChanges;
+
+    // The number of pipeline state changes that were skipped because the same value was already set.
+    unsigned mStateChangesSkipped;
+
+    // The number of batches drawn while batching is on.
+    unsigned mBatches;
+
+    // The number of meshes that were combined into batches.
+    unsigned mBatchedMeshes;
+
+    // The number of times constant buffer data was sent to the graphics card. Data is only sent
+    // when it has changed since the previous draw.
+    unsigned mConstantBufferUploads;
+
+    // The total size of the constant buffer data sent to the graphics card, in bytes.
+    unsigned mConstantBufferBytes;
+
+    // The number of meshes passed to DGL_Graphics_DrawMesh which were not culled.
+    unsigned mMeshesSubmitted;
+
+    // The number of meshes which were skipped because they were outside the camera's view.
+    unsigned mMeshesCulled;
+
+} DGL_DrawStats;
+
+// This struct is used to return the bounds of a mesh from DGL_Graphics_GetMeshBounds().
+// All values are in the mesh's own coordinates, before any transform is applied.
+typedef struct DGL_MeshBounds
+{
+    // The smallest X and Y values of the mesh's vertex positions.
+    DGL_Vec2 mMin;
+
+    // The largest X and Y values of the mesh's vertex positions.
+    DGL_Vec2 mMax;
+
+    // The center of a circle which contains all of the mesh's vertex positions.
+    DGL_Vec2 mCenter;
+
+    // The radius of a circle which contains all of the mesh's vertex positions.
+    float mRadius;
+
+} DGL_MeshBounds;
+
+// This struct is used to return the amount of graphics card memory used by meshes from 
+// DGL_Graphics_GetMeshMemory().
+typedef struct DGL_MeshMemory
+{
+    // The number of meshes which currently exist.
+    unsigned mMeshes;
+
+    // The number of bytes used by the vertex buffers of all current meshes.
+    unsigned long long mVertexBytes;
+
+    // The number of bytes the same vertex buffers would use if every mesh used DGL_VF_DEFAULT.
+    // The difference from mVertexBytes is the memory saved by using smaller vertex formats.
+    unsigned long long mDefaultFormatVertexBytes;
+
+    // The number of bytes used by the index buffers of all current meshes.
+    unsigned long long mIndexBytes;
+
+    // The number of bytes of CPU memory used by the data kept by all current meshes, plus the
+    // list of vertices used by DGL_Graphics_StartMesh(). Builders made with
+    // DGL_MeshBuilder_Create() are not counted.
+    unsigned long long mCPUBytes;
+
+    // The largest value mCPUBytes has had, including while creating a mesh, when the mesh's
+    // vertices are in both the list used to build it and the mesh's own copy.
+    unsigned long long mPeakCPUBytes;
+
+} DGL_MeshMemory;
+
+// This struct is used to return how much a mesh was improved by DGL_Graphics_EndMeshOptimized()
+// or DGL_MeshBuilder_Optimize().
+typedef struct DGL_MeshOptimizeStats
+{
+    // The number of vertices added to the mesh.
+    unsigned mVerticesBefore;
+
+    // The number of vertices left after removing duplicates.
+    unsigned mVerticesAfter;
+
+    // The average number of vertices the graphics card transforms for each triangle, with the
+    // triangles in the order they were added. Lower is better, and the best possible is about 0.5.
+    float mACMRBefore;
+
+    // The average number of vertices transformed for each triangle after reordering them.
+    float mACMRAfter;
+
+} DGL_MeshOptimizeStats;
+
+// This struct is used to return information about the shared buffers meshes are stored in from
+// DGL_Graphics_GetMeshBufferStats(). Each mesh's vertices and indices are stored in part of a
+// large buffer shared with other meshes, so drawing different meshes doesn't need new buffers set.
+typedef struct DGL_MeshBufferStats
+{
+    // The number of shared vertex and index buffers which currently exist.
+    unsigned mBuffers;
+
+    // The total size of the shared buffers, in bytes.
+    unsigned long long mBufferBytes;
+
+    // The number of bytes in the shared buffers used by current meshes.
+    unsigned long long mUsedBytes;
+
+    // The number of separate areas of free space in the shared buffers. When there are many,
+    // the free space is broken up into small pieces.
+    unsigned mFreeBlocks;
+
+    // The size of the largest area of free space in any one shared buffer, in bytes.
+    unsigned long long mLargestFreeBlockBytes;
+
+    // The number of times space was given to a mesh or freed, since Graphics was initialized.
+    unsigned long long mAllocations;
+    unsigned long long mFrees;
+
+    // The total time spent finding and freeing space, in seconds.
+    double mAllocatorSeconds;
+
+} DGL_MeshBufferStats;
+
+// This struct is used to return the upload counters from DGL_Graphics_GetUploadStats().
+// While upload batching is on, the data for new meshes and textures is saved and copied to the
+// graphics card together when the uploads are flushed.
+typedef struct DGL_UploadStats
+{
+    // The number of uploads waiting for the next flush, and the total size of their data in bytes.
+    unsigned mPendingUploads;
+    unsigned long long mPendingBytes;
+
+    // The number of flushes which copied anything, since Graphics was initialized.
+    unsigned mFlushes;
+
+    // The number of uploads copied by the most recent flush, and the number of separate copies
+    // they were combined into.
+    unsigned mLastFlushUploads;
+    unsigned mLastFlushCopies;
+
+    // The number of bytes copied by the most recent flush.
+    unsigned long long mLastFlushBytes;
+
+    // The total number of bytes copied into the shared mesh buffers and batched textures, since
+    // Graphics was initialized.
+    unsigned long long mTotalBytes;
+
+} DGL_UploadStats;
+
+// This struct is used to return the counters for textures loaded in the background from
+// DGL_Graphics_GetTextureLoadStats().
+typedef struct DGL_TextureLoadStats
+{
+    // The number of threads reading and decoding files.
+    unsigned mWorkers;
+
+    // The number of textures which haven't finished loading.
+    unsigned mPending;
+
+    // The number of textures which finished loading, and which failed, since Graphics was initialized.
+    unsigned mLoaded;
+    unsigned mFailed;
+
+    // The total time the worker threads spent reading and decoding files, and building and
+    // compressing levels, in seconds. While several threads are working this can be larger than
+    // the time that has passed.
+    double mDecodeSeconds;
+
+    // The total time spent creating the textures on the graphics card, in seconds.
+    double mCreateSeconds;
+
+} DGL_TextureLoadStats;
+
+// This struct is used to return the counters for textures shared by loading the same file from
+// DGL_Graphics_GetTextureCacheStats().
+typedef struct DGL_TextureCacheStats
+{
+    // The number of loads which found the texture in the cache, and which had to load the file,
+    // since Graphics was initialized. Loads while the cache is off aren't counted.
+    unsigned mHits;
+    unsigned mMisses;
+
+    // The number of textures with no references released to stay within the budget, or by
+    // DGL_Graphics_ClearTextureCache(), since Graphics was initialized.
+    unsigned mEvictions;
+
+    // The number of textures in the cache which are being used, and which have been freed and
+    // are kept in case they are loaded again.
+    unsigned mTextures;
+    unsigned mRetainedTextures;
+
+    // The graphics card memory used by all of the textures in the cache, and by the ones which
+    // have been freed, in bytes.
+    unsigned long long mResidentBytes;
+    unsigned long long mRetainedBytes;
+
+} DGL_TextureCacheStats;
+
+// This struct is used to return the size of one level of a texture from
+// DGL_Graphics_GetTextureLevels().
+typedef struct DGL_TextureLevel
+{
+    // The width and height of the level in pixels.
+    int mWidth;
+    int mHeight;
+
+    // The graphics card memory used by the level, in bytes.
+    unsigned mBytes;
+
+} DGL_TextureLevel;
+
+// This struct is used to return the results of DGL_Graphics_ConvertTextureToDDS().
+typedef struct DGL_CompressionStats
+{
+    // The number of 4x4 blocks compressed in all of the levels.
+    unsigned mBlocks;
+
+    // The most threads used to compress one level.
+    unsigned mThreads;
+
+    // The size of all of the levels before and after compression, in bytes.
+    unsigned mUncompressedBytes;
+    unsigned mCompressedBytes;
+
+    // The time spent compressing the levels, in seconds, not counting reading and writing files.
+    double mSeconds;
+
+    // The peak signal to noise ratio of the full size level after compression, in decibels.
+    // Higher values are closer to the original, and 40 or more is hard to see.
+    float mPSNR;
+
+} DGL_CompressionStats;
+
+// This struct is used to return the counters for a texture atlas from DGL_Graphics_GetAtlasStats().
+typedef struct DGL_AtlasStats
+{
+    // The number of pages the atlas has created.
+    unsigned mPages;
+
+    // The number of textures added to the atlas.
+    unsigned mTextures;
+
+    // The total number of pixels in all of the pages.
+    unsigned long long mPagePixels;
+
+    // The number of page pixels covered by the textures, not counting the padding around them.
+    // Dividing this by mPagePixels gives how efficiently the textures are packed.
+    unsigned long long mUsedPixels;
+
+    // The total time spent finding space for the textures, in seconds.
+    double mPackSeconds;
+
+} DGL_AtlasStats;
+
 // This is the type used for texture data. You will only be working with pointers to this type.
 typedef struct DGL_Texture DGL_Texture;
 
+// This is the type used for texture atlases, which pack many textures into a few large pages.
+// You will only be working with pointers to this type.
+typedef struct DGL_Atlas DGL_Atlas;
+
 // This is the type used for mesh data. You will only be working with pointers to this type.
 typedef struct DGL_Mesh DGL_Mesh;
 
+// This is the type used for meshes combined by DGL_Graphics_BakeStaticBatch(). You will only be
+// working with pointers to this type.
+typedef struct DGL_StaticBatch DGL_StaticBatch;
+
+// This is the type used to build meshes on any thread with the DGL_MeshBuilder functions. You will
+// only be working with pointers to this type.
+typedef struct DGL_MeshBuilder DGL_MeshBuilder;
+
 // This is the type used for custom pixel shaders. You will only be working with pointers to this type.
 typedef struct DGL_PixelShader DGL_PixelShader;
 
@@ -150,6 +449,37 @@ typedef enum
     DGL_AM_MIRROR_ONCE, // Mirror once and then clamp
 } DGL_TextureAddressMode;
 
+// These values are used to return the state of a texture loaded with DGL_Graphics_LoadTextureAsync().
+typedef enum
+{
+    DGL_TS_LOADING,     // The file is waiting to be read or is being decoded
+    DGL_TS_READY,       // The texture has loaded and can be drawn
+    DGL_TS_FAILED,      // The file couldn't be loaded, and the placeholder texture is drawn instead
+} DGL_TextureStatus;
+
+// This is the type used for functions called when a texture loaded with
+// DGL_Graphics_LoadTextureAsync() has finished, either successfully or not.
+typedef void (*DGL_TextureLoadCallback)(DGL_Texture* texture, DGL_TextureStatus status, void* userData);
+
+// These values are used to specify how the smaller levels (mipmaps) of new textures are made.
+// The smaller levels are used when a texture is drawn smaller than its size.
+typedef enum
+{
+    DGL_MM_NONE,        // Textures only have their full size level
+    DGL_MM_DEVICE,      // The graphics card averages each level from the one before it
+    DGL_MM_BOX,         // Each level is averaged on the CPU, keeping transparent pixels from darkening the edges
+    DGL_MM_KAISER,      // Each level is filtered on the CPU with a sharper filter, which is slower
+} DGL_MipmapMode;
+
+// These values are used to specify how textures are stored on the graphics card.
+// Compressed textures use much less memory, but the colors are less exact.
+typedef enum
+{
+    DGL_TC_NONE,        // Four bytes for every pixel
+    DGL_TC_BC1,         // Half a byte for every pixel, with alpha either fully transparent or fully opaque
+    DGL_TC_BC3,         // One byte for every pixel, with smooth alpha
+} DGL_TextureCompression;
+
 // These values are used to specify which pixel shader to use when drawing.
 typedef enum
 {
@@ -165,6 +495,55 @@ typedef enum
     DGL_VSM_CUSTOM,     // Draw using the last set custom vertex shader
 } DGL_VertexShaderMode;
 
+// These values are used to specify how a mesh's vertices are stored on the graphics card.
+// Smaller formats use less memory and are faster to draw, but store values less precisely.
+typedef enum
+{
+    DGL_VF_DEFAULT,             // 32 bytes per vertex, with every value stored as floats
+    DGL_VF_COLOR8,              // 20 bytes per vertex, with 8 bits for each color channel
+    DGL_VF_COLOR8_UVHALF,       // 16 bytes per vertex, with 8-bit color channels and 16-bit float 
+                                // texture coordinates (about 3 decimal digits of precision)
+    DGL_VF_COLOR8_UVUNORM16,    // 16 bytes per vertex, with 8-bit color channels and 16-bit 
+                                // texture coordinates, which must be between 0 and 1
+} DGL_VertexFormat;
+
+// These values are used to specify how much of a mesh's data is kept in CPU memory after it has
+// been copied to the graphics card. The mesh's bounds are always kept, so culling always works.
+typedef enum
+{
+    DGL_MR_NONE,        // Nothing is kept. The mesh can't be batched.
+    DGL_MR_POSITIONS,   // The vertex positions and indices are kept, for things like picking.
+                        // The mesh can't be batched.
+    DGL_MR_ALL,         // All vertex data and indices are kept. This is the default.
+} DGL_MeshRetention;
+
+// This struct is used to pass the data for an object to DGL_Spatial_AddObject() and 
+// DGL_Spatial_UpdateObject().
+typedef struct DGL_SpatialObject
+{
+    // The mesh to draw for this object.
+    const DGL_Mesh* mMesh;
+
+    // The texture to use when drawing this object, or NULL to draw without a texture.
+    const DGL_Texture* mTexture;
+
+    // The draw mode to use when drawing the mesh.
+    DGL_DrawMode mDrawMode;
+
+    // The position of this object.
+    DGL_Vec2 mPosition;
+
+    // The scale of this object.
+    DGL_Vec2 mScale;
+
+    // The rotation of this object, in radians.
+    float mRotation;
+
+    // The Z layer value for this object. Smaller values will appear in front of larger values.
+    float mZValue;
+
+} DGL_SpatialObject;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -274,6 +653,49 @@ DGL_API void DGL_Graphics_SetCustomVertexShader(const DGL_VertexShader* shader);
 // Sets the texture to use when drawing with the texture-based pixel shader.
 DGL_API void DGL_Graphics_SetTexture(const DGL_Texture* texture);
 
+// Turns automatic batching on (TRUE) or off (FALSE). Batching is off by default.
+// While batching is on, consecutive meshes drawn with the same texture, shaders, blend mode, 
+// sampler settings, and constant buffer data (other than the transform and texture offset) 
+// are combined and sent to the graphics card as a single draw.
+DGL_API void DGL_Graphics_SetBatching(BOOL enabled);
+
+// Turns draw sorting on (TRUE) or off (FALSE). Sorting is off by default.
+// While sorting is on, DGL_Graphics_DrawMesh saves each draw along with the current settings
+// instead of drawing it. DGL_Graphics_FinishDrawing then draws meshes with no blending first, 
+// from front to back, grouping meshes with the same Z value by shader, texture, and mesh, 
+// followed by blended meshes from back to front by Z value. Overlapping meshes with no blending 
+// should use different Z values, since the order of meshes with the same Z value may change. 
+// DGL_Graphics_DrawMeshInstanced draws the saved meshes before drawing its instances.
+DGL_API void DGL_Graphics_SetDrawSorting(BOOL enabled);
+
+// Turns dynamic constant data on (TRUE) or off (FALSE). This is off by default.
+// While this is on, the per-object constant buffer data for each draw (transform, tint color, 
+// texture offset, alpha, and shader data) is written into the next part of one large buffer 
+// instead of replacing the contents of a small buffer, which avoids extra copies in the driver 
+// when drawing many objects. If the graphics card doesn't support this, it has no effect.
+// Custom vertex shaders are not affected.
+DGL_API void DGL_Graphics_SetDynamicConstants(BOOL enabled);
+
+// Turns view culling on or off. This is off by default.
+// While culling is on, DGL_Graphics_DrawMesh skips meshes whose bounds are completely outside
+// the camera's view, using the current transform, camera position, zoom, and rotation. 
+// Meshes drawn with a custom vertex shader are never culled.
+DGL_API void DGL_Graphics_SetCulling(BOOL enabled);
+
+// Turns upload batching on (TRUE) or off (FALSE). Upload batching is off by default.
+// While it is on, creating meshes and loading textures from memory saves their data instead of
+// sending it to the graphics card right away. Everything saved is sent together when
+// DGL_Graphics_FlushUploads() is called, at the next DGL_Graphics_StartDrawing(), before anything
+// is drawn, or when upload batching is turned off. This makes loading many resources faster.
+// Textures loaded from files are always uploaded right away.
+DGL_API void DGL_Graphics_SetUploadBatching(BOOL enabled);
+
+// Sends any data saved by upload batching to the graphics card.
+DGL_API void DGL_Graphics_FlushUploads(void);
+
+// Fills in the provided struct with the upload counters.
+DGL_API void DGL_Graphics_GetUploadStats(DGL_UploadStats* stats);
+
 //-------------------------------------------------------------------------------------------------
 // *** Shaders ************************************************************************************
 
@@ -297,6 +719,8 @@ DGL_API void DGL_Graphics_FreeVertexShader(const DGL_VertexShader** shader);
 // *** Textures ***********************************************************************************
 
 // Loads a texture with the provided name and path into memory.
+// DDS files keep the format and any smaller levels saved in the file.
+// While the texture cache is on, files which are already loaded return the same texture.
 // Returns a pointer to the new texture instance.
 DGL_API DGL_Texture* DGL_Graphics_LoadTexture(const char* fileName);
 
@@ -305,13 +729,98 @@ DGL_API DGL_Texture* DGL_Graphics_LoadTexture(const char* fileName);
 // Returns a pointer to the new texture instance.
 DGL_API DGL_Texture* DGL_Graphics_LoadTextureFromMemory(const unsigned char* data, int width, int height);
 
-// Unloads the provided texture from memory.
+// Returns a texture which will be loaded from the file with the provided name and path by
+// background threads, without waiting for the file to be read. Until it has loaded, the texture
+// can be used normally, but the placeholder texture is drawn instead and its size is 0. Files
+// with a higher priority are loaded first. Loaded textures are finished at the next
+// DGL_Graphics_StartDrawing() or DGL_Graphics_GetTextureStatus(), and the callback (which can be
+// NULL) is called then on the same thread.
+DGL_API DGL_Texture* DGL_Graphics_LoadTextureAsync(const char* fileName, int priority,
+    DGL_TextureLoadCallback callback, void* userData);
+
+// Returns whether the texture is still loading, has loaded, or failed to load.
+DGL_API DGL_TextureStatus DGL_Graphics_GetTextureStatus(const DGL_Texture* texture);
+
+// Sets the texture drawn in place of textures which are still loading or failed to load.
+// Passing NULL uses the default placeholder, which is fully transparent.
+DGL_API void DGL_Graphics_SetPlaceholderTexture(const DGL_Texture* texture);
+
+// Fills in the provided struct with the counters for textures loaded in the background.
+DGL_API void DGL_Graphics_GetTextureLoadStats(DGL_TextureLoadStats* stats);
+
+// Sets how the smaller levels (mipmaps) are made for textures loaded after this is called.
+// The default is DGL_MM_NONE. Atlas pages never have smaller levels.
+DGL_API void DGL_Graphics_SetMipmapMode(DGL_MipmapMode mode);
+
+// Sets the folder where levels made on the CPU for textures loaded from files are saved, so the
+// next load of the same file can read them instead. The folder is created if it doesn't exist.
+// Passing NULL stops saving and reading levels.
+DGL_API void DGL_Graphics_SetMipmapCache(const char* directory);
+
+// Fills in the array with the size and memory of each level of the texture, from largest to
+// smallest, up to maxLevels. Returns the number of levels the texture has.
+DGL_API unsigned DGL_Graphics_GetTextureLevels(const DGL_Texture* texture, DGL_TextureLevel* levels,
+    unsigned maxLevels);
+
+// Sets how textures loaded from files other than DDS files, or from memory, after this is called
+// are compressed. The default is DGL_TC_NONE. Textures whose width or height isn't a multiple
+// of 4 aren't compressed, and neither are atlas pages. DGL_MM_DEVICE can't make the levels of
+// compressed textures, so they are made with DGL_MM_BOX instead.
+DGL_API void DGL_Graphics_SetTextureCompression(DGL_TextureCompression compression);
+
+// Reads the source file, makes its smaller levels with the mipmap mode, compresses them, and
+// saves them to a new DDS file, which can be loaded without compressing it again. This doesn't
+// need Graphics to be initialized, so it can be used by tools when building a game. The stats
+// can be NULL. Returns TRUE if the file was saved.
+DGL_API BOOL DGL_Graphics_ConvertTextureToDDS(const char* sourceFile, const char* ddsFile,
+    DGL_TextureCompression compression, DGL_MipmapMode mipmapMode, DGL_CompressionStats* stats);
+
+// Turns the texture cache on or off. While it is on, loading a file with DGL_Graphics_LoadTexture()
+// that is already loaded with the same mipmap mode and compression returns the same texture,
+// and the texture is only unloaded once DGL_Graphics_FreeTexture() has been called for each
+// load. Up to retainedBytes of freed textures are kept in case they are loaded again, dropping
+// the least recently freed first. The cache is off by default. Files which change on disk
+// aren't loaded again while the cache has them.
+DGL_API void DGL_Graphics_SetTextureCache(BOOL enabled, unsigned long long retainedBytes);
+
+// Unloads the freed textures kept by the texture cache.
+DGL_API void DGL_Graphics_ClearTextureCache(void);
+
+// Fills in the provided struct with the counters for the texture cache.
+DGL_API void DGL_Graphics_GetTextureCacheStats(DGL_TextureCacheStats* stats);
+
+// Unloads the provided texture from memory. Textures from an atlas are freed with the atlas.
+// Textures which are still loading in the background stop loading.
+// Textures from the texture cache are only unloaded when each load has been freed.
 // The pointer passed in will be set to NULL.
 DGL_API void DGL_Graphics_FreeTexture(DGL_Texture** texture);
 
 // Returns the width and height of the texture.
 DGL_API DGL_Vec2 DGL_Graphics_GetTextureSize(DGL_Texture* texture);
 
+// Creates a texture atlas whose pages have the provided width and height in pixels.
+// Textures added to the atlas are packed into its pages, and new pages are created as needed.
+// Draws using textures from the same page can be batched and sorted together.
+// Returns a pointer to the new atlas instance.
+DGL_API DGL_Atlas* DGL_Graphics_CreateAtlas(int pageWidth, int pageHeight);
+
+// Loads a texture with the provided name and path into one of the atlas pages.
+// The returned texture is used like any other texture, and is freed with the atlas.
+DGL_API DGL_Texture* DGL_Graphics_AddAtlasTexture(DGL_Atlas* atlas, const char* fileName);
+
+// Copies a texture from the provided array of colors into one of the atlas pages.
+// Color data should include four char values for every pixel (R G B A).
+// The returned texture is used like any other texture, and is freed with the atlas.
+DGL_API DGL_Texture* DGL_Graphics_AddAtlasTextureFromMemory(DGL_Atlas* atlas,
+    const unsigned char* data, int width, int height);
+
+// Fills in the provided struct with the atlas's page and packing counters.
+DGL_API void DGL_Graphics_GetAtlasStats(const DGL_Atlas* atlas, DGL_AtlasStats* stats);
+
+// Unloads the atlas pages and all textures added to the atlas from memory.
+// The pointer passed in will be set to NULL.
+DGL_API void DGL_Graphics_FreeAtlas(DGL_Atlas** atlas);
+
 //-------------------------------------------------------------------------------------------------
 // *** Meshes *************************************************************************************
 
@@ -319,6 +828,11 @@ DGL_API DGL_Vec2 DGL_Graphics_GetTextureSize(DGL_Texture* texture);
 // Any vertices added before this point will be discarded.
 DGL_API void DGL_Graphics_StartMesh(void);
 
+// Tells the graphics system to start building a new mesh, which will store its vertices on the
+// graphics card in the provided format. DGL_Graphics_StartMesh() uses DGL_VF_DEFAULT.
+// Any vertices added before this point will be discarded.
+DGL_API void DGL_Graphics_StartMeshEx(DGL_VertexFormat format);
+
 // Tells the system to complete a mesh with the existing list of vertices.
 // Returns a pointer to the new mesh instance.
 DGL_API DGL_Mesh* DGL_Graphics_EndMesh(void);
@@ -326,9 +840,44 @@ DGL_API DGL_Mesh* DGL_Graphics_EndMesh(void);
 // Tells the system to complete a mesh with the existing list of vertices, and to treat it as an indexed mesh.
 // Requires an array of indices and the size of the array.
 // The indices control which vertices are drawn and in what order.
+// Every index must be less than the number of vertices, or the mesh will not be created.
+// If every index fits in 16 bits, the mesh stores them that way on the graphics card.
 // Returns a pointer to the new mesh instance.
 DGL_API DGL_Mesh* DGL_Graphics_EndMeshIndexed(unsigned* indices, unsigned indexCount);
 
+// The same as DGL_Graphics_EndMeshIndexed, with an array of 16-bit indices.
+DGL_API DGL_Mesh* DGL_Graphics_EndMeshIndexed16(const unsigned short* indices, unsigned indexCount);
+
+// Completes the mesh with the existing list of vertices, treating them as a triangle list.
+// Identical vertices are combined into one and indices are created for them, then the triangles
+// and vertices are reordered so the graphics card can reuse more of its work. The mesh should be 
+// drawn with DGL_DM_TRIANGLELIST. If stats is not NULL, it is filled in with the results.
+DGL_API DGL_Mesh* DGL_Graphics_EndMeshOptimized(DGL_MeshOptimizeStats* stats);
+
+// Creates a mesh from the vertices and format of a builder made with DGL_MeshBuilder_Create().
+// If indices were added to the builder, the mesh is indexed and every index must be less than
+// the number of vertices. If there was a problem while the builder was being filled, the
+// problem is reported here and no mesh is created. This must be called on the same thread as
+// the other graphics functions, but the builder can be filled on any thread.
+// The builder is not changed, so it can be freed or cleared and reused afterward.
+// Returns a pointer to the new mesh instance.
+DGL_API DGL_Mesh* DGL_Graphics_CreateMesh(const DGL_MeshBuilder* builder);
+
+// Creates a mesh whose vertices can be changed with DGL_Graphics_UpdateMesh(), with room for
+// capacity vertices. The mesh starts with no vertices, is not indexed, and always keeps its data.
+// This does not use the vertices added for the current mesh.
+// Returns a pointer to the new mesh instance.
+DGL_API DGL_Mesh* DGL_Graphics_CreateDynamicMesh(unsigned capacity);
+
+// Replaces count vertices of a mesh made by DGL_Graphics_CreateDynamicMesh(), starting at offset.
+// Any vertices after the new ones are removed, so the mesh then has offset + count vertices.
+// The offset can't be more than the current number of vertices, and the vertices must fit in
+// the capacity. The colors and texture coordinates can be NULL, the same as
+// DGL_Graphics_AddVertices. This is much faster than freeing and recreating the mesh each frame,
+// and never waits for the graphics card to finish drawing the old vertices.
+DGL_API void DGL_Graphics_UpdateMesh(DGL_Mesh* mesh, const DGL_Vec2* positions,
+    const DGL_Color* colors, const DGL_Vec2* textureCoords, unsigned count, unsigned offset);
+
 // Adds a new vertex to the list for the current mesh.
 DGL_API void DGL_Graphics_AddVertex(const DGL_Vec2* position, const DGL_Color* color, 
     const DGL_Vec2* textureOffset);
@@ -340,10 +889,70 @@ DGL_API void DGL_Graphics_AddTriangle(
     const DGL_Vec2* position3, const DGL_Color* color3, const DGL_Vec2* textureOffset3
 );
 
+// Adds many vertices to the list for the current mesh, which is much faster than calling
+// DGL_Graphics_AddVertex for each one. Each array must hold count values. If colors is NULL
+// every vertex will be white, and if textureCoords is NULL every vertex will use (0, 0).
+DGL_API void DGL_Graphics_AddVertices(const DGL_Vec2* positions, const DGL_Color* colors, 
+    const DGL_Vec2* textureCoords, unsigned count);
+
+// The same as DGL_Graphics_AddVertices, except each value is the provided number of bytes after
+// the previous value in its array. This allows reading vertices from an array of structs.
+// A stride of 0 means the values are right next to each other.
+DGL_API void DGL_Graphics_AddVerticesStrided(const DGL_Vec2* positions, unsigned positionStride,
+    const DGL_Color* colors, unsigned colorStride, const DGL_Vec2* textureCoords, 
+    unsigned textureCoordStride, unsigned count);
+
+// Adds quads to the list for the current mesh, with two triangles (six vertices) for each quad.
+// Each array must hold four values per quad, for the corners in order around the quad.
+// The colors and texture coordinates can be NULL, the same as DGL_Graphics_AddVertices.
+DGL_API void DGL_Graphics_AddQuads(const DGL_Vec2* positions, const DGL_Color* colors, 
+    const DGL_Vec2* textureCoords, unsigned quadCount);
+
 // Releases the provided mesh from memory.
 // The pointer passed in will be set to NULL.
 DGL_API void DGL_Graphics_FreeMesh(DGL_Mesh** mesh);
 
+// Fills in the provided struct with the box and circle around the mesh's vertex positions.
+DGL_API void DGL_Graphics_GetMeshBounds(const DGL_Mesh* mesh, DGL_MeshBounds* bounds);
+
+// Fills in the provided struct with the amount of graphics card memory used by all current meshes.
+DGL_API void DGL_Graphics_GetMeshMemory(DGL_MeshMemory* memory);
+
+// Sets how much data meshes created after this call keep in CPU memory. The default is DGL_MR_ALL.
+// While batching is on, meshes small enough to be batched always keep all of their data.
+DGL_API void DGL_Graphics_SetMeshRetention(DGL_MeshRetention retention);
+
+// Deletes any of the mesh's CPU data that the provided retention doesn't keep. Data that has
+// already been deleted can't be brought back.
+DGL_API void DGL_Graphics_TrimMeshData(DGL_Mesh* mesh, DGL_MeshRetention retention);
+
+// Copies up to maxCount of the mesh's vertex positions into the array, if it is not NULL.
+// Returns the number of vertices in the mesh, or 0 if the mesh didn't keep its positions.
+DGL_API unsigned DGL_Graphics_GetMeshPositions(const DGL_Mesh* mesh, DGL_Vec2* positions,
+    unsigned maxCount);
+
+// Copies up to maxCount of the mesh's indices into the array, if it is not NULL.
+// Returns the number of indices in the mesh, or 0 if the mesh isn't indexed or didn't keep them.
+DGL_API unsigned DGL_Graphics_GetMeshIndices(const DGL_Mesh* mesh, unsigned* indices,
+    unsigned maxCount);
+
+// Fills in the provided struct with the sizes and counters for the shared buffers meshes are stored in.
+DGL_API void DGL_Graphics_GetMeshBufferStats(DGL_MeshBufferStats* stats);
+
+// Combines many meshes which never move into one mesh for each different texture, so they can be
+// drawn with a few draws instead of one for each mesh. Each mesh is moved by the position, scale,
+// and rotation of its item in the instances array, and its colors and texture coordinates get
+// the item's tint color and texture offset. The Z value and alpha are not used. The textures
+// array can be NULL if no meshes use a texture. Textures from the same atlas page share a mesh. Each mesh must keep all of its data and is
+// treated as a triangle list. The original meshes are not changed.
+// Returns a pointer to the new static batch.
+DGL_API DGL_StaticBatch* DGL_Graphics_BakeStaticBatch(const DGL_Mesh* const* meshes,
+    const DGL_Texture* const* textures, const DGL_InstanceData* instances, unsigned count);
+
+// Releases the meshes in the provided static batch from memory.
+// The pointer passed in will be set to NULL.
+DGL_API void DGL_Graphics_FreeStaticBatch(DGL_StaticBatch** batch);
+
 //-------------------------------------------------------------------------------------------------
 // *** Drawing ************************************************************************************
     
@@ -358,6 +967,28 @@ DGL_API void DGL_Graphics_FinishDrawing(void);
 // Draws the provided mesh with the provided mode.
 DGL_API void DGL_Graphics_DrawMesh(const DGL_Mesh* mesh, DGL_DrawMode mode);
 
+// Draws the provided mesh once for each item in the instances array, all with a single draw.
+// Each instance uses its own transform, Z layer, tint color, texture offset, and alpha values 
+// instead of the values set with the DGL_Graphics_SetCB functions.
+// The default vertex shader is always used, but the current pixel shader and texture are used as normal.
+DGL_API void DGL_Graphics_DrawMeshInstanced(const DGL_Mesh* mesh, DGL_DrawMode mode, 
+    const DGL_InstanceData* instances, unsigned count);
+
+// Draws the provided static batch, using its own texture for each part and the current settings
+// for everything else. The transform, tint color, and texture offset are applied on top of the
+// values baked into the vertices, so they should normally be left at their default values.
+DGL_API void DGL_Graphics_DrawStaticBatch(const DGL_StaticBatch* batch);
+
+// Fills in the provided struct with the drawing counters since the last call to DGL_Graphics_StartDrawing().
+// Calling this after DGL_Graphics_FinishDrawing() gives the totals for the whole frame.
+DGL_API void DGL_Graphics_GetDrawStats(DGL_DrawStats* stats);
+
+// Draws every object added with DGL_Spatial_AddObject() which the camera can see.
+// Each object is drawn like DGL_Graphics_DrawMesh() with its own mesh, texture, transform, and
+// Z layer, using the current shader, blend mode, tint color, and alpha settings. The current 
+// texture and transform settings are the same afterward as they were before.
+DGL_API void DGL_Graphics_DrawVisible(void);
+
 //-------------------------------------------------------------------------------------------------
 // *** Constant buffer ****************************************************************************
 
@@ -370,6 +1001,7 @@ DGL_API void DGL_Graphics_SetCB_TransformData(const DGL_Vec2* position, const DG
 DGL_API void DGL_Graphics_SetCB_ZLayer(float zValue);
 
 // Sets the transformation matrix with position, scale, and rotation to use when drawing meshes.
+// This matrix is used until DGL_Graphics_SetCB_TransformData or DGL_Graphics_SetCB_ZLayer is called.
 DGL_API void DGL_Graphics_SetCB_TransformMatrix(const DGL_Mat4* transformationMatrix);
 
 // Sets the texture offset to use when drawing meshes with textures.
@@ -381,10 +1013,63 @@ DGL_API void DGL_Graphics_SetCB_Alpha(float alpha);
 // Sets the tint color to be applied when drawing meshes. 
 DGL_API void DGL_Graphics_SetCB_TintColor(const DGL_Color* color);
 
-// Sets the float data which is available for custom shaders.
+// Sets the float data which is available for custom shaders. It is in the constant buffer for
+// vertex shaders and is passed to the pixel shader by the default vertex shader.
 DGL_API void DGL_Graphics_SetCB_ShaderData(float data);
 
 
+//*************************************************************************************************
+// MeshBuilder functions
+//*************************************************************************************************
+
+// These functions don't use the graphics card, so they can be called on any thread, even before
+// DGL_System_Init(). Different builders can be filled on different threads at the same time, but
+// each builder should only be used by one thread at a time. Errors are saved on the builder and
+// reported by DGL_Graphics_CreateMesh(), since DGL_System_GetLastError() should only be used on
+// the main thread. Passing a NULL builder does nothing.
+
+// Creates an empty builder whose mesh will store its vertices in the provided format.
+// Returns a pointer to the new builder, which must be freed with DGL_MeshBuilder_Free().
+DGL_API DGL_MeshBuilder* DGL_MeshBuilder_Create(DGL_VertexFormat format);
+
+// Deletes the provided builder. Meshes created from it are not affected.
+// The pointer passed in will be set to NULL.
+DGL_API void DGL_MeshBuilder_Free(DGL_MeshBuilder** builder);
+
+// Removes all vertices, indices, and errors from the builder, keeping its format and memory
+// so it can be used to build another mesh.
+DGL_API void DGL_MeshBuilder_Clear(DGL_MeshBuilder* builder);
+
+// Adds a new vertex to the builder.
+DGL_API void DGL_MeshBuilder_AddVertex(DGL_MeshBuilder* builder, const DGL_Vec2* position,
+    const DGL_Color* color, const DGL_Vec2* textureOffset);
+
+// Adds many vertices to the builder, the same as DGL_Graphics_AddVertices.
+DGL_API void DGL_MeshBuilder_AddVertices(DGL_MeshBuilder* builder, const DGL_Vec2* positions,
+    const DGL_Color* colors, const DGL_Vec2* textureCoords, unsigned count);
+
+// Adds many vertices to the builder, the same as DGL_Graphics_AddVerticesStrided.
+DGL_API void DGL_MeshBuilder_AddVerticesStrided(DGL_MeshBuilder* builder,
+    const DGL_Vec2* positions, unsigned positionStride, const DGL_Color* colors,
+    unsigned colorStride, const DGL_Vec2* textureCoords, unsigned textureCoordStride,
+    unsigned count);
+
+// Adds quads to the builder, the same as DGL_Graphics_AddQuads.
+DGL_API void DGL_MeshBuilder_AddQuads(DGL_MeshBuilder* builder, const DGL_Vec2* positions,
+    const DGL_Color* colors, const DGL_Vec2* textureCoords, unsigned quadCount);
+
+// Adds indices to the builder, which makes its mesh an indexed mesh. The indices are checked
+// when the mesh is created, so vertices can be added before or after them.
+DGL_API void DGL_MeshBuilder_AddIndices(DGL_MeshBuilder* builder, const unsigned* indices,
+    unsigned count);
+
+// Does the same work as DGL_Graphics_EndMeshOptimized on the builder's triangles, so it can be
+// done on another thread. The builder then holds the new vertices and indices. If the builder
+// already has indices, the triangles they make are optimized. If stats is not NULL, it is
+// filled in with the results.
+DGL_API void DGL_MeshBuilder_Optimize(DGL_MeshBuilder* builder, DGL_MeshOptimizeStats* stats);
+
+
 //*************************************************************************************************
 // Input functions
 //*************************************************************************************************
@@ -416,6 +1101,59 @@ DGL_API unsigned char DGL_Input_LastKeyTriggered(void);
 DGL_API void DGL_Input_ShowCursor(BOOL show);
 
 
+//*************************************************************************************************
+// Spatial functions
+//*************************************************************************************************
+
+// Adds an object which will be drawn by DGL_Graphics_DrawVisible() when the camera can see it.
+// Returns the ID of the object, which is used to update or remove it. Returns 0 if there was
+// a problem. IDs of removed objects aren't given to new objects right away, so using an old ID
+// reports an error instead of changing a different object.
+// Objects using a mesh or texture are removed when the mesh or texture is freed.
+DGL_API unsigned DGL_Spatial_AddObject(const DGL_SpatialObject* object);
+
+// Replaces the data for the object with the provided ID. This is fast enough to call every
+// frame for objects which move.
+DGL_API void DGL_Spatial_UpdateObject(unsigned id, const DGL_SpatialObject* object);
+
+// Removes the object with the provided ID.
+DGL_API void DGL_Spatial_RemoveObject(unsigned id);
+
+// Removes all objects.
+DGL_API void DGL_Spatial_Clear(void);
+
+// Fills in the results array with the IDs of the objects which overlap the area, up to 
+// maxResults IDs. Returns the total number of objects which overlap the area, which may be 
+// larger than maxResults.
+DGL_API unsigned DGL_Spatial_QueryArea(const DGL_Vec2* areaMin, const DGL_Vec2* areaMax, 
+    unsigned* results, unsigned maxResults);
+
+// Sets the width and height of the grid cells objects are sorted into. Default is 256.
+// This works best when most objects are smaller than a cell and a cell is smaller than the
+// camera's view.
+DGL_API void DGL_Spatial_SetCellSize(float size);
+
+
+//*************************************************************************************************
+// Math functions
+//*************************************************************************************************
+
+// Transforms each point by the matrix and saves the new points in the results array, which can 
+// be the same as the points array. Only the X and Y rows of the matrix are used, so this is 
+// meant for 2D transforms like the ones used for drawing meshes.
+DGL_API void DGL_Math_TransformPoints(const DGL_Mat4* matrix, const DGL_Vec2* points, 
+    DGL_Vec2* results, unsigned count);
+
+// The same as DGL_Math_TransformPoints, with the X and Y values of the points in separate arrays.
+DGL_API void DGL_Math_TransformPointsSoA(const DGL_Mat4* matrix, const float* xValues, 
+    const float* yValues, float* xResults, float* yResults, unsigned count);
+
+// Calculates the sine and cosine of each angle, in radians. This is faster than calling sinf and
+// cosf for each angle, and the results are within about 0.000001 of the values they would return.
+DGL_API void DGL_Math_SinCos(const float* angles, float* sinResults, float* cosResults, 
+    unsigned count);
+
+
 //*************************************************************************************************
 // Window functions
 //*************************************************************************************************
@@ -0,0 +1,164 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DrawCommands.cpp
+// author:  Andy Ellinger
+// brief:   Recording draws and replaying them sorted by state
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+module DrawCommands;
+
+namespace DGL
+{
+
+// Sort key layout for opaque draws, from the highest bit:
+// transparent flag (1), Z value from front to back (32), vertex shader (3), pixel shader (4), 
+// sampler (3), texture (11), mesh (7), draw mode (3)
+static constexpr uint64_t transparent_bit{ 1ull << 63 };
+static constexpr int depth_shift{ 31 };
+static constexpr int vertex_shader_shift{ 28 };
+static constexpr int pixel_shader_shift{ 24 };
+static constexpr int sampler_shift{ 21 };
+static constexpr int texture_shift{ 10 };
+static constexpr int mesh_shift{ 3 };
+static constexpr int mode_shift{ 0 };
+
+// Sort key layout for transparent draws, from the highest bit:
+// transparent flag (1), Z value from back to front (32), unused (31)
+
+//*************************************************************************************************
+// Returns the value masked to the provided number of bits and moved into place
+static uint64_t KeyField(unsigned value, int bits, int shift)
+{
+    return (uint64_t)(value & ((1u << bits) - 1u)) << shift;
+}
+
+//*************************************************************************************************
+// Returns the bits of the Z value as an unsigned number that sorts the same way as the float
+static uint32_t DepthBits(float zValue)
+{
+    uint32_t bits;
+    memcpy(&bits, &zValue, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+//------------------------------------------------------------------------------- DrawCommandBuffer
+
+//*************************************************************************************************
+void DrawCommandBuffer::Record(const DGL_Mesh* mesh, DGL_DrawMode mode, const DrawState& state)
+{
+    // Save a copy of the state, unless it matches the state of the previous command
+    if (mStates.empty() || !StatesMatch(mStates.back(), state))
+        mStates.push_back(state);
+
+    DrawCommand command;
+    command.mMesh = mesh;
+    command.mMode = mode;
+    command.mStateIndex = (unsigned)mStates.size() - 1;
+    command.mSortKey = MakeSortKey(state, mode,
+        GetId(mVertexShaderIds, state.mVertexShader),
+        GetId(mPixelShaderIds, state.mPixelShader),
+        GetId(mTextureIds, state.mTexture),
+        GetId(mMeshIds, mesh));
+
+    mCommands.push_back(command);
+}
+
+//*************************************************************************************************
+void DrawCommandBuffer::Sort()
+{
+    // A stable sort keeps commands with the same key in the order they were recorded
+    std::stable_sort(mCommands.begin(), mCommands.end(),
+        [](const DrawCommand& first, const DrawCommand& second)
+        {
+            return first.mSortKey < second.mSortKey;
+        });
+}
+
+//*************************************************************************************************
+void DrawCommandBuffer::Replay(CommandBackend& backend) const
+{
+    for (const DrawCommand& command : mCommands)
+        backend.ExecuteCommand(command, mStates[command.mStateIndex]);
+}
+
+//*************************************************************************************************
+void DrawCommandBuffer::Clear()
+{
+    mCommands.clear();
+    mStates.clear();
+    mVertexShaderIds.clear();
+    mPixelShaderIds.clear();
+    mTextureIds.clear();
+    mMeshIds.clear();
+}
+
+//*************************************************************************************************
+unsigned DrawCommandBuffer::GetCommandCount() const
+{
+    return (unsigned)mCommands.size();
+}
+
+//*************************************************************************************************
+unsigned DrawCommandBuffer::GetStateCount() const
+{
+    return (unsigned)mStates.size();
+}
+
+//*************************************************************************************************
+uint64_t DrawCommandBuffer::MakeSortKey(const DrawState& state, DGL_DrawMode mode, 
+    unsigned vertexShaderId, unsigned pixelShaderId, unsigned textureId, unsigned meshId)
+{
+    uint32_t depth = DepthBits(state.mConstantBuffer.mTransformMatrix.m[2][3]);
+
+    // Larger Z values are further back, so they need to be drawn first
+    if (state.mBlendMode != DGL_BM_NONE)
+        return transparent_bit | ((uint64_t)(~depth) << depth_shift);
+
+    // The depth test only passes for closer pixels, so the first of two overlapping draws with
+    // the same Z value is the one that shows. The Z value comes first so only draws with the
+    // same Z value are grouped by state, and closer draws are drawn first.
+    unsigned sampler = (state.mSampleMode == DGL_TSM_POINT ? 4u : 0u) | (unsigned)state.mAddressMode;
+
+    return ((uint64_t)depth << depth_shift) |
+        KeyField(vertexShaderId, 3, vertex_shader_shift) |
+        KeyField(pixelShaderId, 4, pixel_shader_shift) |
+        KeyField(sampler, 3, sampler_shift) |
+        KeyField(textureId, 11, texture_shift) |
+        KeyField(meshId, 7, mesh_shift) |
+        KeyField((unsigned)mode, 3, mode_shift);
+}
+
+//*************************************************************************************************
+unsigned DrawCommandBuffer::GetId(std::unordered_map<const void*, unsigned>& ids, const void* pointer)
+{
+    // If there are more objects than fit in the key, the IDs will repeat, which only means
+    // those draws might not be grouped together
+    auto result = ids.try_emplace(pointer, (unsigned)ids.size());
+    return result.first->second;
+}
+
+//*************************************************************************************************
+bool DrawCommandBuffer::StatesMatch(const DrawState& first, const DrawState& second)
+{
+    return first.mTexture == second.mTexture &&
+        first.mVertexShader == second.mVertexShader &&
+        first.mPixelShader == second.mPixelShader &&
+        first.mVertexShaderMode == second.mVertexShaderMode &&
+        first.mBlendMode == second.mBlendMode &&
+        first.mSampleMode == second.mSampleMode &&
+        first.mAddressMode == second.mAddressMode &&
+        memcmp(&first.mConstantBuffer, &second.mConstantBuffer, sizeof(cbPerObject)) == 0;
+}
+
+} // namespace DGL
@@ -0,0 +1,124 @@
+//-------------------------------------------------------------------------------------------------
+// file:    DrawCommands.ixx
+// author:  Andy Ellinger
+// brief:   Header for recording draws and replaying them sorted by state
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+export module DrawCommands;
+
+import D3DInterface;
+
+namespace DGL
+{
+
+// Everything needed to draw a recorded mesh, other than the mesh and draw mode
+export struct DrawState
+{
+    // The texture to bind (null when drawing with color only)
+    const DGL_Texture* mTexture{ nullptr };
+    // The vertex shader to use
+    ID3D11VertexShader* mVertexShader{ nullptr };
+    // The pixel shader to use
+    ID3D11PixelShader* mPixelShader{ nullptr };
+    // The vertex shader mode, used to decide if the mesh can be batched
+    DGL_VertexShaderMode mVertexShaderMode{ DGL_VSM_DEFAULT };
+    // The blend mode to use
+    DGL_BlendMode mBlendMode{ DGL_BM_NONE };
+    // The texture sample mode to use
+    DGL_TextureSampleMode mSampleMode{ DGL_TSM_LINEAR };
+    // The texture address mode to use
+    DGL_TextureAddressMode mAddressMode{ DGL_AM_WRAP };
+    // The constant buffer data
+    cbPerObject mConstantBuffer;
+};
+
+// A single recorded draw
+export struct DrawCommand
+{
+    // The value used to order the commands
+    uint64_t mSortKey{ 0 };
+    // The mesh to draw
+    const DGL_Mesh* mMesh{ nullptr };
+    // The draw mode to use
+    DGL_DrawMode mMode{ DGL_DM_TRIANGLELIST };
+    // The index of the state to draw with
+    unsigned mStateIndex{ 0 };
+};
+
+//---------------------------------------------------------------------------------- CommandBackend
+
+// Interface for whatever actually draws the commands. Keeping this separate means recording,
+// sorting, and replaying don't depend on having a D3D device.
+export class CommandBackend
+{
+public:
+    virtual ~CommandBackend() = default;
+
+    // Draws a single command with its state
+    virtual void ExecuteCommand(const DrawCommand& command, const DrawState& state) = 0;
+};
+
+//------------------------------------------------------------------------------- DrawCommandBuffer
+
+export class DrawCommandBuffer
+{
+public:
+    // Adds a command to draw the mesh with the provided state
+    void Record(const DGL_Mesh* mesh, DGL_DrawMode mode, const DrawState& state);
+
+    // Orders opaque commands from front to back and by state within each Z value, followed by
+    // transparent commands from back to front
+    void Sort();
+
+    // Sends every command to the backend in the current order
+    void Replay(CommandBackend& backend) const;
+
+    // Removes all commands and states, keeping the memory for the next frame
+    void Clear();
+
+    // Returns the number of recorded commands
+    unsigned GetCommandCount() const;
+
+    // Returns the number of unique states saved for the recorded commands
+    unsigned GetStateCount() const;
+
+    // Returns the sort key for a draw with the provided state and IDs.
+    // Opaque draws are sorted by Z value from front to back, and draws with the same Z value are
+    // grouped by shader, sampler, texture, mesh, and draw mode. Draws with different Z values are
+    // kept correct by the depth test in any order, but where draws with the same Z value overlap
+    // the first one drawn shows, so grouping them can change which one is seen. Transparent draws
+    // come after all opaque draws and are sorted only by Z value, from back to front, so draws 
+    // with the same Z value keep the order they were recorded in.
+    static uint64_t MakeSortKey(const DrawState& state, DGL_DrawMode mode, unsigned vertexShaderId,
+        unsigned pixelShaderId, unsigned textureId, unsigned meshId);
+
+private:
+    // Returns a small ID for the pointer, assigned in the order pointers are first seen
+    static unsigned GetId(std::unordered_map<const void*, unsigned>& ids, const void* pointer);
+
+    // Returns true if the two states would draw the same way
+    static bool StatesMatch(const DrawState& first, const DrawState& second);
+
+    // The recorded commands
+    std::vector<DrawCommand> mCommands;
+    // The states used by the commands. Consecutive draws with the same state share one.
+    std::vector<DrawState> mStates;
+
+    // IDs used in the sort keys for each object used this frame
+    std::unordered_map<const void*, unsigned> mVertexShaderIds;
+    std::unordered_map<const void*, unsigned> mPixelShaderIds;
+    std::unordered_map<const void*, unsigned> mTextureIds;
+    std::unordered_map<const void*, unsigned> mMeshIds;
+};
+
+} // namespace DGL
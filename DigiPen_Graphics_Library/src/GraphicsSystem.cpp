@@ -9,11 +9,16 @@
 module;
 
 #include "DGL.h"
+#include <d3d11.h>
 #include <objbase.h>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 module GraphicsSystem;
 
+import Atlas;
+import DrawCommands;
 import Math;
 import Errors;
 import Texture;
@@ -59,6 +64,26 @@ int GraphicsSystem::Initialize(HWND window)
         return 1;
     }
 
+    // Set up batching to draw through the D3D objects
+    mBatchBackend.Initialize(D3D.mDevice, D3D.mDeviceContext, &D3D.mStateCache);
+    mBatcher.SetBackend(&mBatchBackend);
+
+    // Set up the buffer for instanced drawing
+    mInstanceBuffer.Initialize(D3D.mDevice, D3D.mDeviceContext);
+
+    // Set up the queue for copying data to the graphics card, and the shared buffers that
+    // meshes are stored in
+    mUploadContext.Initialize(D3D.mDeviceContext);
+    mUploads.Initialize(&mUploadContext);
+    Meshes.Initialize(D3D.mDevice, &mUploads);
+
+    // Set up writing into dynamic meshes
+    mMapContext.Initialize(D3D.mDeviceContext);
+
+    // Create the texture drawn in place of textures that are still loading
+    const unsigned char transparent[4] = { 0, 0, 0, 0 };
+    mDefaultPlaceholder = TextureManager::CreateTexture(transparent, 1, 1, D3D.mDevice);
+
     // Initializes the COM library for use by this thread
     CoInitialize(NULL);
 
@@ -92,6 +117,15 @@ int GraphicsSystem::ShutDown()
 
         msg << mTextures << " textures";
     }
+    if (mAtlases)
+    {
+        if (returnValue)
+            msg << ", ";
+        else
+            returnValue = 1;
+
+        msg << mAtlases << " atlases";
+    }
     if (mShaderManager.PixelShaderCount())
     {
         if (returnValue)
@@ -113,7 +147,26 @@ int GraphicsSystem::ShutDown()
     if (returnValue)
         gError->SetError(msg.str());
 
-    // Release all D3D objects
+    // The spatial objects point to meshes and textures which are no longer valid
+    Spatial.Clear();
+
+    // Stop loading textures in the background, release the freed textures kept by the cache,
+    // and release the placeholder
+    mTextureLoader.Release();
+    mTextureCache.Reset(mReleasedTextures);
+    ReleaseCachedTextures();
+    TextureManager::ReleaseTexture(mDefaultPlaceholder);
+    mDefaultPlaceholder = nullptr;
+    mPlaceholderTexture = nullptr;
+
+    // Release the batch, instance, and shared mesh buffers, any waiting uploads, and all D3D
+    // objects
+    mBatchBackend.Release();
+    mInstanceBuffer.Release();
+    mUploads.Release();
+    Meshes.Release();
+    mUploadContext.Initialize(nullptr);
+    mMapContext.Initialize(nullptr);
     D3D.Release();
 
     // Uninitialize the COM library 
@@ -158,6 +211,9 @@ void GraphicsSystem::ReleasePixelShader(const DGL_PixelShader* shader)
         return;
     }
 
+    // The recorded commands or current batch might be using this shader
+    FlushBatch();
+
     mShaderManager.Release(shader);
 }
 
@@ -195,6 +251,9 @@ void GraphicsSystem::ReleaseVertexShader(const DGL_VertexShader* shader)
         return;
     }
 
+    // The recorded commands or current batch might be using this shader
+    FlushBatch();
+
     mShaderManager.Release(shader);
 }
 
@@ -213,10 +272,22 @@ DGL_Texture* GraphicsSystem::LoadTexture(const char* pFileName)
         return nullptr;
     }
 
-    // Create the texture through the texture manager
-    DGL_Texture* texture = TextureManager::LoadTexture(pFileName, D3D.mDevice);
+    // Use the texture already loaded from the file if there is one, or create the texture
+    // through the texture manager
+    DGL_Texture* texture = mTextureCache.Find(pFileName, mTextureSettings);
+    if (!texture)
+    {
+        texture = TextureManager::LoadTexture(pFileName, D3D.mDevice, &mUploads,
+            mTextureSettings);
+        if (texture)
+        {
+            mTextureCache.Add(pFileName, mTextureSettings, texture,
+                TextureCache::GetTextureBytes(texture));
+        }
+    }
 
-    // If it loaded successfuly, increase the texture counter
+    // If it loaded successfuly, increase the texture counter. Each load from the cache is
+    // counted, since each one needs to be freed.
     if (texture)
         ++mTextures;
 
@@ -246,7 +317,8 @@ DGL_Texture* GraphicsSystem::LoadTextureFromMemory(const unsigned char* data, in
     }
 
     // Create the texture through the texture manager
-    DGL_Texture* texture = TextureManager::LoadTextureFromMemory(data, width, height, D3D.mDevice);
+    DGL_Texture* texture = TextureManager::LoadTextureFromMemory(data, width, height, D3D.mDevice,
+        &mUploads, mTextureSettings.mMipmapMode, mTextureSettings.mCompression);
 
     // If it loaded successfuly, increase the texture counter
     if (texture)
@@ -257,311 +329,1427 @@ DGL_Texture* GraphicsSystem::LoadTextureFromMemory(const unsigned char* data, in
 }
 
 //*************************************************************************************************
-void GraphicsSystem::ReleaseTexture(DGL_Texture* texture)
+DGL_Texture* GraphicsSystem::LoadTextureAsync(const char* fileName, int priority,
+    DGL_TextureLoadCallback callback, void* userData)
 {
-    // Make sure the pointer is not null
-    if (!texture)
-        return;
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_LoadTextureAsync when Graphics is not initialized.");
+        return nullptr;
+    }
 
-    // Release the texture through the texture manager
-    TextureManager::ReleaseTexture(texture);
+    if (!fileName)
+    {
+        gError->SetError("Passed a null filename to DGL_Graphics_LoadTextureAsync.");
+        return nullptr;
+    }
 
-    // Decrease the texture counter
-    --mTextures;
-}
+    // The texture exists right away, even though it isn't ready yet
+    ++mTextures;
 
-//*************************************************************************************************
-void GraphicsSystem::SetCurrentTexture(const DGL_Texture* texture)
-{
-    // Save the texture
-    mCurrentTexture = texture;
+    return mTextureLoader.Load(fileName, priority, mTextureSettings, callback, userData);
 }
 
 //*************************************************************************************************
-void GraphicsSystem::StartMesh()
+void GraphicsSystem::FinishTextureLoads()
 {
     if (!mInitialized)
-    {
-        gError->SetError("Called DGL_Graphics_StartMesh when Graphics is not initialized.");
-        return;
-    }
-
-    if (mCreatingMesh)
-    {
-        gError->SetError("Called DGL_Graphics_StartMesh again without calling DGL_Graphics_EndMesh.");
         return;
-    }
-     
-    // Clear any existing vertices in the list
-    Meshes.mVertexList.clear();
 
-    // Set the flag
-    mCreatingMesh = true;
+    mTextureLoader.FinishLoads(D3D.mDevice, &mUploads);
 }
 
 //*************************************************************************************************
-DGL_Mesh* GraphicsSystem::EndMesh()
+DGL_TextureStatus GraphicsSystem::GetTextureStatus(const DGL_Texture* texture)
 {
-    if (!mInitialized)
-    {
-        gError->SetError("Called DGL_Graphics_EndMesh when Graphics is not initialized.");
-        return nullptr;
-    }
-
-    if (!mCreatingMesh)
+    if (!texture)
     {
-        gError->SetError("Called DGL_Graphics_EndMesh without calling DGL_Graphics_StartMesh.");
-        return nullptr;
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetTextureStatus.");
+        return DGL_TS_FAILED;
     }
 
-    // Create the new mesh using the mesh manager
-    DGL_Mesh* newMesh = Meshes.CreateMesh(D3D.mDevice);
-
-    // If it was successful, increase the mesh counter
-    if (newMesh)
-        ++mMeshes;
+    // The texture might have finished decoding since the last check
+    if (texture->status == DGL_TS_LOADING)
+        FinishTextureLoads();
 
-    // Reset the flag
-    mCreatingMesh = false;
-
-    // Return the new mesh
-    return newMesh;
+    return texture->status;
 }
 
 //*************************************************************************************************
-DGL_Mesh* GraphicsSystem::EndMeshIndexed(unsigned* indices, unsigned indexCount)
+void GraphicsSystem::SetPlaceholderTexture(const DGL_Texture* texture)
 {
-    if (!mInitialized)
-    {
-        gError->SetError("Called DGL_Graphics_EndMeshIndexed when Graphics is not initialized.");
-        return nullptr;
-    }
+    mPlaceholderTexture = texture;
+}
 
-    if (!mCreatingMesh)
+//*************************************************************************************************
+void GraphicsSystem::GetTextureLoadStats(DGL_TextureLoadStats* stats) const
+{
+    if (!stats)
     {
-        gError->SetError("Called DGL_Graphics_EndMeshIndexed without calling DGL_Graphics_StartMesh.");
-        return nullptr;
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetTextureLoadStats.");
+        return;
     }
 
-    // Create the new indexed mesh using the mesh manager
-    DGL_Mesh* newMesh = Meshes.CreateMeshIndexed(indices, indexCount, D3D.mDevice);
-
-    // If it was successful, increase the mesh counter
-    if (newMesh)
-        ++mMeshes;
-
-    // Reset the flag
-    mCreatingMesh = false;
-
-    // Return the new mesh
-    return newMesh;
+    mTextureLoader.GetStats(stats);
 }
 
 //*************************************************************************************************
-void GraphicsSystem::AddVertex(const DGL_Vec2& position, const DGL_Color& color, const DGL_Vec2& texCoord)
+void GraphicsSystem::SetMipmapMode(DGL_MipmapMode mode)
 {
-    if (!mCreatingMesh)
+    if (mode < DGL_MM_NONE || mode > DGL_MM_KAISER)
     {
-        gError->SetError("Called DGL_Graphics_AddVertex or DGL_Graphics_AddTriangle without calling DGL_Graphics_StartMesh.");
+        gError->SetError("Passed in an invalid DGL_MipmapMode value to DGL_Graphics_SetMipmapMode.");
         return;
     }
 
-    // Add the vertex to the list on the mesh manager
-    Meshes.mVertexList.push_back({ position, color, texCoord });
+    mTextureSettings.mMipmapMode = mode;
 }
 
 //*************************************************************************************************
-void GraphicsSystem::ReleaseMesh(DGL_Mesh* mesh)
+void GraphicsSystem::SetMipmapCache(const char* directory)
 {
-    // Make sure the pointer is valid
-    if (!mesh)
-        return;
-
-    // Delete the mesh
-    MeshManager::ReleaseMesh(mesh);
-
-    // Reduce the mesh counter
-    --mMeshes;
+    mTextureSettings.mCacheDirectory = directory ? directory : "";
 }
 
 //*************************************************************************************************
-void GraphicsSystem::DrawMesh(const DGL_Mesh* mesh, DGL_DrawMode mode)
+unsigned GraphicsSystem::GetTextureLevels(const DGL_Texture* texture, DGL_TextureLevel* levels,
+    unsigned maxLevels) const
 {
-    if (!mInitialized)
+    if (!texture || (!levels && maxLevels > 0))
     {
-        gError->SetError("Called DGL_Graphics_DrawMesh when Graphics is not initialized.");
-        return;
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetTextureLevels.");
+        return 0;
     }
 
-    CreateTransformMatrix();
-
-    // Draw the mesh using the mesh manager
-    MeshManager::Draw(mesh, mode, mCurrentTexture, D3D.GetCurrentVertexShader(), 
-        D3D.GetCurrentPixelShader(), D3D.mDeviceContext);
+    return TextureManager::GetLevels(texture, levels, maxLevels);
 }
 
 //*************************************************************************************************
-void GraphicsSystem::SetTransformData(const DGL_Vec2& position, const DGL_Vec2& scale, float rotation)
+void GraphicsSystem::SetTextureCompression(DGL_TextureCompression compression)
 {
-    mDrawPosition = position;
-    mDrawScale = scale;
-    mDrawRotation = rotation;
+    if (compression < DGL_TC_NONE || compression > DGL_TC_BC3)
+    {
+        gError->SetError("Passed in an invalid DGL_TextureCompression value to DGL_Graphics_SetTextureCompression.");
+        return;
+    }
 
-    mCreateMatrix = true;
+    mTextureSettings.mCompression = compression;
 }
 
 //*************************************************************************************************
-void GraphicsSystem::SetZValue(float zValue)
+BOOL GraphicsSystem::ConvertTextureToDDS(const char* sourceFile, const char* ddsFile,
+    DGL_TextureCompression compression, DGL_MipmapMode mipmapMode, DGL_CompressionStats* stats)
 {
-    mDrawZValue = zValue;
+    if (!sourceFile || !ddsFile)
+    {
+        gError->SetError("Passed a null filename to DGL_Graphics_ConvertTextureToDDS.");
+        return FALSE;
+    }
 
-    mCreateMatrix = true;
+    if (compression < DGL_TC_NONE || compression > DGL_TC_BC3 || mipmapMode < DGL_MM_NONE ||
+        mipmapMode > DGL_MM_KAISER)
+    {
+        gError->SetError("Passed in an invalid value to DGL_Graphics_ConvertTextureToDDS.");
+        return FALSE;
+    }
+
+    // This doesn't need the device, so it works before Graphics is initialized
+    return TextureManager::ConvertToDDS(sourceFile, ddsFile, compression, mipmapMode, stats) ?
+        TRUE : FALSE;
 }
 
 //*************************************************************************************************
-void GraphicsSystem::CreateTransformMatrix()
+void GraphicsSystem::ReleaseTexture(DGL_Texture* texture)
 {
-    // Create the scale matrix
-    DGL_Mat4 scaleMatrix;
-    Matrix_SetToIdentity(scaleMatrix);
-    scaleMatrix.m[0][0] = mDrawScale.x;
-    scaleMatrix.m[1][1] = mDrawScale.y;
-
-    // Create the rotation matrix
-    DGL_Mat4 rotationMatrix = Matrix_RotateZ(mDrawRotation);
+    // Make sure the pointer is not null
+    if (!texture)
+        return;
 
-    // Create the translation matrix
-    DGL_Mat4 txMatrix;
-    Matrix_SetToIdentity(txMatrix);
-    txMatrix.m[0][3] = mDrawPosition.x;
-    txMatrix.m[1][3] = mDrawPosition.y;
-    txMatrix.m[2][3] = mDrawZValue;
+    // Textures in an atlas are deleted with the atlas
+    if (texture->page)
+    {
+        gError->SetError("Passed a texture from an atlas to DGL_Graphics_FreeTexture, use DGL_Graphics_FreeAtlas instead.");
+        return;
+    }
 
-    // Multiply all matrices together
-    DGL_Mat4 result = Matrix_Multiply(Matrix_Multiply(txMatrix, rotationMatrix), scaleMatrix);
+    // A texture from the cache is only released once every load of it has been freed, and may
+    // be kept after that in case it is loaded again
+    if (mTextureCache.Contains(texture))
+    {
+        --mTextures;
+        if (mTextureCache.Release(texture, mReleasedTextures) > 0)
+            return;
+
+        if (texture == mPlaceholderTexture)
+            mPlaceholderTexture = nullptr;
+        Spatial.RemoveObjectsUsing(texture);
+        ReleaseCachedTextures();
+        return;
+    }
 
-    // Set the transform matrix on the constant buffer
-    D3D.mConstantBuffer.mTransformMatrix = result;
+    if (texture == mPlaceholderTexture)
+        mPlaceholderTexture = nullptr;
 
-    mCreateMatrix = false;
-}
+    // A texture that is still loading was never drawn, so the loader just needs to stop
+    if (texture->status == DGL_TS_LOADING)
+    {
+        Spatial.RemoveObjectsUsing(texture);
+        mTextureLoader.Cancel(texture);
+        --mTextures;
+        return;
+    }
 
-} // namepspace DGL
+    // The recorded commands or current batch might be using this texture
+    FlushBatch();
 
+    // Spatial objects can't be drawn without their texture
+    Spatial.RemoveObjectsUsing(texture);
 
-using namespace DGL;
+    // Release the texture through the texture manager
+    TextureManager::ReleaseTexture(texture);
 
-//*************************************************************************************************
-DGL_Vec2 DGL_Camera_ScreenCoordToWorld(const DGL_Vec2* position)
-{
-    if (position)
-        return gGraphics->Camera.ScreenToWorld(*position);
-    else
-        return DGL_Vec2{ 0,0 };
+    // Decrease the texture counter
+    --mTextures;
 }
 
 //*************************************************************************************************
-DGL_Vec2 DGL_Camera_GetPosition(void)
+void GraphicsSystem::SetTextureCache(bool enabled, unsigned long long retainedBytes)
 {
-    return gGraphics->Camera.GetCameraPosition();
+    mTextureCache.SetRetainedBytes(retainedBytes, mReleasedTextures);
+    mTextureCache.SetEnabled(enabled, mReleasedTextures);
+    ReleaseCachedTextures();
 }
 
 //*************************************************************************************************
-void DGL_Camera_SetPosition(const DGL_Vec2* position)
+void GraphicsSystem::ClearTextureCache()
 {
-    if (position)
-        gGraphics->Camera.SetCameraPosition(*position);
+    mTextureCache.Clear(mReleasedTextures);
+    ReleaseCachedTextures();
 }
 
 //*************************************************************************************************
-float DGL_Camera_GetZoom(void)
+void GraphicsSystem::GetTextureCacheStats(DGL_TextureCacheStats* stats) const
 {
-    return gGraphics->Camera.GetCameraZoom();
-}
+    if (!stats)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetTextureCacheStats.");
+        return;
+    }
 
-//*************************************************************************************************
-void DGL_Camera_SetZoom(float zoom)
-{
-    gGraphics->Camera.SetCameraZoom(zoom);
+    mTextureCache.GetStats(stats);
 }
 
 //*************************************************************************************************
-float DGL_Camera_GetRotation(void)
+void GraphicsSystem::SetCurrentTexture(const DGL_Texture* texture)
 {
-    return gGraphics->Camera.GetCameraRotation();
+    // Save the texture
+    mCurrentTexture = texture;
 }
 
 //*************************************************************************************************
-void DGL_Camera_SetRotation(float radians)
+DGL_Atlas* GraphicsSystem::CreateAtlas(int pageWidth, int pageHeight)
 {
-    gGraphics->Camera.SetCameraRotation(radians);
-}
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_CreateAtlas when Graphics is not initialized.");
+        return nullptr;
+    }
 
-//*************************************************************************************************
-void DGL_Graphics_StartDrawing(void)
-{
-    gGraphics->D3D.StartUpdate();
-}
+    if (pageWidth <= 0 || pageHeight <= 0 || pageWidth > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+        pageHeight > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+    {
+        gError->SetError("Passed invalid size to DGL_Graphics_CreateAtlas.");
+        return nullptr;
+    }
 
-//*************************************************************************************************
-void DGL_Graphics_FinishDrawing(void)
-{
-    gGraphics->D3D.EndUpdate();
+    ++mAtlases;
+
+    return AtlasManager::CreateAtlas(pageWidth, pageHeight);
 }
 
 //*************************************************************************************************
-void DGL_Graphics_SetBackgroundColor(const DGL_Color* color)
+DGL_Texture* GraphicsSystem::AddAtlasTexture(DGL_Atlas* atlas, const char* fileName)
 {
-    if (color)
+    if (!mInitialized)
     {
-        gGraphics->D3D.mBackgroundColor[0] = color->r;
-        gGraphics->D3D.mBackgroundColor[1] = color->g;
-        gGraphics->D3D.mBackgroundColor[2] = color->b;
+        gError->SetError("Called DGL_Graphics_AddAtlasTexture when Graphics is not initialized.");
+        return nullptr;
     }
-}
 
-//*************************************************************************************************
-void DGL_Graphics_SetTextureSamplerData(DGL_TextureSampleMode sampleMode, DGL_TextureAddressMode addressMode)
-{
-    gGraphics->D3D.SetSamplerState(sampleMode, addressMode);
+    if (!atlas || !fileName)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_AddAtlasTexture.");
+        return nullptr;
+    }
+
+    // Pixels from memory might still be waiting to be copied into the pages
+    mUploads.Flush();
+
+    return AtlasManager::AddTexture(atlas, fileName, D3D.mDevice, D3D.mDeviceContext);
 }
 
 //*************************************************************************************************
-void DGL_Graphics_SetBlendMode(DGL_BlendMode mode)
+DGL_Texture* GraphicsSystem::AddAtlasTextureFromMemory(DGL_Atlas* atlas,
+    const unsigned char* data, int width, int height)
 {
-    gGraphics->D3D.SetBlendMode(mode);
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_AddAtlasTextureFromMemory when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    if (!atlas || !data)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_AddAtlasTextureFromMemory.");
+        return nullptr;
+    }
+
+    if (width <= 0 || height <= 0)
+    {
+        gError->SetError("Passed invalid size to DGL_Graphics_AddAtlasTextureFromMemory.");
+        return nullptr;
+    }
+
+    return AtlasManager::AddTextureFromMemory(atlas, data, width, height, D3D.mDevice,
+        &mUploads);
 }
 
 //*************************************************************************************************
-void DGL_Graphics_SetShaderMode(DGL_PixelShaderMode pixelMode, DGL_VertexShaderMode vertexMode)
+void GraphicsSystem::GetAtlasStats(const DGL_Atlas* atlas, DGL_AtlasStats* stats) const
 {
-    gGraphics->D3D.SetPixelShaderMode(pixelMode);
-    gGraphics->D3D.SetVertexShaderMode(vertexMode);
+    if (!atlas || !stats)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetAtlasStats.");
+        return;
+    }
+
+    AtlasManager::GetStats(atlas, stats);
 }
 
 //*************************************************************************************************
-void DGL_Graphics_SetCustomPixelShader(const DGL_PixelShader* shader)
+void GraphicsSystem::ReleaseAtlas(DGL_Atlas* atlas)
 {
-    gGraphics->D3D.SetCustomPixelShader(shader);
+    if (!atlas)
+        return;
+
+    // The recorded commands or current batch might be using the pages
+    FlushBatch();
+
+    // Spatial objects can't be drawn without their texture
+    Spatial.RemoveObjectsUsing(atlas->mTextures);
+
+    AtlasManager::ReleaseAtlas(atlas);
+
+    --mAtlases;
 }
 
 //*************************************************************************************************
-void DGL_Graphics_SetCustomVertexShader(const DGL_VertexShader* shader)
+void GraphicsSystem::SetBlendMode(DGL_BlendMode mode)
 {
-    gGraphics->D3D.SetCustomVertexShader(shader);
+    // Anything already batched needs to be drawn with the old blend mode
+    mBatcher.SetDrawSettings(mode, D3D.GetSampleMode(), D3D.GetAddressMode());
+
+    D3D.SetBlendMode(mode);
 }
 
 //*************************************************************************************************
-void DGL_Graphics_SetTexture(const DGL_Texture* texture)
+void GraphicsSystem::SetSamplerState(DGL_TextureSampleMode sampleMode, DGL_TextureAddressMode addressMode)
 {
-    gGraphics->SetCurrentTexture(texture);
+    // Anything already batched needs to be drawn with the old sampler
+    mBatcher.SetDrawSettings(D3D.GetBlendMode(), sampleMode, addressMode);
+
+    D3D.SetSamplerState(sampleMode, addressMode);
 }
 
 //*************************************************************************************************
-const DGL_PixelShader* DGL_Graphics_LoadPixelShader(const char* filename)
+void GraphicsSystem::StartMesh(DGL_VertexFormat format)
 {
-    return gGraphics->LoadPixelShader(filename);
-}
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_StartMesh when Graphics is not initialized.");
+        return;
+    }
+
+    if (mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_StartMesh again without calling DGL_Graphics_EndMesh.");
+        return;
+    }
+
+    if ((unsigned)format >= vertex_format_count)
+    {
+        gError->SetError("Passed in an invalid DGL_VertexFormat value to DGL_Graphics_StartMeshEx.");
+        return;
+    }
+     
+    // Clear any existing vertices in the list
+    MeshBuilder::Reset(mMeshBuilder, format);
+
+    // Set the flag
+    mCreatingMesh = true;
+}
+
+//*************************************************************************************************
+DGL_Mesh* GraphicsSystem::EndMesh()
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_EndMesh when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    if (!mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_EndMesh without calling DGL_Graphics_StartMesh.");
+        return nullptr;
+    }
+
+    // Create the new mesh from the current mesh's builder
+    DGL_Mesh* newMesh = CreateMesh(&mMeshBuilder);
+
+    // Reset the flag
+    mCreatingMesh = false;
+
+    // Return the new mesh
+    return newMesh;
+}
+
+//*************************************************************************************************
+DGL_Mesh* GraphicsSystem::EndMeshIndexed(unsigned* indices, unsigned indexCount)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_EndMeshIndexed when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    if (!mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_EndMeshIndexed without calling DGL_Graphics_StartMesh.");
+        return nullptr;
+    }
+
+    // Create the new indexed mesh using the mesh manager
+    DGL_Mesh* newMesh = Meshes.CreateMeshIndexed(mMeshBuilder, indices, indexCount, D3D.mDevice);
+
+    // If it was successful, increase the mesh counters
+    if (newMesh)
+    {
+        ++mMeshes;
+        CountMeshMemory(newMesh, true);
+    }
+
+    // Reset the flag
+    mCreatingMesh = false;
+
+    // Return the new mesh
+    return newMesh;
+}
+
+//*************************************************************************************************
+DGL_Mesh* GraphicsSystem::EndMeshIndexed16(const unsigned short* indices, unsigned indexCount)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_EndMeshIndexed16 when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    if (!mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_EndMeshIndexed16 without calling DGL_Graphics_StartMesh.");
+        return nullptr;
+    }
+
+    // Create the new indexed mesh using the mesh manager
+    DGL_Mesh* newMesh = Meshes.CreateMeshIndexed16(mMeshBuilder, indices, indexCount,
+        D3D.mDevice);
+
+    // If it was successful, increase the mesh counters
+    if (newMesh)
+    {
+        ++mMeshes;
+        CountMeshMemory(newMesh, true);
+    }
+
+    // Reset the flag
+    mCreatingMesh = false;
+
+    // Return the new mesh
+    return newMesh;
+}
+
+//*************************************************************************************************
+DGL_Mesh* GraphicsSystem::EndMeshOptimized(DGL_MeshOptimizeStats* stats)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_EndMeshOptimized when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    if (!mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_EndMeshOptimized without calling DGL_Graphics_StartMesh.");
+        return nullptr;
+    }
+
+    // Replace the vertex list with the optimized vertices and indices, then create an indexed mesh
+    MeshBuilder::Optimize(mMeshBuilder, stats);
+    DGL_Mesh* newMesh = CreateMesh(&mMeshBuilder);
+
+    // Reset the flag
+    mCreatingMesh = false;
+
+    // Return the new mesh
+    return newMesh;
+}
+
+//*************************************************************************************************
+DGL_Mesh* GraphicsSystem::CreateMesh(const DGL_MeshBuilder* builder)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_CreateMesh when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    if (!builder)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_CreateMesh.");
+        return nullptr;
+    }
+
+    // Problems found while filling the builder couldn't be reported on the thread filling it
+    if (builder->mError)
+    {
+        gError->SetError(builder->mError);
+        return nullptr;
+    }
+
+    // Create the new mesh using the mesh manager
+    DGL_Mesh* newMesh = nullptr;
+    if (builder->mIndices.empty())
+        newMesh = Meshes.CreateMesh(*builder, D3D.mDevice);
+    else
+        newMesh = Meshes.CreateMeshIndexed(*builder, builder->mIndices.data(),
+            (unsigned)builder->mIndices.size(), D3D.mDevice);
+
+    // If it was successful, increase the mesh counters
+    if (newMesh)
+    {
+        ++mMeshes;
+        CountMeshMemory(newMesh, true);
+    }
+
+    return newMesh;
+}
+
+//*************************************************************************************************
+DGL_Mesh* GraphicsSystem::CreateDynamicMesh(unsigned capacity)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_CreateDynamicMesh when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    DGL_Mesh* newMesh = Meshes.CreateDynamicMesh(capacity, D3D.mDevice);
+
+    // If it was successful, increase the mesh counters
+    if (newMesh)
+    {
+        ++mMeshes;
+        CountMeshMemory(newMesh, true);
+    }
+
+    return newMesh;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::UpdateMesh(DGL_Mesh* mesh, const DGL_Vec2* positions, const DGL_Color* colors,
+    const DGL_Vec2* texCoords, unsigned count, unsigned offset)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_UpdateMesh when Graphics is not initialized.");
+        return;
+    }
+
+    const char* error = MeshManager::CheckUpdate(mesh, positions, count, offset);
+    if (error)
+    {
+        gError->SetError(error);
+        return;
+    }
+
+    // Recorded commands would draw the new vertices instead of the ones they were made with.
+    // Draws that already happened, including the current batch, keep using the old ones.
+    if (mCommands.GetCommandCount())
+        FlushBatch();
+
+    if (!MeshManager::UpdateMesh(mesh, positions, colors, texCoords, count, offset,
+        &mMapContext))
+        return;
+
+    // The bounds may have changed, so spatial objects using the mesh may touch different cells
+    Spatial.UpdateObjectsUsing(mesh);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::AddVertex(const DGL_Vec2& position, const DGL_Color& color, const DGL_Vec2& texCoord)
+{
+    if (!mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_AddVertex or DGL_Graphics_AddTriangle without calling DGL_Graphics_StartMesh.");
+        return;
+    }
+
+    // Add the vertex to the list for the current mesh
+    mMeshBuilder.mVertexList.push_back({ position, color, texCoord });
+}
+
+//*************************************************************************************************
+void GraphicsSystem::AddVertices(const DGL_Vec2* positions, unsigned positionStride,
+    const DGL_Color* colors, unsigned colorStride, const DGL_Vec2* texCoords, 
+    unsigned texCoordStride, unsigned count)
+{
+    if (!mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_AddVertices without calling DGL_Graphics_StartMesh.");
+        return;
+    }
+
+    if (!positions)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_AddVertices.");
+        return;
+    }
+
+    MeshBuilder::AddVertices(mMeshBuilder, positions, positionStride, colors, colorStride,
+        texCoords, texCoordStride, count);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::AddQuads(const DGL_Vec2* positions, const DGL_Color* colors,
+    const DGL_Vec2* texCoords, unsigned quadCount)
+{
+    if (!mCreatingMesh)
+    {
+        gError->SetError("Called DGL_Graphics_AddQuads without calling DGL_Graphics_StartMesh.");
+        return;
+    }
+
+    if (!positions)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_AddQuads.");
+        return;
+    }
+
+    MeshBuilder::AddQuads(mMeshBuilder, positions, colors, texCoords, quadCount);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::ReleaseMesh(DGL_Mesh* mesh)
+{
+    // Make sure the pointer is valid
+    if (!mesh)
+        return;
+
+    // The recorded commands might be using this mesh
+    FlushBatch();
+
+    // Spatial objects can't be drawn without their mesh
+    Spatial.RemoveObjectsUsing(mesh);
+
+    // Reduce the mesh counters
+    CountMeshMemory(mesh, false);
+    --mMeshes;
+
+    // Delete the mesh
+    Meshes.ReleaseMesh(mesh);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetMeshRetention(DGL_MeshRetention retention)
+{
+    if ((unsigned)retention > DGL_MR_ALL)
+    {
+        gError->SetError("Passed in an invalid DGL_MeshRetention value to DGL_Graphics_SetMeshRetention.");
+        return;
+    }
+
+    Meshes.mRetention = retention;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::TrimMeshData(DGL_Mesh* mesh, DGL_MeshRetention retention)
+{
+    if (!mesh)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_TrimMeshData.");
+        return;
+    }
+
+    if ((unsigned)retention > DGL_MR_ALL)
+    {
+        gError->SetError("Passed in an invalid DGL_MeshRetention value to DGL_Graphics_TrimMeshData.");
+        return;
+    }
+
+    // Updating part of a dynamic mesh needs the rest of its vertices
+    if (mesh->mDynamicCapacity)
+    {
+        gError->SetError("Called DGL_Graphics_TrimMeshData with a dynamic mesh, which must keep its data.");
+        return;
+    }
+
+    // Recorded commands and the current batch might still need the vertices
+    FlushBatch();
+
+    // Update the memory counters for the data that was deleted
+    CountMeshMemory(mesh, false);
+    MeshManager::TrimMesh(mesh, retention);
+    CountMeshMemory(mesh, true);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::DrawMesh(const DGL_Mesh* mesh, DGL_DrawMode mode)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_DrawMesh when Graphics is not initialized.");
+        return;
+    }
+
+    CreateTransformMatrix();
+
+    // Skip the mesh if it can't be seen
+    if (mCulling && !IsVisible(mesh))
+    {
+        ++mMeshesCulled;
+        return;
+    }
+    ++mMeshesSubmitted;
+
+    // The texture is only used if the pixel shader mode is not color
+    const DGL_Texture* texture = D3D.GetPixelShaderMode() != DGL_PSM_COLOR ? mCurrentTexture : nullptr;
+    texture = UseTextureRect(texture);
+
+    // If sorting, save the draw with a copy of the current state to be drawn later
+    if (mDrawSorting)
+    {
+        DrawState state;
+        state.mTexture = texture;
+        state.mVertexShader = D3D.GetCurrentVertexShader();
+        state.mPixelShader = D3D.GetCurrentPixelShader();
+        state.mVertexShaderMode = D3D.GetVertexShaderMode();
+        state.mBlendMode = D3D.GetBlendMode();
+        state.mSampleMode = D3D.GetSampleMode();
+        state.mAddressMode = D3D.GetAddressMode();
+        state.mConstantBuffer = D3D.mConstantBuffer;
+
+        mCommands.Record(mesh, mode, state);
+        return;
+    }
+
+    SubmitMesh(mesh, mode, texture, D3D.GetCurrentVertexShader(), D3D.GetCurrentPixelShader(),
+        D3D.GetVertexShaderMode(), D3D.mConstantBuffer);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::DrawMeshInstanced(const DGL_Mesh* mesh, DGL_DrawMode mode, 
+    const DGL_InstanceData* instances, unsigned count)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_DrawMeshInstanced when Graphics is not initialized.");
+        return;
+    }
+
+    if (!mesh || !instances)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_DrawMeshInstanced.");
+        return;
+    }
+
+    if (count == 0)
+        return;
+
+    // Anything recorded or batched needs to be drawn before these instances
+    FlushBatch();
+
+    // The mesh and texture might still be waiting to be uploaded
+    mUploads.Flush();
+
+    // Copy the instance data to the instance buffer
+    if (!mInstanceBuffer.Upload(instances, count))
+        return;
+
+    // The texture is only used if the pixel shader mode is not color
+    const DGL_Texture* texture = D3D.GetPixelShaderMode() != DGL_PSM_COLOR ? mCurrentTexture : nullptr;
+    texture = UseTextureRect(texture);
+
+    // Draw all instances with the instanced vertex shader
+    MeshManager::DrawInstanced(mesh, mode, texture, D3D.mInstanceVertexShader,
+        D3D.GetCurrentPixelShader(), D3D.mConstantBuffer, mInstanceBuffer.GetBuffer(), count,
+        &D3D.mStateCache);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::DrawVisible()
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_DrawVisible when Graphics is not initialized.");
+        return;
+    }
+
+    // Find the objects which overlap the area the camera can see
+    DGL_Vec2 areaMin;
+    DGL_Vec2 areaMax;
+    Camera.GetVisibleArea(areaMin, areaMax);
+    mVisibleObjects.clear();
+    Spatial.Query(areaMin, areaMax, mVisibleObjects);
+
+    // Save the current settings so they can be put back afterward
+    const DGL_Texture* texture = mCurrentTexture;
+    DGL_Vec2 position = mDrawPosition;
+    DGL_Vec2 scale = mDrawScale;
+    float rotation = mDrawRotation;
+    float zValue = mDrawZValue;
+    bool userMatrix = mUserMatrix;
+    DGL_Mat4 transformMatrix = D3D.mConstantBuffer.mTransformMatrix;
+
+    // Draw each object with its own texture and transform
+    for (unsigned id : mVisibleObjects)
+    {
+        const DGL_SpatialObject* object = Spatial.GetObject(id);
+
+        mCurrentTexture = object->mTexture;
+        SetTransformData(object->mPosition, object->mScale, object->mRotation);
+        mDrawZValue = object->mZValue;
+
+        DrawMesh(object->mMesh, object->mDrawMode);
+    }
+
+    // Put the settings back
+    mCurrentTexture = texture;
+    mDrawPosition = position;
+    mDrawScale = scale;
+    mDrawRotation = rotation;
+    mDrawZValue = zValue;
+    mCreateMatrix = true;
+    if (userMatrix)
+        SetTransformMatrix(transformMatrix);
+}
+
+//*************************************************************************************************
+DGL_StaticBatch* GraphicsSystem::BakeStaticBatch(const DGL_Mesh* const* meshes,
+    const DGL_Texture* const* textures, const DGL_InstanceData* instances, unsigned count)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_BakeStaticBatch when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    if (!meshes || !instances || count == 0)
+    {
+        gError->SetError("Passed in a null parameter or a count of 0 to DGL_Graphics_BakeStaticBatch.");
+        return nullptr;
+    }
+
+    // Group the objects by texture, keeping the order each texture was first used
+    std::vector<const DGL_Texture*> groupTextures;
+    std::vector<std::vector<unsigned>> groups;
+    std::unordered_map<const DGL_Texture*, unsigned> groupIndices;
+    unsigned long long totalVertices = 0;
+    unsigned long long totalIndices = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const DGL_Mesh* mesh = meshes[i];
+        if (!mesh)
+        {
+            gError->SetError("Passed in a null parameter or a count of 0 to DGL_Graphics_BakeStaticBatch.");
+            return nullptr;
+        }
+
+        // The vertices are moved on the CPU, so the mesh must have kept them
+        if (!mesh->mVertexList)
+        {
+            gError->SetError("Couldn't bake static batch, a mesh didn't keep all of its data.");
+            return nullptr;
+        }
+
+        // Meshes are joined as triangle lists, so each one must end on a complete triangle
+        unsigned indexCount = mesh->mIndexCount ? mesh->mIndexCount : mesh->mVertexCount;
+        if (indexCount % 3 != 0)
+        {
+            gError->SetError("Couldn't bake static batch, a mesh is not made of complete triangles.");
+            return nullptr;
+        }
+
+        totalVertices += mesh->mVertexCount;
+        totalIndices += indexCount;
+
+        // Textures in an atlas are baked into the vertices, so their whole page is one group
+        const DGL_Texture* texture = textures ? textures[i] : nullptr;
+        if (texture && texture->page)
+            texture = texture->page;
+        auto group = groupIndices.try_emplace(texture, (unsigned)groups.size());
+        if (group.second)
+        {
+            groups.emplace_back();
+            groupTextures.push_back(texture);
+        }
+        groups[group.first->second].push_back(i);
+    }
+
+    if (totalVertices > 0xFFFFFFFF || totalIndices > 0xFFFFFFFF)
+    {
+        gError->SetError("Couldn't bake static batch, there are too many vertices.");
+        return nullptr;
+    }
+
+    // The builder keeps its memory between groups
+    DGL_MeshBuilder builder;
+
+    DGL_StaticBatch* batch = new DGL_StaticBatch;
+    bool created = true;
+    for (unsigned group = 0; group < groups.size() && created; ++group)
+    {
+        StaticBatchBuilder::Build(meshes, textures, instances, groups[group],
+            builder.mVertexList, builder.mIndices, 0);
+
+        DGL_Mesh* mesh = CreateMesh(&builder);
+        if (mesh)
+            batch->mParts.push_back({ mesh, groupTextures[group] });
+
+        created = mesh != nullptr;
+    }
+
+    // The mesh manager has set the error message, so just release the parts that were created
+    if (!created)
+    {
+        ReleaseStaticBatch(batch);
+        return nullptr;
+    }
+
+    return batch;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::DrawStaticBatch(const DGL_StaticBatch* batch)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_DrawStaticBatch when Graphics is not initialized.");
+        return;
+    }
+
+    if (!batch)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_DrawStaticBatch.");
+        return;
+    }
+
+    // Draw each part with its own texture, then put the current texture back
+    const DGL_Texture* texture = mCurrentTexture;
+    for (const DGL_StaticBatch::Part& part : batch->mParts)
+    {
+        mCurrentTexture = part.mTexture;
+        DrawMesh(part.mMesh, DGL_DM_TRIANGLELIST);
+    }
+    mCurrentTexture = texture;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::ReleaseStaticBatch(DGL_StaticBatch* batch)
+{
+    if (!batch)
+        return;
+
+    for (DGL_StaticBatch::Part& part : batch->mParts)
+        ReleaseMesh(part.mMesh);
+
+    delete batch;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetBatching(bool enabled)
+{
+    // Draw anything still in the batch before turning it off
+    if (!enabled)
+        mBatcher.Flush();
+
+    mBatching = enabled;
+
+    // Batching needs the vertices of any mesh small enough to be batched
+    Meshes.mKeepAllMaxVertices = enabled ? SpriteBatcher::max_mesh_vertices : 0;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetDrawSorting(bool enabled)
+{
+    // Draw anything already recorded before turning it off
+    if (!enabled)
+        FlushBatch();
+
+    mDrawSorting = enabled;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetCulling(bool enabled)
+{
+    mCulling = enabled;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetUploadBatching(bool enabled)
+{
+    if (!mInitialized)
+    {
+        gError->SetError("Called DGL_Graphics_SetUploadBatching when Graphics is not initialized.");
+        return;
+    }
+
+    mUploads.SetBatching(enabled);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::FlushUploads()
+{
+    mUploads.Flush();
+}
+
+//*************************************************************************************************
+void GraphicsSystem::GetUploadStats(DGL_UploadStats* stats) const
+{
+    if (!stats)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetUploadStats.");
+        return;
+    }
+
+    mUploads.GetStats(stats);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::FlushBatch()
+{
+    if (mCommands.GetCommandCount())
+    {
+        // Save the current settings, since replaying will change them
+        DGL_BlendMode blendMode = D3D.GetBlendMode();
+        DGL_TextureSampleMode sampleMode = D3D.GetSampleMode();
+        DGL_TextureAddressMode addressMode = D3D.GetAddressMode();
+
+        // Draw all recorded commands in sorted order
+        mCommands.Sort();
+        mCommands.Replay(*this);
+        mCommands.Clear();
+
+        // Put back the settings for anything drawn after this
+        SetBlendMode(blendMode);
+        SetSamplerState(sampleMode, addressMode);
+    }
+
+    mBatcher.Flush();
+}
+
+//*************************************************************************************************
+void GraphicsSystem::GetDrawStats(DGL_DrawStats* stats) const
+{
+    if (!stats)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetDrawStats.");
+        return;
+    }
+
+    stats->mDrawCalls = D3D.mStateCache.GetDrawCalls();
+    stats->mStateChanges = D3D.mStateCache.GetCallsIssued();
+    stats->mStateChangesSkipped = D3D.mStateCache.GetCallsSkipped();
+    stats->mBatches = mBatcher.GetBatchCount();
+    stats->mBatchedMeshes = mBatcher.GetMeshCount();
+    stats->mConstantBufferUploads = D3D.GetConstantBufferUploads();
+    stats->mConstantBufferBytes = D3D.GetConstantBufferBytes();
+    stats->mMeshesSubmitted = mMeshesSubmitted;
+    stats->mMeshesCulled = mMeshesCulled;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::ResetDrawStats()
+{
+    D3D.mStateCache.ResetCounters();
+    D3D.ResetUploadCounters();
+    mBatcher.ResetCounters();
+    mMeshesSubmitted = 0;
+    mMeshesCulled = 0;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::GetMeshMemory(DGL_MeshMemory* memory) const
+{
+    if (!memory)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetMeshMemory.");
+        return;
+    }
+
+    memory->mMeshes = (unsigned)mMeshes;
+    memory->mVertexBytes = mVertexBytes;
+    memory->mDefaultFormatVertexBytes = mDefaultFormatVertexBytes;
+    memory->mIndexBytes = mIndexBytes;
+    memory->mCPUBytes = mCPUBytes + sizeof(VertexData) * mMeshBuilder.mVertexList.capacity() +
+        sizeof(unsigned) * mMeshBuilder.mIndices.capacity();
+    memory->mPeakCPUBytes = mPeakCPUBytes > memory->mCPUBytes ? mPeakCPUBytes : memory->mCPUBytes;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::GetMeshBufferStats(DGL_MeshBufferStats* stats) const
+{
+    if (!stats)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetMeshBufferStats.");
+        return;
+    }
+
+    Meshes.GetBufferStats(stats);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetTransformData(const DGL_Vec2& position, const DGL_Vec2& scale, float rotation)
+{
+    mDrawPosition = position;
+    mDrawScale = scale;
+    mDrawRotation = rotation;
+
+    mCreateMatrix = true;
+    mUserMatrix = false;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetZValue(float zValue)
+{
+    mDrawZValue = zValue;
+
+    mCreateMatrix = true;
+    mUserMatrix = false;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SetTransformMatrix(const DGL_Mat4& matrix)
+{
+    D3D.SetTransformMatrix(matrix);
+
+    // Keep this matrix until the transform data is set again
+    mUserMatrix = true;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::SubmitMesh(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+    ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+    DGL_VertexShaderMode vertexShaderMode, const cbPerObject& constantBuffer)
+{
+    // The mesh and texture might still be waiting to be uploaded
+    mUploads.Flush();
+
+    // Try to add the mesh to the current batch. Custom vertex shaders might not use the 
+    // transform the same way, so those meshes are always drawn separately.
+    if (mBatching && vertexShaderMode == DGL_VSM_DEFAULT)
+    {
+        if (mBatcher.Add(mesh, mode, texture, vertexShader, pixelShader, constantBuffer))
+            return;
+    }
+
+    // Anything in the current batch needs to be drawn before this mesh
+    mBatcher.Flush();
+
+    // Draw the mesh using the mesh manager
+    MeshManager::Draw(mesh, mode, texture, vertexShader, pixelShader, constantBuffer, 
+        &D3D.mStateCache);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::ExecuteCommand(const DrawCommand& command, const DrawState& state)
+{
+    // Only changes the D3D state if the settings are different from the previous command
+    SetBlendMode(state.mBlendMode);
+    SetSamplerState(state.mSampleMode, state.mAddressMode);
+
+    SubmitMesh(command.mMesh, command.mMode, state.mTexture, state.mVertexShader, 
+        state.mPixelShader, state.mVertexShaderMode, state.mConstantBuffer);
+}
+
+//*************************************************************************************************
+void GraphicsSystem::CreateTransformMatrix()
+{
+    // Keep the current matrix if nothing has changed or the user set their own matrix
+    if (!mCreateMatrix || mUserMatrix)
+        return;
+
+    // Sine and cosine are only recalculated when the rotation changes
+    mDrawRotationCache.SetAngle(mDrawRotation);
+
+    // Build translation * rotation * scale directly instead of multiplying full matrices
+    Affine2D transform = Affine_Compose(mDrawPosition, mDrawScale, mDrawRotationCache.GetSin(),
+        mDrawRotationCache.GetCos());
+
+    // Set the transform matrix on the constant buffer
+    D3D.SetTransformMatrix(Affine_ToMatrix(transform, mDrawZValue));
+
+    mCreateMatrix = false;
+}
+
+//*************************************************************************************************
+const DGL_Texture* GraphicsSystem::UseTextureRect(const DGL_Texture* texture)
+{
+    // Textures in an atlas are drawn from their page, using only their part of it. Everything
+    // else uses the whole texture, so draws with different textures from the same page have the
+    // same texture and can still be batched or sorted together.
+    if (texture && texture->status != DGL_TS_READY)
+    {
+        texture = mPlaceholderTexture;
+        if (!texture || texture->status != DGL_TS_READY)
+            texture = mDefaultPlaceholder;
+    }
+
+    if (texture && texture->page)
+    {
+        D3D.SetTexRect(texture->uvOffset, texture->uvScale);
+        return texture->page;
+    }
+
+    D3D.SetTexRect({ 0.0f, 0.0f }, { 1.0f, 1.0f });
+    return texture;
+}
+
+//*************************************************************************************************
+void GraphicsSystem::CountMeshMemory(const DGL_Mesh* mesh, bool created)
+{
+    // Dynamic meshes use the same amount of memory however many vertices they have
+    unsigned bufferVertices = MeshManager::GetBufferVertexCount(mesh);
+    unsigned long long bytes = (unsigned long long)mesh->mVertexStride * bufferVertices;
+    unsigned long long defaultBytes = (unsigned long long)sizeof(VertexData) * bufferVertices;
+    unsigned long long indexBytes = 
+        (unsigned long long)MeshManager::GetIndexSize(mesh->mIndexFormat) * mesh->mIndexCount;
+    unsigned long long cpuBytes = MeshManager::GetCPUBytes(mesh);
+
+    if (created)
+    {
+        mVertexBytes += bytes;
+        mDefaultFormatVertexBytes += defaultBytes;
+        mIndexBytes += indexBytes;
+        mCPUBytes += cpuBytes;
+
+        // The list used to build the mesh still holds its vertices at this point
+        unsigned long long totalCPUBytes = mCPUBytes +
+            sizeof(VertexData) * mMeshBuilder.mVertexList.capacity() +
+            sizeof(unsigned) * mMeshBuilder.mIndices.capacity();
+        if (totalCPUBytes > mPeakCPUBytes)
+            mPeakCPUBytes = totalCPUBytes;
+    }
+    else
+    {
+        mVertexBytes -= bytes;
+        mDefaultFormatVertexBytes -= defaultBytes;
+        mIndexBytes -= indexBytes;
+        mCPUBytes -= cpuBytes;
+    }
+}
+
+//*************************************************************************************************
+void GraphicsSystem::ReleaseCachedTextures()
+{
+    if (mReleasedTextures.empty())
+        return;
+
+    // The recorded commands or current batch might be using these textures
+    FlushBatch();
+
+    for (DGL_Texture* texture : mReleasedTextures)
+        TextureManager::ReleaseTexture(texture);
+    mReleasedTextures.clear();
+}
+
+//*************************************************************************************************
+bool GraphicsSystem::IsVisible(const DGL_Mesh* mesh) const
+{
+    // Custom vertex shaders might not use the transform the same way
+    if (!mesh || D3D.GetVertexShaderMode() != DGL_VSM_DEFAULT)
+        return true;
+
+    // The bounds can only be checked with a 2D transform
+    const DGL_Mat4& transform = D3D.mConstantBuffer.mTransformMatrix;
+    if (transform.m[3][0] != 0.0f || transform.m[3][1] != 0.0f || transform.m[3][3] != 1.0f)
+        return true;
+
+    return Camera.IsVisible(mesh->mBounds.mMin, mesh->mBounds.mMax, Affine_FromMatrix(transform));
+}
+
+} // namepspace DGL
+
+
+using namespace DGL;
+
+//*************************************************************************************************
+DGL_Vec2 DGL_Camera_ScreenCoordToWorld(const DGL_Vec2* position)
+{
+    if (position)
+        return gGraphics->Camera.ScreenToWorld(*position);
+    else
+        return DGL_Vec2{ 0,0 };
+}
+
+//*************************************************************************************************
+DGL_Vec2 DGL_Camera_GetPosition(void)
+{
+    return gGraphics->Camera.GetCameraPosition();
+}
+
+//*************************************************************************************************
+void DGL_Camera_SetPosition(const DGL_Vec2* position)
+{
+    if (position)
+        gGraphics->Camera.SetCameraPosition(*position);
+}
+
+//*************************************************************************************************
+float DGL_Camera_GetZoom(void)
+{
+    return gGraphics->Camera.GetCameraZoom();
+}
+
+//*************************************************************************************************
+void DGL_Camera_SetZoom(float zoom)
+{
+    gGraphics->Camera.SetCameraZoom(zoom);
+}
+
+//*************************************************************************************************
+float DGL_Camera_GetRotation(void)
+{
+    return gGraphics->Camera.GetCameraRotation();
+}
+
+//*************************************************************************************************
+void DGL_Camera_SetRotation(float radians)
+{
+    gGraphics->Camera.SetCameraRotation(radians);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_StartDrawing(void)
+{
+    gGraphics->FinishTextureLoads();
+    gGraphics->FlushUploads();
+    gGraphics->ResetDrawStats();
+    gGraphics->D3D.StartUpdate();
+}
+
+//*************************************************************************************************
+void DGL_Graphics_FinishDrawing(void)
+{
+    gGraphics->FlushBatch();
+    gGraphics->D3D.EndUpdate();
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetBackgroundColor(const DGL_Color* color)
+{
+    if (color)
+    {
+        gGraphics->D3D.mBackgroundColor[0] = color->r;
+        gGraphics->D3D.mBackgroundColor[1] = color->g;
+        gGraphics->D3D.mBackgroundColor[2] = color->b;
+    }
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetTextureSamplerData(DGL_TextureSampleMode sampleMode, DGL_TextureAddressMode addressMode)
+{
+    gGraphics->SetSamplerState(sampleMode, addressMode);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetBlendMode(DGL_BlendMode mode)
+{
+    gGraphics->SetBlendMode(mode);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetBatching(BOOL enabled)
+{
+    gGraphics->SetBatching(enabled != FALSE);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetDynamicConstants(BOOL enabled)
+{
+    gGraphics->D3D.SetDynamicConstants(enabled != FALSE);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetDrawSorting(BOOL enabled)
+{
+    gGraphics->SetDrawSorting(enabled != FALSE);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetCulling(BOOL enabled)
+{
+    gGraphics->SetCulling(enabled != FALSE);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetUploadBatching(BOOL enabled)
+{
+    gGraphics->SetUploadBatching(enabled != FALSE);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_FlushUploads(void)
+{
+    gGraphics->FlushUploads();
+}
+
+//*************************************************************************************************
+void DGL_Graphics_GetUploadStats(DGL_UploadStats* stats)
+{
+    gGraphics->GetUploadStats(stats);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetShaderMode(DGL_PixelShaderMode pixelMode, DGL_VertexShaderMode vertexMode)
+{
+    gGraphics->D3D.SetPixelShaderMode(pixelMode);
+    gGraphics->D3D.SetVertexShaderMode(vertexMode);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetCustomPixelShader(const DGL_PixelShader* shader)
+{
+    gGraphics->D3D.SetCustomPixelShader(shader);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetCustomVertexShader(const DGL_VertexShader* shader)
+{
+    gGraphics->D3D.SetCustomVertexShader(shader);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetTexture(const DGL_Texture* texture)
+{
+    gGraphics->SetCurrentTexture(texture);
+}
+
+//*************************************************************************************************
+const DGL_PixelShader* DGL_Graphics_LoadPixelShader(const char* filename)
+{
+    return gGraphics->LoadPixelShader(filename);
+}
 
 //*************************************************************************************************
 const DGL_VertexShader* DGL_Graphics_LoadVertexShader(const char* filename)
@@ -601,6 +1789,81 @@ DGL_Texture* DGL_Graphics_LoadTextureFromMemory(const unsigned char* data, int w
     return gGraphics->LoadTextureFromMemory(data, width, height);
 }
 
+//*************************************************************************************************
+DGL_Texture* DGL_Graphics_LoadTextureAsync(const char* fileName, int priority,
+    DGL_TextureLoadCallback callback, void* userData)
+{
+    return gGraphics->LoadTextureAsync(fileName, priority, callback, userData);
+}
+
+//*************************************************************************************************
+DGL_TextureStatus DGL_Graphics_GetTextureStatus(const DGL_Texture* texture)
+{
+    return gGraphics->GetTextureStatus(texture);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetPlaceholderTexture(const DGL_Texture* texture)
+{
+    gGraphics->SetPlaceholderTexture(texture);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_GetTextureLoadStats(DGL_TextureLoadStats* stats)
+{
+    gGraphics->GetTextureLoadStats(stats);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetMipmapMode(DGL_MipmapMode mode)
+{
+    gGraphics->SetMipmapMode(mode);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetMipmapCache(const char* directory)
+{
+    gGraphics->SetMipmapCache(directory);
+}
+
+//*************************************************************************************************
+unsigned DGL_Graphics_GetTextureLevels(const DGL_Texture* texture, DGL_TextureLevel* levels,
+    unsigned maxLevels)
+{
+    return gGraphics->GetTextureLevels(texture, levels, maxLevels);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetTextureCompression(DGL_TextureCompression compression)
+{
+    gGraphics->SetTextureCompression(compression);
+}
+
+//*************************************************************************************************
+BOOL DGL_Graphics_ConvertTextureToDDS(const char* sourceFile, const char* ddsFile,
+    DGL_TextureCompression compression, DGL_MipmapMode mipmapMode, DGL_CompressionStats* stats)
+{
+    return gGraphics->ConvertTextureToDDS(sourceFile, ddsFile, compression, mipmapMode, stats);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetTextureCache(BOOL enabled, unsigned long long retainedBytes)
+{
+    gGraphics->SetTextureCache(enabled != FALSE, retainedBytes);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_ClearTextureCache(void)
+{
+    gGraphics->ClearTextureCache();
+}
+
+//*************************************************************************************************
+void DGL_Graphics_GetTextureCacheStats(DGL_TextureCacheStats* stats)
+{
+    gGraphics->GetTextureCacheStats(stats);
+}
+
 //*************************************************************************************************
 void DGL_Graphics_FreeTexture(DGL_Texture** texture)
 {
@@ -620,10 +1883,51 @@ DGL_Vec2 DGL_Graphics_GetTextureSize(DGL_Texture* texture)
     return texture->textureSize;
 }
 
+//*************************************************************************************************
+DGL_Atlas* DGL_Graphics_CreateAtlas(int pageWidth, int pageHeight)
+{
+    return gGraphics->CreateAtlas(pageWidth, pageHeight);
+}
+
+//*************************************************************************************************
+DGL_Texture* DGL_Graphics_AddAtlasTexture(DGL_Atlas* atlas, const char* fileName)
+{
+    return gGraphics->AddAtlasTexture(atlas, fileName);
+}
+
+//*************************************************************************************************
+DGL_Texture* DGL_Graphics_AddAtlasTextureFromMemory(DGL_Atlas* atlas, const unsigned char* data,
+    int width, int height)
+{
+    return gGraphics->AddAtlasTextureFromMemory(atlas, data, width, height);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_GetAtlasStats(const DGL_Atlas* atlas, DGL_AtlasStats* stats)
+{
+    gGraphics->GetAtlasStats(atlas, stats);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_FreeAtlas(DGL_Atlas** atlas)
+{
+    if (!atlas)
+        return;
+
+    gGraphics->ReleaseAtlas(*atlas);
+    *atlas = nullptr;
+}
+
 //*************************************************************************************************
 void DGL_Graphics_StartMesh(void)
 {
-    gGraphics->StartMesh();
+    gGraphics->StartMesh(DGL_VF_DEFAULT);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_StartMeshEx(DGL_VertexFormat format)
+{
+    gGraphics->StartMesh(format);
 }
 
 //*************************************************************************************************
@@ -638,6 +1942,37 @@ DGL_Mesh* DGL_Graphics_EndMeshIndexed(unsigned* indices, unsigned indexCount)
     return gGraphics->EndMeshIndexed(indices, indexCount);
 }
 
+//*************************************************************************************************
+DGL_Mesh* DGL_Graphics_EndMeshIndexed16(const unsigned short* indices, unsigned indexCount)
+{
+    return gGraphics->EndMeshIndexed16(indices, indexCount);
+}
+
+//*************************************************************************************************
+DGL_Mesh* DGL_Graphics_EndMeshOptimized(DGL_MeshOptimizeStats* stats)
+{
+    return gGraphics->EndMeshOptimized(stats);
+}
+
+//*************************************************************************************************
+DGL_Mesh* DGL_Graphics_CreateMesh(const DGL_MeshBuilder* builder)
+{
+    return gGraphics->CreateMesh(builder);
+}
+
+//*************************************************************************************************
+DGL_Mesh* DGL_Graphics_CreateDynamicMesh(unsigned capacity)
+{
+    return gGraphics->CreateDynamicMesh(capacity);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_UpdateMesh(DGL_Mesh* mesh, const DGL_Vec2* positions, const DGL_Color* colors,
+    const DGL_Vec2* textureCoords, unsigned count, unsigned offset)
+{
+    gGraphics->UpdateMesh(mesh, positions, colors, textureCoords, count, offset);
+}
+
 //*************************************************************************************************
 void DGL_Graphics_AddVertex(const DGL_Vec2* position, const DGL_Color* color, const DGL_Vec2* textureOffset)
 {
@@ -656,6 +1991,52 @@ void DGL_Graphics_AddTriangle(
     DGL_Graphics_AddVertex(position3, color3, textureOffset3);
 }
 
+//*************************************************************************************************
+void DGL_Graphics_AddVertices(const DGL_Vec2* positions, const DGL_Color* colors, 
+    const DGL_Vec2* textureCoords, unsigned count)
+{
+    gGraphics->AddVertices(positions, 0, colors, 0, textureCoords, 0, count);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_AddVerticesStrided(const DGL_Vec2* positions, unsigned positionStride,
+    const DGL_Color* colors, unsigned colorStride, const DGL_Vec2* textureCoords, 
+    unsigned textureCoordStride, unsigned count)
+{
+    gGraphics->AddVertices(positions, positionStride, colors, colorStride, textureCoords,
+        textureCoordStride, count);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_AddQuads(const DGL_Vec2* positions, const DGL_Color* colors, 
+    const DGL_Vec2* textureCoords, unsigned quadCount)
+{
+    gGraphics->AddQuads(positions, colors, textureCoords, quadCount);
+}
+
+//*************************************************************************************************
+DGL_StaticBatch* DGL_Graphics_BakeStaticBatch(const DGL_Mesh* const* meshes,
+    const DGL_Texture* const* textures, const DGL_InstanceData* instances, unsigned count)
+{
+    return gGraphics->BakeStaticBatch(meshes, textures, instances, count);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_DrawStaticBatch(const DGL_StaticBatch* batch)
+{
+    gGraphics->DrawStaticBatch(batch);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_FreeStaticBatch(DGL_StaticBatch** batch)
+{
+    if (!batch)
+        return;
+
+    gGraphics->ReleaseStaticBatch(*batch);
+    *batch = nullptr;
+}
+
 //*************************************************************************************************
 void DGL_Graphics_FreeMesh(DGL_Mesh** mesh)
 {
@@ -666,12 +2047,91 @@ void DGL_Graphics_FreeMesh(DGL_Mesh** mesh)
     *mesh = nullptr;
 }
 
+//*************************************************************************************************
+void DGL_Graphics_GetMeshBounds(const DGL_Mesh* mesh, DGL_MeshBounds* bounds)
+{
+    if (!mesh || !bounds)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetMeshBounds.");
+        return;
+    }
+
+    *bounds = mesh->mBounds;
+}
+
+//*************************************************************************************************
+void DGL_Graphics_GetMeshMemory(DGL_MeshMemory* memory)
+{
+    gGraphics->GetMeshMemory(memory);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_GetMeshBufferStats(DGL_MeshBufferStats* stats)
+{
+    gGraphics->GetMeshBufferStats(stats);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_SetMeshRetention(DGL_MeshRetention retention)
+{
+    gGraphics->SetMeshRetention(retention);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_TrimMeshData(DGL_Mesh* mesh, DGL_MeshRetention retention)
+{
+    gGraphics->TrimMeshData(mesh, retention);
+}
+
+//*************************************************************************************************
+unsigned DGL_Graphics_GetMeshPositions(const DGL_Mesh* mesh, DGL_Vec2* positions, unsigned maxCount)
+{
+    if (!mesh)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetMeshPositions.");
+        return 0;
+    }
+
+    return MeshManager::GetPositions(mesh, positions, maxCount);
+}
+
+//*************************************************************************************************
+unsigned DGL_Graphics_GetMeshIndices(const DGL_Mesh* mesh, unsigned* indices, unsigned maxCount)
+{
+    if (!mesh)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Graphics_GetMeshIndices.");
+        return 0;
+    }
+
+    return MeshManager::GetIndices(mesh, indices, maxCount);
+}
+
 //*************************************************************************************************
 void DGL_Graphics_DrawMesh(const DGL_Mesh* mesh, DGL_DrawMode mode)
 {
     gGraphics->DrawMesh(mesh, mode);
 }
 
+//*************************************************************************************************
+void DGL_Graphics_DrawMeshInstanced(const DGL_Mesh* mesh, DGL_DrawMode mode,
+    const DGL_InstanceData* instances, unsigned count)
+{
+    gGraphics->DrawMeshInstanced(mesh, mode, instances, count);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_GetDrawStats(DGL_DrawStats* stats)
+{
+    gGraphics->GetDrawStats(stats);
+}
+
+//*************************************************************************************************
+void DGL_Graphics_DrawVisible(void)
+{
+    gGraphics->DrawVisible();
+}
+
 //*************************************************************************************************
 void DGL_Graphics_SetCB_TransformData(const DGL_Vec2* position, const DGL_Vec2* scale,
     float rotationRadians)
@@ -697,7 +2157,7 @@ void DGL_Graphics_SetCB_TransformMatrix(const DGL_Mat4* transformationMatrix)
     if (!transformationMatrix)
         return;
 
-    gGraphics->D3D.mConstantBuffer.mTransformMatrix = *transformationMatrix;
+    gGraphics->SetTransformMatrix(*transformationMatrix);
 }
 
 //*************************************************************************************************
@@ -709,13 +2169,13 @@ void DGL_Graphics_SetCB_TextureOffset(const DGL_Vec2* textureOffset)
         return;
     }
 
-    gGraphics->D3D.mConstantBuffer.mTexOffset = *textureOffset;
+    gGraphics->D3D.SetTexOffset(*textureOffset);
 }
 
 //*************************************************************************************************
 void DGL_Graphics_SetCB_Alpha(float alpha)
 {
-    gGraphics->D3D.mConstantBuffer.mAlpha = alpha;
+    gGraphics->D3D.SetAlpha(alpha);
 }
 
 //*************************************************************************************************
@@ -727,11 +2187,83 @@ void DGL_Graphics_SetCB_TintColor(const DGL_Color* color)
         return;
     }
 
-    gGraphics->D3D.mConstantBuffer.mTintColor = *color;
+    gGraphics->D3D.SetTintColor(*color);
 }
 
 //*************************************************************************************************
 void DGL_Graphics_SetCB_ShaderData(float data)
 {
-    gGraphics->D3D.mConstantBuffer.mShaderData = data;
+    gGraphics->D3D.SetShaderData(data);
+}
+
+//*************************************************************************************************
+unsigned DGL_Spatial_AddObject(const DGL_SpatialObject* object)
+{
+    if (!object || !object->mMesh)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Spatial_AddObject.");
+        return 0;
+    }
+
+    return gGraphics->Spatial.Add(*object);
+}
+
+//*************************************************************************************************
+void DGL_Spatial_UpdateObject(unsigned id, const DGL_SpatialObject* object)
+{
+    if (!object || !object->mMesh)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Spatial_UpdateObject.");
+        return;
+    }
+
+    if (!gGraphics->Spatial.Update(id, *object))
+        gError->SetError("Passed an invalid ID to DGL_Spatial_UpdateObject.");
+}
+
+//*************************************************************************************************
+void DGL_Spatial_RemoveObject(unsigned id)
+{
+    if (!gGraphics->Spatial.Remove(id))
+        gError->SetError("Passed an invalid ID to DGL_Spatial_RemoveObject.");
+}
+
+//*************************************************************************************************
+void DGL_Spatial_Clear(void)
+{
+    gGraphics->Spatial.Clear();
+}
+
+//*************************************************************************************************
+unsigned DGL_Spatial_QueryArea(const DGL_Vec2* areaMin, const DGL_Vec2* areaMax, 
+    unsigned* results, unsigned maxResults)
+{
+    if (!areaMin || !areaMax || (!results && maxResults))
+    {
+        gError->SetError("Passed in a null parameter to DGL_Spatial_QueryArea.");
+        return 0;
+    }
+
+    // Kept between calls to avoid allocating every query
+    static std::vector<unsigned> found;
+    found.clear();
+    gGraphics->Spatial.Query(*areaMin, *areaMax, found);
+
+    unsigned count = (unsigned)found.size();
+    if (results)
+        memcpy(results, found.data(), sizeof(unsigned) * (count < maxResults ? count : maxResults));
+
+    return count;
+}
+
+//*************************************************************************************************
+void DGL_Spatial_SetCellSize(float size)
+{
+    if (size <= 0.0f)
+    {
+        gError->SetError("Passed in a cell size less than or equal to zero to DGL_Spatial_SetCellSize.");
+        return;
+    }
+
+    gGraphics->Spatial.SetCellSize(size);
 }
@@ -9,21 +9,33 @@
 module;
 
 #include "DGL.h"
+#include <d3d11.h>
 #include <vector>
 
 export module GraphicsSystem;
 
+import Batch;
 import Camera;
 import D3DInterface;
+import DrawCommands;
+import Instancing;
+import Math;
 import Mesh;
+import MeshBuilder;
 import Shader;
+import Spatial;
+import StaticBatch;
+import Texture;
+import TextureCache;
+import TextureLoader;
+import UploadQueue;
 
 namespace DGL
 {
 
 //---------------------------------------------------------------------------------- GraphicsSystem
 
-export class GraphicsSystem
+export class GraphicsSystem : private CommandBackend
 {
 public:
     // Sets the global pointer
@@ -55,14 +67,79 @@ public:
     // Loads a texture from the provided pixel data
     DGL_Texture* LoadTextureFromMemory(const unsigned char* data, int width, int height);
 
+    // Returns a texture which will be loaded from the provided file on background threads
+    DGL_Texture* LoadTextureAsync(const char* fileName, int priority,
+        DGL_TextureLoadCallback callback, void* userData);
+
+    // Creates the textures which have finished loading on background threads
+    void FinishTextureLoads();
+
+    // Returns whether the texture is loading, ready, or failed to load
+    DGL_TextureStatus GetTextureStatus(const DGL_Texture* texture);
+
+    // Sets the texture drawn in place of textures which aren't ready, or the default if null
+    void SetPlaceholderTexture(const DGL_Texture* texture);
+
+    // Fills in the counters for textures loaded on background threads
+    void GetTextureLoadStats(DGL_TextureLoadStats* stats) const;
+
+    // Sets how the smaller levels of new textures are made
+    void SetMipmapMode(DGL_MipmapMode mode);
+
+    // Sets the folder where levels built on the CPU are saved, or stops saving them if null
+    void SetMipmapCache(const char* directory);
+
+    // Fills in the size and memory of each level of the texture, returning the number of levels
+    unsigned GetTextureLevels(const DGL_Texture* texture, DGL_TextureLevel* levels,
+        unsigned maxLevels) const;
+
+    // Sets how new textures are compressed
+    void SetTextureCompression(DGL_TextureCompression compression);
+
+    // Builds and compresses the levels of the source file and saves them to the DDS file
+    BOOL ConvertTextureToDDS(const char* sourceFile, const char* ddsFile,
+        DGL_TextureCompression compression, DGL_MipmapMode mipmapMode,
+        DGL_CompressionStats* stats);
+
     // Releases the texture and deletes the struct
     void ReleaseTexture(DGL_Texture* texture);
 
+    // Turns the texture cache on or off and sets how many bytes of freed textures it keeps
+    void SetTextureCache(bool enabled, unsigned long long retainedBytes);
+
+    // Releases the freed textures kept by the texture cache
+    void ClearTextureCache();
+
+    // Fills in the provided struct with the texture cache counters
+    void GetTextureCacheStats(DGL_TextureCacheStats* stats) const;
+
     // Sets the texture to use when drawing a mesh
     void SetCurrentTexture(const DGL_Texture* texture);
 
-    // Starts creating a new mesh by clearing the list of vertices
-    void StartMesh();
+    // Creates an atlas whose pages have the provided size
+    DGL_Atlas* CreateAtlas(int pageWidth, int pageHeight);
+
+    // Loads a texture from the provided file into one of the atlas pages
+    DGL_Texture* AddAtlasTexture(DGL_Atlas* atlas, const char* fileName);
+
+    // Copies a texture from the provided pixel data into one of the atlas pages
+    DGL_Texture* AddAtlasTextureFromMemory(DGL_Atlas* atlas, const unsigned char* data, int width,
+        int height);
+
+    // Fills in the page and packing counters for the atlas
+    void GetAtlasStats(const DGL_Atlas* atlas, DGL_AtlasStats* stats) const;
+
+    // Releases the atlas pages and deletes the atlas and its textures
+    void ReleaseAtlas(DGL_Atlas* atlas);
+
+    // Sets the blend mode, drawing the current batch first if the mode is changing
+    void SetBlendMode(DGL_BlendMode mode);
+
+    // Sets the sampler state, drawing the current batch first if the state is changing
+    void SetSamplerState(DGL_TextureSampleMode sampleMode, DGL_TextureAddressMode addressMode);
+
+    // Starts creating a new mesh with the vertex format by clearing the list of vertices
+    void StartMesh(DGL_VertexFormat format);
 
     // Creates a mesh from the existing list of vertices
     DGL_Mesh* EndMesh();
@@ -70,47 +147,209 @@ public:
     // Creates an indexed mesh from the existing list of vertices, with the provided indices
     DGL_Mesh* EndMeshIndexed(unsigned* indices, unsigned indexCount);
 
+    // Creates an indexed mesh from the existing list of vertices, with the provided 16-bit indices
+    DGL_Mesh* EndMeshIndexed16(const unsigned short* indices, unsigned indexCount);
+
+    // Creates an indexed mesh from the existing list of vertices after removing duplicate
+    // vertices and reordering them, filling in the stats if they are provided
+    DGL_Mesh* EndMeshOptimized(DGL_MeshOptimizeStats* stats);
+
+    // Creates a mesh from the builder's vertices, using its indices if it has any
+    DGL_Mesh* CreateMesh(const DGL_MeshBuilder* builder);
+
+    // Creates a mesh whose vertices can be changed after it is created, with room for the
+    // number of vertices
+    DGL_Mesh* CreateDynamicMesh(unsigned capacity);
+
+    // Replaces the dynamic mesh's vertices starting at the offset, removing any after them
+    void UpdateMesh(DGL_Mesh* mesh, const DGL_Vec2* positions, const DGL_Color* colors,
+        const DGL_Vec2* texCoords, unsigned count, unsigned offset);
+
     // Adds a new vertex to the list for creating a new mesh
     void AddVertex(const DGL_Vec2& position, const DGL_Color& color, const DGL_Vec2& texCoord);
 
+    // Adds an array of vertices to the list for creating a new mesh
+    void AddVertices(const DGL_Vec2* positions, unsigned positionStride, const DGL_Color* colors,
+        unsigned colorStride, const DGL_Vec2* texCoords, unsigned texCoordStride, unsigned count);
+
+    // Adds two triangles for each group of four corners to the list for creating a new mesh
+    void AddQuads(const DGL_Vec2* positions, const DGL_Color* colors, const DGL_Vec2* texCoords,
+        unsigned quadCount);
+
     // Releases the mesh and deletes the struct
     void ReleaseMesh(DGL_Mesh* mesh);
 
+    // Sets how much data new meshes keep on the CPU
+    void SetMeshRetention(DGL_MeshRetention retention);
+
+    // Deletes any of the mesh's CPU data that the retention doesn't keep
+    void TrimMeshData(DGL_Mesh* mesh, DGL_MeshRetention retention);
+
     // Draws the mesh with the specified mode
     void DrawMesh(const DGL_Mesh* mesh, DGL_DrawMode mode);
 
+    // Draws the mesh once for each instance in the array
+    void DrawMeshInstanced(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_InstanceData* instances,
+        unsigned count);
+
+    // Draws every object in the spatial grid which the camera can see
+    void DrawVisible();
+
+    // Combines the meshes, moved by the transform data in the instances, into one mesh for
+    // each different texture
+    DGL_StaticBatch* BakeStaticBatch(const DGL_Mesh* const* meshes,
+        const DGL_Texture* const* textures, const DGL_InstanceData* instances, unsigned count);
+
+    // Draws each part of the static batch with its texture
+    void DrawStaticBatch(const DGL_StaticBatch* batch);
+
+    // Releases the meshes in the static batch and deletes the struct
+    void ReleaseStaticBatch(DGL_StaticBatch* batch);
+
+    // Turns automatic batching of draws on or off
+    void SetBatching(bool enabled);
+
+    // Turns recording and sorting of draws on or off
+    void SetDrawSorting(bool enabled);
+
+    // Turns view culling on or off
+    void SetCulling(bool enabled);
+
+    // Turns batching of mesh and texture uploads on or off
+    void SetUploadBatching(bool enabled);
+
+    // Copies any batched uploads to the graphics card
+    void FlushUploads();
+
+    // Fills in the upload counters
+    void GetUploadStats(DGL_UploadStats* stats) const;
+
+    // Draws any recorded commands and anything waiting in the current batch
+    void FlushBatch();
+
+    // Fills in the draw counters since the last reset
+    void GetDrawStats(DGL_DrawStats* stats) const;
+
+    // Sets all draw counters back to zero
+    void ResetDrawStats();
+
+    // Fills in the amount of memory used by the current meshes
+    void GetMeshMemory(DGL_MeshMemory* memory) const;
+
+    // Fills in the sizes and counters for the shared buffers meshes are stored in
+    void GetMeshBufferStats(DGL_MeshBufferStats* stats) const;
+
     // Sets the transform data to be used when drawing the next mesh
     void SetTransformData(const DGL_Vec2& position, const DGL_Vec2& scale, float rotation);
 
     // Sets the Z layer value to be used when drawing the next mesh
     void SetZValue(float zValue);
 
+    // Sets a transform matrix to use instead of the transform data. This matrix is used for all
+    // meshes until SetTransformData or SetZValue is called.
+    void SetTransformMatrix(const DGL_Mat4& matrix);
+
     D3DInterface D3D;
     CameraObject Camera;
+    SpatialGrid Spatial;
 
 private:
+    // Sets the transform matrix from the transform data, if anything has changed
     void CreateTransformMatrix();
 
+    // Sets the texture rect on the constant buffer for textures in an atlas, and returns the
+    // texture to bind for drawing with the texture. Textures which aren't ready are drawn with
+    // the placeholder texture.
+    const DGL_Texture* UseTextureRect(const DGL_Texture* texture);
+
+    // Adds or removes the mesh's vertex and index buffer sizes from the memory counters
+    void CountMeshMemory(const DGL_Mesh* mesh, bool created);
+
+    // Releases the textures the texture cache is done with, after drawing anything using them
+    void ReleaseCachedTextures();
+
+    // Returns false if the mesh will be completely outside the camera's view when drawn with
+    // the current transform and vertex shader
+    bool IsVisible(const DGL_Mesh* mesh) const;
+
+    // Draws the mesh right away, or adds it to the current batch if possible
+    void SubmitMesh(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+        ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+        DGL_VertexShaderMode vertexShaderMode, const cbPerObject& constantBuffer);
+
+    // Draws a recorded command while replaying the command buffer
+    void ExecuteCommand(const DrawCommand& command, const DrawState& state) override;
+
     // The number of textures that have been loaded and not released
     int mTextures{ 0 };
+    // The number of atlases that have been created and not released
+    int mAtlases{ 0 };
     // The number of meshes that have been loaded and not released
     int mMeshes{ 0 };
+    // The number of bytes used by the vertex buffers of the current meshes
+    unsigned long long mVertexBytes{ 0 };
+    // The number of bytes the same vertex buffers would use with DGL_VF_DEFAULT
+    unsigned long long mDefaultFormatVertexBytes{ 0 };
+    // The number of bytes used by the index buffers of the current meshes
+    unsigned long long mIndexBytes{ 0 };
+    // The number of bytes of CPU memory used by the data kept by the current meshes
+    unsigned long long mCPUBytes{ 0 };
+    // The largest amount of CPU memory used by meshes and the list for building them
+    unsigned long long mPeakCPUBytes{ 0 };
     // The texture to use when drawing the next mesh
     const DGL_Texture* mCurrentTexture{ nullptr };
+    // The texture drawn in place of textures which aren't ready, or null to use the default
+    const DGL_Texture* mPlaceholderTexture{ nullptr };
+    // The default placeholder, a single transparent pixel
+    DGL_Texture* mDefaultPlaceholder{ nullptr };
+    // How the smaller levels of new textures are made and how they are compressed
+    TextureLoadSettings mTextureSettings;
     // Tracks whether or not the graphics system has been initialized
     bool mInitialized{ false };
     // Tracks mesh creation status
     bool mCreatingMesh{ false };
     // Tracks whether we need to recreate the transform matrix
     bool mCreateMatrix{ true };
+    // Tracks whether the transform matrix was set directly instead of from the transform data
+    bool mUserMatrix{ false };
+    // Tracks whether draws should be combined into batches
+    bool mBatching{ false };
+    // Tracks whether draws should be recorded and sorted before drawing
+    bool mDrawSorting{ false };
+    // Tracks whether meshes outside the camera's view should be skipped
+    bool mCulling{ false };
+    // The number of meshes drawn since the counters were reset
+    unsigned mMeshesSubmitted{ 0 };
+    // The number of meshes skipped by culling since the counters were reset
+    unsigned mMeshesCulled{ 0 };
 
     DGL_Vec2 mDrawPosition{ 0, 0 };
     DGL_Vec2 mDrawScale{ 0,0 };
     float mDrawRotation{ 0 };
     float mDrawZValue{ 0 };
+    // The sine and cosine of the draw rotation
+    CachedRotation mDrawRotationCache;
 
     MeshManager Meshes;
+    // Writes into dynamic meshes' vertex buffers
+    D3DMapContext mMapContext;
     ShaderManager mShaderManager;
+    SpriteBatcher mBatcher;
+    DrawCommandBuffer mCommands;
+    D3DBatchBackend mBatchBackend;
+    InstanceBuffer mInstanceBuffer;
+    UploadQueue mUploads;
+    // Passes the upload queue's copies to the D3D device context
+    D3DUploadContext mUploadContext;
+    TextureLoader mTextureLoader;
+    // Shares the textures loaded from the same file
+    TextureCache mTextureCache;
+    // The textures the cache is done with, kept to avoid allocating each time
+    std::vector<DGL_Texture*> mReleasedTextures;
+    // The builder used by StartMesh and the functions that add to the current mesh
+    DGL_MeshBuilder mMeshBuilder;
+    // The IDs found by the most recent spatial query, kept to avoid allocating every frame
+    std::vector<unsigned> mVisibleObjects;
 };
 
 // Global pointer for accessing the graphics system
@@ -0,0 +1,174 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Instancing.cpp
+// author:  Andy Ellinger
+// brief:   Drawing many copies of a mesh with a single draw
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <vector>
+
+module Instancing;
+
+import Errors;
+import Math;
+
+namespace DGL
+{
+
+//*************************************************************************************************
+void PackInstances(const DGL_InstanceData* instances, unsigned count, InstanceVertexData* output)
+{
+    // The rotations are handled in groups so the sine and cosine can be calculated together
+    const unsigned group_size = 64;
+    float angles[group_size];
+    float sinAngles[group_size];
+    float cosAngles[group_size];
+
+    for (unsigned start = 0; start < count; start += group_size)
+    {
+        unsigned groupCount = count - start < group_size ? count - start : group_size;
+
+        for (unsigned i = 0; i < groupCount; ++i)
+            angles[i] = instances[start + i].mRotation;
+        SinCos_Array(angles, sinAngles, cosAngles, groupCount);
+
+        for (unsigned i = 0; i < groupCount; ++i)
+        {
+            const DGL_InstanceData& instance = instances[start + i];
+            InstanceVertexData& packed = output[start + i];
+
+            // This is the same as translation * rotation * scale in CreateTransformMatrix
+            Affine2D transform = Affine_Compose(instance.mPosition, instance.mScale, sinAngles[i],
+                cosAngles[i]);
+
+            packed.mTransformX[0] = transform.mXX;
+            packed.mTransformX[1] = transform.mXY;
+            packed.mTransformX[2] = transform.mX;
+            packed.mTransformX[3] = instance.mZValue;
+
+            packed.mTransformY[0] = transform.mYX;
+            packed.mTransformY[1] = transform.mYY;
+            packed.mTransformY[2] = transform.mY;
+            packed.mTransformY[3] = instance.mAlpha;
+
+            packed.mTintColor = instance.mTintColor;
+            packed.mTexOffset = instance.mTextureOffset;
+            packed.mShaderData = instance.mShaderData;
+            packed.mPadding = 0.0f;
+        }
+    }
+}
+
+//*************************************************************************************************
+unsigned GetInstanceCapacity(unsigned currentCapacity, unsigned requiredCount)
+{
+    // Keep the current buffer if it's big enough
+    if (requiredCount <= currentCapacity)
+        return currentCapacity;
+
+    // Otherwise grow to the next power of two so a slowly growing count
+    // doesn't recreate the buffer every frame
+    unsigned capacity = InstanceBuffer::min_capacity;
+    while (capacity < requiredCount)
+        capacity *= 2;
+
+    return capacity;
+}
+
+//---------------------------------------------------------------------------------- InstanceBuffer
+
+//*************************************************************************************************
+void InstanceBuffer::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+{
+    mDevice = device;
+    mDeviceContext = deviceContext;
+}
+
+//*************************************************************************************************
+void InstanceBuffer::Release()
+{
+    if (mBuffer)
+        mBuffer->Release();
+
+    mBuffer = nullptr;
+    mCapacity = 0;
+    mDevice = nullptr;
+    mDeviceContext = nullptr;
+}
+
+//*************************************************************************************************
+bool InstanceBuffer::Upload(const DGL_InstanceData* instances, unsigned count)
+{
+    if (!mDeviceContext)
+    {
+        gError->SetError("Trying to upload instance data when Graphics is not initialized.");
+        return false;
+    }
+
+    // Make sure the buffer is large enough
+    if (!Reserve(count))
+        return false;
+
+    // Pack the instance data
+    if (mPacked.size() < count)
+        mPacked.resize(count);
+    PackInstances(instances, count, mPacked.data());
+
+    // Copy the packed data into the buffer, discarding the previous contents
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    HRESULT hr = mDeviceContext->Map(mBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem mapping instance buffer. ", hr);
+        return false;
+    }
+    memcpy(mappedResource.pData, mPacked.data(), sizeof(InstanceVertexData) * count);
+    mDeviceContext->Unmap(mBuffer, 0);
+
+    return true;
+}
+
+//*************************************************************************************************
+ID3D11Buffer* InstanceBuffer::GetBuffer() const
+{
+    return mBuffer;
+}
+
+//*************************************************************************************************
+bool InstanceBuffer::Reserve(unsigned count)
+{
+    unsigned newCapacity = GetInstanceCapacity(mCapacity, count);
+    if (newCapacity == mCapacity && mBuffer)
+        return true;
+
+    // Release the old buffer
+    if (mBuffer)
+        mBuffer->Release();
+    mBuffer = nullptr;
+    mCapacity = 0;
+
+    // Set up the buffer description struct
+    D3D11_BUFFER_DESC bufferDesc = { 0 };
+    bufferDesc.ByteWidth = sizeof(InstanceVertexData) * newCapacity;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    // Create the buffer
+    HRESULT hr = mDevice->CreateBuffer(&bufferDesc, NULL, &mBuffer);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem creating instance buffer. ", hr);
+        return false;
+    }
+
+    mCapacity = newCapacity;
+
+    return true;
+}
+
+} // namespace DGL
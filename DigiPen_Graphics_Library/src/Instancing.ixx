@@ -0,0 +1,83 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Instancing.ixx
+// author:  Andy Ellinger
+// brief:   Header for drawing many copies of a mesh with a single draw
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <vector>
+
+export module Instancing;
+
+namespace DGL
+{
+
+// The per-instance data as it is stored in the instance buffer.
+// This must match the INSTANCE inputs in VertexShaderInstanced.hlsl.
+export struct InstanceVertexData
+{
+    // The first row of the transform: scale and rotation for X, then X position and Z layer
+    float mTransformX[4];
+    // The second row of the transform: scale and rotation for Y, then Y position and alpha
+    float mTransformY[4];
+    // The color that will be added to the object's color
+    DGL_Color mTintColor;
+    // The texture offset coordinates
+    DGL_Vec2 mTexOffset;
+    // Extra data which is passed to the pixel shader for custom shaders
+    float mShaderData;
+    // Unused, keeps the struct size a multiple of 16 bytes
+    float mPadding;
+};
+
+// Converts the API instance data into the format used by the instance buffer
+export void PackInstances(const DGL_InstanceData* instances, unsigned count, InstanceVertexData* output);
+
+// Returns the capacity the instance buffer should have to hold the required number of instances
+export unsigned GetInstanceCapacity(unsigned currentCapacity, unsigned requiredCount);
+
+//---------------------------------------------------------------------------------- InstanceBuffer
+
+export class InstanceBuffer
+{
+public:
+    // Saves the D3D objects to use
+    void Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+
+    // Releases the D3D buffer
+    void Release();
+
+    // Packs the instance data and copies it into the D3D buffer. Returns false if there was a problem.
+    bool Upload(const DGL_InstanceData* instances, unsigned count);
+
+    // Returns the D3D buffer object
+    ID3D11Buffer* GetBuffer() const;
+
+    static constexpr UINT instance_stride{ sizeof(InstanceVertexData) };
+    static constexpr UINT instance_offset{ 0 };
+
+    // The smallest number of instances the buffer will be created with
+    static constexpr unsigned min_capacity{ 256 };
+
+private:
+    // Makes sure the D3D buffer can hold the provided number of instances
+    bool Reserve(unsigned count);
+
+    // The D3D device object
+    ID3D11Device* mDevice{ nullptr };
+    // The D3D device context object
+    ID3D11DeviceContext* mDeviceContext{ nullptr };
+    // The D3D buffer containing the packed instance data
+    ID3D11Buffer* mBuffer{ nullptr };
+    // The number of instances the D3D buffer can hold
+    unsigned mCapacity{ 0 };
+    // The packed instance data, kept to avoid allocating every draw
+    std::vector<InstanceVertexData> mPacked;
+};
+
+} // namespace DGL
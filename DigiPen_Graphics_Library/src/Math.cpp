@@ -9,30 +9,78 @@
 module;
 
 #include "DGL.h"
+#include <intrin.h>
+#include <immintrin.h>
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 
 module Math;
 
+import Errors;
+
 namespace DGL
 {
 
-//*************************************************************************************************
-DGL_Mat4 Matrix_RotateZ(const float& angle)
+namespace
 {
-    DGL_Mat4 m{ 0 };
 
-    m.m[0][0] = cosf(angle);    m.m[0][1] = -sinf(angle);   m.m[0][2] = 0.0f;   m.m[0][3] = 0.0f;
-    m.m[1][0] = sinf(angle);    m.m[1][1] = cosf(angle);    m.m[1][2] = 0.0f;   m.m[1][3] = 0.0f;
-    m.m[2][0] = 0.0f;           m.m[2][1] = 0.0f;           m.m[2][2] = 1.0f;   m.m[2][3] = 0.0f;
-    m.m[3][0] = 0.0f;           m.m[3][1] = 0.0f;           m.m[3][2] = 0.0f;   m.m[3][3] = 1.0f;
+// The values are read as plain float arrays
+static_assert(sizeof(DGL_Vec2) == sizeof(float) * 2);
 
-    return m;
-}
+// The values used by the fast sine and cosine
+constexpr float pi{ 3.141592654f };
+constexpr float half_pi{ 1.570796327f };
+// Two pi split into a part with few bits, so multiplying it by the quotient is exact, 
+// and the rest. This keeps the range reduction accurate for larger angles.
+constexpr float two_pi_high{ 6.28125f };
+constexpr float two_pi_low{ 0.001935307180f };
+constexpr float inv_two_pi{ 0.159154943f };
+
+// The values used to convert floats to half floats
+constexpr uint32_t sign_bit{ 0x80000000u };
+constexpr uint32_t float_infinity{ 0x7f800000u };
+// Floats with this exponent or larger are too large for a half float
+constexpr uint32_t half_overflow{ (127 + 16) << 23 };
+// Floats smaller than this are denormal or zero as half floats
+constexpr uint32_t half_smallest_normal{ (127 - 14) << 23 };
+constexpr uint32_t half_infinity{ 0x7c00 };
+constexpr uint32_t half_nan{ 0x7e00 };
+// 0.5, which puts the half float's denormal bits at the bottom of the float when added
+constexpr float half_denormal_magic{ 0.5f };
+constexpr uint32_t half_denormal_magic_bits{ 126 << 23 };
+// Changes the exponent from the float bias to the half float bias, plus the rounding value
+constexpr uint32_t half_rebias{ ((uint32_t)(15 - 127) << 23) + 0xfff };
+
+// The functions used by each math operation
+struct MathKernels
+{
+    void (*mMultiply)(const DGL_Mat4& m1, const DGL_Mat4& m2, DGL_Mat4& result);
+    void (*mTransformPoints)(const Affine2D& transform, const DGL_Vec2* points,
+        DGL_Vec2* results, unsigned count);
+    void (*mTransformPointsSoA)(const Affine2D& transform, const float* xValues,
+        const float* yValues, float* xResults, float* yResults, unsigned count);
+    void (*mSinCos)(const float* angles, float* sinResults, float* cosResults, unsigned count);
+    void (*mPackColors)(const DGL_Color* colors, unsigned colorStride, uint32_t* results,
+        unsigned resultStride, unsigned count);
+    void (*mPackHalf2)(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+        unsigned resultStride, unsigned count);
+    void (*mPackUnorm16x2)(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+        unsigned resultStride, unsigned count);
+    unsigned (*mFindMaxIndex)(const unsigned* indices, unsigned count);
+    unsigned (*mFindMaxIndex16)(const uint16_t* indices, unsigned count);
+    void (*mNarrowIndices)(const unsigned* indices, uint16_t* results, unsigned count);
+    void (*mAddScaled)(const float* values, float scale, float* results, unsigned count);
+    void (*mResample4)(const float* values, const unsigned* firsts, const float* weights,
+        unsigned taps, float* results, unsigned count);
+};
+
+//------------------------------------------------------------------------------------------ Scalar
 
 //*************************************************************************************************
-DGL_Mat4 Matrix_Multiply(const DGL_Mat4& m1, const DGL_Mat4& m2)
+void MultiplyScalar(const DGL_Mat4& m1, const DGL_Mat4& m2, DGL_Mat4& result)
 {
-    return { 
+    result = { 
         m1.m[0][0] * m2.m[0][0] + m1.m[0][1] * m2.m[1][0] + m1.m[0][2] * m2.m[2][0] + m1.m[0][3] * m2.m[3][0],
         m1.m[0][0] * m2.m[0][1] + m1.m[0][1] * m2.m[1][1] + m1.m[0][2] * m2.m[2][1] + m1.m[0][3] * m2.m[3][1],
         m1.m[0][0] * m2.m[0][2] + m1.m[0][1] * m2.m[1][2] + m1.m[0][2] * m2.m[2][2] + m1.m[0][3] * m2.m[3][2],
@@ -55,6 +103,691 @@ DGL_Mat4 Matrix_Multiply(const DGL_Mat4& m1, const DGL_Mat4& m2)
     };
 }
 
+//*************************************************************************************************
+void TransformPointsScalar(const Affine2D& transform, const DGL_Vec2* points, DGL_Vec2* results,
+    unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        DGL_Vec2 point = points[i];
+        results[i].x = transform.mXX * point.x + transform.mXY * point.y + transform.mX;
+        results[i].y = transform.mYX * point.x + transform.mYY * point.y + transform.mY;
+    }
+}
+
+//*************************************************************************************************
+void TransformPointsSoAScalar(const Affine2D& transform, const float* xValues,
+    const float* yValues, float* xResults, float* yResults, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float x = xValues[i];
+        float y = yValues[i];
+        xResults[i] = transform.mXX * x + transform.mXY * y + transform.mX;
+        yResults[i] = transform.mYX * x + transform.mYY * y + transform.mY;
+    }
+}
+
+//*************************************************************************************************
+void SinCosScalar(const float* angles, float* sinResults, float* cosResults, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        // Bring the angle into the range -pi to pi
+        float quotient = nearbyintf(angles[i] * inv_two_pi);
+        float y = (angles[i] - two_pi_high * quotient) - two_pi_low * quotient;
+
+        // Reflect the angle into the range -pi/2 to pi/2, which keeps the sine the same
+        // and flips the sign of the cosine
+        float cosSign = 1.0f;
+        if (y > half_pi)
+        {
+            y = pi - y;
+            cosSign = -1.0f;
+        }
+        else if (y < -half_pi)
+        {
+            y = -pi - y;
+            cosSign = -1.0f;
+        }
+
+        // Polynomial approximations of sine and cosine in that range
+        float y2 = y * y;
+        sinResults[i] = (((((-2.3889859e-08f * y2 + 2.7525562e-06f) * y2 - 0.00019840874f) * y2 +
+            0.0083333310f) * y2 - 0.16666667f) * y2 + 1.0f) * y;
+        cosResults[i] = (((((-2.6051615e-07f * y2 + 2.4760495e-05f) * y2 - 0.0013888378f) * y2 +
+            0.041666638f) * y2 - 0.5f) * y2 + 1.0f) * cosSign;
+    }
+}
+
+//*************************************************************************************************
+float Saturate(float value)
+{
+    // Written with comparisons so NaN becomes 0, the same as the SSE2 version
+    value = value > 0.0f ? value : 0.0f;
+    return value < 1.0f ? value : 1.0f;
+}
+
+//*************************************************************************************************
+uint32_t PackUnorm8(float value)
+{
+    return (uint32_t)(Saturate(value) * 255.0f + 0.5f);
+}
+
+//*************************************************************************************************
+uint32_t PackUnorm16(float value)
+{
+    return (uint32_t)(Saturate(value) * 65535.0f + 0.5f);
+}
+
+//*************************************************************************************************
+uint32_t PackHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = bits & sign_bit;
+    bits ^= sign;
+
+    uint32_t result;
+    if (bits >= half_overflow)
+    {
+        // Too large for a half float, so use infinity, or keep it as NaN
+        result = bits > float_infinity ? half_nan : half_infinity;
+    }
+    else if (bits < half_smallest_normal)
+    {
+        // Adding the magic value lines the bits up with the half float's denormal values 
+        // and rounds them
+        float shifted;
+        memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += half_denormal_magic;
+        memcpy(&result, &shifted, sizeof(result));
+        result -= half_denormal_magic_bits;
+    }
+    else
+    {
+        // Change the exponent bias and round to the nearest value, with ties going to even
+        uint32_t odd = (bits >> 13) & 1;
+        result = (bits + half_rebias + odd) >> 13;
+    }
+
+    return result | (sign >> 16);
+}
+
+//*************************************************************************************************
+void PackColorsScalar(const DGL_Color* colors, unsigned colorStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    const char* color = (const char*)colors;
+    char* result = (char*)results;
+
+    for (unsigned i = 0; i < count; ++i, color += colorStride, result += resultStride)
+    {
+        const DGL_Color& value = *(const DGL_Color*)color;
+        *(uint32_t*)result = PackUnorm8(value.r) | (PackUnorm8(value.g) << 8) |
+            (PackUnorm8(value.b) << 16) | (PackUnorm8(value.a) << 24);
+    }
+}
+
+//*************************************************************************************************
+void PackHalf2Scalar(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    const char* value = (const char*)values;
+    char* result = (char*)results;
+
+    for (unsigned i = 0; i < count; ++i, value += valueStride, result += resultStride)
+    {
+        const DGL_Vec2& vec = *(const DGL_Vec2*)value;
+        *(uint32_t*)result = PackHalf(vec.x) | (PackHalf(vec.y) << 16);
+    }
+}
+
+//*************************************************************************************************
+void PackUnorm16x2Scalar(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    const char* value = (const char*)values;
+    char* result = (char*)results;
+
+    for (unsigned i = 0; i < count; ++i, value += valueStride, result += resultStride)
+    {
+        const DGL_Vec2& vec = *(const DGL_Vec2*)value;
+        *(uint32_t*)result = PackUnorm16(vec.x) | (PackUnorm16(vec.y) << 16);
+    }
+}
+
+//*************************************************************************************************
+unsigned FindMaxIndexScalar(const unsigned* indices, unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+        result = indices[i] > result ? indices[i] : result;
+    return result;
+}
+
+//*************************************************************************************************
+unsigned FindMaxIndex16Scalar(const uint16_t* indices, unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+        result = indices[i] > result ? indices[i] : result;
+    return result;
+}
+
+//*************************************************************************************************
+void NarrowIndicesScalar(const unsigned* indices, uint16_t* results, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        results[i] = (uint16_t)indices[i];
+}
+
+//*************************************************************************************************
+void AddScaledScalar(const float* values, float scale, float* results, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        results[i] += values[i] * scale;
+}
+
+//*************************************************************************************************
+void Resample4Scalar(const float* values, const unsigned* firsts, const float* weights,
+    unsigned taps, float* results, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i, weights += taps, results += 4)
+    {
+        const float* value = values + firsts[i] * 4;
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (unsigned tap = 0; tap < taps; ++tap, value += 4)
+        {
+            for (unsigned channel = 0; channel < 4; ++channel)
+                sum[channel] += value[channel] * weights[tap];
+        }
+
+        for (unsigned channel = 0; channel < 4; ++channel)
+            results[channel] = sum[channel];
+    }
+}
+
+//-------------------------------------------------------------------------------------------- SSE2
+
+//*************************************************************************************************
+void MultiplySSE2(const DGL_Mat4& m1, const DGL_Mat4& m2, DGL_Mat4& result)
+{
+    __m128 row0 = _mm_loadu_ps(m2.m[0]);
+    __m128 row1 = _mm_loadu_ps(m2.m[1]);
+    __m128 row2 = _mm_loadu_ps(m2.m[2]);
+    __m128 row3 = _mm_loadu_ps(m2.m[3]);
+
+    // Each row of the result is the rows of m2 scaled by the values in the same row of m1
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(m1.m[i][0]), row0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m1.m[i][1]), row1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m1.m[i][2]), row2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m1.m[i][3]), row3));
+        _mm_storeu_ps(result.m[i], sum);
+    }
+}
+
+//*************************************************************************************************
+void TransformPointsSSE2(const Affine2D& transform, const DGL_Vec2* points, DGL_Vec2* results,
+    unsigned count)
+{
+    // With two points loaded as x, y, x, y, the results are the points times the diagonal
+    // values plus the swapped points times the other values
+    __m128 diagonal = _mm_setr_ps(transform.mXX, transform.mYY, transform.mXX, transform.mYY);
+    __m128 other = _mm_setr_ps(transform.mXY, transform.mYX, transform.mXY, transform.mYX);
+    __m128 offset = _mm_setr_ps(transform.mX, transform.mY, transform.mX, transform.mY);
+
+    unsigned i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128 point = _mm_loadu_ps(&points[i].x);
+        __m128 swapped = _mm_shuffle_ps(point, point, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(diagonal, point),
+            _mm_mul_ps(other, swapped)), offset);
+        _mm_storeu_ps(&results[i].x, result);
+    }
+
+    TransformPointsScalar(transform, points + i, results + i, count - i);
+}
+
+//*************************************************************************************************
+void TransformPointsSoASSE2(const Affine2D& transform, const float* xValues,
+    const float* yValues, float* xResults, float* yResults, unsigned count)
+{
+    __m128 xx = _mm_set1_ps(transform.mXX);
+    __m128 xy = _mm_set1_ps(transform.mXY);
+    __m128 xOffset = _mm_set1_ps(transform.mX);
+    __m128 yx = _mm_set1_ps(transform.mYX);
+    __m128 yy = _mm_set1_ps(transform.mYY);
+    __m128 yOffset = _mm_set1_ps(transform.mY);
+
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(xValues + i);
+        __m128 y = _mm_loadu_ps(yValues + i);
+        _mm_storeu_ps(xResults + i, 
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, x), _mm_mul_ps(xy, y)), xOffset));
+        _mm_storeu_ps(yResults + i, 
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(yx, x), _mm_mul_ps(yy, y)), yOffset));
+    }
+
+    TransformPointsSoAScalar(transform, xValues + i, yValues + i, xResults + i, yResults + i,
+        count - i);
+}
+
+//*************************************************************************************************
+void SinCosSSE2(const float* angles, float* sinResults, float* cosResults, unsigned count)
+{
+    __m128 signBit = _mm_set1_ps(-0.0f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 negativeOne = _mm_set1_ps(-1.0f);
+
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // Bring the angle into the range -pi to pi
+        __m128 angle = _mm_loadu_ps(angles + i);
+        __m128 quotient = _mm_cvtepi32_ps(_mm_cvtps_epi32(
+            _mm_mul_ps(angle, _mm_set1_ps(inv_two_pi))));
+        __m128 y = _mm_sub_ps(_mm_sub_ps(angle, _mm_mul_ps(_mm_set1_ps(two_pi_high), quotient)),
+            _mm_mul_ps(_mm_set1_ps(two_pi_low), quotient));
+
+        // Reflect values outside -pi/2 to pi/2 around pi or -pi
+        __m128 reflect = _mm_cmpgt_ps(_mm_andnot_ps(signBit, y), _mm_set1_ps(half_pi));
+        __m128 signedPi = _mm_or_ps(_mm_and_ps(y, signBit), _mm_set1_ps(pi));
+        y = _mm_or_ps(_mm_and_ps(reflect, _mm_sub_ps(signedPi, y)), _mm_andnot_ps(reflect, y));
+        __m128 cosSign = _mm_or_ps(_mm_and_ps(reflect, negativeOne), _mm_andnot_ps(reflect, one));
+
+        // The same polynomials as the scalar version
+        __m128 y2 = _mm_mul_ps(y, y);
+        __m128 sinValue = _mm_set1_ps(-2.3889859e-08f);
+        sinValue = _mm_add_ps(_mm_mul_ps(sinValue, y2), _mm_set1_ps(2.7525562e-06f));
+        sinValue = _mm_sub_ps(_mm_mul_ps(sinValue, y2), _mm_set1_ps(0.00019840874f));
+        sinValue = _mm_add_ps(_mm_mul_ps(sinValue, y2), _mm_set1_ps(0.0083333310f));
+        sinValue = _mm_sub_ps(_mm_mul_ps(sinValue, y2), _mm_set1_ps(0.16666667f));
+        sinValue = _mm_add_ps(_mm_mul_ps(sinValue, y2), one);
+        _mm_storeu_ps(sinResults + i, _mm_mul_ps(sinValue, y));
+
+        __m128 cosValue = _mm_set1_ps(-2.6051615e-07f);
+        cosValue = _mm_add_ps(_mm_mul_ps(cosValue, y2), _mm_set1_ps(2.4760495e-05f));
+        cosValue = _mm_sub_ps(_mm_mul_ps(cosValue, y2), _mm_set1_ps(0.0013888378f));
+        cosValue = _mm_add_ps(_mm_mul_ps(cosValue, y2), _mm_set1_ps(0.041666638f));
+        cosValue = _mm_sub_ps(_mm_mul_ps(cosValue, y2), _mm_set1_ps(0.5f));
+        cosValue = _mm_add_ps(_mm_mul_ps(cosValue, y2), one);
+        _mm_storeu_ps(cosResults + i, _mm_mul_ps(cosValue, cosSign));
+    }
+
+    SinCosScalar(angles + i, sinResults + i, cosResults + i, count - i);
+}
+
+//*************************************************************************************************
+__m128 LoadTwoVec2(const char* first, const char* second)
+{
+    return _mm_castpd_ps(_mm_loadh_pd(_mm_load_sd((const double*)first), (const double*)second));
+}
+
+//*************************************************************************************************
+void StoreTwoPairs(__m128i values, char* first, char* second)
+{
+    // Each pair of 16-bit values is in the low half of two 32-bit values, so move the second
+    // value of each pair up next to the first
+    values = _mm_or_si128(values, _mm_srli_epi64(values, 16));
+    *(uint32_t*)first = (uint32_t)_mm_cvtsi128_si32(values);
+    *(uint32_t*)second = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(values, 8));
+}
+
+//*************************************************************************************************
+void PackColorsSSE2(const DGL_Color* colors, unsigned colorStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 scale = _mm_set1_ps(255.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+
+    const char* color = (const char*)colors;
+    char* result = (char*)results;
+
+    for (unsigned i = 0; i < count; ++i, color += colorStride, result += resultStride)
+    {
+        // Convert all four channels at once, then narrow them down to bytes
+        __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps((const float*)color), zero), one);
+        __m128i channels = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+        channels = _mm_packs_epi32(channels, channels);
+        channels = _mm_packus_epi16(channels, channels);
+        *(uint32_t*)result = (uint32_t)_mm_cvtsi128_si32(channels);
+    }
+}
+
+//*************************************************************************************************
+void PackHalf2SSE2(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    __m128i signBit = _mm_set1_epi32((int)sign_bit);
+    __m128i overflow = _mm_set1_epi32((int)half_overflow - 1);
+    __m128i infinity = _mm_set1_epi32((int)float_infinity);
+    __m128i halfInfinity = _mm_set1_epi32((int)half_infinity);
+    __m128i nanBit = _mm_set1_epi32((int)(half_nan ^ half_infinity));
+    __m128i smallestNormal = _mm_set1_epi32((int)half_smallest_normal);
+    __m128 denormalMagic = _mm_set1_ps(half_denormal_magic);
+    __m128i denormalMagicBits = _mm_set1_epi32((int)half_denormal_magic_bits);
+    __m128i rebias = _mm_set1_epi32((int)half_rebias);
+    __m128i oneBit = _mm_set1_epi32(1);
+
+    const char* value = (const char*)values;
+    char* result = (char*)results;
+
+    unsigned i = 0;
+    for (; i + 2 <= count; i += 2, value += valueStride * 2, result += resultStride * 2)
+    {
+        // The same steps as the scalar version, choosing between the results with masks
+        __m128i bits = _mm_castps_si128(LoadTwoVec2(value, value + valueStride));
+        __m128i sign = _mm_and_si128(bits, signBit);
+        bits = _mm_xor_si128(bits, sign);
+
+        __m128i isNan = _mm_cmpgt_epi32(bits, infinity);
+        __m128i special = _mm_or_si128(halfInfinity, _mm_and_si128(isNan, nanBit));
+
+        __m128i denormal = _mm_sub_epi32(_mm_castps_si128(
+            _mm_add_ps(_mm_castsi128_ps(bits), denormalMagic)), denormalMagicBits);
+
+        __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 13), oneBit);
+        __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, rebias), odd), 13);
+
+        __m128i isSmall = _mm_cmplt_epi32(bits, smallestNormal);
+        __m128i packed = _mm_or_si128(_mm_and_si128(isSmall, denormal),
+            _mm_andnot_si128(isSmall, normal));
+        __m128i isOverflow = _mm_cmpgt_epi32(bits, overflow);
+        packed = _mm_or_si128(_mm_and_si128(isOverflow, special),
+            _mm_andnot_si128(isOverflow, packed));
+        packed = _mm_or_si128(packed, _mm_srli_epi32(sign, 16));
+
+        StoreTwoPairs(packed, result, result + resultStride);
+    }
+
+    PackHalf2Scalar((const DGL_Vec2*)value, valueStride, (uint32_t*)result, resultStride,
+        count - i);
+}
+
+//*************************************************************************************************
+void PackUnorm16x2SSE2(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 scale = _mm_set1_ps(65535.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+
+    const char* value = (const char*)values;
+    char* result = (char*)results;
+
+    unsigned i = 0;
+    for (; i + 2 <= count; i += 2, value += valueStride * 2, result += resultStride * 2)
+    {
+        __m128 pairs = _mm_min_ps(_mm_max_ps(LoadTwoVec2(value, value + valueStride), zero), one);
+        __m128i packed = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(pairs, scale), half));
+        StoreTwoPairs(packed, result, result + resultStride);
+    }
+
+    PackUnorm16x2Scalar((const DGL_Vec2*)value, valueStride, (uint32_t*)result, resultStride,
+        count - i);
+}
+
+//*************************************************************************************************
+unsigned FindMaxIndexSSE2(const unsigned* indices, unsigned count)
+{
+    // SSE2 can only compare signed values, so flip the top bit to keep the order the same
+    __m128i flip = _mm_set1_epi32((int)sign_bit);
+    __m128i largest = flip;
+
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i values = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(indices + i)), flip);
+        __m128i greater = _mm_cmpgt_epi32(values, largest);
+        largest = _mm_or_si128(_mm_and_si128(greater, values), _mm_andnot_si128(greater, largest));
+    }
+
+    // Combine the four values with the rest of the array
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, _mm_xor_si128(largest, flip));
+    unsigned result = FindMaxIndexScalar(indices + i, count - i);
+    for (uint32_t lane : lanes)
+        result = lane > result ? lane : result;
+    return result;
+}
+
+//*************************************************************************************************
+unsigned FindMaxIndex16SSE2(const uint16_t* indices, unsigned count)
+{
+    // The same as the 32-bit version, using the signed 16-bit max instruction
+    __m128i flip = _mm_set1_epi16((short)0x8000);
+    __m128i largest = flip;
+
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i values = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(indices + i)), flip);
+        largest = _mm_max_epi16(largest, values);
+    }
+
+    uint16_t lanes[8];
+    _mm_storeu_si128((__m128i*)lanes, _mm_xor_si128(largest, flip));
+    unsigned result = FindMaxIndex16Scalar(indices + i, count - i);
+    for (uint16_t lane : lanes)
+        result = lane > result ? lane : result;
+    return result;
+}
+
+//*************************************************************************************************
+void NarrowIndicesSSE2(const unsigned* indices, uint16_t* results, unsigned count)
+{
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // Sign extend the low 16 bits so the signed saturating pack keeps them as they are
+        __m128i low = _mm_loadu_si128((const __m128i*)(indices + i));
+        __m128i high = _mm_loadu_si128((const __m128i*)(indices + i + 4));
+        low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+        high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+        _mm_storeu_si128((__m128i*)(results + i), _mm_packs_epi32(low, high));
+    }
+
+    NarrowIndicesScalar(indices + i, results + i, count - i);
+}
+
+//*************************************************************************************************
+void AddScaledSSE2(const float* values, float scale, float* results, unsigned count)
+{
+    __m128 factor = _mm_set1_ps(scale);
+
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 value = _mm_loadu_ps(values + i);
+        _mm_storeu_ps(results + i, _mm_add_ps(_mm_loadu_ps(results + i),
+            _mm_mul_ps(value, factor)));
+    }
+
+    AddScaledScalar(values + i, scale, results + i, count - i);
+}
+
+//*************************************************************************************************
+void Resample4SSE2(const float* values, const unsigned* firsts, const float* weights,
+    unsigned taps, float* results, unsigned count)
+{
+    // Each group of four values fits in one register, so every tap is one multiply and add
+    for (unsigned i = 0; i < count; ++i, weights += taps, results += 4)
+    {
+        const float* value = values + firsts[i] * 4;
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned tap = 0; tap < taps; ++tap, value += 4)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(value), _mm_set1_ps(weights[tap])));
+
+        _mm_storeu_ps(results, sum);
+    }
+}
+
+//--------------------------------------------------------------------------------------------- AVX
+
+//*************************************************************************************************
+void TransformPointsAVX(const Affine2D& transform, const DGL_Vec2* points, DGL_Vec2* results,
+    unsigned count)
+{
+    // The same as the SSE2 version with four points at a time
+    __m256 diagonal = _mm256_setr_ps(transform.mXX, transform.mYY, transform.mXX, transform.mYY,
+        transform.mXX, transform.mYY, transform.mXX, transform.mYY);
+    __m256 other = _mm256_setr_ps(transform.mXY, transform.mYX, transform.mXY, transform.mYX,
+        transform.mXY, transform.mYX, transform.mXY, transform.mYX);
+    __m256 offset = _mm256_setr_ps(transform.mX, transform.mY, transform.mX, transform.mY,
+        transform.mX, transform.mY, transform.mX, transform.mY);
+
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256 point = _mm256_loadu_ps(&points[i].x);
+        __m256 swapped = _mm256_permute_ps(point, _MM_SHUFFLE(2, 3, 0, 1));
+        __m256 result = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(diagonal, point),
+            _mm256_mul_ps(other, swapped)), offset);
+        _mm256_storeu_ps(&results[i].x, result);
+    }
+
+    TransformPointsSSE2(transform, points + i, results + i, count - i);
+}
+
+//*************************************************************************************************
+void TransformPointsSoAAVX(const Affine2D& transform, const float* xValues,
+    const float* yValues, float* xResults, float* yResults, unsigned count)
+{
+    __m256 xx = _mm256_set1_ps(transform.mXX);
+    __m256 xy = _mm256_set1_ps(transform.mXY);
+    __m256 xOffset = _mm256_set1_ps(transform.mX);
+    __m256 yx = _mm256_set1_ps(transform.mYX);
+    __m256 yy = _mm256_set1_ps(transform.mYY);
+    __m256 yOffset = _mm256_set1_ps(transform.mY);
+
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(xValues + i);
+        __m256 y = _mm256_loadu_ps(yValues + i);
+        _mm256_storeu_ps(xResults + i, 
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, x), _mm256_mul_ps(xy, y)), xOffset));
+        _mm256_storeu_ps(yResults + i, 
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yx, x), _mm256_mul_ps(yy, y)), yOffset));
+    }
+
+    TransformPointsSoASSE2(transform, xValues + i, yValues + i, xResults + i, yResults + i,
+        count - i);
+}
+
+//----------------------------------------------------------------------------------------- Dispatch
+
+//*************************************************************************************************
+bool CPUSupportsSSE2()
+{
+#if defined(_M_X64)
+    // Every 64-bit CPU supports SSE2
+    return true;
+#else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#endif
+}
+
+//*************************************************************************************************
+bool CPUSupportsAVX()
+{
+    // The CPU needs to support AVX, and the OS needs to save the AVX registers
+    int info[4];
+    __cpuid(info, 1);
+    bool osSaves = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    return osSaves && avx && (_xgetbv(0) & 0x6) == 0x6;
+}
+
+//*************************************************************************************************
+bool CPUSupportsLevel(MathKernelLevel level)
+{
+    switch (level)
+    {
+    case MathKernelLevel::AVX:
+        return CPUSupportsAVX();
+    case MathKernelLevel::SSE2:
+        return CPUSupportsSSE2();
+    default:
+        return true;
+    }
+}
+
+//*************************************************************************************************
+MathKernels SelectKernels(MathKernelLevel level)
+{
+    if (level == MathKernelLevel::AVX)
+        return { MultiplySSE2, TransformPointsAVX, TransformPointsSoAAVX, SinCosSSE2,
+            PackColorsSSE2, PackHalf2SSE2, PackUnorm16x2SSE2,
+            FindMaxIndexSSE2, FindMaxIndex16SSE2, NarrowIndicesSSE2,
+            AddScaledSSE2, Resample4SSE2 };
+
+    if (level == MathKernelLevel::SSE2)
+        return { MultiplySSE2, TransformPointsSSE2, TransformPointsSoASSE2, SinCosSSE2,
+            PackColorsSSE2, PackHalf2SSE2, PackUnorm16x2SSE2,
+            FindMaxIndexSSE2, FindMaxIndex16SSE2, NarrowIndicesSSE2,
+            AddScaledSSE2, Resample4SSE2 };
+
+    return { MultiplyScalar, TransformPointsScalar, TransformPointsSoAScalar, SinCosScalar,
+        PackColorsScalar, PackHalf2Scalar, PackUnorm16x2Scalar,
+        FindMaxIndexScalar, FindMaxIndex16Scalar, NarrowIndicesScalar,
+        AddScaledScalar, Resample4Scalar };
+}
+
+//*************************************************************************************************
+MathKernels SelectKernels()
+{
+    if (CPUSupportsAVX())
+        return SelectKernels(MathKernelLevel::AVX);
+
+    if (CPUSupportsSSE2())
+        return SelectKernels(MathKernelLevel::SSE2);
+
+    return SelectKernels(MathKernelLevel::Scalar);
+}
+
+//*************************************************************************************************
+MathKernels& GetKernels()
+{
+    // Checks the CPU the first time this is called
+    static MathKernels kernels = SelectKernels();
+    return kernels;
+}
+
+} // namespace
+
+//*************************************************************************************************
+DGL_Mat4 Matrix_RotateZ(const float& angle)
+{
+    DGL_Mat4 m{ 0 };
+
+    m.m[0][0] = cosf(angle);    m.m[0][1] = -sinf(angle);   m.m[0][2] = 0.0f;   m.m[0][3] = 0.0f;
+    m.m[1][0] = sinf(angle);    m.m[1][1] = cosf(angle);    m.m[1][2] = 0.0f;   m.m[1][3] = 0.0f;
+    m.m[2][0] = 0.0f;           m.m[2][1] = 0.0f;           m.m[2][2] = 1.0f;   m.m[2][3] = 0.0f;
+    m.m[3][0] = 0.0f;           m.m[3][1] = 0.0f;           m.m[3][2] = 0.0f;   m.m[3][3] = 1.0f;
+
+    return m;
+}
+
+//*************************************************************************************************
+DGL_Mat4 Matrix_Multiply(const DGL_Mat4& m1, const DGL_Mat4& m2)
+{
+    DGL_Mat4 result;
+    GetKernels().mMultiply(m1, m2, result);
+    return result;
+}
+
 //*************************************************************************************************
 void Matrix_SetToIdentity(DGL_Mat4& matrix)
 {
@@ -65,4 +798,241 @@ void Matrix_SetToIdentity(DGL_Mat4& matrix)
     matrix.m[3][3] = 1;
 }
 
+//*************************************************************************************************
+Affine2D Affine_Compose(const DGL_Vec2& position, const DGL_Vec2& scale, float sinAngle,
+    float cosAngle)
+{
+    Affine2D transform;
+
+    transform.mXX = cosAngle * scale.x;
+    transform.mXY = -sinAngle * scale.y;
+    transform.mX = position.x;
+
+    transform.mYX = sinAngle * scale.x;
+    transform.mYY = cosAngle * scale.y;
+    transform.mY = position.y;
+
+    return transform;
+}
+
+//*************************************************************************************************
+DGL_Mat4 Affine_ToMatrix(const Affine2D& transform, float zValue)
+{
+    DGL_Mat4 m{ 0 };
+
+    m.m[0][0] = transform.mXX;  m.m[0][1] = transform.mXY;  m.m[0][2] = 0.0f;   m.m[0][3] = transform.mX;
+    m.m[1][0] = transform.mYX;  m.m[1][1] = transform.mYY;  m.m[1][2] = 0.0f;   m.m[1][3] = transform.mY;
+    m.m[2][0] = 0.0f;           m.m[2][1] = 0.0f;           m.m[2][2] = 1.0f;   m.m[2][3] = zValue;
+    m.m[3][0] = 0.0f;           m.m[3][1] = 0.0f;           m.m[3][2] = 0.0f;   m.m[3][3] = 1.0f;
+
+    return m;
+}
+
+//*************************************************************************************************
+Affine2D Affine_FromMatrix(const DGL_Mat4& matrix)
+{
+    Affine2D transform;
+
+    transform.mXX = matrix.m[0][0];
+    transform.mXY = matrix.m[0][1];
+    transform.mX = matrix.m[0][3];
+
+    transform.mYX = matrix.m[1][0];
+    transform.mYY = matrix.m[1][1];
+    transform.mY = matrix.m[1][3];
+
+    return transform;
+}
+
+//*************************************************************************************************
+Affine2D Affine_Multiply(const Affine2D& first, const Affine2D& second)
+{
+    Affine2D result;
+
+    result.mXX = first.mXX * second.mXX + first.mXY * second.mYX;
+    result.mXY = first.mXX * second.mXY + first.mXY * second.mYY;
+    result.mX = first.mXX * second.mX + first.mXY * second.mY + first.mX;
+
+    result.mYX = first.mYX * second.mXX + first.mYY * second.mYX;
+    result.mYY = first.mYX * second.mXY + first.mYY * second.mYY;
+    result.mY = first.mYX * second.mX + first.mYY * second.mY + first.mY;
+
+    return result;
+}
+
+//*************************************************************************************************
+void Affine_TransformBox(const Affine2D& transform, const DGL_Vec2& boxMin,
+    const DGL_Vec2& boxMax, DGL_Vec2& resultMin, DGL_Vec2& resultMax)
+{
+    // Transform the center, then find how far the rotated and scaled corners reach from it
+    DGL_Vec2 center = { (boxMin.x + boxMax.x) * 0.5f, (boxMin.y + boxMax.y) * 0.5f };
+    DGL_Vec2 halfSize = { (boxMax.x - boxMin.x) * 0.5f, (boxMax.y - boxMin.y) * 0.5f };
+
+    DGL_Vec2 newCenter = {
+        transform.mXX * center.x + transform.mXY * center.y + transform.mX,
+        transform.mYX * center.x + transform.mYY * center.y + transform.mY
+    };
+    DGL_Vec2 newHalfSize = {
+        fabsf(transform.mXX) * halfSize.x + fabsf(transform.mXY) * halfSize.y,
+        fabsf(transform.mYX) * halfSize.x + fabsf(transform.mYY) * halfSize.y
+    };
+
+    resultMin = { newCenter.x - newHalfSize.x, newCenter.y - newHalfSize.y };
+    resultMax = { newCenter.x + newHalfSize.x, newCenter.y + newHalfSize.y };
+}
+
+//*************************************************************************************************
+void Affine_TransformPoints(const Affine2D& transform, const DGL_Vec2* points,
+    DGL_Vec2* results, unsigned count)
+{
+    GetKernels().mTransformPoints(transform, points, results, count);
+}
+
+//*************************************************************************************************
+void Affine_TransformPointsSoA(const Affine2D& transform, const float* xValues,
+    const float* yValues, float* xResults, float* yResults, unsigned count)
+{
+    GetKernels().mTransformPointsSoA(transform, xValues, yValues, xResults, yResults, count);
+}
+
+//*************************************************************************************************
+void SinCos_Array(const float* angles, float* sinResults, float* cosResults, unsigned count)
+{
+    GetKernels().mSinCos(angles, sinResults, cosResults, count);
+}
+
+//*************************************************************************************************
+void Pack_ColorsUnorm8(const DGL_Color* colors, unsigned colorStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    GetKernels().mPackColors(colors, colorStride, results, resultStride, count);
+}
+
+//*************************************************************************************************
+void Pack_Vec2Half(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    GetKernels().mPackHalf2(values, valueStride, results, resultStride, count);
+}
+
+//*************************************************************************************************
+void Pack_Vec2Unorm16(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count)
+{
+    GetKernels().mPackUnorm16x2(values, valueStride, results, resultStride, count);
+}
+
+//*************************************************************************************************
+unsigned Index_FindMax(const unsigned* indices, unsigned count)
+{
+    return GetKernels().mFindMaxIndex(indices, count);
+}
+
+//*************************************************************************************************
+unsigned Index_FindMax16(const uint16_t* indices, unsigned count)
+{
+    return GetKernels().mFindMaxIndex16(indices, count);
+}
+
+//*************************************************************************************************
+void Index_Narrow(const unsigned* indices, uint16_t* results, unsigned count)
+{
+    GetKernels().mNarrowIndices(indices, results, count);
+}
+
+//*************************************************************************************************
+void Array_AddScaled(const float* values, float scale, float* results, unsigned count)
+{
+    GetKernels().mAddScaled(values, scale, results, count);
+}
+
+//*************************************************************************************************
+void Array_Resample4(const float* values, const unsigned* firsts, const float* weights,
+    unsigned taps, float* results, unsigned count)
+{
+    GetKernels().mResample4(values, firsts, weights, taps, results, count);
+}
+
+//*************************************************************************************************
+bool CPU_SupportsSSE2()
+{
+    return CPUSupportsSSE2();
+}
+
+//*************************************************************************************************
+bool Math_SetKernelLevel(MathKernelLevel level)
+{
+    if (!CPUSupportsLevel(level))
+        return false;
+
+    GetKernels() = SelectKernels(level);
+    return true;
+}
+
+//---------------------------------------------------------------------------------- CachedRotation
+
+//*************************************************************************************************
+void CachedRotation::SetAngle(float angle)
+{
+    if (angle == mAngle)
+        return;
+
+    mAngle = angle;
+    mSin = sinf(angle);
+    mCos = cosf(angle);
+}
+
+//*************************************************************************************************
+float CachedRotation::GetSin() const
+{
+    return mSin;
+}
+
+//*************************************************************************************************
+float CachedRotation::GetCos() const
+{
+    return mCos;
+}
+
 } // namepspace DGL
+
+using namespace DGL;
+
+//*************************************************************************************************
+void DGL_Math_TransformPoints(const DGL_Mat4* matrix, const DGL_Vec2* points, DGL_Vec2* results,
+    unsigned count)
+{
+    if (!matrix || !points || !results)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Math_TransformPoints.");
+        return;
+    }
+
+    Affine_TransformPoints(Affine_FromMatrix(*matrix), points, results, count);
+}
+
+//*************************************************************************************************
+void DGL_Math_TransformPointsSoA(const DGL_Mat4* matrix, const float* xValues, 
+    const float* yValues, float* xResults, float* yResults, unsigned count)
+{
+    if (!matrix || !xValues || !yValues || !xResults || !yResults)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Math_TransformPointsSoA.");
+        return;
+    }
+
+    Affine_TransformPointsSoA(Affine_FromMatrix(*matrix), xValues, yValues, xResults, yResults,
+        count);
+}
+
+//*************************************************************************************************
+void DGL_Math_SinCos(const float* angles, float* sinResults, float* cosResults, unsigned count)
+{
+    if (!angles || !sinResults || !cosResults)
+    {
+        gError->SetError("Passed in a null parameter to DGL_Math_SinCos.");
+        return;
+    }
+
+    SinCos_Array(angles, sinResults, cosResults, count);
+}
@@ -9,6 +9,7 @@
 module;
 
 #include "DGL.h"
+#include <stdint.h>
 
 export module Math;
 
@@ -25,4 +26,126 @@ export DGL_Mat4 Matrix_Multiply(const DGL_Mat4& matrix1, const DGL_Mat4& matrix2
 // Sets the provided matrix to the identity values
 export void Matrix_SetToIdentity(DGL_Mat4& matrix);
 
+// A 2D transform with scale, rotation, and translation. This holds the top two rows of the 
+// 3x3 matrix, since the bottom row is always 0, 0, 1.
+export struct Affine2D
+{
+    // X scale and rotation, then X translation
+    float mXX{ 1.0f };
+    float mXY{ 0.0f };
+    float mX{ 0.0f };
+    // Y scale and rotation, then Y translation
+    float mYX{ 0.0f };
+    float mYY{ 1.0f };
+    float mY{ 0.0f };
+};
+
+// Returns the transform that scales, then rotates, then translates.
+// This is the same as translation * rotation * scale, without building each matrix.
+export Affine2D Affine_Compose(const DGL_Vec2& position, const DGL_Vec2& scale, float sinAngle,
+    float cosAngle);
+
+// Returns the 4x4 matrix for the 2D transform with the provided Z value
+export DGL_Mat4 Affine_ToMatrix(const Affine2D& transform, float zValue);
+
+// Returns the 2D transform using the X and Y rows of the matrix. The Z and W rows are ignored.
+export Affine2D Affine_FromMatrix(const DGL_Mat4& matrix);
+
+// Returns the transform that applies the second transform and then the first
+export Affine2D Affine_Multiply(const Affine2D& first, const Affine2D& second);
+
+// Finds the smallest box containing the provided box after it has been transformed
+export void Affine_TransformBox(const Affine2D& transform, const DGL_Vec2& boxMin,
+    const DGL_Vec2& boxMax, DGL_Vec2& resultMin, DGL_Vec2& resultMax);
+
+//------------------------------------------------------------------------------------- Array Math
+
+// These functions process whole arrays at once. They use SSE2 or AVX instructions when the
+// CPU supports them, which is checked the first time any of them are called. The output 
+// arrays can be the same as the input arrays.
+
+// Transforms each point by the 2D transform
+export void Affine_TransformPoints(const Affine2D& transform, const DGL_Vec2* points,
+    DGL_Vec2* results, unsigned count);
+
+// Transforms each point by the 2D transform, with the X and Y values in separate arrays
+export void Affine_TransformPointsSoA(const Affine2D& transform, const float* xValues,
+    const float* yValues, float* xResults, float* yResults, unsigned count);
+
+// Calculates the approximate sine and cosine of each angle, in radians. The results are
+// within about 0.000001 of sinf and cosf for angles between -1000 and 1000.
+export void SinCos_Array(const float* angles, float* sinResults, float* cosResults, unsigned count);
+
+// The packing functions read and write with strides, which are the number of bytes from one
+// value to the next in each array, so they can work directly on interleaved vertex data.
+// The results must be in a separate array from the values.
+
+// Converts each color to four 8-bit values, with red in the lowest byte. The channels are 
+// clamped between 0 and 1 first, and rounded to the nearest of the 256 steps.
+export void Pack_ColorsUnorm8(const DGL_Color* colors, unsigned colorStride, uint32_t* results,
+    unsigned resultStride, unsigned count);
+
+// Converts the X and Y of each value to 16-bit floats, with X in the low 16 bits.
+// Values too large for a 16-bit float become infinity.
+export void Pack_Vec2Half(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count);
+
+// Converts the X and Y of each value to 16-bit values, with X in the low 16 bits. The values
+// are clamped between 0 and 1 first, and rounded to the nearest of the 65536 steps.
+export void Pack_Vec2Unorm16(const DGL_Vec2* values, unsigned valueStride, uint32_t* results,
+    unsigned resultStride, unsigned count);
+
+// Returns the largest index in the array, or 0 if the array is empty
+export unsigned Index_FindMax(const unsigned* indices, unsigned count);
+
+// Returns the largest 16-bit index in the array, or 0 if the array is empty
+export unsigned Index_FindMax16(const uint16_t* indices, unsigned count);
+
+// Copies each index into the 16-bit results array. Every index must be less than 65536.
+export void Index_Narrow(const unsigned* indices, uint16_t* results, unsigned count);
+
+// Adds each value times the scale to the result at the same position
+export void Array_AddScaled(const float* values, float scale, float* results, unsigned count);
+
+// Treats the values and results as groups of four floats, such as the channels of a pixel. Each
+// group of results is set to the sum of taps groups of values, starting at the group in firsts,
+// each multiplied by the next weight. There are taps weights for each group of results. The
+// results must be in a separate array from the values.
+export void Array_Resample4(const float* values, const unsigned* firsts, const float* weights,
+    unsigned taps, float* results, unsigned count);
+
+// Returns true if the CPU supports SSE2, for modules with their own SSE2 versions of functions
+export bool CPU_SupportsSSE2();
+
+// The instruction sets the array functions can use
+export enum class MathKernelLevel { Scalar, SSE2, AVX };
+
+// Makes the array functions use the provided instruction set, so each version can be tested 
+// against the others. Returns false, without changing anything, if the CPU doesn't support it.
+export bool Math_SetKernelLevel(MathKernelLevel level);
+
+//---------------------------------------------------------------------------------- CachedRotation
+
+// Keeps the sine and cosine of an angle, only recalculating them when the angle changes
+export class CachedRotation
+{
+public:
+    // Sets the angle in radians, updating the sine and cosine if it is different
+    void SetAngle(float angle);
+
+    // Returns the sine of the current angle
+    float GetSin() const;
+
+    // Returns the cosine of the current angle
+    float GetCos() const;
+
+private:
+    // The current angle, in radians
+    float mAngle{ 0.0f };
+    // The sine of the current angle
+    float mSin{ 0.0f };
+    // The cosine of the current angle
+    float mCos{ 1.0f };
+};
+
 } // namespace DGL
\ No newline at end of file
@@ -10,20 +10,73 @@ module;
 
 #include "DGL.h"
 #include <d3d11.h>
+#include <math.h>
+#include <stdint.h>
 #include <vector>
 
 module Mesh;
 
+import BufferPool;
 import Errors;
+import Math;
 import Texture;
 import GraphicsSystem;
+import Instancing;
+import StateCache;
+import UploadQueue;
 
 namespace DGL
 {
+//----------------------------------------------------------------------------------- D3DMapContext
+
+//*************************************************************************************************
+void D3DMapContext::Initialize(ID3D11DeviceContext* deviceContext)
+{
+    mDeviceContext = deviceContext;
+}
+
+//*************************************************************************************************
+HRESULT D3DMapContext::Map(ID3D11Buffer* buffer, D3D11_MAP mapType,
+    D3D11_MAPPED_SUBRESOURCE* mappedResource)
+{
+    return mDeviceContext->Map(buffer, 0, mapType, 0, mappedResource);
+}
+
+//*************************************************************************************************
+void D3DMapContext::Unmap(ID3D11Buffer* buffer)
+{
+    mDeviceContext->Unmap(buffer, 0);
+}
+
 //------------------------------------------------------------------------------------- MeshManager
 
 //*************************************************************************************************
-DGL_Mesh* MeshManager::CreateMesh(ID3D11Device* device)
+void MeshManager::Initialize(ID3D11Device* device, UploadQueue* uploads)
+{
+    for (unsigned format = 0; format < vertex_format_count; ++format)
+    {
+        unsigned stride = GetVertexStride((DGL_VertexFormat)format);
+        mVertexPools[format].Initialize(device, uploads, D3D11_BIND_VERTEX_BUFFER, stride,
+            vertex_page_bytes / stride);
+    }
+
+    GetIndexPool(DXGI_FORMAT_R16_UINT).Initialize(device, uploads, D3D11_BIND_INDEX_BUFFER,
+        sizeof(uint16_t), index_page_bytes / sizeof(uint16_t));
+    GetIndexPool(DXGI_FORMAT_R32_UINT).Initialize(device, uploads, D3D11_BIND_INDEX_BUFFER,
+        sizeof(unsigned), index_page_bytes / sizeof(unsigned));
+}
+
+//*************************************************************************************************
+void MeshManager::Release()
+{
+    for (BufferPool& pool : mVertexPools)
+        pool.Release();
+    for (BufferPool& pool : mIndexPools)
+        pool.Release();
+}
+
+//*************************************************************************************************
+DGL_Mesh* MeshManager::CreateMesh(const DGL_MeshBuilder& builder, ID3D11Device* device)
 {
     if (!device)
     {
@@ -31,8 +84,10 @@ DGL_Mesh* MeshManager::CreateMesh(ID3D11Device* device)
         return nullptr;
     }
 
+    const std::vector<VertexData>& vertexList = builder.mVertexList;
+
     // Check to make sure there are vertices in the list
-    if (mVertexList.size() == 0)
+    if (vertexList.size() == 0)
     {
         gError->SetError("Couldn't create mesh, no vertices added.");
         return nullptr;
@@ -42,29 +97,112 @@ DGL_Mesh* MeshManager::CreateMesh(ID3D11Device* device)
     DGL_Mesh* newMesh = new DGL_Mesh;
 
     // Save the number of vertices
-    newMesh->mVertexCount = (unsigned)mVertexList.size();
-    // Copy the vertices into the mesh's list
-    newMesh->mVertexList = new VertexData[newMesh->mVertexCount];
-    memcpy(newMesh->mVertexList, mVertexList.data(), sizeof(VertexData) * newMesh->mVertexCount);
+    newMesh->mVertexCount = (unsigned)vertexList.size();
+
+    // The bounds are always kept, so culling works even if the vertices aren't
+    CalculateBounds(vertexList.data(), newMesh->mVertexCount, newMesh->mBounds);
+
+    // Smaller formats are converted from the full vertex data, which the mesh still keeps
+    DGL_VertexFormat format = builder.mVertexFormat;
+    newMesh->mVertexFormat = format;
+    newMesh->mVertexStride = GetVertexStride(format);
+    char* converted = nullptr;
+    if (format != DGL_VF_DEFAULT)
+    {
+        converted = new char[(size_t)newMesh->mVertexStride * newMesh->mVertexCount];
+        ConvertVertices(vertexList.data(), newMesh->mVertexCount, format, converted);
+    }
+
+    // Copy the vertices into a block of one of the shared vertex buffers for the format
+    const void* vertexData = converted ? (const void*)converted : (const void*)vertexList.data();
+    bool allocated = mVertexPools[format].Allocate(vertexData, newMesh->mVertexCount,
+        newMesh->mVertexPage, newMesh->mBaseVertex, newMesh->mVertexBuffer);
+    delete[] converted;
+    if (!allocated)
+    {
+        // The pool has set the error message, so just delete the mesh
+        ReleaseMesh(newMesh);
+        return nullptr;
+    }
+
+    // Keep as much of the vertex data on the CPU as the retention asks for
+    newMesh->mRetention = GetRetention(newMesh->mVertexCount);
+    if (newMesh->mRetention == DGL_MR_ALL)
+    {
+        newMesh->mVertexList = new VertexData[newMesh->mVertexCount];
+        memcpy(newMesh->mVertexList, vertexList.data(), sizeof(VertexData) * newMesh->mVertexCount);
+    }
+    else if (newMesh->mRetention == DGL_MR_POSITIONS)
+    {
+        newMesh->mPositions = new DGL_Vec2[newMesh->mVertexCount];
+        for (unsigned i = 0; i < newMesh->mVertexCount; ++i)
+            newMesh->mPositions[i] = vertexList[i].mPosition;
+    }
+
+    return newMesh;
+}
+
+//*************************************************************************************************
+DGL_Mesh* MeshManager::CreateMeshIndexed(const DGL_MeshBuilder& builder, const unsigned* indices,
+    unsigned indexCount, ID3D11Device* device)
+{
+    // Make sure every index refers to a vertex before creating anything
+    unsigned maxIndex = indices ? Index_FindMax(indices, indexCount) : 0;
+    if (!CheckIndices(indices, indexCount, maxIndex, (unsigned)builder.mVertexList.size(), device))
+        return nullptr;
+
+    return CreateMeshIndexed(builder, indices, nullptr, indexCount, maxIndex, device);
+}
+
+//*************************************************************************************************
+DGL_Mesh* MeshManager::CreateMeshIndexed16(const DGL_MeshBuilder& builder,
+    const uint16_t* indices, unsigned indexCount, ID3D11Device* device)
+{
+    // Make sure every index refers to a vertex before creating anything
+    unsigned maxIndex = indices ? Index_FindMax16(indices, indexCount) : 0;
+    if (!CheckIndices(indices, indexCount, maxIndex, (unsigned)builder.mVertexList.size(), device))
+        return nullptr;
+
+    return CreateMeshIndexed(builder, nullptr, indices, indexCount, maxIndex, device);
+}
+
+//*************************************************************************************************
+DGL_Mesh* MeshManager::CreateDynamicMesh(unsigned capacity, ID3D11Device* device)
+{
+    if (!device)
+    {
+        gError->SetError("Trying to create mesh when Graphics is not initialized.");
+        return nullptr;
+    }
+
+    // Make sure every copy of the vertices fits in one buffer
+    if (capacity == 0 || capacity > 0xFFFFFFFF / (dynamic_copies * sizeof(VertexData)))
+    {
+        gError->SetError("Couldn't create dynamic mesh, the capacity is 0 or too large.");
+        return nullptr;
+    }
+
+    // Create the new mesh object
+    DGL_Mesh* newMesh = new DGL_Mesh;
+    newMesh->mDynamicCapacity = capacity;
+
+    // The first update wraps around to the first copy, which discards the new buffer
+    newMesh->mDynamicCopy = dynamic_copies - 1;
+
+    // The mesh always keeps all of its vertices, since an update can replace only some of them
+    newMesh->mVertexList = new VertexData[capacity];
 
     // Set up the vertex buffer description struct
     D3D11_BUFFER_DESC vertexBufferDesc = { 0 };
-    vertexBufferDesc.ByteWidth = sizeof(VertexData) * newMesh->mVertexCount;
-    vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    vertexBufferDesc.ByteWidth = sizeof(VertexData) * capacity * dynamic_copies;
+    vertexBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
     vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    // Set up the subresource data struct
-    D3D11_SUBRESOURCE_DATA srData = { 0 };
-    srData.pSysMem = newMesh->mVertexList;
+    vertexBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
     // Create the vertex buffer
-    HRESULT hr = device->CreateBuffer(
-        &vertexBufferDesc,
-        &srData,
-        &newMesh->mVertexBuffer
-    );
+    HRESULT hr = device->CreateBuffer(&vertexBufferDesc, NULL, &newMesh->mVertexBuffer);
     if (FAILED(hr))
     {
-        // If there was a problem, set the error message and delete the mesh
-        gError->SetError("Problem creating vertex buffer for mesh. ", hr);
+        gError->SetError("Problem creating dynamic vertex buffer. ", hr);
         ReleaseMesh(newMesh);
         return nullptr;
     }
@@ -73,103 +211,489 @@ DGL_Mesh* MeshManager::CreateMesh(ID3D11Device* device)
 }
 
 //*************************************************************************************************
-DGL_Mesh* MeshManager::CreateMeshIndexed(unsigned* indices, unsigned indexCount, ID3D11Device* device)
+const char* MeshManager::CheckUpdate(const DGL_Mesh* mesh, const DGL_Vec2* positions,
+    unsigned count, unsigned offset)
+{
+    if (!mesh || (!positions && count))
+        return "Passed in a null parameter to DGL_Graphics_UpdateMesh.";
+
+    if (!mesh->mDynamicCapacity)
+        return "Called DGL_Graphics_UpdateMesh with a mesh not made by DGL_Graphics_CreateDynamicMesh.";
+
+    // Leaving a gap would draw vertices that were never set
+    if (offset > mesh->mVertexCount || count > mesh->mDynamicCapacity - offset)
+        return "Couldn't update mesh, the vertices are past the end of the mesh or its capacity.";
+
+    return nullptr;
+}
+
+//*************************************************************************************************
+bool MeshManager::UpdateMesh(DGL_Mesh* mesh, const DGL_Vec2* positions, const DGL_Color* colors,
+    const DGL_Vec2* texCoords, unsigned count, unsigned offset, MapContext* context)
+{
+    // Write the new vertices into the list, which always holds the whole mesh
+    CopyVertices(mesh->mVertexList + offset, positions, 0, colors, 0, texCoords, 0, count);
+    mesh->mVertexCount = offset + count;
+
+    if (mesh->mVertexCount)
+        CalculateBounds(mesh->mVertexList, mesh->mVertexCount, mesh->mBounds);
+    else
+        mesh->mBounds = {};
+
+    // Write the whole mesh into the next copy, since it still holds older vertices. Copies the
+    // graphics card might be reading are never written over, and the buffer is only discarded
+    // when wrapping around, so the CPU never waits for the graphics card.
+    unsigned copy = (mesh->mDynamicCopy + 1) % dynamic_copies;
+    D3D11_MAP mapType = copy == 0 ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    HRESULT hr = context->Map(mesh->mVertexBuffer, mapType, &mappedResource);
+    if (FAILED(hr))
+    {
+        gError->SetError("Problem mapping dynamic vertex buffer. ", hr);
+        return false;
+    }
+    VertexData* copyStart = (VertexData*)mappedResource.pData + (size_t)copy * mesh->mDynamicCapacity;
+    memcpy(copyStart, mesh->mVertexList, sizeof(VertexData) * mesh->mVertexCount);
+    context->Unmap(mesh->mVertexBuffer);
+
+    // Draw from the new copy
+    mesh->mDynamicCopy = copy;
+    mesh->mBaseVertex = copy * mesh->mDynamicCapacity;
+
+    return true;
+}
+
+//*************************************************************************************************
+void MeshManager::ReleaseMesh(DGL_Mesh* mesh)
+{
+    if (!mesh)
+        return;
+
+    // Free the blocks of the shared buffers, or release the mesh's own buffers
+    if (mesh->mVertexPage != BufferPool::no_page)
+        mVertexPools[mesh->mVertexFormat].Free(mesh->mVertexPage, mesh->mBaseVertex,
+            mesh->mVertexCount);
+    else if (mesh->mVertexBuffer)
+        mesh->mVertexBuffer->Release();
+    if (mesh->mIndexPage != BufferPool::no_page)
+        GetIndexPool(mesh->mIndexFormat).Free(mesh->mIndexPage, mesh->mStartIndex,
+            mesh->mIndexCount);
+    else if (mesh->mIndexBuffer)
+        mesh->mIndexBuffer->Release();
+
+    // Delete the lists, if necessary
+    delete[] mesh->mVertexList;
+    delete[] mesh->mPositions;
+    delete[] mesh->mIndices;
+
+    // Delete the DGL mesh
+    delete mesh;
+}
+
+//*************************************************************************************************
+void MeshManager::Draw(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture, 
+    ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, 
+    const cbPerObject& constantBuffer, StateCache* stateCache)
+{
+    if (!stateCache)
+    {
+        gError->SetError("Trying to draw mesh when Graphics is not initialized.");
+        return;
+    }
+
+    // Set the input layout, topology, shaders, texture, vertex buffer, and constant buffer
+    SetDrawState(mesh, mode, texture, vertexShader, pixelShader, constantBuffer, false, stateCache);
+
+    // If the mesh is not indexed, draw it normally. The vertex and index buffers may be shared
+    // with other meshes, so start at this mesh's part of them.
+    if (mesh->mIndexCount == 0)
+        stateCache->Draw(mesh->mVertexCount, mesh->mBaseVertex);
+    else
+    {
+        // Set the index buffer
+        stateCache->SetIndexBuffer(mesh->mIndexBuffer, mesh->mIndexFormat, 0);
+        // Draw the indexed mesh
+        stateCache->DrawIndexed(mesh->mIndexCount, mesh->mStartIndex, mesh->mBaseVertex);
+    }
+}
+
+//*************************************************************************************************
+void MeshManager::DrawInstanced(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+    ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+    const cbPerObject& constantBuffer, ID3D11Buffer* instanceBuffer, unsigned instanceCount,
+    StateCache* stateCache)
+{
+    if (!stateCache)
+    {
+        gError->SetError("Trying to draw mesh when Graphics is not initialized.");
+        return;
+    }
+
+    // Set the input layout, topology, shaders, texture, vertex buffer, and constant buffer
+    SetDrawState(mesh, mode, texture, vertexShader, pixelShader, constantBuffer, true, stateCache);
+
+    // Set the instance buffer in the second slot
+    stateCache->SetVertexBuffer(1, instanceBuffer, InstanceBuffer::instance_stride,
+        InstanceBuffer::instance_offset);
+
+    // If the mesh is not indexed, draw it normally
+    if (mesh->mIndexCount == 0)
+        stateCache->DrawInstanced(mesh->mVertexCount, instanceCount, mesh->mBaseVertex);
+    else
+    {
+        // Set the index buffer
+        stateCache->SetIndexBuffer(mesh->mIndexBuffer, mesh->mIndexFormat, 0);
+        // Draw the indexed mesh
+        stateCache->DrawIndexedInstanced(mesh->mIndexCount, instanceCount, mesh->mStartIndex,
+            mesh->mBaseVertex);
+    }
+}
+
+//*************************************************************************************************
+void MeshManager::CopyVertices(VertexData* vertices, const DGL_Vec2* positions,
+    unsigned positionStride, const DGL_Color* colors, unsigned colorStride,
+    const DGL_Vec2* texCoords, unsigned texCoordStride, unsigned count)
+{
+    if (!positionStride)
+        positionStride = sizeof(DGL_Vec2);
+    if (!colorStride)
+        colorStride = sizeof(DGL_Color);
+    if (!texCoordStride)
+        texCoordStride = sizeof(DGL_Vec2);
+
+    VertexData* vertex = vertices;
+    const char* position = (const char*)positions;
+    const char* color = (const char*)colors;
+    const char* texCoord = (const char*)texCoords;
+
+    for (unsigned i = 0; i < count; ++i, ++vertex)
+    {
+        vertex->mPosition = *(const DGL_Vec2*)position;
+        vertex->mColor = color ? *(const DGL_Color*)color : default_color;
+        vertex->mTexCoord = texCoord ? *(const DGL_Vec2*)texCoord : default_tex_coord;
+
+        position += positionStride;
+        if (color)
+            color += colorStride;
+        if (texCoord)
+            texCoord += texCoordStride;
+    }
+}
+
+//*************************************************************************************************
+bool MeshManager::CheckIndices(const void* indices, unsigned indexCount, unsigned maxIndex,
+    unsigned vertexCount, ID3D11Device* device)
 {
     if (!device)
     {
         gError->SetError("Trying to create mesh when Graphics is not initialized.");
-        return nullptr;
+        return false;
     }
 
     // Make sure there are indices to use
-    if (indexCount == 0)
+    if (!indices || indexCount == 0)
     {
         gError->SetError("Couldn't create indexed mesh, no indexes.");
-        return nullptr;
+        return false;
+    }
+
+    // If there are no vertices, creating the mesh will set the error
+    if (vertexCount && maxIndex >= vertexCount)
+    {
+        gError->SetError("Couldn't create indexed mesh, an index is larger than the number of vertices.");
+        return false;
     }
 
+    return true;
+}
+
+//*************************************************************************************************
+DGL_Mesh* MeshManager::CreateMeshIndexed(const DGL_MeshBuilder& builder, const unsigned* indices,
+    const uint16_t* shortIndices, unsigned indexCount, unsigned maxIndex, ID3D11Device* device)
+{
     // Create the basic mesh
-    DGL_Mesh* newMesh = MeshManager::CreateMesh(device);
+    DGL_Mesh* newMesh = MeshManager::CreateMesh(builder, device);
     if (!newMesh)
         return nullptr;
 
-    // Save the indices
     newMesh->mIndexCount = indexCount;
-    newMesh->mIndices = new unsigned[indexCount];
-    memcpy(newMesh->mIndices, indices, sizeof(unsigned) * indexCount);
-
-    // Set up the index buffer description struct
-    D3D11_BUFFER_DESC indexBufferDesc = { 0 };
-    indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned) * indexCount;
-    indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    indexBufferDesc.CPUAccessFlags = 0;
-    indexBufferDesc.MiscFlags = 0;
-    // Set up the subresource data struct
-    D3D11_SUBRESOURCE_DATA srData = { 0 };
-    srData.pSysMem = indices;
-    // Create the index buffer
-    HRESULT hr = device->CreateBuffer(&indexBufferDesc, &srData, &newMesh->mIndexBuffer);
-    if (FAILED(hr))
+
+    // Use 16-bit indices if they all fit, which halves the size of the index buffer. The
+    // indices are uploaded straight from the provided array when it has the right size.
+    uint16_t* narrowed = nullptr;
+    unsigned* widened = nullptr;
+    const void* indexData = indices;
+    newMesh->mIndexFormat = DXGI_FORMAT_R32_UINT;
+    if (maxIndex < max_16bit_index)
+    {
+        if (!shortIndices)
+        {
+            narrowed = new uint16_t[indexCount];
+            Index_Narrow(indices, narrowed, indexCount);
+        }
+        indexData = shortIndices ? (const void*)shortIndices : (const void*)narrowed;
+        newMesh->mIndexFormat = DXGI_FORMAT_R16_UINT;
+    }
+    else if (shortIndices)
     {
-        // If there was a problem, set the error message and delete the mesh
-        gError->SetError("Problem creating index buffer for mesh. ", hr);
+        // The largest 16-bit value can only be used as an index when stored as 32 bits
+        widened = new unsigned[indexCount];
+        for (unsigned i = 0; i < indexCount; ++i)
+            widened[i] = shortIndices[i];
+        indexData = widened;
+    }
+
+    // Copy the indices into a block of one of the shared index buffers for the format
+    bool allocated = GetIndexPool(newMesh->mIndexFormat).Allocate(indexData, indexCount,
+        newMesh->mIndexPage, newMesh->mStartIndex, newMesh->mIndexBuffer);
+    delete[] narrowed;
+    delete[] widened;
+    if (!allocated)
+    {
+        // The pool has set the error message, so just delete the mesh
         ReleaseMesh(newMesh);
         return nullptr;
     }
 
+    // Keep the indices on the CPU along with any of the vertex data
+    if (newMesh->mRetention != DGL_MR_NONE)
+    {
+        newMesh->mIndices = new unsigned[indexCount];
+        if (indices)
+            memcpy(newMesh->mIndices, indices, sizeof(unsigned) * indexCount);
+        else
+        {
+            for (unsigned i = 0; i < indexCount; ++i)
+                newMesh->mIndices[i] = shortIndices[i];
+        }
+    }
+
     return newMesh;
 }
 
 //*************************************************************************************************
-void MeshManager::ReleaseMesh(DGL_Mesh* mesh)
+void MeshManager::TrimMesh(DGL_Mesh* mesh, DGL_MeshRetention retention)
 {
-    if (!mesh)
+    if (retention >= mesh->mRetention)
         return;
 
-    // Release the vertex and index buffers (if they exist)
-    if (mesh->mVertexBuffer) 
-        mesh->mVertexBuffer->Release();
-    if (mesh->mIndexBuffer) 
-        mesh->mIndexBuffer->Release();
+    // Keep the positions from the full vertex data if they are still needed
+    if (mesh->mVertexList)
+    {
+        if (retention == DGL_MR_POSITIONS)
+        {
+            mesh->mPositions = new DGL_Vec2[mesh->mVertexCount];
+            for (unsigned i = 0; i < mesh->mVertexCount; ++i)
+                mesh->mPositions[i] = mesh->mVertexList[i].mPosition;
+        }
 
-    // Delete the lists, if necessary
+        delete[] mesh->mVertexList;
+        mesh->mVertexList = nullptr;
+    }
+
+    if (retention == DGL_MR_NONE)
+    {
+        delete[] mesh->mPositions;
+        mesh->mPositions = nullptr;
+        delete[] mesh->mIndices;
+        mesh->mIndices = nullptr;
+    }
+
+    mesh->mRetention = retention;
+}
+
+//*************************************************************************************************
+unsigned MeshManager::GetPositions(const DGL_Mesh* mesh, DGL_Vec2* positions, unsigned maxCount)
+{
+    if (!mesh->mVertexList && !mesh->mPositions)
+        return 0;
+
+    if (positions)
+    {
+        unsigned count = mesh->mVertexCount < maxCount ? mesh->mVertexCount : maxCount;
+        for (unsigned i = 0; i < count; ++i)
+            positions[i] = mesh->mPositions ? mesh->mPositions[i] : mesh->mVertexList[i].mPosition;
+    }
+
+    return mesh->mVertexCount;
+}
+
+//*************************************************************************************************
+unsigned MeshManager::GetIndices(const DGL_Mesh* mesh, unsigned* indices, unsigned maxCount)
+{
+    if (!mesh->mIndices)
+        return 0;
+
+    if (indices)
+    {
+        unsigned count = mesh->mIndexCount < maxCount ? mesh->mIndexCount : maxCount;
+        memcpy(indices, mesh->mIndices, sizeof(unsigned) * count);
+    }
+
+    return mesh->mIndexCount;
+}
+
+//*************************************************************************************************
+unsigned long long MeshManager::GetCPUBytes(const DGL_Mesh* mesh)
+{
+    // A dynamic mesh's list is large enough for its whole capacity
+    unsigned listCount = mesh->mDynamicCapacity ? mesh->mDynamicCapacity : mesh->mVertexCount;
+
+    unsigned long long bytes = 0;
     if (mesh->mVertexList)
-        delete mesh->mVertexList;
+        bytes += (unsigned long long)sizeof(VertexData) * listCount;
+    if (mesh->mPositions)
+        bytes += (unsigned long long)sizeof(DGL_Vec2) * mesh->mVertexCount;
     if (mesh->mIndices)
-        delete mesh->mIndices;
+        bytes += (unsigned long long)sizeof(unsigned) * mesh->mIndexCount;
 
-    // Delete the DGL mesh
-    delete mesh;
+    return bytes;
 }
 
 //*************************************************************************************************
-void MeshManager::Draw(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture, 
-    ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, ID3D11DeviceContext* deviceContext)
+void MeshManager::GetBufferStats(DGL_MeshBufferStats* stats) const
 {
-    if (!deviceContext)
+    *stats = {};
+
+    for (const BufferPool& pool : mVertexPools)
+        pool.AddStats(*stats);
+    for (const BufferPool& pool : mIndexPools)
+        pool.AddStats(*stats);
+}
+
+//*************************************************************************************************
+unsigned MeshManager::GetIndexSize(DXGI_FORMAT format)
+{
+    return format == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(unsigned);
+}
+
+//*************************************************************************************************
+unsigned MeshManager::GetBufferVertexCount(const DGL_Mesh* mesh)
+{
+    if (mesh->mDynamicCapacity)
+        return mesh->mDynamicCapacity * dynamic_copies;
+
+    return mesh->mVertexCount;
+}
+
+//*************************************************************************************************
+unsigned MeshManager::GetVertexStride(DGL_VertexFormat format)
+{
+    switch (format)
     {
-        gError->SetError("Trying to draw mesh when Graphics is not initialized.");
+    case DGL_VF_COLOR8:
+        return sizeof(VertexDataColor8);
+    case DGL_VF_COLOR8_UVHALF:
+    case DGL_VF_COLOR8_UVUNORM16:
+        return sizeof(VertexDataCompact);
+    default:
+        return sizeof(VertexData);
+    }
+}
+
+//*************************************************************************************************
+DGL_MeshRetention MeshManager::GetRetention(unsigned vertexCount) const
+{
+    // Features that read the vertices on the CPU can ask for small meshes to keep everything
+    if (vertexCount <= mKeepAllMaxVertices)
+        return DGL_MR_ALL;
+
+    return mRetention;
+}
+
+//*************************************************************************************************
+void MeshManager::CalculateBounds(const VertexData* vertices, unsigned count,
+    DGL_MeshBounds& bounds)
+{
+    // Find the smallest and largest X and Y values
+    bounds.mMin = vertices[0].mPosition;
+    bounds.mMax = vertices[0].mPosition;
+    for (unsigned i = 1; i < count; ++i)
+    {
+        const DGL_Vec2& position = vertices[i].mPosition;
+        bounds.mMin.x = fminf(bounds.mMin.x, position.x);
+        bounds.mMin.y = fminf(bounds.mMin.y, position.y);
+        bounds.mMax.x = fmaxf(bounds.mMax.x, position.x);
+        bounds.mMax.y = fmaxf(bounds.mMax.y, position.y);
+    }
+
+    // Center the circle on the box and make it large enough to reach the farthest vertex
+    bounds.mCenter = { (bounds.mMin.x + bounds.mMax.x) * 0.5f, (bounds.mMin.y + bounds.mMax.y) * 0.5f };
+    float radiusSquared = 0.0f;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float x = vertices[i].mPosition.x - bounds.mCenter.x;
+        float y = vertices[i].mPosition.y - bounds.mCenter.y;
+        radiusSquared = fmaxf(radiusSquared, x * x + y * y);
+    }
+    bounds.mRadius = sqrtf(radiusSquared);
+}
+
+//*************************************************************************************************
+void MeshManager::ConvertVertices(const VertexData* vertices, unsigned count,
+    DGL_VertexFormat format, void* results)
+{
+    if (format == DGL_VF_COLOR8)
+    {
+        VertexDataColor8* result = (VertexDataColor8*)results;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            result[i].mPosition = vertices[i].mPosition;
+            result[i].mTexCoord = vertices[i].mTexCoord;
+        }
+
+        Pack_ColorsUnorm8(&vertices[0].mColor, sizeof(VertexData), &result[0].mColor,
+            sizeof(VertexDataColor8), count);
         return;
     }
 
+    VertexDataCompact* result = (VertexDataCompact*)results;
+    for (unsigned i = 0; i < count; ++i)
+        result[i].mPosition = vertices[i].mPosition;
+
+    Pack_ColorsUnorm8(&vertices[0].mColor, sizeof(VertexData), &result[0].mColor,
+        sizeof(VertexDataCompact), count);
+
+    if (format == DGL_VF_COLOR8_UVHALF)
+        Pack_Vec2Half(&vertices[0].mTexCoord, sizeof(VertexData), &result[0].mTexCoord,
+            sizeof(VertexDataCompact), count);
+    else
+        Pack_Vec2Unorm16(&vertices[0].mTexCoord, sizeof(VertexData), &result[0].mTexCoord,
+            sizeof(VertexDataCompact), count);
+}
+
+//*************************************************************************************************
+BufferPool& MeshManager::GetIndexPool(DXGI_FORMAT format)
+{
+    return mIndexPools[format == DXGI_FORMAT_R16_UINT ? 0 : 1];
+}
+
+//*************************************************************************************************
+void MeshManager::SetDrawState(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+    ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+    const cbPerObject& constantBuffer, bool instanced, StateCache* stateCache)
+{
+    // Set the input layout for the vertex format and the type of draw
+    gGraphics->D3D.SetInputLayout(mesh->mVertexFormat, instanced);
+
     // Set the primitive topology setting as specified
     switch (mode)
     {
     case DGL_DM_TRIANGLELIST:
-        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         break;
     case DGL_DM_LINELIST:
-        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+        stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
         break;
     case DGL_DM_LINESTRIP:
-        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
+        stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
         break;
     case DGL_DM_POINTLIST:
-        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+        stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
         break;
     case DGL_DM_TRIANGLESTRIP:
-        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
         break;
     default:
         gError->SetError("Passed in an invalid DGL_DrawMode value to DGL_Graphics_DrawMesh.");
@@ -177,41 +701,17 @@ void MeshManager::Draw(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Textur
     }
 
     // Set the shader
-    deviceContext->VSSetShader(vertexShader, NULL, 0);
-    deviceContext->PSSetShader(pixelShader, NULL, 0);
-
-    // If there is a texture, set the shader resource
-    if (gGraphics->D3D.GetPixelShaderMode() != DGL_PSM_COLOR && texture)
-        deviceContext->PSSetShaderResources(0, 1, &(texture->texResourceView));
-    else
-    {
-        ID3D11ShaderResourceView* nullSRV = { nullptr };
-        deviceContext->PSSetShaderResources(0, 1, &nullSRV);
-    }
+    stateCache->SetVertexShader(vertexShader);
+    stateCache->SetPixelShader(pixelShader);
 
+    // If there is a texture, set the shader resource, otherwise clear it
+    stateCache->SetPixelShaderResource(texture ? texture->texResourceView : nullptr);
 
     // Set the vertex buffer
-    deviceContext->IASetVertexBuffers(
-        0,
-        1,
-        &mesh->mVertexBuffer,
-        &vertex_stride,
-        &vertex_offset
-    );
+    stateCache->SetVertexBuffer(0, mesh->mVertexBuffer, mesh->mVertexStride, vertex_offset);
 
     // Update the constant buffer data
-    gGraphics->D3D.UpdateConstantBuffer();
-
-    // If the mesh is not indexed, draw it normally
-    if (mesh->mIndexCount == 0)
-        deviceContext->Draw(mesh->mVertexCount, 0);
-    else
-    {
-        // Set the index buffer
-        deviceContext->IASetIndexBuffer(mesh->mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-        // Draw the indexed mesh
-        deviceContext->DrawIndexed(mesh->mIndexCount, 0, 0);
-    }
+    gGraphics->D3D.UpdateConstantBuffer(constantBuffer, vertexShader);
 }
 
 } // namespace DGL
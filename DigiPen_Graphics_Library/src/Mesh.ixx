@@ -10,10 +10,16 @@ module;
 
 #include "DGL.h"
 #include <d3d11.h>
+#include <stdint.h>
 #include <vector>
 
 export module Mesh;
 
+import BufferPool;
+import D3DInterface;
+import StateCache;
+import UploadQueue;
+
 export typedef struct
 {
     // The position of this vertex
@@ -24,50 +30,264 @@ export typedef struct
     DGL_Vec2 mTexCoord;
 } VertexData;
 
+// The vertex data stored on the graphics card for DGL_VF_COLOR8
+export typedef struct
+{
+    DGL_Vec2 mPosition;
+    // The color channels as 8-bit values, with red in the lowest byte
+    uint32_t mColor;
+    DGL_Vec2 mTexCoord;
+} VertexDataColor8;
+
+// The vertex data stored on the graphics card for DGL_VF_COLOR8_UVHALF and DGL_VF_COLOR8_UVUNORM16
+export typedef struct
+{
+    DGL_Vec2 mPosition;
+    // The color channels as 8-bit values, with red in the lowest byte
+    uint32_t mColor;
+    // The texture coordinates as 16-bit values, with X in the low 16 bits
+    uint32_t mTexCoord;
+} VertexDataCompact;
+
 export typedef struct DGL_Mesh
 {
-    // The list of vertex data for this mesh
+    // The list of vertex data for this mesh (will be null unless the mesh keeps all of its data)
     VertexData* mVertexList{ nullptr };
+    // The vertex positions, kept instead of the vertex data when only positions are kept
+    DGL_Vec2* mPositions{ nullptr };
     // The number of vertices in this mesh
     unsigned mVertexCount{ 0 };
-    // The array of indices for an indexed mesh (will be null for a non-indexed mesh)
+    // The array of indices for an indexed mesh (will be null for a non-indexed mesh, or if the
+    // mesh doesn't keep any data)
     unsigned* mIndices{ nullptr };
+    // How much of the data this mesh keeps on the CPU after it is created
+    DGL_MeshRetention mRetention{ DGL_MR_ALL };
     // The number of indices in the index array
     unsigned mIndexCount{ 0 };
-    // The D3D vertex buffer object
+    // The format of the data in the vertex buffer
+    DGL_VertexFormat mVertexFormat{ DGL_VF_DEFAULT };
+    // The size of each vertex in the vertex buffer
+    unsigned mVertexStride{ sizeof(VertexData) };
+    // The D3D vertex buffer object, which may be shared with other meshes
     ID3D11Buffer* mVertexBuffer{ nullptr };
-    // The D3D index buffer object
+    // The D3D index buffer object, which may be shared with other meshes
     ID3D11Buffer* mIndexBuffer{ nullptr };
+    // The format of the indices in the index buffer
+    DXGI_FORMAT mIndexFormat{ DXGI_FORMAT_R32_UINT };
+    // The position of this mesh's first vertex in the vertex buffer
+    unsigned mBaseVertex{ 0 };
+    // The position of this mesh's first index in the index buffer
+    unsigned mStartIndex{ 0 };
+    // The shared buffer pages holding the vertices and indices, or BufferPool::no_page if the
+    // mesh has its own buffers
+    unsigned mVertexPage{ DGL::BufferPool::no_page };
+    unsigned mIndexPage{ DGL::BufferPool::no_page };
+    // The number of vertices each copy in a dynamic mesh's vertex buffer can hold, or 0 if the
+    // mesh is not dynamic
+    unsigned mDynamicCapacity{ 0 };
+    // The copy in a dynamic mesh's vertex buffer that was written most recently
+    unsigned mDynamicCopy{ 0 };
+    // The box and circle around the vertex positions
+    DGL_MeshBounds mBounds{ { 0.0f, 0.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f };
 } DGL_Mesh;
 
+export typedef struct DGL_MeshBuilder
+{
+    // The vertices added so far
+    std::vector<VertexData> mVertexList;
+    // The indices added so far. The mesh is indexed if there are any.
+    std::vector<unsigned> mIndices;
+    // The format the vertex buffer will use
+    DGL_VertexFormat mVertexFormat{ DGL_VF_DEFAULT };
+    // The first problem found while adding data, or null. Builders can be filled on any thread,
+    // so this is only passed to the error handler when the mesh is created.
+    const char* mError{ nullptr };
+} DGL_MeshBuilder;
+
 namespace DGL
 {
 
+//-------------------------------------------------------------------------------------- MapContext
+
+// The device context functions used to write into a dynamic mesh's vertex buffer. Updates only
+// talk to the device context through this, so they can be checked against a version that
+// records the calls.
+export class MapContext
+{
+public:
+    virtual ~MapContext() = default;
+
+    virtual HRESULT Map(ID3D11Buffer* buffer, D3D11_MAP mapType,
+        D3D11_MAPPED_SUBRESOURCE* mappedResource) = 0;
+    virtual void Unmap(ID3D11Buffer* buffer) = 0;
+};
+
+//----------------------------------------------------------------------------------- D3DMapContext
+
+// Passes the calls straight through to a D3D device context
+export class D3DMapContext : public MapContext
+{
+public:
+    // Sets the D3D device context to use
+    void Initialize(ID3D11DeviceContext* deviceContext);
+
+    HRESULT Map(ID3D11Buffer* buffer, D3D11_MAP mapType,
+        D3D11_MAPPED_SUBRESOURCE* mappedResource) override;
+    void Unmap(ID3D11Buffer* buffer) override;
+
+private:
+    // The D3D device context object
+    ID3D11DeviceContext* mDeviceContext{ nullptr };
+};
+
 //------------------------------------------------------------------------------------- MeshManager
 
 export class MeshManager
 {
 public:
+    // Sets up the shared vertex and index buffers that new meshes are stored in, which are
+    // filled through the upload queue
+    void Initialize(ID3D11Device* device, UploadQueue* uploads);
+
+    // Releases the shared buffers
+    void Release();
 
-    // Creates a new mesh based on the current vertices in the list
-    DGL_Mesh* CreateMesh(ID3D11Device* device);
+    // Creates a new mesh based on the builder's vertices and format. The builder's indices are
+    // not used.
+    DGL_Mesh* CreateMesh(const DGL_MeshBuilder& builder, ID3D11Device* device);
 
-    // Creates a new indexed mesh based on the current vertices in the list 
+    // Creates a new indexed mesh based on the builder's vertices and format
     // and the provided index list
-    DGL_Mesh* CreateMeshIndexed(unsigned* indices, unsigned indexCount, ID3D11Device* device);
+    DGL_Mesh* CreateMeshIndexed(const DGL_MeshBuilder& builder, const unsigned* indices,
+        unsigned indexCount, ID3D11Device* device);
+
+    // Creates a new indexed mesh based on the builder's vertices and format
+    // and the provided list of 16-bit indices
+    DGL_Mesh* CreateMeshIndexed16(const DGL_MeshBuilder& builder, const uint16_t* indices,
+        unsigned indexCount, ID3D11Device* device);
+
+    // Creates a mesh with its own dynamic vertex buffer which can hold the number of vertices.
+    // The mesh starts with no vertices.
+    DGL_Mesh* CreateDynamicMesh(unsigned capacity, ID3D11Device* device);
+
+    // Returns the problem with updating the mesh with these values, or null if there isn't one
+    static const char* CheckUpdate(const DGL_Mesh* mesh, const DGL_Vec2* positions,
+        unsigned count, unsigned offset);
+
+    // Replaces the dynamic mesh's vertices starting at the offset, and removes any vertices after
+    // the new ones. The colors and texture coordinates can be null, the same as CopyVertices.
+    static bool UpdateMesh(DGL_Mesh* mesh, const DGL_Vec2* positions, const DGL_Color* colors,
+        const DGL_Vec2* texCoords, unsigned count, unsigned offset, MapContext* context);
 
     // Releases the data in the provided mesh and deletes the mesh object
-    static void ReleaseMesh(DGL_Mesh* mesh);
+    void ReleaseMesh(DGL_Mesh* mesh);
+
+    // Fills in the stats for the shared buffers
+    void GetBufferStats(DGL_MeshBufferStats* stats) const;
+
+    // Deletes any of the mesh's CPU data that the retention doesn't keep. Data that has
+    // already been deleted can't be brought back.
+    static void TrimMesh(DGL_Mesh* mesh, DGL_MeshRetention retention);
+
+    // Returns the size of the data the mesh keeps on the CPU
+    static unsigned long long GetCPUBytes(const DGL_Mesh* mesh);
+
+    // Copies up to maxCount of the mesh's vertex positions into the array, if it is not null.
+    // Returns the number of vertices, or 0 if the mesh didn't keep its positions.
+    static unsigned GetPositions(const DGL_Mesh* mesh, DGL_Vec2* positions, unsigned maxCount);
 
-    // Draws the mesh with the provided mode, texture, and shader
+    // Copies up to maxCount of the mesh's indices into the array, if it is not null.
+    // Returns the number of indices, or 0 if the mesh has no indices or didn't keep them.
+    static unsigned GetIndices(const DGL_Mesh* mesh, unsigned* indices, unsigned maxCount);
+
+    // Writes vertices into the array, reading each value from its array with the provided stride
+    // in bytes. A stride of 0 means the values are right next to each other. If the colors or 
+    // texture coordinates are null, the default values are used for every vertex.
+    static void CopyVertices(VertexData* vertices, const DGL_Vec2* positions,
+        unsigned positionStride, const DGL_Color* colors, unsigned colorStride,
+        const DGL_Vec2* texCoords, unsigned texCoordStride, unsigned count);
+
+    // Draws the mesh with the provided mode, texture, shader, and constant buffer data
+    // If the texture is null, no texture will be bound
     static void Draw(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
-        ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, ID3D11DeviceContext* deviceContext);
+        ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, 
+        const cbPerObject& constantBuffer, StateCache* stateCache);
 
-    // List of vertex data to use when creating a new mesh
-    std::vector<VertexData> mVertexList;
+    // Draws the mesh once for each instance in the instance buffer
+    // The vertex shader must be the instanced vertex shader
+    static void DrawInstanced(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+        ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+        const cbPerObject& constantBuffer, ID3D11Buffer* instanceBuffer, unsigned instanceCount,
+        StateCache* stateCache);
+
+    // Returns the size of each vertex stored in the format
+    static unsigned GetVertexStride(DGL_VertexFormat format);
+
+    // Returns the size of each index stored in the format
+    static unsigned GetIndexSize(DXGI_FORMAT format);
+
+    // Returns the number of vertices the mesh's part of its vertex buffer holds
+    static unsigned GetBufferVertexCount(const DGL_Mesh* mesh);
+
+    // How much data new meshes keep on the CPU
+    DGL_MeshRetention mRetention{ DGL_MR_ALL };
+
+    // New meshes with at most this many vertices keep all of their data, whatever the
+    // retention. Features which read the vertices on the CPU raise this while they are on.
+    unsigned mKeepAllMaxVertices{ 0 };
 
-    static constexpr UINT vertex_stride{ sizeof(VertexData) };
     static constexpr UINT vertex_offset{ 0 };
+
+    // The size of each shared buffer, unless a mesh needs a larger one
+    static constexpr unsigned vertex_page_bytes{ 4 * 1024 * 1024 };
+    static constexpr unsigned index_page_bytes{ 1024 * 1024 };
+
+    // Index buffers use 16-bit indices when every index is less than this. Strips treat the
+    // largest 16-bit value as a cut, so it can't be used as a normal index.
+    static constexpr unsigned max_16bit_index{ 0xFFFF };
+
+    // The number of copies of the vertices in a dynamic mesh's vertex buffer. Each update writes
+    // the next copy without waiting for the graphics card, and the buffer is only discarded when
+    // the updates wrap around to the first copy.
+    static constexpr unsigned dynamic_copies{ 3 };
+
+    // The values used when colors or texture coordinates are not provided
+    static constexpr DGL_Color default_color{ 1.0f, 1.0f, 1.0f, 1.0f };
+    static constexpr DGL_Vec2 default_tex_coord{ 0.0f, 0.0f };
+
+private:
+    // Returns false and sets an error if there are no indices or any index is too large
+    static bool CheckIndices(const void* indices, unsigned indexCount, unsigned maxIndex,
+        unsigned vertexCount, ID3D11Device* device);
+
+    // Creates the mesh and its index buffer after the indices have been checked. Only one of
+    // the index arrays should be provided. The index buffer uses 16-bit indices if they fit.
+    DGL_Mesh* CreateMeshIndexed(const DGL_MeshBuilder& builder, const unsigned* indices,
+        const uint16_t* shortIndices, unsigned indexCount, unsigned maxIndex,
+        ID3D11Device* device);
+
+    // Returns how much data a new mesh with the number of vertices should keep
+    DGL_MeshRetention GetRetention(unsigned vertexCount) const;
+
+    // Finds the box and circle around the vertex positions
+    static void CalculateBounds(const VertexData* vertices, unsigned count, DGL_MeshBounds& bounds);
+
+    // Converts the vertices to the format, writing them into the results array
+    static void ConvertVertices(const VertexData* vertices, unsigned count,
+        DGL_VertexFormat format, void* results);
+
+    // Sets everything through the state cache needed to draw the mesh, except the index buffer
+    static void SetDrawState(const DGL_Mesh* mesh, DGL_DrawMode mode, const DGL_Texture* texture,
+        ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader,
+        const cbPerObject& constantBuffer, bool instanced, StateCache* stateCache);
+
+    // Returns the pool for index buffers in the format
+    BufferPool& GetIndexPool(DXGI_FORMAT format);
+
+    // The shared vertex buffers for each vertex format
+    BufferPool mVertexPools[vertex_format_count];
+    // The shared index buffers for 16-bit and 32-bit indices
+    BufferPool mIndexPools[2];
 };
 
 } // namespace DGL
\ No newline at end of file
@@ -0,0 +1,235 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshBuilder.cpp
+// author:  Andy Ellinger
+// brief:   Filling lists of vertices and indices for new meshes on any thread
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <vector>
+
+module MeshBuilder;
+
+import D3DInterface;
+import Mesh;
+import MeshOptimizer;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------- MeshBuilder
+
+//*************************************************************************************************
+void MeshBuilder::Reset(DGL_MeshBuilder& builder, DGL_VertexFormat format)
+{
+    builder.mVertexList.clear();
+    builder.mIndices.clear();
+    builder.mVertexFormat = format;
+    builder.mError = nullptr;
+}
+
+//*************************************************************************************************
+void MeshBuilder::AddVertices(DGL_MeshBuilder& builder, const DGL_Vec2* positions,
+    unsigned positionStride, const DGL_Color* colors, unsigned colorStride,
+    const DGL_Vec2* texCoords, unsigned texCoordStride, unsigned count)
+{
+    // Grow the list once and write the vertices straight into it
+    std::vector<VertexData>& vertexList = builder.mVertexList;
+    size_t start = vertexList.size();
+    vertexList.resize(start + count);
+    MeshManager::CopyVertices(vertexList.data() + start, positions, positionStride, colors,
+        colorStride, texCoords, texCoordStride, count);
+}
+
+//*************************************************************************************************
+void MeshBuilder::AddQuads(DGL_MeshBuilder& builder, const DGL_Vec2* positions,
+    const DGL_Color* colors, const DGL_Vec2* texCoords, unsigned quadCount)
+{
+    // Each quad is split into the triangles 0, 1, 2 and 0, 2, 3
+    const unsigned corners[6] = { 0, 1, 2, 0, 2, 3 };
+
+    std::vector<VertexData>& vertexList = builder.mVertexList;
+    size_t start = vertexList.size();
+    vertexList.resize(start + (size_t)quadCount * 6);
+    VertexData* vertex = vertexList.data() + start;
+
+    for (unsigned quad = 0; quad < quadCount; ++quad)
+    {
+        for (unsigned corner : corners)
+        {
+            unsigned i = quad * 4 + corner;
+            vertex->mPosition = positions[i];
+            vertex->mColor = colors ? colors[i] : MeshManager::default_color;
+            vertex->mTexCoord = texCoords ? texCoords[i] : MeshManager::default_tex_coord;
+            ++vertex;
+        }
+    }
+}
+
+//*************************************************************************************************
+void MeshBuilder::AddIndices(DGL_MeshBuilder& builder, const unsigned* indices, unsigned count)
+{
+    builder.mIndices.insert(builder.mIndices.end(), indices, indices + count);
+}
+
+//*************************************************************************************************
+void MeshBuilder::Optimize(DGL_MeshBuilder& builder, DGL_MeshOptimizeStats* stats)
+{
+    // Creating the mesh will report that there are no vertices
+    if (builder.mVertexList.empty())
+        return;
+
+    // The optimizer works on a plain list of triangles, so write out the vertex for each index
+    std::vector<VertexData> expanded;
+    const std::vector<VertexData>* source = &builder.mVertexList;
+    if (!builder.mIndices.empty())
+    {
+        expanded.reserve(builder.mIndices.size());
+        for (unsigned index : builder.mIndices)
+        {
+            if (index >= builder.mVertexList.size())
+            {
+                SetError(builder, "Couldn't optimize mesh, an index is larger than the number of vertices.");
+                return;
+            }
+
+            expanded.push_back(builder.mVertexList[index]);
+        }
+        source = &expanded;
+    }
+
+    std::vector<VertexData> vertices;
+    MeshOptimizer::Optimize(source->data(), (unsigned)source->size(), vertices, builder.mIndices,
+        stats);
+    builder.mVertexList.swap(vertices);
+}
+
+//*************************************************************************************************
+void MeshBuilder::SetError(DGL_MeshBuilder& builder, const char* error)
+{
+    // The first problem is usually the cause of any later ones
+    if (!builder.mError)
+        builder.mError = error;
+}
+
+} // namespace DGL
+
+using namespace DGL;
+
+//*************************************************************************************************
+DGL_MeshBuilder* DGL_MeshBuilder_Create(DGL_VertexFormat format)
+{
+    DGL_MeshBuilder* builder = new DGL_MeshBuilder;
+    MeshBuilder::Reset(*builder, format);
+
+    if ((unsigned)format >= vertex_format_count)
+    {
+        MeshBuilder::SetError(*builder, "Passed in an invalid DGL_VertexFormat value to DGL_MeshBuilder_Create.");
+        builder->mVertexFormat = DGL_VF_DEFAULT;
+    }
+
+    return builder;
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_Free(DGL_MeshBuilder** builder)
+{
+    if (!builder)
+        return;
+
+    delete *builder;
+    *builder = NULL;
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_Clear(DGL_MeshBuilder* builder)
+{
+    if (!builder)
+        return;
+
+    MeshBuilder::Reset(*builder, builder->mVertexFormat);
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_AddVertex(DGL_MeshBuilder* builder, const DGL_Vec2* position,
+    const DGL_Color* color, const DGL_Vec2* textureOffset)
+{
+    if (!builder)
+        return;
+
+    if (!position || !color || !textureOffset)
+    {
+        MeshBuilder::SetError(*builder, "Passed in a null parameter to DGL_MeshBuilder_AddVertex.");
+        return;
+    }
+
+    builder->mVertexList.push_back({ *position, *color, *textureOffset });
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_AddVertices(DGL_MeshBuilder* builder, const DGL_Vec2* positions,
+    const DGL_Color* colors, const DGL_Vec2* textureCoords, unsigned count)
+{
+    DGL_MeshBuilder_AddVerticesStrided(builder, positions, 0, colors, 0, textureCoords, 0, count);
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_AddVerticesStrided(DGL_MeshBuilder* builder, const DGL_Vec2* positions,
+    unsigned positionStride, const DGL_Color* colors, unsigned colorStride,
+    const DGL_Vec2* textureCoords, unsigned textureCoordStride, unsigned count)
+{
+    if (!builder)
+        return;
+
+    if (!positions)
+    {
+        MeshBuilder::SetError(*builder, "Passed in a null parameter to DGL_MeshBuilder_AddVertices.");
+        return;
+    }
+
+    MeshBuilder::AddVertices(*builder, positions, positionStride, colors, colorStride,
+        textureCoords, textureCoordStride, count);
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_AddQuads(DGL_MeshBuilder* builder, const DGL_Vec2* positions,
+    const DGL_Color* colors, const DGL_Vec2* textureCoords, unsigned quadCount)
+{
+    if (!builder)
+        return;
+
+    if (!positions)
+    {
+        MeshBuilder::SetError(*builder, "Passed in a null parameter to DGL_MeshBuilder_AddQuads.");
+        return;
+    }
+
+    MeshBuilder::AddQuads(*builder, positions, colors, textureCoords, quadCount);
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_AddIndices(DGL_MeshBuilder* builder, const unsigned* indices, unsigned count)
+{
+    if (!builder)
+        return;
+
+    if (!indices)
+    {
+        MeshBuilder::SetError(*builder, "Passed in a null parameter to DGL_MeshBuilder_AddIndices.");
+        return;
+    }
+
+    MeshBuilder::AddIndices(*builder, indices, count);
+}
+
+//*************************************************************************************************
+void DGL_MeshBuilder_Optimize(DGL_MeshBuilder* builder, DGL_MeshOptimizeStats* stats)
+{
+    if (!builder)
+        return;
+
+    MeshBuilder::Optimize(*builder, stats);
+}
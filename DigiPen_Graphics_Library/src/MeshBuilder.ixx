@@ -0,0 +1,56 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshBuilder.ixx
+// author:  Andy Ellinger
+// brief:   Header for filling lists of vertices and indices for new meshes on any thread
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <vector>
+
+export module MeshBuilder;
+
+import Mesh;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------- MeshBuilder
+
+// Fills a DGL_MeshBuilder on the CPU. Nothing here uses the graphics device or the error
+// handler, so different builders can be filled on different threads at the same time.
+// Problems are saved on the builder and reported when the mesh is created.
+export class MeshBuilder
+{
+public:
+    // Removes the vertices, indices, and any error, and sets the vertex format. The memory for
+    // the lists is kept so the builder can be reused.
+    static void Reset(DGL_MeshBuilder& builder, DGL_VertexFormat format);
+
+    // Adds vertices to the list, reading the values the same way as MeshManager::CopyVertices
+    static void AddVertices(DGL_MeshBuilder& builder, const DGL_Vec2* positions,
+        unsigned positionStride, const DGL_Color* colors, unsigned colorStride,
+        const DGL_Vec2* texCoords, unsigned texCoordStride, unsigned count);
+
+    // Adds two triangles to the list for each group of four corners in the arrays.
+    // The colors and texture coordinates can be null, the same as AddVertices.
+    static void AddQuads(DGL_MeshBuilder& builder, const DGL_Vec2* positions,
+        const DGL_Color* colors, const DGL_Vec2* texCoords, unsigned quadCount);
+
+    // Adds indices to the list. They are checked against the vertices when the mesh is created,
+    // so vertices can be added after them.
+    static void AddIndices(DGL_MeshBuilder& builder, const unsigned* indices, unsigned count);
+
+    // Replaces the vertices and indices with welded vertices and indices reordered for the vertex
+    // cache, filling in the stats if they are provided. If there are already indices, the
+    // vertices they use are optimized in their order.
+    static void Optimize(DGL_MeshBuilder& builder, DGL_MeshOptimizeStats* stats);
+
+    // Saves the error on the builder, unless it already has one
+    static void SetError(DGL_MeshBuilder& builder, const char* error);
+};
+
+} // namespace DGL
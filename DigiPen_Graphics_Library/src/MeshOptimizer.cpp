@@ -0,0 +1,317 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshOptimizer.cpp
+// author:  Andy Ellinger
+// brief:   Removing duplicate vertices and reordering meshes for faster drawing
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+module MeshOptimizer;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- MeshOptimizer
+
+//*************************************************************************************************
+void MeshOptimizer::WeldVertices(const VertexData* vertices, unsigned vertexCount,
+    std::vector<VertexData>& weldedVertices, std::vector<unsigned>& indices)
+{
+    weldedVertices.clear();
+    indices.resize(vertexCount);
+
+    // The hash table holds positions in the welded list, and is kept at most half full so
+    // searches stay short
+    constexpr unsigned empty_slot{ 0xFFFFFFFF };
+    unsigned tableSize = 16;
+    while (tableSize < vertexCount * 2ull)
+        tableSize *= 2;
+    std::vector<unsigned> table(tableSize, empty_slot);
+
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        const VertexData& vertex = vertices[i];
+
+        // Look for the same vertex, moving to the next slot until it or an empty slot is found
+        unsigned slot = HashVertex(vertex) & (tableSize - 1);
+        while (table[slot] != empty_slot &&
+            memcmp(&weldedVertices[table[slot]], &vertex, sizeof(VertexData)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == empty_slot)
+        {
+            table[slot] = (unsigned)weldedVertices.size();
+            weldedVertices.push_back(vertex);
+        }
+
+        indices[i] = table[slot];
+    }
+}
+
+//*************************************************************************************************
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned>& indices, unsigned vertexCount)
+{
+    unsigned triangleCount = (unsigned)indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Make a list of the triangles using each vertex. The triangles for a vertex start at its
+    // offset, and the ones which haven't been drawn yet are kept at the front.
+    std::vector<unsigned> remainingTriangles(vertexCount, 0);
+    for (unsigned i = 0; i < triangleCount * 3; ++i)
+        ++remainingTriangles[indices[i]];
+
+    std::vector<unsigned> triangleOffsets(vertexCount);
+    unsigned offset = 0;
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        triangleOffsets[i] = offset;
+        offset += remainingTriangles[i];
+    }
+
+    std::vector<unsigned> vertexTriangles(triangleCount * 3);
+    std::vector<unsigned> listSizes(vertexCount, 0);
+    for (unsigned i = 0; i < triangleCount * 3; ++i)
+    {
+        unsigned vertex = indices[i];
+        vertexTriangles[triangleOffsets[vertex] + listSizes[vertex]++] = i / 3;
+    }
+
+    // Score every vertex and triangle before anything is in the cache
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (unsigned i = 0; i < vertexCount; ++i)
+        vertexScores[i] = VertexScore(-1, remainingTriangles[i]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> drawn(triangleCount, false);
+    unsigned bestTriangle = 0;
+    for (unsigned i = 0; i < triangleCount; ++i)
+    {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] +
+            vertexScores[indices[i * 3 + 2]];
+        if (triangleScores[i] > triangleScores[bestTriangle])
+            bestTriangle = i;
+    }
+
+    // The cache has room for the new triangle's vertices before the oldest ones are dropped
+    unsigned cache[cache_size + 3];
+    unsigned cacheCount = 0;
+    unsigned nextTriangle = 0;
+
+    std::vector<unsigned> results;
+    results.reserve(triangleCount * 3);
+
+    for (unsigned count = 0; count < triangleCount; ++count)
+    {
+        // If no triangle in the cache is left, continue with the next one in the original order
+        if (bestTriangle == triangleCount)
+        {
+            while (drawn[nextTriangle])
+                ++nextTriangle;
+            bestTriangle = nextTriangle;
+        }
+
+        const unsigned* triangle = &indices[bestTriangle * 3];
+        results.insert(results.end(), triangle, triangle + 3);
+        drawn[bestTriangle] = true;
+
+        // Take the triangle out of each of its vertices' lists of remaining triangles
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            unsigned* list = &vertexTriangles[triangleOffsets[triangle[i]]];
+            unsigned& remaining = remainingTriangles[triangle[i]];
+            for (unsigned j = 0; j < remaining; ++j)
+            {
+                if (list[j] == bestTriangle)
+                {
+                    list[j] = list[remaining - 1];
+                    --remaining;
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the cache
+        unsigned newCache[cache_size + 3];
+        unsigned newCount = 0;
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            if (newCount == 0 || (newCache[0] != triangle[i] &&
+                (newCount == 1 || newCache[1] != triangle[i])))
+                newCache[newCount++] = triangle[i];
+        }
+        for (unsigned i = 0; i < cacheCount; ++i)
+        {
+            if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+                newCache[newCount++] = cache[i];
+        }
+
+        // Update the scores of every vertex which moved, including the ones which fell out of
+        // the cache, along with the scores of their remaining triangles
+        for (unsigned i = 0; i < newCount; ++i)
+        {
+            unsigned vertex = newCache[i];
+            cachePositions[vertex] = i < cache_size ? (int)i : -1;
+
+            float score = VertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+            float change = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            const unsigned* list = &vertexTriangles[triangleOffsets[vertex]];
+            for (unsigned j = 0; j < remainingTriangles[vertex]; ++j)
+                triangleScores[list[j]] += change;
+        }
+
+        // The next triangle is the best one using a vertex still in the cache
+        cacheCount = newCount < cache_size ? newCount : cache_size;
+        bestTriangle = triangleCount;
+        float bestScore = 0.0f;
+        for (unsigned i = 0; i < cacheCount; ++i)
+        {
+            unsigned vertex = newCache[i];
+            cache[i] = vertex;
+
+            const unsigned* list = &vertexTriangles[triangleOffsets[vertex]];
+            for (unsigned j = 0; j < remainingTriangles[vertex]; ++j)
+            {
+                if (bestTriangle == triangleCount || triangleScores[list[j]] > bestScore)
+                {
+                    bestTriangle = list[j];
+                    bestScore = triangleScores[list[j]];
+                }
+            }
+        }
+    }
+
+    // Keep any leftover indices which don't make a complete triangle
+    results.insert(results.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices.swap(results);
+}
+
+//*************************************************************************************************
+void MeshOptimizer::OptimizeVertexFetch(std::vector<VertexData>& vertices,
+    std::vector<unsigned>& indices)
+{
+    constexpr unsigned unused{ 0xFFFFFFFF };
+    std::vector<unsigned> newPositions(vertices.size(), unused);
+
+    std::vector<VertexData> reordered;
+    reordered.reserve(vertices.size());
+
+    // Give each vertex the next position the first time it is used
+    for (unsigned& index : indices)
+    {
+        if (newPositions[index] == unused)
+        {
+            newPositions[index] = (unsigned)reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+
+        index = newPositions[index];
+    }
+
+    vertices.swap(reordered);
+}
+
+//*************************************************************************************************
+float MeshOptimizer::CalculateACMR(const unsigned* indices, unsigned indexCount,
+    unsigned vertexCount, unsigned cacheSize)
+{
+    unsigned triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return 0.0f;
+
+    // Each vertex remembers when it was added to the cache. It has been pushed out once
+    // more than the cache size of vertices have been added since then.
+    std::vector<unsigned> addedTimes(vertexCount, 0);
+    unsigned time = cacheSize + 1;
+    unsigned misses = 0;
+
+    for (unsigned i = 0; i < triangleCount * 3; ++i)
+    {
+        if (time - addedTimes[indices[i]] > cacheSize)
+        {
+            addedTimes[indices[i]] = time++;
+            ++misses;
+        }
+    }
+
+    return (float)misses / triangleCount;
+}
+
+//*************************************************************************************************
+void MeshOptimizer::Optimize(const VertexData* vertices, unsigned vertexCount,
+    std::vector<VertexData>& optimizedVertices, std::vector<unsigned>& indices,
+    DGL_MeshOptimizeStats* stats)
+{
+    WeldVertices(vertices, vertexCount, optimizedVertices, indices);
+
+    if (stats)
+    {
+        stats->mVerticesBefore = vertexCount;
+        stats->mACMRBefore = CalculateACMR(indices.data(), (unsigned)indices.size(),
+            (unsigned)optimizedVertices.size(), acmr_cache_size);
+    }
+
+    // The triangle order can only be changed if the vertices are made of complete triangles
+    if (vertexCount % 3 == 0)
+        OptimizeVertexCache(indices, (unsigned)optimizedVertices.size());
+
+    OptimizeVertexFetch(optimizedVertices, indices);
+
+    if (stats)
+    {
+        stats->mVerticesAfter = (unsigned)optimizedVertices.size();
+        stats->mACMRAfter = CalculateACMR(indices.data(), (unsigned)indices.size(),
+            (unsigned)optimizedVertices.size(), acmr_cache_size);
+    }
+}
+
+//*************************************************************************************************
+float MeshOptimizer::VertexScore(int cachePosition, unsigned remainingTriangles)
+{
+    // Vertices with no triangles left should never be picked
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The last triangle's vertices all get the same score, since the order they were
+        // used in doesn't matter
+        if (cachePosition < 3)
+            score = last_triangle_score;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3) / (cache_size - 3), cache_decay_power);
+    }
+
+    // Vertices with only a few triangles left are finished off so they can leave the cache
+    score += valence_boost_scale * powf((float)remainingTriangles, -valence_boost_power);
+
+    return score;
+}
+
+//*************************************************************************************************
+unsigned MeshOptimizer::HashVertex(const VertexData& vertex)
+{
+    // Hash the bits of each value, so vertices are only matched when they are exactly the same
+    uint32_t values[sizeof(VertexData) / sizeof(uint32_t)];
+    memcpy(values, &vertex, sizeof(VertexData));
+
+    uint32_t hash = 2166136261u;
+    for (uint32_t value : values)
+        hash = (hash ^ value) * 16777619u;
+
+    return hash ^ (hash >> 16);
+}
+
+} // namespace DGL
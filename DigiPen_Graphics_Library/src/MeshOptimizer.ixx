@@ -0,0 +1,77 @@
+//-------------------------------------------------------------------------------------------------
+// file:    MeshOptimizer.ixx
+// author:  Andy Ellinger
+// brief:   Header for removing duplicate vertices and reordering meshes for faster drawing
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <vector>
+
+export module MeshOptimizer;
+
+import Mesh;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- MeshOptimizer
+
+// Works only with vertex and index lists on the CPU, so it can be used and checked without
+// a graphics device. The index lists are treated as triangle lists.
+export class MeshOptimizer
+{
+public:
+    // Fills the vertex list with one copy of each different vertex and the index list with the
+    // position of each original vertex in the new list. Vertices are only combined when every
+    // value is exactly the same.
+    static void WeldVertices(const VertexData* vertices, unsigned vertexCount,
+        std::vector<VertexData>& weldedVertices, std::vector<unsigned>& indices);
+
+    // Changes the order of the triangles so vertices are reused while they are still in the
+    // graphics card's cache of recently transformed vertices
+    static void OptimizeVertexCache(std::vector<unsigned>& indices, unsigned vertexCount);
+
+    // Changes the order of the vertices to match the order the indices first use them, so the
+    // vertex data is read in order. Vertices not used by any index are removed.
+    static void OptimizeVertexFetch(std::vector<VertexData>& vertices,
+        std::vector<unsigned>& indices);
+
+    // Returns the average number of vertices transformed per triangle (the ACMR) with a
+    // first-in-first-out cache of the provided size. Lower is better, and 0.5 is the best
+    // possible value for large meshes.
+    static float CalculateACMR(const unsigned* indices, unsigned indexCount,
+        unsigned vertexCount, unsigned cacheSize);
+
+    // Welds the vertices and reorders the result for the vertex cache and vertex fetch,
+    // filling in the stats if they are provided
+    static void Optimize(const VertexData* vertices, unsigned vertexCount,
+        std::vector<VertexData>& optimizedVertices, std::vector<unsigned>& indices,
+        DGL_MeshOptimizeStats* stats);
+
+    // The cache size the triangle order is chosen for
+    static constexpr unsigned cache_size{ 32 };
+    // The cache size used when reporting the ACMR, matching older graphics cards
+    static constexpr unsigned acmr_cache_size{ 16 };
+
+private:
+    // Returns how useful it is to draw a triangle using the vertex next, based on where the
+    // vertex is in the cache and how many of its triangles haven't been drawn yet
+    static float VertexScore(int cachePosition, unsigned remainingTriangles);
+
+    // Returns a hash of every value in the vertex
+    static unsigned HashVertex(const VertexData& vertex);
+
+    // The values used to score vertices, from Tom Forsyth's "Linear-Speed Vertex Cache
+    // Optimisation". The last triangle's vertices get a fixed score, later cache positions
+    // score less and less, and vertices with few triangles left get a boost.
+    static constexpr float last_triangle_score{ 0.75f };
+    static constexpr float cache_decay_power{ 1.5f };
+    static constexpr float valence_boost_scale{ 2.0f };
+    static constexpr float valence_boost_power{ 0.5f };
+};
+
+} // namespace DGL
@@ -0,0 +1,434 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Mipmap.cpp
+// author:  Andy Ellinger
+// brief:   Building the smaller levels of textures on the CPU
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <math.h>
+#include <sstream>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+module Mipmap;
+
+import Math;
+
+namespace DGL
+{
+
+namespace
+{
+
+constexpr float pi{ 3.141592654f };
+
+// Identifies cache files. The version changes when the layout of the files changes.
+constexpr char cache_magic[4] = { 'D', 'G', 'L', 'M' };
+constexpr unsigned cache_version{ 2 };
+
+// The start of each cache file, which is followed by the full path of the source file and then
+// the width, height, and data of each level
+struct CacheHeader
+{
+    char mMagic[4];
+    unsigned mVersion;
+    unsigned mMode;
+    unsigned mFormat;
+    unsigned mLevels;
+    unsigned mNameLength;
+    // The size and last write time of the source file when the levels were built
+    unsigned long long mSourceSize;
+    long long mSourceTime;
+};
+
+//*************************************************************************************************
+float BesselI0(float x)
+{
+    // The zeroth order modified Bessel function, from its power series, used by the Kaiser window
+    float sum = 1.0f;
+    float term = 1.0f;
+    float quarterSquared = x * x * 0.25f;
+    for (int k = 1; k < 20; ++k)
+    {
+        term *= quarterSquared / (float)(k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+//*************************************************************************************************
+std::string GetFullPath(const std::string& fileName)
+{
+    // The same file gets the same cache file no matter which folder the program runs from
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::absolute(fileName, error);
+    return error ? fileName : path.lexically_normal().string();
+}
+
+//*************************************************************************************************
+bool GetSourceInfo(const std::string& fileName, unsigned long long& size, long long& time)
+{
+    std::error_code error;
+    size = std::filesystem::file_size(fileName, error);
+    if (error)
+        return false;
+
+    time = std::filesystem::last_write_time(fileName, error).time_since_epoch().count();
+    return !error;
+}
+
+} // namespace
+
+//--------------------------------------------------------------------------------- MipmapGenerator
+
+//*************************************************************************************************
+unsigned MipmapGenerator::GetLevelCount(int width, int height)
+{
+    unsigned count = 1;
+    while (width > 1 || height > 1)
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ++count;
+    }
+
+    return count;
+}
+
+//*************************************************************************************************
+unsigned MipmapGenerator::GetLevelBytes(DXGI_FORMAT format, int width, int height)
+{
+    unsigned rows = (unsigned)height;
+    switch (format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC7_UNORM:
+        rows = height > 0 ? (height + 3) / 4 : 0;
+        break;
+    default:
+        break;
+    }
+
+    return GetRowPitch(format, width) * rows;
+}
+
+//*************************************************************************************************
+unsigned MipmapGenerator::GetRowPitch(DXGI_FORMAT format, int width)
+{
+    // Block compressed formats have 8 or 16 bytes for each block
+    unsigned blocks = width > 0 ? (width + 3) / 4 : 0;
+    switch (format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC4_UNORM:
+        return blocks * 8;
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC7_UNORM:
+        return blocks * 16;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        return width * 16;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        return width * 8;
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R16_UNORM:
+        return width * 2;
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_A8_UNORM:
+        return width;
+    default:
+        return width * 4;
+    }
+}
+
+//*************************************************************************************************
+void MipmapGenerator::BuildLevels(std::vector<MipLevel>& levels, DGL_MipmapMode mode)
+{
+    int width = levels[0].mWidth;
+    int height = levels[0].mHeight;
+    unsigned count = GetLevelCount(width, height);
+    levels.resize(1);
+    levels.reserve(count);
+
+    // Filter with the colors multiplied by alpha, keeping each level as floats for the next one
+    std::vector<float> source((size_t)width * height * 4);
+    const unsigned char* pixel = levels[0].mPixels.data();
+    for (size_t i = 0; i < source.size(); i += 4, pixel += 4)
+    {
+        float alpha = pixel[3] / 255.0f;
+        source[i] = pixel[0] / 255.0f * alpha;
+        source[i + 1] = pixel[1] / 255.0f * alpha;
+        source[i + 2] = pixel[2] / 255.0f * alpha;
+        source[i + 3] = alpha;
+    }
+
+    Filter columns, rows;
+    std::vector<float> shrunkRows, result;
+    std::vector<DGL_Color> colors;
+    for (unsigned level = 1; level < count; ++level)
+    {
+        int newWidth = width > 1 ? width / 2 : 1;
+        int newHeight = height > 1 ? height / 2 : 1;
+        BuildFilter(width, newWidth, mode, columns);
+        BuildFilter(height, newHeight, mode, rows);
+
+        // Shrink each row, then add the shrunk rows together into the rows of the new level
+        shrunkRows.resize((size_t)newWidth * height * 4);
+        for (int y = 0; y < height; ++y)
+        {
+            Array_Resample4(source.data() + (size_t)y * width * 4, columns.mFirsts.data(),
+                columns.mWeights.data(), columns.mTaps, shrunkRows.data() + (size_t)y * newWidth * 4,
+                newWidth);
+        }
+
+        unsigned rowFloats = newWidth * 4;
+        result.assign((size_t)newHeight * rowFloats, 0.0f);
+        for (int y = 0; y < newHeight; ++y)
+        {
+            const float* weights = rows.mWeights.data() + (size_t)y * rows.mTaps;
+            for (unsigned tap = 0; tap < rows.mTaps; ++tap)
+            {
+                if (weights[tap] != 0.0f)
+                {
+                    Array_AddScaled(shrunkRows.data() + (size_t)(rows.mFirsts[y] + tap) * rowFloats,
+                        weights[tap], result.data() + (size_t)y * rowFloats, rowFloats);
+                }
+            }
+        }
+
+        // The Kaiser filter can overshoot, so keep alpha between 0 and 1 and the colors below
+        // alpha, then divide the colors by alpha again
+        size_t pixelCount = (size_t)newWidth * newHeight;
+        colors.resize(pixelCount);
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            float* value = result.data() + i * 4;
+            value[3] = value[3] < 0.0f ? 0.0f : (value[3] > 1.0f ? 1.0f : value[3]);
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                if (value[channel] < 0.0f)
+                    value[channel] = 0.0f;
+                else if (value[channel] > value[3])
+                    value[channel] = value[3];
+            }
+
+            float scale = value[3] > 0.0f ? 1.0f / value[3] : 0.0f;
+            colors[i] = { value[0] * scale, value[1] * scale, value[2] * scale, value[3] };
+        }
+
+        MipLevel& newLevel = levels.emplace_back();
+        newLevel.mWidth = newWidth;
+        newLevel.mHeight = newHeight;
+        newLevel.mPixels.resize(pixelCount * 4);
+        Pack_ColorsUnorm8(colors.data(), sizeof(DGL_Color), (uint32_t*)newLevel.mPixels.data(),
+            sizeof(uint32_t), (unsigned)pixelCount);
+
+        source.swap(result);
+        width = newWidth;
+        height = newHeight;
+    }
+}
+
+//*************************************************************************************************
+bool MipmapGenerator::ReadCache(const std::string& directory, const std::string& fileName,
+    DGL_MipmapMode mode, DXGI_FORMAT format, std::vector<MipLevel>& levels)
+{
+    unsigned long long sourceSize;
+    long long sourceTime;
+    if (!GetSourceInfo(fileName, sourceSize, sourceTime))
+        return false;
+
+    std::string sourcePath = GetFullPath(fileName);
+    std::ifstream file(GetCachePath(directory, sourcePath), std::ios::binary);
+    if (!file)
+        return false;
+
+    // The levels are only used if they were built from the same file with the same filter and
+    // compressed to the same format
+    CacheHeader header;
+    if (!file.read((char*)&header, sizeof(header)) ||
+        memcmp(header.mMagic, cache_magic, sizeof(cache_magic)) != 0 ||
+        header.mVersion != cache_version || header.mMode != (unsigned)mode ||
+        header.mFormat != (unsigned)format ||
+        header.mSourceSize != sourceSize || header.mSourceTime != sourceTime ||
+        header.mNameLength != sourcePath.size())
+        return false;
+
+    std::string name(header.mNameLength, '\0');
+    if (!file.read(name.data(), name.size()) || name != sourcePath)
+        return false;
+
+    // Check every size before reading, in case the file was cut off or changed
+    levels.clear();
+    for (unsigned i = 0; i < header.mLevels; ++i)
+    {
+        int width, height;
+        if (!file.read((char*)&width, sizeof(width)) || !file.read((char*)&height, sizeof(height)))
+            return false;
+
+        if (i == 0)
+        {
+            if (width <= 0 || height <= 0 || width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+                height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+                header.mLevels != GetLevelCount(width, height))
+                return false;
+        }
+        else
+        {
+            const MipLevel& previous = levels.back();
+            if (width != (previous.mWidth > 1 ? previous.mWidth / 2 : 1) ||
+                height != (previous.mHeight > 1 ? previous.mHeight / 2 : 1))
+                return false;
+        }
+
+        MipLevel& level = levels.emplace_back();
+        level.mWidth = width;
+        level.mHeight = height;
+        level.mPixels.resize(GetLevelBytes(format, width, height));
+        if (!file.read((char*)level.mPixels.data(), level.mPixels.size()))
+            return false;
+    }
+
+    return !levels.empty();
+}
+
+//*************************************************************************************************
+void MipmapGenerator::WriteCache(const std::string& directory, const std::string& fileName,
+    DGL_MipmapMode mode, DXGI_FORMAT format, const std::vector<MipLevel>& levels)
+{
+    unsigned long long sourceSize;
+    long long sourceTime;
+    if (!GetSourceInfo(fileName, sourceSize, sourceTime))
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    std::string sourcePath = GetFullPath(fileName);
+    std::ofstream file(GetCachePath(directory, sourcePath), std::ios::binary | std::ios::trunc);
+    if (!file)
+        return;
+
+    CacheHeader header{ { 0 }, cache_version, (unsigned)mode, (unsigned)format,
+        (unsigned)levels.size(), (unsigned)sourcePath.size(), sourceSize, sourceTime };
+    memcpy(header.mMagic, cache_magic, sizeof(cache_magic));
+    file.write((const char*)&header, sizeof(header));
+    file.write(sourcePath.data(), sourcePath.size());
+
+    for (const MipLevel& level : levels)
+    {
+        file.write((const char*)&level.mWidth, sizeof(level.mWidth));
+        file.write((const char*)&level.mHeight, sizeof(level.mHeight));
+        file.write((const char*)level.mPixels.data(), level.mPixels.size());
+    }
+}
+
+//*************************************************************************************************
+void MipmapGenerator::BuildFilter(int sourceSize, int newSize, DGL_MipmapMode mode,
+    Filter& filter)
+{
+    float scale = (float)sourceSize / newSize;
+    float radius = mode == DGL_MM_KAISER ? kaiser_radius * scale : scale * 0.5f;
+
+    // Find the range of source pixels for each new pixel. Pixels past the edges use the edge
+    // pixel, the same as the clamp address mode, so the ranges stay inside the source.
+    filter.mTaps = 0;
+    filter.mFirsts.resize(newSize);
+    for (int i = 0; i < newSize; ++i)
+    {
+        float center = (i + 0.5f) * scale;
+        int first = (int)floorf(center - radius);
+        int last = (int)ceilf(center + radius) - 1;
+        first = first < 0 ? 0 : first;
+        last = last >= sourceSize ? sourceSize - 1 : last;
+
+        filter.mFirsts[i] = first;
+        if ((unsigned)(last - first + 1) > filter.mTaps)
+            filter.mTaps = last - first + 1;
+    }
+
+    // Every new pixel uses the same number of taps, so move the ranges near the end back to
+    // fit, with zero weights for the extra pixels
+    filter.mWeights.assign((size_t)newSize * filter.mTaps, 0.0f);
+    for (int i = 0; i < newSize; ++i)
+    {
+        if (filter.mFirsts[i] + filter.mTaps > (unsigned)sourceSize)
+            filter.mFirsts[i] = sourceSize - filter.mTaps;
+
+        float center = (i + 0.5f) * scale;
+        float* weights = filter.mWeights.data() + (size_t)i * filter.mTaps;
+        int start = (int)floorf(center - radius);
+        int end = (int)ceilf(center + radius);
+        float total = 0.0f;
+        for (int j = start; j < end; ++j)
+        {
+            float weight;
+            if (mode == DGL_MM_KAISER)
+                weight = KaiserWeight((j + 0.5f - center) / scale);
+            else
+            {
+                // The box filter weights each pixel by how much of it the new pixel covers
+                float left = j > i * scale ? (float)j : i * scale;
+                float right = j + 1 < (i + 1) * scale ? (float)(j + 1) : (i + 1) * scale;
+                weight = right > left ? right - left : 0.0f;
+            }
+
+            int source = j < 0 ? 0 : (j >= sourceSize ? sourceSize - 1 : j);
+            weights[source - filter.mFirsts[i]] += weight;
+            total += weight;
+        }
+
+        for (unsigned tap = 0; tap < filter.mTaps; ++tap)
+            weights[tap] /= total;
+    }
+}
+
+//*************************************************************************************************
+float MipmapGenerator::KaiserWeight(float distance)
+{
+    float x = fabsf(distance);
+    if (x >= kaiser_radius)
+        return 0.0f;
+
+    float sinc = x < 0.0001f ? 1.0f : sinf(pi * x) / (pi * x);
+    float t = x / kaiser_radius;
+    return sinc * BesselI0(kaiser_alpha * sqrtf(1.0f - t * t)) / BesselI0(kaiser_alpha);
+}
+
+//*************************************************************************************************
+std::string MipmapGenerator::GetCachePath(const std::string& directory,
+    const std::string& fileName)
+{
+    // Name the cache file with a hash of the full path of the source file
+    unsigned long long hash = 14695981039346656037ull;
+    for (char c : fileName)
+    {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ull;
+    }
+
+    std::stringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash << ".mips";
+    return (std::filesystem::path(directory) / stream.str()).string();
+}
+
+} // namespace DGL
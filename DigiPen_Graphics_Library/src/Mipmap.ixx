@@ -0,0 +1,90 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Mipmap.ixx
+// author:  Andy Ellinger
+// brief:   Header for building the smaller levels of textures on the CPU
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <dxgiformat.h>
+#include <string>
+#include <vector>
+
+export module Mipmap;
+
+namespace DGL
+{
+
+// The data for one level of a texture, either RGBA pixels or compressed blocks
+export struct MipLevel
+{
+    std::vector<unsigned char> mPixels;
+    // The size of the level in pixels
+    int mWidth{ 0 };
+    int mHeight{ 0 };
+};
+
+//--------------------------------------------------------------------------------- MipmapGenerator
+
+// Builds the smaller levels of a texture on the CPU. Each level is half the width and height of
+// the one before it, down to 1x1, and is filtered from the one before it. The colors are
+// multiplied by alpha while filtering, so the colors of transparent pixels don't bleed into the
+// pixels next to them. Nothing here uses the graphics device, so it can be used on any thread.
+export class MipmapGenerator
+{
+public:
+    // Returns the number of levels in a full chain for a texture of the provided size
+    static unsigned GetLevelCount(int width, int height);
+
+    // Returns the number of bytes in a level with the format. Block compressed formats store
+    // each 4x4 block of pixels together, so partial blocks at the edges use a whole block.
+    static unsigned GetLevelBytes(DXGI_FORMAT format, int width, int height);
+
+    // Returns the number of bytes in each row of pixels, or each row of blocks for block
+    // compressed formats
+    static unsigned GetRowPitch(DXGI_FORMAT format, int width);
+
+    // Adds the smaller levels after the first level, using the filter for the mode
+    static void BuildLevels(std::vector<MipLevel>& levels, DGL_MipmapMode mode);
+
+    // Reads the levels saved for the file in the cache folder with the mode and format. Returns
+    // false if they weren't saved, or if the file has changed since they were.
+    static bool ReadCache(const std::string& directory, const std::string& fileName,
+        DGL_MipmapMode mode, DXGI_FORMAT format, std::vector<MipLevel>& levels);
+
+    // Saves the levels for the file in the cache folder. Problems are ignored, since the levels
+    // can always be built again.
+    static void WriteCache(const std::string& directory, const std::string& fileName,
+        DGL_MipmapMode mode, DXGI_FORMAT format, const std::vector<MipLevel>& levels);
+
+    // The distance from the center of the Kaiser filter to its edge, in pixels of the new level
+    static constexpr float kaiser_radius{ 3.0f };
+    // The shape of the Kaiser window. Larger values are smoother, with less ringing.
+    static constexpr float kaiser_alpha{ 4.0f };
+
+    // The weights for filtering a row or column of one level into the next
+    struct Filter
+    {
+        // The first source pixel for each new pixel
+        std::vector<unsigned> mFirsts;
+        // The weights for each new pixel, mTaps at a time
+        std::vector<float> mWeights;
+        // The number of source pixels used for each new pixel
+        unsigned mTaps{ 0 };
+    };
+
+    // Sets up the filter to shrink a row or column from the source size to the new size
+    static void BuildFilter(int sourceSize, int newSize, DGL_MipmapMode mode, Filter& filter);
+
+    // Returns the Kaiser windowed sinc filter at the distance, in pixels of the new level
+    static float KaiserWeight(float distance);
+
+private:
+    // Returns the path of the cache file for the file
+    static std::string GetCachePath(const std::string& directory, const std::string& fileName);
+};
+
+} // namespace DGL
@@ -0,0 +1,220 @@
+//-------------------------------------------------------------------------------------------------
+// file:    RingBuffer.cpp
+// author:  Andy Ellinger
+// brief:   Writing per-draw constant data into a shared dynamic buffer
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <d3d11_1.h>
+#include <stdint.h>
+#include <string.h>
+
+module RingBuffer;
+
+import Errors;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- RingAllocator
+
+//*************************************************************************************************
+void RingAllocator::Reset(unsigned capacity)
+{
+    mCapacity = capacity;
+    mHead = 0;
+    mTail = 0;
+    for (uint64_t& frameEnd : mFrameEnds)
+        frameEnd = 0;
+    mFrameCount = 0;
+}
+
+//*************************************************************************************************
+unsigned RingAllocator::Allocate(unsigned size, unsigned alignment)
+{
+    if (size == 0 || alignment == 0 || size > mCapacity)
+        return invalid_offset;
+
+    uint64_t start = mHead;
+    unsigned offset = (unsigned)(start % mCapacity);
+    unsigned padding = (alignment - offset % alignment) % alignment;
+
+    if ((uint64_t)offset + padding + size <= mCapacity)
+    {
+        // Move the start up to the alignment
+        start += padding;
+        offset += padding;
+    }
+    else
+    {
+        // There isn't enough space before the end of the buffer, so skip to the start
+        start += mCapacity - offset;
+        offset = 0;
+    }
+
+    // Make sure this wouldn't overwrite data from a frame that's still in use
+    if (start + size - mTail > mCapacity)
+        return invalid_offset;
+
+    mHead = start + size;
+
+    return offset;
+}
+
+//*************************************************************************************************
+void RingAllocator::EndFrame()
+{
+    // Save where this frame ended
+    mFrameEnds[mFrameCount % frames_in_flight] = mHead;
+    ++mFrameCount;
+
+    // Everything before the end of the oldest saved frame is free again
+    if (mFrameCount >= frames_in_flight)
+        mTail = mFrameEnds[mFrameCount % frames_in_flight];
+}
+
+//*************************************************************************************************
+unsigned RingAllocator::GetCapacity() const
+{
+    return mCapacity;
+}
+
+//*************************************************************************************************
+unsigned RingAllocator::GetUsed() const
+{
+    return (unsigned)(mHead - mTail);
+}
+
+//------------------------------------------------------------------------------------ ConstantRing
+
+//*************************************************************************************************
+void ConstantRing::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+{
+    mDevice = device;
+    mDeviceContext = deviceContext;
+
+    // Binding part of a constant buffer needs D3D 11.1 and driver support, and so does mapping
+    // a dynamic constant buffer with D3D11_MAP_WRITE_NO_OVERWRITE
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = { 0 };
+    HRESULT hr = mDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+    mSupported = SUCCEEDED(hr) && options.ConstantBufferOffsetting &&
+        options.MapNoOverwriteOnDynamicConstantBuffer;
+}
+
+//*************************************************************************************************
+void ConstantRing::Release()
+{
+    if (mBuffer)
+        mBuffer->Release();
+
+    mBuffer = nullptr;
+    mAllocator.Reset(0);
+    mNeedsDiscard = true;
+    mSupported = false;
+    mDevice = nullptr;
+    mDeviceContext = nullptr;
+}
+
+//*************************************************************************************************
+bool ConstantRing::IsSupported() const
+{
+    return mSupported;
+}
+
+//*************************************************************************************************
+bool ConstantRing::Write(const void* data, UINT size, UINT& firstConstant, UINT& constantCount)
+{
+    if (!mDeviceContext || !mSupported)
+        return false;
+
+    // Bound parts must also be a multiple of 16 constants long
+    UINT blockSize = (size + constant_alignment - 1) / constant_alignment * constant_alignment;
+
+    // Find space for the data, making the buffer larger if all of it is in use
+    unsigned offset = mBuffer ? mAllocator.Allocate(blockSize, constant_alignment) :
+        RingAllocator::invalid_offset;
+    if (offset == RingAllocator::invalid_offset)
+    {
+        if (!Grow(blockSize))
+            return false;
+
+        offset = mAllocator.Allocate(blockSize, constant_alignment);
+        if (offset == RingAllocator::invalid_offset)
+            return false;
+    }
+
+    // Copy the data without waiting for the graphics card, since the allocator keeps this
+    // from overwriting anything that could still be in use
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    D3D11_MAP mapType = mNeedsDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+    HRESULT hr = mDeviceContext->Map(mBuffer, 0, mapType, 0, &mappedResource);
+    if (FAILED(hr))
+    {
+        // Turn the ring off so every draw after this uses the normal constant buffer instead
+        // of failing again, and the error is only reported once
+        gError->SetError("Problem mapping constant ring buffer. ", hr);
+        mSupported = false;
+        return false;
+    }
+    memcpy((char*)mappedResource.pData + offset, data, size);
+    mDeviceContext->Unmap(mBuffer, 0);
+    mNeedsDiscard = false;
+
+    firstConstant = offset / 16;
+    constantCount = blockSize / 16;
+
+    return true;
+}
+
+//*************************************************************************************************
+void ConstantRing::EndFrame()
+{
+    mAllocator.EndFrame();
+}
+
+//*************************************************************************************************
+ID3D11Buffer* ConstantRing::GetBuffer() const
+{
+    return mBuffer;
+}
+
+//*************************************************************************************************
+bool ConstantRing::Grow(UINT requiredSize)
+{
+    // Double the size to avoid recreating the buffer too often
+    UINT newCapacity = mAllocator.GetCapacity() ? mAllocator.GetCapacity() * 2 : initial_capacity;
+    while (newCapacity < requiredSize)
+        newCapacity *= 2;
+
+    // Release the old buffer. D3D keeps it alive until the graphics card is finished with it.
+    if (mBuffer)
+        mBuffer->Release();
+    mBuffer = nullptr;
+    mAllocator.Reset(0);
+
+    // Set up the buffer description struct
+    D3D11_BUFFER_DESC bufferDesc = { 0 };
+    bufferDesc.ByteWidth = newCapacity;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    // Create the buffer
+    HRESULT hr = mDevice->CreateBuffer(&bufferDesc, NULL, &mBuffer);
+    if (FAILED(hr))
+    {
+        // Turn the ring off so the error is only reported once
+        gError->SetError("Problem creating constant ring buffer. ", hr);
+        mSupported = false;
+        return false;
+    }
+
+    mAllocator.Reset(newCapacity);
+    mNeedsDiscard = true;
+
+    return true;
+}
+
+} // namespace DGL
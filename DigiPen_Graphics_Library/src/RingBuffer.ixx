@@ -0,0 +1,113 @@
+//-------------------------------------------------------------------------------------------------
+// file:    RingBuffer.ixx
+// author:  Andy Ellinger
+// brief:   Header for writing per-draw constant data into a shared dynamic buffer
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <d3d11_1.h>
+#include <stdint.h>
+
+export module RingBuffer;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- RingAllocator
+
+// Hands out space from a fixed-size buffer in order, wrapping back to the start when it reaches
+// the end. Space used in a frame isn't handed out again until that frame is old enough that the
+// graphics card must be finished with it.
+export class RingAllocator
+{
+public:
+    // Sets the size of the buffer and forgets all previous allocations
+    void Reset(unsigned capacity);
+
+    // Returns the offset of a new block of the provided size and alignment, or invalid_offset
+    // if there isn't enough space that isn't still in use by a recent frame
+    unsigned Allocate(unsigned size, unsigned alignment);
+
+    // Marks the end of the current frame, freeing the space used by the oldest frame
+    void EndFrame();
+
+    // Returns the size of the buffer
+    unsigned GetCapacity() const;
+
+    // Returns the amount of space currently in use, including space skipped when wrapping
+    unsigned GetUsed() const;
+
+    static constexpr unsigned invalid_offset{ 0xffffffff };
+
+    // The number of frames whose data is kept: the current frame plus the three frames DXGI 
+    // allows to be queued by default
+    static constexpr unsigned frames_in_flight{ 4 };
+
+private:
+    // The size of the buffer
+    unsigned mCapacity{ 0 };
+    // The total amount of space handed out since the last reset. The offset in the buffer is
+    // this value wrapped to the capacity.
+    uint64_t mHead{ 0 };
+    // The position of the oldest data that might still be in use
+    uint64_t mTail{ 0 };
+    // The head position at the end of each recent frame
+    uint64_t mFrameEnds[frames_in_flight]{ 0 };
+    // The number of frames ended since the last reset
+    uint64_t mFrameCount{ 0 };
+};
+
+//------------------------------------------------------------------------------------ ConstantRing
+
+// A dynamic constant buffer that per-draw constant data is written into with 
+// D3D11_MAP_WRITE_NO_OVERWRITE, with each draw binding its own part of the buffer
+export class ConstantRing
+{
+public:
+    // Saves the D3D objects to use and checks if constant buffer offsets are supported
+    void Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+
+    // Releases the D3D buffer
+    void Release();
+
+    // Returns true if the device supports binding part of a constant buffer and the ring hasn't
+    // been turned off after a problem
+    bool IsSupported() const;
+
+    // Copies the data into the buffer and returns the location to bind, in 16-byte constants.
+    // Returns false if there was a problem, which turns the ring off.
+    bool Write(const void* data, UINT size, UINT& firstConstant, UINT& constantCount);
+
+    // Marks the end of the current frame
+    void EndFrame();
+
+    // Returns the D3D buffer object
+    ID3D11Buffer* GetBuffer() const;
+
+    // Bound parts of a constant buffer must start on a multiple of 16 constants
+    static constexpr UINT constant_alignment{ 256 };
+    // The size of the buffer when it is first created
+    static constexpr UINT initial_capacity{ 64 * 1024 };
+
+private:
+    // Creates a larger buffer that can hold at least the provided size
+    bool Grow(UINT requiredSize);
+
+    // The D3D device object
+    ID3D11Device* mDevice{ nullptr };
+    // The D3D device context object
+    ID3D11DeviceContext* mDeviceContext{ nullptr };
+    // The D3D constant buffer
+    ID3D11Buffer* mBuffer{ nullptr };
+    // Tracks which parts of the buffer are free
+    RingAllocator mAllocator;
+    // Tracks whether the ring can be used
+    bool mSupported{ false };
+    // A new buffer must be mapped with discard the first time
+    bool mNeedsDiscard{ true };
+};
+
+} // namespace DGL
@@ -0,0 +1,411 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Spatial.cpp
+// author:  Andy Ellinger
+// brief:   Finding objects by area
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <math.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+module Spatial;
+
+import Math;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------- SpatialGrid
+
+//*************************************************************************************************
+unsigned SpatialGrid::Add(const DGL_SpatialObject& object)
+{
+    // Reuse an unused entry if there is one
+    unsigned index;
+    if (!mFreeEntries.empty())
+    {
+        index = mFreeEntries.back();
+        mFreeEntries.pop_back();
+    }
+    else
+    {
+        // Every index has to fit in the low bits of an ID
+        if (mEntries.size() >= max_objects)
+            return 0;
+
+        index = (unsigned)mEntries.size();
+        mEntries.push_back({});
+    }
+
+    Entry& entry = mEntries[index];
+    entry.mObject = object;
+    entry.mQueryStamp = mQueryStamp;
+    entry.mInUse = true;
+    SetBounds(entry);
+    Link(index);
+
+    ++mObjectCount;
+
+    return GetId(index);
+}
+
+//*************************************************************************************************
+bool SpatialGrid::Update(unsigned id, const DGL_SpatialObject& object)
+{
+    unsigned index = GetIndex(id);
+    if (index == invalid_index)
+        return false;
+
+    Entry* entry = &mEntries[index];
+    Entry updated = *entry;
+    updated.mObject = object;
+    SetBounds(updated);
+
+    // Only change cells if the object is touching different ones
+    if (updated.mCellMinX != entry->mCellMinX || updated.mCellMinY != entry->mCellMinY ||
+        updated.mCellMaxX != entry->mCellMaxX || updated.mCellMaxY != entry->mCellMaxY ||
+        updated.mLarge != entry->mLarge)
+    {
+        Unlink(index);
+        *entry = updated;
+        Link(index);
+    }
+    else
+    {
+        *entry = updated;
+    }
+
+    return true;
+}
+
+//*************************************************************************************************
+bool SpatialGrid::Remove(unsigned id)
+{
+    unsigned index = GetIndex(id);
+    if (index == invalid_index)
+        return false;
+
+    RemoveAt(index);
+    return true;
+}
+
+//*************************************************************************************************
+void SpatialGrid::RemoveObjectsUsing(const DGL_Mesh* mesh)
+{
+    for (unsigned i = 0; i < mEntries.size(); ++i)
+    {
+        if (mEntries[i].mInUse && mEntries[i].mObject.mMesh == mesh)
+            RemoveAt(i);
+    }
+}
+
+//*************************************************************************************************
+void SpatialGrid::UpdateObjectsUsing(const DGL_Mesh* mesh)
+{
+    for (unsigned i = 0; i < mEntries.size(); ++i)
+    {
+        if (mEntries[i].mInUse && mEntries[i].mObject.mMesh == mesh)
+            Update(GetId(i), mEntries[i].mObject);
+    }
+}
+
+//*************************************************************************************************
+void SpatialGrid::RemoveObjectsUsing(const DGL_Texture* texture)
+{
+    for (unsigned i = 0; i < mEntries.size(); ++i)
+    {
+        if (mEntries[i].mInUse && mEntries[i].mObject.mTexture == texture)
+            RemoveAt(i);
+    }
+}
+
+//*************************************************************************************************
+void SpatialGrid::RemoveObjectsUsing(const std::vector<DGL_Texture*>& textures)
+{
+    // Check every object once instead of once for each texture
+    std::unordered_set<const DGL_Texture*> textureSet(textures.begin(), textures.end());
+    for (unsigned i = 0; i < mEntries.size(); ++i)
+    {
+        if (mEntries[i].mInUse && textureSet.count(mEntries[i].mObject.mTexture))
+            RemoveAt(i);
+    }
+}
+
+//*************************************************************************************************
+void SpatialGrid::Clear()
+{
+    // Keep the entries so the IDs of the removed objects don't match new objects. The entries
+    // are added to the free list from the end, so new objects use the first ones again.
+    mFreeEntries.clear();
+    for (unsigned i = (unsigned)mEntries.size(); i-- > 0;)
+    {
+        Entry& entry = mEntries[i];
+        if (entry.mInUse)
+        {
+            entry.mInUse = false;
+            ++entry.mGeneration;
+        }
+        mFreeEntries.push_back(i);
+    }
+
+    mCells.clear();
+    mLargeEntries.clear();
+    mObjectCount = 0;
+}
+
+//*************************************************************************************************
+void SpatialGrid::SetCellSize(float size)
+{
+    if (size <= 0.0f || size == mCellSize)
+        return;
+
+    // Take every object out of the old cells and put it into the new ones
+    mCells.clear();
+    mLargeEntries.clear();
+    mCellSize = size;
+
+    for (unsigned i = 0; i < mEntries.size(); ++i)
+    {
+        if (!mEntries[i].mInUse)
+            continue;
+
+        SetBounds(mEntries[i]);
+        Link(i);
+    }
+}
+
+//*************************************************************************************************
+void SpatialGrid::Query(const DGL_Vec2& areaMin, const DGL_Vec2& areaMax,
+    std::vector<unsigned>& results)
+{
+    // Use a new stamp so each object is only checked once. If the stamp wraps around,
+    // clear the old stamps so none of them match by accident.
+    if (++mQueryStamp == 0)
+    {
+        for (Entry& entry : mEntries)
+            entry.mQueryStamp = 0;
+        mQueryStamp = 1;
+    }
+
+    // Adds the object if it hasn't been checked yet and its box overlaps the area
+    auto check = [&](unsigned index)
+    {
+        Entry& entry = mEntries[index];
+        if (entry.mQueryStamp == mQueryStamp)
+            return;
+        entry.mQueryStamp = mQueryStamp;
+
+        if (entry.mMin.x <= areaMax.x && entry.mMax.x >= areaMin.x &&
+            entry.mMin.y <= areaMax.y && entry.mMax.y >= areaMin.y)
+            results.push_back(GetId(index));
+    };
+
+    int cellMinX = ToCell(areaMin.x);
+    int cellMinY = ToCell(areaMin.y);
+    int cellMaxX = ToCell(areaMax.x);
+    int cellMaxY = ToCell(areaMax.y);
+    int64_t cellCount = ((int64_t)cellMaxX - cellMinX + 1) * ((int64_t)cellMaxY - cellMinY + 1);
+
+    if (cellCount <= (int64_t)mCells.size())
+    {
+        // Look up each cell in the area
+        for (int y = cellMinY; y <= cellMaxY; ++y)
+        {
+            for (int x = cellMinX; x <= cellMaxX; ++x)
+            {
+                auto cell = mCells.find(CellKey(x, y));
+                if (cell == mCells.end())
+                    continue;
+
+                for (unsigned index : cell->second)
+                    check(index);
+            }
+        }
+    }
+    else
+    {
+        // The area covers more cells than have objects, so go through the used cells instead
+        for (const auto& [key, cell] : mCells)
+        {
+            int x = (int)(int32_t)(uint32_t)(key >> 32);
+            int y = (int)(int32_t)(uint32_t)key;
+            if (x < cellMinX || x > cellMaxX || y < cellMinY || y > cellMaxY)
+                continue;
+
+            for (unsigned index : cell)
+                check(index);
+        }
+    }
+
+    for (unsigned index : mLargeEntries)
+        check(index);
+}
+
+//*************************************************************************************************
+const DGL_SpatialObject* SpatialGrid::GetObject(unsigned id) const
+{
+    unsigned index = GetIndex(id);
+    if (index == invalid_index)
+        return nullptr;
+
+    return &mEntries[index].mObject;
+}
+
+//*************************************************************************************************
+unsigned SpatialGrid::GetObjectCount() const
+{
+    return mObjectCount;
+}
+
+//*************************************************************************************************
+size_t SpatialGrid::GetMemoryBytes() const
+{
+    size_t bytes = mEntries.capacity() * sizeof(Entry) +
+        mFreeEntries.capacity() * sizeof(unsigned) +
+        mLargeEntries.capacity() * sizeof(unsigned) +
+        mCells.bucket_count() * sizeof(void*);
+
+    // Each cell is a map node holding its key and list, plus the indices in the list
+    for (const auto& [key, cell] : mCells)
+        bytes += sizeof(void*) + sizeof(key) + sizeof(cell) + cell.capacity() * sizeof(unsigned);
+
+    return bytes;
+}
+
+//*************************************************************************************************
+void SpatialGrid::SetBounds(Entry& entry) const
+{
+    const DGL_SpatialObject& object = entry.mObject;
+    const DGL_MeshBounds& bounds = object.mMesh->mBounds;
+
+    // Transform the mesh's box the same way it will be transformed when drawing
+    Affine2D transform = Affine_Compose(object.mPosition, object.mScale, sinf(object.mRotation),
+        cosf(object.mRotation));
+    Affine_TransformBox(transform, bounds.mMin, bounds.mMax, entry.mMin, entry.mMax);
+
+    entry.mCellMinX = ToCell(entry.mMin.x);
+    entry.mCellMinY = ToCell(entry.mMin.y);
+    entry.mCellMaxX = ToCell(entry.mMax.x);
+    entry.mCellMaxY = ToCell(entry.mMax.y);
+
+    int64_t cellCount = ((int64_t)entry.mCellMaxX - entry.mCellMinX + 1) *
+        ((int64_t)entry.mCellMaxY - entry.mCellMinY + 1);
+    entry.mLarge = cellCount > max_object_cells;
+}
+
+//*************************************************************************************************
+void SpatialGrid::Link(unsigned index)
+{
+    const Entry& entry = mEntries[index];
+
+    if (entry.mLarge)
+    {
+        mLargeEntries.push_back(index);
+        return;
+    }
+
+    for (int y = entry.mCellMinY; y <= entry.mCellMaxY; ++y)
+    {
+        for (int x = entry.mCellMinX; x <= entry.mCellMaxX; ++x)
+            mCells[CellKey(x, y)].push_back(index);
+    }
+}
+
+//*************************************************************************************************
+void SpatialGrid::Unlink(unsigned index)
+{
+    // Removes the index from the list by moving the last value into its place
+    auto removeFrom = [index](std::vector<unsigned>& list)
+    {
+        for (unsigned i = 0; i < list.size(); ++i)
+        {
+            if (list[i] == index)
+            {
+                list[i] = list.back();
+                list.pop_back();
+                return;
+            }
+        }
+    };
+
+    const Entry& entry = mEntries[index];
+
+    if (entry.mLarge)
+    {
+        removeFrom(mLargeEntries);
+        return;
+    }
+
+    for (int y = entry.mCellMinY; y <= entry.mCellMaxY; ++y)
+    {
+        for (int x = entry.mCellMinX; x <= entry.mCellMaxX; ++x)
+        {
+            auto cell = mCells.find(CellKey(x, y));
+            if (cell == mCells.end())
+                continue;
+
+            removeFrom(cell->second);
+
+            // Don't keep empty cells around, so the map only holds cells with objects
+            if (cell->second.empty())
+                mCells.erase(cell);
+        }
+    }
+}
+
+//*************************************************************************************************
+void SpatialGrid::RemoveAt(unsigned index)
+{
+    Entry& entry = mEntries[index];
+    Unlink(index);
+    entry.mInUse = false;
+    ++entry.mGeneration;
+    mFreeEntries.push_back(index);
+
+    --mObjectCount;
+}
+
+//*************************************************************************************************
+unsigned SpatialGrid::GetIndex(unsigned id) const
+{
+    unsigned index = (id & id_index_mask) - 1;
+    if ((id & id_index_mask) == 0 || index >= mEntries.size() || !mEntries[index].mInUse ||
+        GetId(index) != id)
+        return invalid_index;
+
+    return index;
+}
+
+//*************************************************************************************************
+unsigned SpatialGrid::GetId(unsigned index) const
+{
+    return (mEntries[index].mGeneration << id_index_bits) | (index + 1);
+}
+
+//*************************************************************************************************
+int SpatialGrid::ToCell(float value) const
+{
+    // Keep the cell inside the range of an int, which also handles infinite values
+    float cell = floorf(value / mCellSize);
+    if (!(cell > -1.0e9f))
+        return -1000000000;
+    if (cell > 1.0e9f)
+        return 1000000000;
+
+    return (int)cell;
+}
+
+//*************************************************************************************************
+uint64_t SpatialGrid::CellKey(int x, int y)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+} // namespace DGL
@@ -0,0 +1,149 @@
+//-------------------------------------------------------------------------------------------------
+// file:    Spatial.ixx
+// author:  Andy Ellinger
+// brief:   Header for finding objects by area
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+export module Spatial;
+
+import Mesh;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------- SpatialGrid
+
+// Keeps objects in a grid of square cells so the objects in an area can be found without
+// checking every object. Each object is listed in every cell its box touches, and only
+// changes cells when it moves far enough to touch different ones.
+export class SpatialGrid
+{
+public:
+    // Adds the object and returns its ID, which will never be 0. Returns 0 if the grid is full.
+    unsigned Add(const DGL_SpatialObject& object);
+
+    // Replaces the data for the object with the provided ID. Returns false if the ID is not valid.
+    bool Update(unsigned id, const DGL_SpatialObject& object);
+
+    // Removes the object with the provided ID. Returns false if the ID is not valid.
+    bool Remove(unsigned id);
+
+    // Removes all objects using the mesh
+    void RemoveObjectsUsing(const DGL_Mesh* mesh);
+
+    // Moves all objects using the mesh to the cells its current bounds touch
+    void UpdateObjectsUsing(const DGL_Mesh* mesh);
+
+    // Removes all objects using the texture
+    void RemoveObjectsUsing(const DGL_Texture* texture);
+
+    // Removes all objects using any of the textures
+    void RemoveObjectsUsing(const std::vector<DGL_Texture*>& textures);
+
+    // Removes all objects, keeping the memory for new ones
+    void Clear();
+
+    // Changes the size of the cells, moving all objects into the new cells
+    void SetCellSize(float size);
+
+    // Adds the ID of each object whose box overlaps the area to the results list
+    void Query(const DGL_Vec2& areaMin, const DGL_Vec2& areaMax, std::vector<unsigned>& results);
+
+    // Returns the data for the object with the provided ID, or null if the ID is not valid
+    const DGL_SpatialObject* GetObject(unsigned id) const;
+
+    // Returns the number of objects
+    unsigned GetObjectCount() const;
+
+    // Returns an estimate of the memory used for the entries and cells, in bytes
+    size_t GetMemoryBytes() const;
+
+    // The width and height of a cell when the grid is created
+    static constexpr float default_cell_size{ 256.0f };
+    // Objects touching more cells than this are kept in a separate list checked by every query
+    static constexpr int64_t max_object_cells{ 64 };
+    // The low bits of an ID hold the entry index plus one, and the high bits hold the entry's
+    // generation, which changes each time its object is removed. An ID from a removed object
+    // doesn't match the entry's next object until the generation wraps around.
+    static constexpr unsigned id_index_bits{ 24 };
+    static constexpr unsigned id_index_mask{ (1u << id_index_bits) - 1 };
+    // The largest number of objects the grid can hold
+    static constexpr unsigned max_objects{ id_index_mask };
+
+private:
+    // An object along with the box and cells it covers
+    struct Entry
+    {
+        DGL_SpatialObject mObject;
+        // The box around the object's mesh after being transformed
+        DGL_Vec2 mMin;
+        DGL_Vec2 mMax;
+        // The range of cells the box touches
+        int mCellMinX;
+        int mCellMinY;
+        int mCellMaxX;
+        int mCellMaxY;
+        // The last query which checked this object, so objects in several cells are only checked once
+        unsigned mQueryStamp;
+        // Increased each time the entry's object is removed, so old IDs stop matching it
+        unsigned mGeneration;
+        // Tracks whether this entry is holding an object
+        bool mInUse;
+        // Tracks whether the object is in the large object list instead of the cells
+        bool mLarge;
+    };
+
+    // Calculates the box and cell range for the entry's object
+    void SetBounds(Entry& entry) const;
+
+    // Adds the entry to each cell it touches, or to the large object list
+    void Link(unsigned index);
+
+    // Removes the entry from each cell it touches, or from the large object list
+    void Unlink(unsigned index);
+
+    // Removes the object in the entry, and marks the entry as unused
+    void RemoveAt(unsigned index);
+
+    // Returns the index of the entry for the ID, or invalid_index if the ID is not valid
+    unsigned GetIndex(unsigned id) const;
+
+    // Returns the ID for the object in the entry
+    unsigned GetId(unsigned index) const;
+
+    // Returns the cell coordinate containing the value
+    int ToCell(float value) const;
+
+    // Returns the key used to find a cell in the map
+    static uint64_t CellKey(int x, int y);
+
+    // Returned by GetIndex for IDs which don't match an object
+    static constexpr unsigned invalid_index{ ~0u };
+
+    // All entries, including unused ones
+    std::vector<Entry> mEntries;
+    // The indices of unused entries
+    std::vector<unsigned> mFreeEntries;
+    // The indices of the entries touching each cell which has any
+    std::unordered_map<uint64_t, std::vector<unsigned>> mCells;
+    // The indices of entries which touch too many cells to be added to each one
+    std::vector<unsigned> mLargeEntries;
+    // The width and height of a cell
+    float mCellSize{ default_cell_size };
+    // The number of entries in use
+    unsigned mObjectCount{ 0 };
+    // Increased for each query
+    unsigned mQueryStamp{ 0 };
+};
+
+} // namespace DGL
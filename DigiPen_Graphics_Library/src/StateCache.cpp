@@ -0,0 +1,311 @@
+//-------------------------------------------------------------------------------------------------
+// file:    StateCache.cpp
+// author:  Andy Ellinger
+// brief:   Skipping redundant device context state changes
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <d3d11_1.h>
+
+module StateCache;
+
+namespace DGL
+{
+
+//--------------------------------------------------------------------------------- D3DStateContext
+
+//*************************************************************************************************
+void D3DStateContext::Initialize(ID3D11DeviceContext* deviceContext)
+{
+    if (mDeviceContext1)
+        mDeviceContext1->Release();
+    mDeviceContext1 = nullptr;
+
+    mDeviceContext = deviceContext;
+
+    // Get the D3D 11.1 interface if it's available
+    if (mDeviceContext)
+    {
+        mDeviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1),
+            reinterpret_cast<void**>(&mDeviceContext1));
+    }
+}
+
+//*************************************************************************************************
+D3DStateContext::~D3DStateContext()
+{
+    if (mDeviceContext1)
+        mDeviceContext1->Release();
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    mDeviceContext->IASetPrimitiveTopology(topology);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetInputLayout(ID3D11InputLayout* inputLayout)
+{
+    mDeviceContext->IASetInputLayout(inputLayout);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset)
+{
+    mDeviceContext->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+    mDeviceContext->IASetIndexBuffer(buffer, format, offset);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetVertexShader(ID3D11VertexShader* shader)
+{
+    mDeviceContext->VSSetShader(shader, NULL, 0);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetVertexConstantBuffer(UINT slot, ID3D11Buffer* buffer)
+{
+    mDeviceContext->VSSetConstantBuffers(slot, 1, &buffer);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetVertexConstantBufferRange(UINT slot, ID3D11Buffer* buffer, 
+    UINT firstConstant, UINT constantCount)
+{
+    if (mDeviceContext1)
+        mDeviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetPixelShader(ID3D11PixelShader* shader)
+{
+    mDeviceContext->PSSetShader(shader, NULL, 0);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetPixelShaderResource(ID3D11ShaderResourceView* resourceView)
+{
+    mDeviceContext->PSSetShaderResources(0, 1, &resourceView);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetPixelSampler(ID3D11SamplerState* sampler)
+{
+    mDeviceContext->PSSetSamplers(0, 1, &sampler);
+}
+
+//*************************************************************************************************
+void D3DStateContext::SetBlendState(ID3D11BlendState* blendState)
+{
+    mDeviceContext->OMSetBlendState(blendState, NULL, 0xffffffff);
+}
+
+//*************************************************************************************************
+void D3DStateContext::Draw(UINT vertexCount, UINT startVertex)
+{
+    mDeviceContext->Draw(vertexCount, startVertex);
+}
+
+//*************************************************************************************************
+void D3DStateContext::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+{
+    mDeviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+//*************************************************************************************************
+void D3DStateContext::DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex)
+{
+    mDeviceContext->DrawInstanced(vertexCount, instanceCount, startVertex, 0);
+}
+
+//*************************************************************************************************
+void D3DStateContext::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+    INT baseVertex)
+{
+    mDeviceContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, 0);
+}
+
+//-------------------------------------------------------------------------------------- StateCache
+
+//*************************************************************************************************
+void StateCache::Initialize(StateContext* context)
+{
+    mContext = context;
+    Reset();
+}
+
+//*************************************************************************************************
+void StateCache::Reset()
+{
+    mTopology = {};
+    mInputLayout = {};
+    for (CachedValue<VertexBufferBinding>& binding : mVertexBuffers)
+        binding = {};
+    mIndexBuffer = {};
+    mVertexShader = {};
+    for (CachedValue<ConstantBufferBinding>& binding : mVertexConstantBuffers)
+        binding = {};
+    mPixelShader = {};
+    mPixelShaderResource = {};
+    mPixelSampler = {};
+    mBlendState = {};
+}
+
+//*************************************************************************************************
+void StateCache::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    if (Count(mTopology.Update(topology)))
+        mContext->SetPrimitiveTopology(topology);
+}
+
+//*************************************************************************************************
+void StateCache::SetInputLayout(ID3D11InputLayout* inputLayout)
+{
+    if (Count(mInputLayout.Update(inputLayout)))
+        mContext->SetInputLayout(inputLayout);
+}
+
+//*************************************************************************************************
+void StateCache::SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset)
+{
+    // Slots that aren't tracked are always sent
+    if (slot >= max_slots || Count(mVertexBuffers[slot].Update({ buffer, stride, offset })))
+        mContext->SetVertexBuffer(slot, buffer, stride, offset);
+}
+
+//*************************************************************************************************
+void StateCache::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+    if (Count(mIndexBuffer.Update({ buffer, format, offset })))
+        mContext->SetIndexBuffer(buffer, format, offset);
+}
+
+//*************************************************************************************************
+void StateCache::SetVertexShader(ID3D11VertexShader* shader)
+{
+    if (Count(mVertexShader.Update(shader)))
+        mContext->SetVertexShader(shader);
+}
+
+//*************************************************************************************************
+void StateCache::SetVertexConstantBuffer(UINT slot, ID3D11Buffer* buffer)
+{
+    // Slots that aren't tracked are always sent
+    if (slot >= max_slots || Count(mVertexConstantBuffers[slot].Update({ buffer, 0, 0 })))
+        mContext->SetVertexConstantBuffer(slot, buffer);
+}
+
+//*************************************************************************************************
+void StateCache::SetVertexConstantBufferRange(UINT slot, ID3D11Buffer* buffer, UINT firstConstant,
+    UINT constantCount)
+{
+    // Slots that aren't tracked are always sent
+    if (slot >= max_slots || 
+        Count(mVertexConstantBuffers[slot].Update({ buffer, firstConstant, constantCount })))
+        mContext->SetVertexConstantBufferRange(slot, buffer, firstConstant, constantCount);
+}
+
+//*************************************************************************************************
+void StateCache::SetPixelShader(ID3D11PixelShader* shader)
+{
+    if (Count(mPixelShader.Update(shader)))
+        mContext->SetPixelShader(shader);
+}
+
+//*************************************************************************************************
+void StateCache::SetPixelShaderResource(ID3D11ShaderResourceView* resourceView)
+{
+    if (Count(mPixelShaderResource.Update(resourceView)))
+        mContext->SetPixelShaderResource(resourceView);
+}
+
+//*************************************************************************************************
+void StateCache::SetPixelSampler(ID3D11SamplerState* sampler)
+{
+    if (Count(mPixelSampler.Update(sampler)))
+        mContext->SetPixelSampler(sampler);
+}
+
+//*************************************************************************************************
+void StateCache::SetBlendState(ID3D11BlendState* blendState)
+{
+    if (Count(mBlendState.Update(blendState)))
+        mContext->SetBlendState(blendState);
+}
+
+//*************************************************************************************************
+void StateCache::Draw(UINT vertexCount, UINT startVertex)
+{
+    ++mDrawCalls;
+    mContext->Draw(vertexCount, startVertex);
+}
+
+//*************************************************************************************************
+void StateCache::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+{
+    ++mDrawCalls;
+    mContext->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+//*************************************************************************************************
+void StateCache::DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex)
+{
+    ++mDrawCalls;
+    mContext->DrawInstanced(vertexCount, instanceCount, startVertex);
+}
+
+//*************************************************************************************************
+void StateCache::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+    INT baseVertex)
+{
+    ++mDrawCalls;
+    mContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex);
+}
+
+//*************************************************************************************************
+unsigned StateCache::GetCallsIssued() const
+{
+    return mCallsIssued;
+}
+
+//*************************************************************************************************
+unsigned StateCache::GetCallsSkipped() const
+{
+    return mCallsSkipped;
+}
+
+//*************************************************************************************************
+unsigned StateCache::GetDrawCalls() const
+{
+    return mDrawCalls;
+}
+
+//*************************************************************************************************
+void StateCache::ResetCounters()
+{
+    mCallsIssued = 0;
+    mCallsSkipped = 0;
+    mDrawCalls = 0;
+}
+
+//*************************************************************************************************
+bool StateCache::Count(bool changed)
+{
+    if (changed)
+        ++mCallsIssued;
+    else
+        ++mCallsSkipped;
+
+    return changed;
+}
+
+} // namespace DGL
@@ -0,0 +1,202 @@
+//-------------------------------------------------------------------------------------------------
+// file:    StateCache.ixx
+// author:  Andy Ellinger
+// brief:   Header for skipping redundant device context state changes
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <d3d11_1.h>
+
+export module StateCache;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------ StateContext
+
+// The device context functions used for drawing. The state cache only talks to the device
+// context through this, so it can be checked against a version that records the calls.
+export class StateContext
+{
+public:
+    virtual ~StateContext() = default;
+
+    virtual void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+    virtual void SetInputLayout(ID3D11InputLayout* inputLayout) = 0;
+    virtual void SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset) = 0;
+    virtual void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) = 0;
+    virtual void SetVertexShader(ID3D11VertexShader* shader) = 0;
+    virtual void SetVertexConstantBuffer(UINT slot, ID3D11Buffer* buffer) = 0;
+    virtual void SetVertexConstantBufferRange(UINT slot, ID3D11Buffer* buffer, UINT firstConstant,
+        UINT constantCount) = 0;
+    virtual void SetPixelShader(ID3D11PixelShader* shader) = 0;
+    virtual void SetPixelShaderResource(ID3D11ShaderResourceView* resourceView) = 0;
+    virtual void SetPixelSampler(ID3D11SamplerState* sampler) = 0;
+    virtual void SetBlendState(ID3D11BlendState* blendState) = 0;
+
+    virtual void Draw(UINT vertexCount, UINT startVertex) = 0;
+    virtual void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) = 0;
+    virtual void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex) = 0;
+    virtual void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+        INT baseVertex) = 0;
+};
+
+//--------------------------------------------------------------------------------- D3DStateContext
+
+// Passes the calls straight through to a D3D device context
+export class D3DStateContext : public StateContext
+{
+public:
+    // Sets the D3D device context to use
+    void Initialize(ID3D11DeviceContext* deviceContext);
+
+    // Releases the D3D 11.1 device context interface
+    ~D3DStateContext();
+
+    void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+    void SetInputLayout(ID3D11InputLayout* inputLayout) override;
+    void SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset) override;
+    void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) override;
+    void SetVertexShader(ID3D11VertexShader* shader) override;
+    void SetVertexConstantBuffer(UINT slot, ID3D11Buffer* buffer) override;
+    void SetVertexConstantBufferRange(UINT slot, ID3D11Buffer* buffer, UINT firstConstant,
+        UINT constantCount) override;
+    void SetPixelShader(ID3D11PixelShader* shader) override;
+    void SetPixelShaderResource(ID3D11ShaderResourceView* resourceView) override;
+    void SetPixelSampler(ID3D11SamplerState* sampler) override;
+    void SetBlendState(ID3D11BlendState* blendState) override;
+
+    void Draw(UINT vertexCount, UINT startVertex) override;
+    void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) override;
+    void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex) override;
+    void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+        INT baseVertex) override;
+
+private:
+    // The D3D device context object
+    ID3D11DeviceContext* mDeviceContext{ nullptr };
+    // The D3D 11.1 device context interface, needed to bind part of a constant buffer
+    ID3D11DeviceContext1* mDeviceContext1{ nullptr };
+};
+
+//-------------------------------------------------------------------------------------- StateCache
+
+// Remembers what is currently bound and only passes along calls that change something
+export class StateCache
+{
+public:
+    // Sets the context to send calls to and forgets all current state
+    void Initialize(StateContext* context);
+
+    // Forgets all current state, so the next call of each type will always be sent
+    void Reset();
+
+    void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+    void SetInputLayout(ID3D11InputLayout* inputLayout);
+    void SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset);
+    void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset);
+    void SetVertexShader(ID3D11VertexShader* shader);
+    void SetVertexConstantBuffer(UINT slot, ID3D11Buffer* buffer);
+    void SetVertexConstantBufferRange(UINT slot, ID3D11Buffer* buffer, UINT firstConstant,
+        UINT constantCount);
+    void SetPixelShader(ID3D11PixelShader* shader);
+    void SetPixelShaderResource(ID3D11ShaderResourceView* resourceView);
+    void SetPixelSampler(ID3D11SamplerState* sampler);
+    void SetBlendState(ID3D11BlendState* blendState);
+
+    void Draw(UINT vertexCount, UINT startVertex);
+    void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex);
+    void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex);
+    void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex);
+
+    // Returns the number of state changes passed along to the context
+    unsigned GetCallsIssued() const;
+
+    // Returns the number of state changes that were skipped because nothing changed
+    unsigned GetCallsSkipped() const;
+
+    // Returns the number of draw calls passed along to the context
+    unsigned GetDrawCalls() const;
+
+    // Sets all counters back to zero
+    void ResetCounters();
+
+    // The number of vertex buffer and constant buffer slots that are tracked
+    static constexpr UINT max_slots{ 2 };
+
+private:
+    // A single piece of state, along with whether it is known
+    template <typename T>
+    struct CachedValue
+    {
+        // Saves the new value and returns true if it is different from the current value
+        bool Update(const T& value)
+        {
+            if (mKnown && mValue == value)
+                return false;
+            mValue = value;
+            mKnown = true;
+            return true;
+        }
+
+        T mValue{};
+        bool mKnown{ false };
+    };
+
+    // The data passed to IASetVertexBuffers for one slot
+    struct VertexBufferBinding
+    {
+        ID3D11Buffer* mBuffer{ nullptr };
+        UINT mStride{ 0 };
+        UINT mOffset{ 0 };
+        bool operator==(const VertexBufferBinding&) const = default;
+    };
+
+    // The data passed to VSSetConstantBuffers1 for one slot. A count of zero means the whole
+    // buffer is bound with VSSetConstantBuffers.
+    struct ConstantBufferBinding
+    {
+        ID3D11Buffer* mBuffer{ nullptr };
+        UINT mFirstConstant{ 0 };
+        UINT mConstantCount{ 0 };
+        bool operator==(const ConstantBufferBinding&) const = default;
+    };
+
+    // The data passed to IASetIndexBuffer
+    struct IndexBufferBinding
+    {
+        ID3D11Buffer* mBuffer{ nullptr };
+        DXGI_FORMAT mFormat{ DXGI_FORMAT_UNKNOWN };
+        UINT mOffset{ 0 };
+        bool operator==(const IndexBufferBinding&) const = default;
+    };
+
+    // Increases the correct counter and returns the value of changed
+    bool Count(bool changed);
+
+    // Where state changes are sent
+    StateContext* mContext{ nullptr };
+
+    CachedValue<D3D11_PRIMITIVE_TOPOLOGY> mTopology;
+    CachedValue<ID3D11InputLayout*> mInputLayout;
+    CachedValue<VertexBufferBinding> mVertexBuffers[max_slots];
+    CachedValue<IndexBufferBinding> mIndexBuffer;
+    CachedValue<ID3D11VertexShader*> mVertexShader;
+    CachedValue<ConstantBufferBinding> mVertexConstantBuffers[max_slots];
+    CachedValue<ID3D11PixelShader*> mPixelShader;
+    CachedValue<ID3D11ShaderResourceView*> mPixelShaderResource;
+    CachedValue<ID3D11SamplerState*> mPixelSampler;
+    CachedValue<ID3D11BlendState*> mBlendState;
+
+    // The number of state changes sent to the context
+    unsigned mCallsIssued{ 0 };
+    // The number of state changes that were skipped
+    unsigned mCallsSkipped{ 0 };
+    // The number of draw calls sent to the context
+    unsigned mDrawCalls{ 0 };
+};
+
+} // namespace DGL
@@ -0,0 +1,163 @@
+//-------------------------------------------------------------------------------------------------
+// file:    StaticBatch.cpp
+// author:  Andy Ellinger
+// brief:   Combining meshes which never move into a few large meshes
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <algorithm>
+#include <math.h>
+#include <thread>
+#include <vector>
+
+module StaticBatch;
+
+import Math;
+import Texture;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------ StaticBatchBuilder
+
+//*************************************************************************************************
+void StaticBatchBuilder::Build(const DGL_Mesh* const* meshes, const DGL_Texture* const* textures,
+    const DGL_InstanceData* instances, const std::vector<unsigned>& objects,
+    std::vector<VertexData>& vertices, std::vector<unsigned>& indices, unsigned threadCount)
+{
+    unsigned objectCount = (unsigned)objects.size();
+
+    // Find where each object's vertices and indices start, so the objects can be built in any
+    // order. The last offsets are the totals.
+    std::vector<unsigned> vertexOffsets(objectCount + 1);
+    std::vector<unsigned> indexOffsets(objectCount + 1);
+    unsigned vertexCount = 0;
+    unsigned indexCount = 0;
+    for (unsigned i = 0; i < objectCount; ++i)
+    {
+        const DGL_Mesh* mesh = meshes[objects[i]];
+        vertexOffsets[i] = vertexCount;
+        indexOffsets[i] = indexCount;
+        vertexCount += mesh->mVertexCount;
+        indexCount += mesh->mIndexCount ? mesh->mIndexCount : mesh->mVertexCount;
+    }
+    vertexOffsets[objectCount] = vertexCount;
+    indexOffsets[objectCount] = indexCount;
+
+    vertices.resize(vertexCount);
+    indices.resize(indexCount);
+
+    if (!threadCount)
+        threadCount = std::thread::hardware_concurrency();
+    if (vertexCount < parallel_min_vertices || threadCount < 2 || objectCount < 2)
+    {
+        BuildRange(meshes, textures, instances, objects.data(), vertexOffsets.data(),
+            indexOffsets.data(), 0, objectCount, vertices.data(), indices.data());
+        return;
+    }
+
+    // Give each thread about the same number of vertices, without splitting up an object
+    if (threadCount > objectCount)
+        threadCount = objectCount;
+    std::vector<std::thread> threads;
+    unsigned first = 0;
+    for (unsigned thread = 1; thread <= threadCount; ++thread)
+    {
+        unsigned target = (unsigned)((unsigned long long)vertexCount * thread / threadCount);
+        unsigned last = (unsigned)(std::lower_bound(vertexOffsets.begin() + first,
+            vertexOffsets.begin() + objectCount, target) - vertexOffsets.begin());
+        if (thread == threadCount)
+            last = objectCount;
+        if (last == first)
+            continue;
+
+        threads.emplace_back(BuildRange, meshes, textures, instances, objects.data(),
+            vertexOffsets.data(), indexOffsets.data(), first, last, vertices.data(),
+            indices.data());
+        first = last;
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+//*************************************************************************************************
+DGL_Color StaticBatchBuilder::BakeColor(const DGL_Color& color, const DGL_Color& tint)
+{
+    // The vertex shader outputs the color channels multiplied by alpha plus the tint channels
+    // multiplied by the tint alpha, and the squared alpha plus the squared tint alpha. The baked
+    // color gives the same output with a tint of 0.
+    float alpha = sqrtf(color.a * color.a + tint.a * tint.a);
+    if (alpha == 0.0f)
+        return { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    return {
+        (color.r * color.a + tint.r * tint.a) / alpha,
+        (color.g * color.a + tint.g * tint.a) / alpha,
+        (color.b * color.a + tint.b * tint.a) / alpha,
+        alpha
+    };
+}
+
+//*************************************************************************************************
+void StaticBatchBuilder::BuildRange(const DGL_Mesh* const* meshes,
+    const DGL_Texture* const* textures, const DGL_InstanceData* instances,
+    const unsigned* objects, const unsigned* vertexOffsets, const unsigned* indexOffsets,
+    unsigned first, unsigned last, VertexData* vertices, unsigned* indices)
+{
+    for (unsigned i = first; i < last; ++i)
+    {
+        const DGL_Mesh* mesh = meshes[objects[i]];
+        const DGL_InstanceData& instance = instances[objects[i]];
+
+        // Use the same transform as drawing the mesh with the instance's transform data
+        Affine2D transform = Affine_Compose(instance.mPosition, instance.mScale,
+            sinf(instance.mRotation), cosf(instance.mRotation));
+
+        // Textures in an atlas only use their part of the page
+        DGL_Vec2 rectOffset = { 0.0f, 0.0f };
+        DGL_Vec2 rectScale = { 1.0f, 1.0f };
+        const DGL_Texture* texture = textures ? textures[objects[i]] : nullptr;
+        if (texture && texture->page)
+        {
+            rectOffset = texture->uvOffset;
+            rectScale = texture->uvScale;
+        }
+
+        VertexData* vertex = vertices + vertexOffsets[i];
+        for (unsigned j = 0; j < mesh->mVertexCount; ++j, ++vertex)
+        {
+            const VertexData& source = mesh->mVertexList[j];
+            const DGL_Vec2& position = source.mPosition;
+            vertex->mPosition = {
+                transform.mXX * position.x + transform.mXY * position.y + transform.mX,
+                transform.mYX * position.x + transform.mYY * position.y + transform.mY
+            };
+            vertex->mColor = BakeColor(source.mColor, instance.mTintColor);
+            vertex->mTexCoord = {
+                rectOffset.x + (source.mTexCoord.x + instance.mTextureOffset.x) * rectScale.x,
+                rectOffset.y + (source.mTexCoord.y + instance.mTextureOffset.y) * rectScale.y
+            };
+        }
+
+        // Move the indices to where the object's vertices are in the combined list
+        unsigned base = vertexOffsets[i];
+        unsigned* index = indices + indexOffsets[i];
+        if (mesh->mIndexCount)
+        {
+            for (unsigned j = 0; j < mesh->mIndexCount; ++j)
+                index[j] = base + mesh->mIndices[j];
+        }
+        else
+        {
+            for (unsigned j = 0; j < mesh->mVertexCount; ++j)
+                index[j] = base + j;
+        }
+    }
+}
+
+} // namespace DGL
@@ -0,0 +1,67 @@
+//-------------------------------------------------------------------------------------------------
+// file:    StaticBatch.ixx
+// author:  Andy Ellinger
+// brief:   Header for combining meshes which never move into a few large meshes
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <vector>
+
+export module StaticBatch;
+
+import Mesh;
+import Texture;
+
+export typedef struct DGL_StaticBatch
+{
+    // A mesh holding every object which uses the same texture
+    struct Part
+    {
+        DGL_Mesh* mMesh{ nullptr };
+        const DGL_Texture* mTexture{ nullptr };
+    };
+
+    // One part for each different texture, in the order the textures were first used
+    std::vector<Part> mParts;
+} DGL_StaticBatch;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------ StaticBatchBuilder
+
+// Builds the vertex and index lists for a static batch on the CPU. Each object's vertices are
+// moved by its transform and given its tint color, texture offset, and the texture rect of an
+// atlas texture, so the result can be drawn with no transform, tint, or offset.
+export class StaticBatchBuilder
+{
+public:
+    // Fills the lists with the transformed vertices and indices of the listed objects, in order.
+    // Every mesh must have kept its vertices and be made of complete triangles. The textures can
+    // be null. Large inputs are split between up to the number of threads, or one thread for
+    // each core if it is 0. The results are the same for any number of threads.
+    static void Build(const DGL_Mesh* const* meshes, const DGL_Texture* const* textures,
+        const DGL_InstanceData* instances, const std::vector<unsigned>& objects,
+        std::vector<VertexData>& vertices, std::vector<unsigned>& indices, unsigned threadCount);
+
+    // Returns the color that looks the same when drawn with no tint as the provided color does
+    // when drawn with the tint
+    static DGL_Color BakeColor(const DGL_Color& color, const DGL_Color& tint);
+
+    // Inputs with fewer vertices than this are built on one thread, since starting threads
+    // would take longer than the work
+    static constexpr unsigned parallel_min_vertices{ 64 * 1024 };
+
+private:
+    // Builds the objects from first up to last, writing each one at its offsets in the lists
+    static void BuildRange(const DGL_Mesh* const* meshes, const DGL_Texture* const* textures,
+        const DGL_InstanceData* instances, const unsigned* objects, const unsigned* vertexOffsets,
+        const unsigned* indexOffsets, unsigned first, unsigned last, VertexData* vertices,
+        unsigned* indices);
+};
+
+} // namespace DGL
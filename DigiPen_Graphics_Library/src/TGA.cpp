@@ -0,0 +1,304 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TGA.cpp
+// author:  Andy Ellinger
+// brief:   Reading and writing TGA image files without WIC
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <algorithm>
+#include <ctype.h>
+#include <fstream>
+#include <iterator>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+module TGA;
+
+import Mipmap;
+
+namespace DGL
+{
+
+namespace
+{
+
+// The size of the header at the start of every file
+constexpr size_t header_size{ 18 };
+
+// The image types
+constexpr unsigned char type_true_color{ 2 };
+constexpr unsigned char type_grayscale{ 3 };
+constexpr unsigned char type_run_length{ 8 };
+
+// The descriptor flags for the order of the pixels
+constexpr unsigned char descriptor_right_to_left{ 0x10 };
+constexpr unsigned char descriptor_top_to_bottom{ 0x20 };
+
+// The most pixels in one run-length packet
+constexpr int max_packet{ 128 };
+
+//*************************************************************************************************
+// Reads a little-endian 16 bit value
+int ReadShort(const unsigned char* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+//*************************************************************************************************
+// Writes a little-endian 16 bit value
+void WriteShort(unsigned char* data, int value)
+{
+    data[0] = (unsigned char)(value & 0xff);
+    data[1] = (unsigned char)((value >> 8) & 0xff);
+}
+
+//*************************************************************************************************
+// Converts one pixel from the file to RGBA
+void ConvertPixel(const unsigned char* source, int bytesPerPixel, unsigned char* dest)
+{
+    switch (bytesPerPixel)
+    {
+    case 1:
+        dest[0] = dest[1] = dest[2] = source[0];
+        dest[3] = 255;
+        break;
+    case 2:
+        dest[0] = dest[1] = dest[2] = source[0];
+        dest[3] = source[1];
+        break;
+    case 3:
+        dest[0] = source[2];
+        dest[1] = source[1];
+        dest[2] = source[0];
+        dest[3] = 255;
+        break;
+    default:
+        dest[0] = source[2];
+        dest[1] = source[1];
+        dest[2] = source[0];
+        dest[3] = source[3];
+        break;
+    }
+}
+
+//*************************************************************************************************
+// Writes the pixel as BGRA
+void WritePixel(const unsigned char* pixel, std::vector<unsigned char>& data)
+{
+    const unsigned char bgra[4] = { pixel[2], pixel[1], pixel[0], pixel[3] };
+    data.insert(data.end(), bgra, bgra + 4);
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------------------- TGAFile
+
+//*************************************************************************************************
+bool TGAFile::IsTGAFile(const char* fileName)
+{
+    size_t length = strlen(fileName);
+    if (length < 4)
+        return false;
+
+    const char* extension = fileName + length - 4;
+    return extension[0] == '.' && tolower(extension[1]) == 't' && tolower(extension[2]) == 'g' &&
+        tolower(extension[3]) == 'a';
+}
+
+//*************************************************************************************************
+bool TGAFile::Read(const char* fileName, MipLevel& level)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    return Decode(data.data(), data.size(), level);
+}
+
+//*************************************************************************************************
+bool TGAFile::Decode(const unsigned char* data, size_t size, MipLevel& level)
+{
+    if (size < header_size)
+        return false;
+
+    int idLength = data[0];
+    int colorMapType = data[1];
+    int imageType = data[2];
+    int colorMapLength = ReadShort(data + 5);
+    int colorMapBits = data[7];
+    int width = ReadShort(data + 12);
+    int height = ReadShort(data + 14);
+    int bitsPerPixel = data[16];
+    int descriptor = data[17];
+
+    // Color mapped images aren't supported, but true color images can still have a color map
+    // that isn't used
+    bool runLength = (imageType & type_run_length) != 0;
+    int baseType = imageType & ~type_run_length;
+    int bytesPerPixel = bitsPerPixel / 8;
+    if (baseType == type_true_color)
+    {
+        if (bitsPerPixel != 24 && bitsPerPixel != 32)
+            return false;
+    }
+    else if (baseType == type_grayscale)
+    {
+        if (bitsPerPixel != 8 && bitsPerPixel != 16)
+            return false;
+    }
+    else
+        return false;
+
+    if (width <= 0 || height <= 0 || width > max_size || height > max_size)
+        return false;
+
+    // Skip the image ID and the color map
+    size_t offset = header_size + idLength;
+    if (colorMapType != 0)
+        offset += (size_t)colorMapLength * ((colorMapBits + 7) / 8);
+    if (offset > size)
+        return false;
+
+    // Read the pixels in the order they are stored, then put them in rows from the top down
+    size_t pixelCount = (size_t)width * height;
+    std::vector<unsigned char>& pixels = level.mPixels;
+    pixels.resize(pixelCount * 4);
+    if (!runLength)
+    {
+        if (size - offset < pixelCount * bytesPerPixel)
+            return false;
+
+        for (size_t i = 0; i < pixelCount; ++i)
+            ConvertPixel(data + offset + i * bytesPerPixel, bytesPerPixel, &pixels[i * 4]);
+    }
+    else
+    {
+        // Each packet is a run of one pixel repeated or a list of different pixels
+        size_t i = 0;
+        while (i < pixelCount)
+        {
+            if (offset >= size)
+                return false;
+
+            unsigned char packet = data[offset++];
+            size_t count = (size_t)(packet & 0x7f) + 1;
+            if (count > pixelCount - i)
+                return false;
+
+            if (packet & 0x80)
+            {
+                if (size - offset < (size_t)bytesPerPixel)
+                    return false;
+
+                ConvertPixel(data + offset, bytesPerPixel, &pixels[i * 4]);
+                for (size_t j = 1; j < count; ++j)
+                    memcpy(&pixels[(i + j) * 4], &pixels[i * 4], 4);
+                offset += bytesPerPixel;
+            }
+            else
+            {
+                if (size - offset < count * bytesPerPixel)
+                    return false;
+
+                for (size_t j = 0; j < count; ++j)
+                    ConvertPixel(data + offset + j * bytesPerPixel, bytesPerPixel,
+                        &pixels[(i + j) * 4]);
+                offset += count * bytesPerPixel;
+            }
+            i += count;
+        }
+    }
+
+    level.mWidth = width;
+    level.mHeight = height;
+
+    // Files are stored from the bottom up unless the descriptor says otherwise
+    size_t rowBytes = (size_t)width * 4;
+    if (!(descriptor & descriptor_top_to_bottom))
+    {
+        std::vector<unsigned char> temp(rowBytes);
+        for (int row = 0; row < height / 2; ++row)
+        {
+            unsigned char* top = pixels.data() + row * rowBytes;
+            unsigned char* bottom = pixels.data() + (height - 1 - row) * rowBytes;
+            memcpy(temp.data(), top, rowBytes);
+            memcpy(top, bottom, rowBytes);
+            memcpy(bottom, temp.data(), rowBytes);
+        }
+    }
+    if (descriptor & descriptor_right_to_left)
+    {
+        for (int row = 0; row < height; ++row)
+        {
+            unsigned char* left = pixels.data() + row * rowBytes;
+            unsigned char* right = left + rowBytes - 4;
+            for (; left < right; left += 4, right -= 4)
+                std::swap_ranges(left, left + 4, right);
+        }
+    }
+
+    return true;
+}
+
+//*************************************************************************************************
+void TGAFile::Encode(const MipLevel& level, bool runLength, std::vector<unsigned char>& data)
+{
+    data.assign(header_size, 0);
+    data[2] = runLength ? type_true_color | type_run_length : type_true_color;
+    WriteShort(&data[12], level.mWidth);
+    WriteShort(&data[14], level.mHeight);
+    data[16] = 32;
+    data[17] = descriptor_top_to_bottom | 8;
+
+    const unsigned char* pixels = level.mPixels.data();
+    if (!runLength)
+    {
+        data.reserve(header_size + level.mPixels.size());
+        for (size_t i = 0; i < level.mPixels.size(); i += 4)
+            WritePixel(pixels + i, data);
+        return;
+    }
+
+    // Packets don't cross the end of a row, so each row can be decoded on its own
+    for (int row = 0; row < level.mHeight; ++row)
+    {
+        const unsigned char* rowPixels = pixels + (size_t)row * level.mWidth * 4;
+        int x = 0;
+        while (x < level.mWidth)
+        {
+            // Count how many times the pixel repeats
+            int run = 1;
+            while (x + run < level.mWidth && run < max_packet &&
+                memcmp(rowPixels + x * 4, rowPixels + (x + run) * 4, 4) == 0)
+                ++run;
+
+            if (run > 1)
+            {
+                data.push_back((unsigned char)(0x80 | (run - 1)));
+                WritePixel(rowPixels + x * 4, data);
+                x += run;
+                continue;
+            }
+
+            // List the pixels until one repeats
+            int count = 1;
+            while (x + count < level.mWidth && count < max_packet &&
+                (x + count + 1 >= level.mWidth ||
+                memcmp(rowPixels + (x + count) * 4, rowPixels + (x + count + 1) * 4, 4) != 0))
+                ++count;
+
+            data.push_back((unsigned char)(count - 1));
+            for (int i = 0; i < count; ++i)
+                WritePixel(rowPixels + (x + i) * 4, data);
+            x += count;
+        }
+    }
+}
+
+} // namespace DGL
@@ -0,0 +1,48 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TGA.ixx
+// author:  Andy Ellinger
+// brief:   Header for reading and writing TGA image files without WIC
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include <stddef.h>
+#include <vector>
+
+export module TGA;
+
+import Mipmap;
+
+namespace DGL
+{
+
+//---------------------------------------------------------------------------------------- TGAFile
+
+// Reads and writes TGA files, which WIC can't decode. Uncompressed and run-length encoded true
+// color and grayscale files are supported, but not color mapped ones. Only the standard library
+// is used, so files can be decoded on any thread and on any platform.
+export class TGAFile
+{
+public:
+    // Returns true if the file name ends with .tga
+    static bool IsTGAFile(const char* fileName);
+
+    // Reads the file into the level as RGBA pixels. Returns false if the file can't be read or
+    // isn't a supported TGA file.
+    static bool Read(const char* fileName, MipLevel& level);
+
+    // Decodes the contents of a TGA file into the level as RGBA pixels. Returns false if the
+    // data isn't a supported TGA file or ends early.
+    static bool Decode(const unsigned char* data, size_t size, MipLevel& level);
+
+    // Encodes the RGBA pixels of the level as a 32 bit TGA file, with rows from the top down.
+    // Runs of the same pixel are stored once when runLength is true.
+    static void Encode(const MipLevel& level, bool runLength, std::vector<unsigned char>& data);
+
+    // The largest width or height read, the same as the largest texture the device can create
+    static constexpr int max_size{ 16384 };
+};
+
+} // namespace DGL
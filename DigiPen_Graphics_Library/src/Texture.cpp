@@ -9,18 +9,28 @@
 module;
 
 #include "WICTextureLoader11.h"
+#include <math.h>
 #include <sstream>
+#include <string>
+#include <vector>
+#include <wincodec.h>
 
 module Texture;
 
+import BlockCompression;
+import DDS;
 import Errors;
+import Mipmap;
+import TGA;
+import UploadQueue;
 
 namespace DGL
 {
 //---------------------------------------------------------------------------------- TextureManager
 
 //*************************************************************************************************
-DGL_Texture* TextureManager::LoadTexture(const char* pFileName, ID3D11Device* device)
+DGL_Texture* TextureManager::LoadTexture(const char* pFileName, ID3D11Device* device,
+    UploadQueue* uploads, const TextureLoadSettings& settings)
 {
     if (!device)
     {
@@ -28,6 +38,25 @@ DGL_Texture* TextureManager::LoadTexture(const char* pFileName, ID3D11Device* de
         return nullptr;
     }
 
+    // Textures with smaller levels or compression are read into memory first, so the levels
+    // can be built, DDS files are read as they are, and TGA files are decoded without WIC
+    if (settings.mMipmapMode != DGL_MM_NONE || settings.mCompression != DGL_TC_NONE ||
+        DDSFile::IsDDSFile(pFileName) || TGAFile::IsTGAFile(pFileName))
+    {
+        std::vector<MipLevel> levels;
+        DXGI_FORMAT format;
+        HRESULT hr = ReadLevels(pFileName, settings, levels, format);
+        if (FAILED(hr))
+        {
+            std::stringstream stream;
+            stream << "Failed to load texture from file \"" << pFileName << "\". ";
+            gError->SetError(stream.str(), hr);
+            return nullptr;
+        }
+
+        return LoadTextureFromLevels(levels, format, settings.mMipmapMode, device, uploads);
+    }
+
     // Create the new texture object
     DGL_Texture* newTexture = new DGL_Texture;
 
@@ -78,7 +107,8 @@ DGL_Texture* TextureManager::LoadTexture(const char* pFileName, ID3D11Device* de
 
 //*************************************************************************************************
 DGL_Texture* TextureManager::LoadTextureFromMemory(const unsigned char* data, int width, int height, 
-    ID3D11Device* device)
+    ID3D11Device* device, UploadQueue* uploads, DGL_MipmapMode mipmapMode,
+    DGL_TextureCompression compression)
 {
     if (!device)
     {
@@ -90,9 +120,192 @@ DGL_Texture* TextureManager::LoadTextureFromMemory(const unsigned char* data, in
     if (!data || width == 0 || height == 0)
         return nullptr;
 
-    // Create the new texture object
-    DGL_Texture* newTexture = new DGL_Texture;
+    // The device can't fill in the levels of compressed textures, so they are built on the CPU
+    DXGI_FORMAT format = BlockCompressor::GetFormat(compression);
+    if (format != DXGI_FORMAT_R8G8B8A8_UNORM && mipmapMode == DGL_MM_DEVICE)
+        mipmapMode = DGL_MM_BOX;
+
+    // Levels built on the CPU and compressed levels are all passed in when the texture is created
+    if (mipmapMode == DGL_MM_BOX || mipmapMode == DGL_MM_KAISER ||
+        format != DXGI_FORMAT_R8G8B8A8_UNORM)
+    {
+        std::vector<MipLevel> levels(1);
+        levels[0].mPixels.assign(data, data + (size_t)width * height * sizeof(uint32_t));
+        levels[0].mWidth = width;
+        levels[0].mHeight = height;
+        PrepareLevels(levels, mipmapMode, format, 0);
+
+        return CreateTexture(levels, format, device);
+    }
+
+    // The device fills in the other levels once the first level has been copied, so both go
+    // through the upload queue to stay in order
+    if (mipmapMode == DGL_MM_DEVICE)
+    {
+        DGL_Texture* newTexture = CreateMipmappedTexture(width, height, device);
+        if (!newTexture)
+            return nullptr;
+
+        uploads->UploadTexture(newTexture->texture, data, width * sizeof(uint32_t), height);
+        uploads->GenerateMips(newTexture->texResourceView);
+
+        return newTexture;
+    }
+
+    // While uploads are batched the texture starts empty, and the pixels are copied in with the
+    // other uploads
+    bool batched = uploads && uploads->IsBatching();
+    DGL_Texture* newTexture = CreateTexture(batched ? nullptr : data, width, height, device);
+    if (!newTexture)
+        return nullptr;
+
+    if (batched)
+        uploads->UploadTexture(newTexture->texture, data, width * sizeof(uint32_t), height);
+
+    // Return the new texture object
+    return newTexture;
+}
+
+//*************************************************************************************************
+DGL_Texture* TextureManager::LoadTextureFromLevels(const std::vector<MipLevel>& levels,
+    DXGI_FORMAT format, DGL_MipmapMode mipmapMode, ID3D11Device* device, UploadQueue* uploads)
+{
+    if (levels.size() > 1 || format != DXGI_FORMAT_R8G8B8A8_UNORM)
+        return CreateTexture(levels, format, device);
+
+    return LoadTextureFromMemory(levels[0].mPixels.data(), levels[0].mWidth, levels[0].mHeight,
+        device, uploads, mipmapMode, DGL_TC_NONE);
+}
+
+//*************************************************************************************************
+HRESULT TextureManager::ReadLevels(const char* pFileName, const TextureLoadSettings& settings,
+    std::vector<MipLevel>& levels, DXGI_FORMAT& format)
+{
+    if (DDSFile::IsDDSFile(pFileName))
+        return DDSFile::Read(pFileName, levels, format);
+
+    // The device can't fill in the levels of compressed textures, so they are built on the CPU
+    DGL_MipmapMode mipmapMode = settings.mMipmapMode;
+    format = BlockCompressor::GetFormat(settings.mCompression);
+    if (format != DXGI_FORMAT_R8G8B8A8_UNORM && mipmapMode == DGL_MM_DEVICE)
+        mipmapMode = DGL_MM_BOX;
+
+    // Levels built or compressed on the CPU may have been saved by an earlier load of the file
+    bool buildLevels = mipmapMode == DGL_MM_BOX || mipmapMode == DGL_MM_KAISER ||
+        format != DXGI_FORMAT_R8G8B8A8_UNORM;
+    bool useCache = buildLevels && !settings.mCacheDirectory.empty();
+    if (useCache && MipmapGenerator::ReadCache(settings.mCacheDirectory, pFileName, mipmapMode,
+        format, levels))
+        return S_OK;
+
+    levels.clear();
+    levels.resize(1);
+    HRESULT hr = DecodeFile(pFileName, levels[0]);
+    if (FAILED(hr))
+        return hr;
+
+    if (buildLevels)
+    {
+        PrepareLevels(levels, mipmapMode, format, settings.mCompressThreads);
+        if (useCache)
+        {
+            MipmapGenerator::WriteCache(settings.mCacheDirectory, pFileName, mipmapMode, format,
+                levels);
+        }
+    }
+
+    return S_OK;
+}
+
+//*************************************************************************************************
+bool TextureManager::ConvertToDDS(const char* pSourceFile, const char* pDDSFile,
+    DGL_TextureCompression compression, DGL_MipmapMode mipmapMode, DGL_CompressionStats* stats)
+{
+    // Graphics may not be initialized, so make sure the WIC decoder can be used on this thread
+    HRESULT comResult = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+
+    std::vector<MipLevel> levels(1);
+    HRESULT hr = DecodeFile(pSourceFile, levels[0]);
+    if (SUCCEEDED(comResult))
+        CoUninitialize();
+    if (FAILED(hr))
+    {
+        std::stringstream stream;
+        stream << "Failed to load texture from file \"" << pSourceFile << "\". ";
+        gError->SetError(stream.str(), hr);
+        return false;
+    }
+
+    // DDS files hold every level, so levels the device would fill in are built on the CPU
+    DXGI_FORMAT format = BlockCompressor::GetFormat(compression);
+    if (mipmapMode == DGL_MM_DEVICE)
+        mipmapMode = DGL_MM_BOX;
+    if (format != DXGI_FORMAT_R8G8B8A8_UNORM &&
+        !BlockCompressor::CanCompress(levels[0].mWidth, levels[0].mHeight))
+    {
+        std::stringstream stream;
+        stream << "Can't compress texture from file \"" << pSourceFile
+            << "\" because its width and height aren't multiples of 4.";
+        gError->SetError(stream.str());
+        return false;
+    }
+
+    if (mipmapMode == DGL_MM_BOX || mipmapMode == DGL_MM_KAISER)
+        MipmapGenerator::BuildLevels(levels, mipmapMode);
+
+    // Keep the first level to measure the compressed one against
+    MipLevel original = levels[0];
+    unsigned uncompressedBytes = 0;
+    for (const MipLevel& level : levels)
+        uncompressedBytes += (unsigned)level.mPixels.size();
+
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    unsigned threads = PrepareLevels(levels, DGL_MM_NONE, format, 0);
+    QueryPerformanceCounter(&end);
+
+    hr = DDSFile::Write(pDDSFile, levels, format);
+    if (FAILED(hr))
+    {
+        std::stringstream stream;
+        stream << "Failed to save texture to file \"" << pDDSFile << "\". ";
+        gError->SetError(stream.str(), hr);
+        return false;
+    }
+
+    if (stats)
+    {
+        bool compressed = format != DXGI_FORMAT_R8G8B8A8_UNORM;
+        stats->mBlocks = 0;
+        stats->mCompressedBytes = 0;
+        for (const MipLevel& level : levels)
+        {
+            if (compressed)
+                stats->mBlocks += ((level.mWidth + 3) / 4) * ((level.mHeight + 3) / 4);
+            stats->mCompressedBytes += (unsigned)level.mPixels.size();
+        }
+        stats->mThreads = threads;
+        stats->mUncompressedBytes = uncompressedBytes;
+        stats->mSeconds = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+
+        // Uncompressed levels are exact
+        if (!compressed)
+            stats->mPSNR = INFINITY;
+        else
+        {
+            BlockCompressor::Decompress(levels, format);
+            stats->mPSNR = BlockCompressor::GetPSNR(original, levels[0]);
+        }
+    }
 
+    return true;
+}
+
+//*************************************************************************************************
+DGL_Texture* TextureManager::CreateTexture(const unsigned char* data, int width, int height,
+    ID3D11Device* device)
+{
     // Set up the subresource data struct
     D3D11_SUBRESOURCE_DATA subrecData = { 0 };
     subrecData.pSysMem = data;
@@ -111,8 +324,117 @@ DGL_Texture* TextureManager::LoadTextureFromMemory(const unsigned char* data, in
     texDesc.Usage = D3D11_USAGE_DEFAULT;
     texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
+    return CreateTexture(texDesc, data ? &subrecData : nullptr, device);
+}
+
+//*************************************************************************************************
+DGL_Texture* TextureManager::CreateTexture(const std::vector<MipLevel>& levels,
+    DXGI_FORMAT format, ID3D11Device* device)
+{
+    // Set up a subresource data struct for each level. Block compressed formats give the size
+    // of each row of blocks.
+    std::vector<D3D11_SUBRESOURCE_DATA> subrecData(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        subrecData[i].pSysMem = levels[i].mPixels.data();
+        subrecData[i].SysMemPitch = MipmapGenerator::GetRowPitch(format, levels[i].mWidth);
+    }
+
+    D3D11_TEXTURE2D_DESC texDesc;
+    ZeroMemory(&texDesc, sizeof(texDesc));
+    texDesc.Width = levels[0].mWidth;
+    texDesc.Height = levels[0].mHeight;
+    texDesc.MipLevels = (UINT)levels.size();
+    texDesc.ArraySize = 1;
+    texDesc.Format = format;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.SampleDesc.Quality = 0;
+    texDesc.Usage = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    return CreateTexture(texDesc, subrecData.data(), device);
+}
+
+//*************************************************************************************************
+DGL_Texture* TextureManager::CreateMipmappedTexture(int width, int height, ID3D11Device* device)
+{
+    // Generating the levels on the device renders into them, so the texture has to be a render
+    // target too. Zero levels makes a full chain.
+    D3D11_TEXTURE2D_DESC texDesc;
+    ZeroMemory(&texDesc, sizeof(texDesc));
+    texDesc.Width = width;
+    texDesc.Height = height;
+    texDesc.MipLevels = 0;
+    texDesc.ArraySize = 1;
+    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.SampleDesc.Quality = 0;
+    texDesc.Usage = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+    texDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+    return CreateTexture(texDesc, nullptr, device);
+}
+
+//*************************************************************************************************
+unsigned TextureManager::GetLevels(const DGL_Texture* texture, DGL_TextureLevel* levels,
+    unsigned maxLevels)
+{
+    // Textures in an atlas use part of a page, and pages only have one level
+    if (texture->page)
+    {
+        int width = (int)texture->textureSize.x;
+        int height = (int)texture->textureSize.y;
+        if (maxLevels > 0)
+        {
+            levels[0] = { width, height,
+                MipmapGenerator::GetLevelBytes(DXGI_FORMAT_R8G8B8A8_UNORM, width, height) };
+        }
+        return 1;
+    }
+
+    // Textures which are still loading don't have any levels yet
+    if (!texture->texture)
+        return 0;
+
+    D3D11_TEXTURE2D_DESC texInfo{ 0 };
+    texture->texture->GetDesc(&texInfo);
+    for (unsigned i = 0; i < texInfo.MipLevels && i < maxLevels; ++i)
+    {
+        int width = texInfo.Width >> i ? texInfo.Width >> i : 1;
+        int height = texInfo.Height >> i ? texInfo.Height >> i : 1;
+        levels[i] = { width, height,
+            MipmapGenerator::GetLevelBytes(texInfo.Format, width, height) };
+    }
+
+    return texInfo.MipLevels;
+}
+
+//*************************************************************************************************
+void TextureManager::ReleaseTexture(DGL_Texture* texture)
+{
+    if (!texture)
+        return;
+
+    // Release the texture and shader resource view
+    if (texture->texResourceView) 
+        texture->texResourceView->Release();
+    if (texture->texture) 
+        texture->texture->Release();
+
+    // Delete the DGL struct
+    delete texture;
+}
+
+//*************************************************************************************************
+DGL_Texture* TextureManager::CreateTexture(const D3D11_TEXTURE2D_DESC& texDesc,
+    const D3D11_SUBRESOURCE_DATA* subrecData, ID3D11Device* device)
+{
+    // Create the new texture object
+    DGL_Texture* newTexture = new DGL_Texture;
+
     // Create the texture using the subresource and texture structs
-    HRESULT hr = device->CreateTexture2D(&texDesc, &subrecData, &newTexture->texture);
+    HRESULT hr = device->CreateTexture2D(&texDesc, subrecData, &newTexture->texture);
     if (FAILED(hr))
     {
         // If it didn't work, set the error message and delete the texture
@@ -121,12 +443,12 @@ DGL_Texture* TextureManager::LoadTextureFromMemory(const unsigned char* data, in
         return nullptr;
     }
 
-    // Set up the shader resource view description
+    // Set up the shader resource view description, using every level of the texture
     D3D11_SHADER_RESOURCE_VIEW_DESC srDesc;
     ZeroMemory(&srDesc, sizeof(srDesc));
-    srDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    srDesc.Format = texDesc.Format;
     srDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srDesc.Texture2D.MipLevels = 1;
+    srDesc.Texture2D.MipLevels = (UINT)-1;
     srDesc.Texture2D.MostDetailedMip = 0;
 
     // Create the shader resource view using the texture and shader resource struct
@@ -141,27 +463,94 @@ DGL_Texture* TextureManager::LoadTextureFromMemory(const unsigned char* data, in
     }
 
     // Save the size of the texture
-    newTexture->textureSize.x = (float)width;
-    newTexture->textureSize.y = (float)height;
+    newTexture->textureSize.x = (float)texDesc.Width;
+    newTexture->textureSize.y = (float)texDesc.Height;
 
     // Return the new texture object
     return newTexture;
 }
 
 //*************************************************************************************************
-void TextureManager::ReleaseTexture(DGL_Texture* texture)
+HRESULT TextureManager::DecodeFile(const char* pFileName, MipLevel& level)
 {
-    if (!texture)
-        return;
+    // WIC can't decode TGA files
+    if (TGAFile::IsTGAFile(pFileName))
+        return TGAFile::Read(pFileName, level) ? S_OK : E_INVALIDARG;
 
-    // Release the texture and shader resource view
-    if (texture->texResourceView) 
-        texture->texResourceView->Release();
-    if (texture->texture) 
-        texture->texture->Release();
+    // Translate the file name to wide char
+    std::wstring wideFileName;
+    size_t fileNameSize = strlen(pFileName);
+    for (unsigned i = 0; i < fileNameSize; ++i)
+        wideFileName += (wchar_t)pFileName[i];
 
-    // Delete the DGL struct
-    delete texture;
+    IWICImagingFactory* factory = nullptr;
+    IWICBitmapDecoder* decoder = nullptr;
+    IWICBitmapFrameDecode* frame = nullptr;
+    IWICFormatConverter* converter = nullptr;
+    UINT width = 0;
+    UINT height = 0;
+
+    // Read the first frame of the file and convert it to the same format as textures from memory
+    HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+        IID_PPV_ARGS(&factory));
+    if (SUCCEEDED(hr))
+    {
+        hr = factory->CreateDecoderFromFilename(wideFileName.c_str(), nullptr, GENERIC_READ,
+            WICDecodeMetadataCacheOnDemand, &decoder);
+    }
+    if (SUCCEEDED(hr))
+        hr = decoder->GetFrame(0, &frame);
+    if (SUCCEEDED(hr))
+        hr = frame->GetSize(&width, &height);
+    if (SUCCEEDED(hr) && (width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+        height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION))
+        hr = E_INVALIDARG;
+    if (SUCCEEDED(hr))
+        hr = factory->CreateFormatConverter(&converter);
+    if (SUCCEEDED(hr))
+    {
+        hr = converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone,
+            nullptr, 0.0, WICBitmapPaletteTypeMedianCut);
+    }
+    if (SUCCEEDED(hr))
+    {
+        level.mWidth = (int)width;
+        level.mHeight = (int)height;
+        level.mPixels.resize((size_t)width * height * 4);
+        hr = converter->CopyPixels(nullptr, width * 4, (UINT)level.mPixels.size(),
+            level.mPixels.data());
+    }
+
+    if (converter)
+        converter->Release();
+    if (frame)
+        frame->Release();
+    if (decoder)
+        decoder->Release();
+    if (factory)
+        factory->Release();
+
+    return hr;
+}
+
+//*************************************************************************************************
+unsigned TextureManager::PrepareLevels(std::vector<MipLevel>& levels, DGL_MipmapMode mipmapMode,
+    DXGI_FORMAT& format, unsigned maxThreads)
+{
+    if (mipmapMode == DGL_MM_BOX || mipmapMode == DGL_MM_KAISER)
+        MipmapGenerator::BuildLevels(levels, mipmapMode);
+
+    if (format == DXGI_FORMAT_R8G8B8A8_UNORM)
+        return 0;
+
+    // Textures which aren't whole blocks stay uncompressed
+    if (!BlockCompressor::CanCompress(levels[0].mWidth, levels[0].mHeight))
+    {
+        format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        return 0;
+    }
+
+    return BlockCompressor::Compress(levels, format, maxThreads);
 }
 
 } // namespace DGL
@@ -10,9 +10,14 @@ module;
 
 #include <d3d11.h>
 #include "DGL.h"
+#include <string>
+#include <vector>
 
 export module Texture;
 
+import Mipmap;
+import UploadQueue;
+
 export typedef struct DGL_Texture
 {
     // The D3D 2D texture object
@@ -21,27 +26,102 @@ export typedef struct DGL_Texture
     ID3D11ShaderResourceView* texResourceView{ nullptr };
     // Width and height of the texture
     DGL_Vec2 textureSize{ 0 };
+    // For a texture in an atlas, the atlas page holding its pixels. Textures in an atlas don't
+    // have their own D3D objects.
+    DGL_Texture* page{ nullptr };
+    // The part of the page used by this texture, as an offset and scale for texture coordinates
+    DGL_Vec2 uvOffset{ 0.0f, 0.0f };
+    DGL_Vec2 uvScale{ 1.0f, 1.0f };
+    // Whether the texture can be drawn yet. Textures loaded in the background don't have their
+    // D3D objects until they are ready.
+    DGL_TextureStatus status{ DGL_TS_READY };
 } DGL_Texture;
 
 namespace DGL
 {
 
+// How new textures are read and stored
+export struct TextureLoadSettings
+{
+    DGL_MipmapMode mMipmapMode{ DGL_MM_NONE };
+    // The folder where levels built on the CPU are saved, or empty to not save them
+    std::string mCacheDirectory;
+    DGL_TextureCompression mCompression{ DGL_TC_NONE };
+    // The most threads used to compress each level, or 0 for one for each core
+    unsigned mCompressThreads{ 0 };
+};
+
 //---------------------------------------------------------------------------------- TextureManager
 
 export class TextureManager
 {
 public:
 
-    // Creates a new texture from the provided file name
-    static DGL_Texture* LoadTexture(const char* pFileName, ID3D11Device* device);
+    // Creates a new texture from the provided file name, with smaller levels and compression
+    // made using the settings. DDS files keep the format saved in them.
+    static DGL_Texture* LoadTexture(const char* pFileName, ID3D11Device* device,
+        UploadQueue* uploads, const TextureLoadSettings& settings);
 
-    // Creates a new texture from the provided pixel data
+    // Creates a new texture from the provided pixel data. While the upload queue is batching,
+    // the pixels are copied into the texture when the queue is flushed. Levels built on the CPU
+    // and compressed textures are always copied right away.
     static DGL_Texture* LoadTextureFromMemory(const unsigned char* data, int width, int height, 
+        ID3D11Device* device, UploadQueue* uploads, DGL_MipmapMode mipmapMode,
+        DGL_TextureCompression compression);
+
+    // Creates a new texture from levels read by ReadLevels
+    static DGL_Texture* LoadTextureFromLevels(const std::vector<MipLevel>& levels,
+        DXGI_FORMAT format, DGL_MipmapMode mipmapMode, ID3D11Device* device,
+        UploadQueue* uploads);
+
+    // Reads the file into the first level as RGBA pixels. When the settings build levels on the
+    // CPU or compress them, that is done too, or they are read from the cache folder if they
+    // were saved. DDS files are read as they are. This doesn't use the graphics device or the
+    // error handler, so it can be called from any thread.
+    static HRESULT ReadLevels(const char* pFileName, const TextureLoadSettings& settings,
+        std::vector<MipLevel>& levels, DXGI_FORMAT& format);
+
+    // Reads the source file, builds its levels, compresses them, and writes them to the DDS
+    // file. This doesn't use the graphics device, so Graphics doesn't need to be initialized.
+    static bool ConvertToDDS(const char* pSourceFile, const char* pDDSFile,
+        DGL_TextureCompression compression, DGL_MipmapMode mipmapMode,
+        DGL_CompressionStats* stats);
+
+    // Creates a new RGBA texture with the provided pixel data, or with no data if it is null
+    static DGL_Texture* CreateTexture(const unsigned char* data, int width, int height,
         ID3D11Device* device);
 
+    // Creates a new texture with each of the levels in the format, from largest to smallest
+    static DGL_Texture* CreateTexture(const std::vector<MipLevel>& levels, DXGI_FORMAT format,
+        ID3D11Device* device);
+
+    // Creates a new empty RGBA texture with a full chain of levels, which the device can fill in
+    // from the first level with GenerateMips
+    static DGL_Texture* CreateMipmappedTexture(int width, int height, ID3D11Device* device);
+
+    // Fills in the size and memory of each level of the texture, up to maxLevels, and returns
+    // the number of levels it has
+    static unsigned GetLevels(const DGL_Texture* texture, DGL_TextureLevel* levels,
+        unsigned maxLevels);
+
     // Releases the D3D objects and deletes the texture
     static void ReleaseTexture(DGL_Texture* texture);
 
+private:
+    // Creates the texture and its shader resource view from the description
+    static DGL_Texture* CreateTexture(const D3D11_TEXTURE2D_DESC& texDesc,
+        const D3D11_SUBRESOURCE_DATA* subrecData, ID3D11Device* device);
+
+    // Reads the first frame of the file and converts it to RGBA pixels. TGA files are decoded by
+    // TGAFile, and other files by WIC.
+    static HRESULT DecodeFile(const char* pFileName, MipLevel& level);
+
+    // Builds the smaller levels after the first level if the mode builds them on the CPU, then
+    // compresses the levels to the format. Levels which can't be compressed are left as RGBA,
+    // and the format is changed to match. Returns the most threads used to compress a level.
+    static unsigned PrepareLevels(std::vector<MipLevel>& levels, DGL_MipmapMode mipmapMode,
+        DXGI_FORMAT& format, unsigned maxThreads);
+
 };
 
 } // namespace DGL
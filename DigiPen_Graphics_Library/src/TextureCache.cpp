@@ -0,0 +1,203 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TextureCache.cpp
+// author:  Andy Ellinger
+// brief:   Sharing textures loaded from the same file
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <cctype>
+#include <filesystem>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+module TextureCache;
+
+import Texture;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------ TextureCache
+
+//*************************************************************************************************
+void TextureCache::SetEnabled(bool enabled, std::vector<DGL_Texture*>& released)
+{
+    mEnabled = enabled;
+
+    // Nothing can find the textures with no references any more
+    if (!mEnabled)
+        Clear(released);
+}
+
+//*************************************************************************************************
+void TextureCache::SetRetainedBytes(unsigned long long bytes, std::vector<DGL_Texture*>& released)
+{
+    mRetainedBudget = bytes;
+    Trim(mRetainedBudget, released);
+}
+
+//*************************************************************************************************
+DGL_Texture* TextureCache::Find(const char* fileName, const TextureLoadSettings& settings)
+{
+    if (!mEnabled)
+        return nullptr;
+
+    auto found = mTextures.find(MakeKey(fileName, settings));
+    if (found == mTextures.end())
+    {
+        ++mMisses;
+        return nullptr;
+    }
+
+    ++mHits;
+    DGL_Texture* texture = found->second;
+    Entry& entry = mEntries[texture];
+
+    // A texture with no references is in use again
+    if (entry.mReferences == 0)
+    {
+        mRetained.erase(entry.mRetained);
+        mRetainedBytes -= entry.mBytes;
+    }
+
+    ++entry.mReferences;
+    return texture;
+}
+
+//*************************************************************************************************
+void TextureCache::Add(const char* fileName, const TextureLoadSettings& settings,
+    DGL_Texture* texture, unsigned long long bytes)
+{
+    if (!mEnabled)
+        return;
+
+    Entry& entry = mEntries[texture];
+    entry.mKey = MakeKey(fileName, settings);
+    entry.mReferences = 1;
+    entry.mBytes = bytes;
+    mTextures[entry.mKey] = texture;
+    mResidentBytes += entry.mBytes;
+}
+
+//*************************************************************************************************
+bool TextureCache::Contains(const DGL_Texture* texture) const
+{
+    return mEntries.find(texture) != mEntries.end();
+}
+
+//*************************************************************************************************
+unsigned TextureCache::Release(DGL_Texture* texture, std::vector<DGL_Texture*>& released)
+{
+    Entry& entry = mEntries[texture];
+    if (--entry.mReferences > 0)
+        return entry.mReferences;
+
+    // A texture too big for the budget is released right away, without releasing the smaller
+    // textures kept before it
+    unsigned long long budget = mEnabled ? mRetainedBudget : 0;
+    if (entry.mBytes > budget)
+    {
+        Evict(texture, released);
+        return 0;
+    }
+
+    // Keep the texture in case it is loaded again, then make the rest fit
+    mRetained.push_front(texture);
+    entry.mRetained = mRetained.begin();
+    mRetainedBytes += entry.mBytes;
+    Trim(budget, released);
+
+    return 0;
+}
+
+//*************************************************************************************************
+void TextureCache::Clear(std::vector<DGL_Texture*>& released)
+{
+    Trim(0, released);
+}
+
+//*************************************************************************************************
+void TextureCache::Reset(std::vector<DGL_Texture*>& released)
+{
+    Clear(released);
+
+    mEntries.clear();
+    mTextures.clear();
+    mResidentBytes = 0;
+    mHits = 0;
+    mMisses = 0;
+    mEvictions = 0;
+}
+
+//*************************************************************************************************
+void TextureCache::GetStats(DGL_TextureCacheStats* stats) const
+{
+    stats->mHits = mHits;
+    stats->mMisses = mMisses;
+    stats->mEvictions = mEvictions;
+    stats->mTextures = (unsigned)(mEntries.size() - mRetained.size());
+    stats->mRetainedTextures = (unsigned)mRetained.size();
+    stats->mResidentBytes = mResidentBytes;
+    stats->mRetainedBytes = mRetainedBytes;
+}
+
+//*************************************************************************************************
+unsigned long long TextureCache::GetTextureBytes(const DGL_Texture* texture)
+{
+    std::vector<DGL_TextureLevel> levels(TextureManager::GetLevels(texture, nullptr, 0));
+    TextureManager::GetLevels(texture, levels.data(), (unsigned)levels.size());
+
+    unsigned long long bytes = 0;
+    for (const DGL_TextureLevel& level : levels)
+        bytes += level.mBytes;
+    return bytes;
+}
+
+//*************************************************************************************************
+std::string TextureCache::MakeKey(const char* fileName, const TextureLoadSettings& settings)
+{
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::absolute(fileName, error);
+    std::string key = error ? std::string(fileName) :
+        path.lexically_normal().make_preferred().string();
+    for (char& c : key)
+        c = (char)std::tolower((unsigned char)c);
+
+    // The same file loaded with different settings makes a different texture. The cache
+    // directory only changes where levels are saved, so it isn't part of the key.
+    key += '|' + std::to_string(settings.mMipmapMode) + '|' +
+        std::to_string(settings.mCompression);
+    return key;
+}
+
+//*************************************************************************************************
+void TextureCache::Trim(unsigned long long budget, std::vector<DGL_Texture*>& released)
+{
+    while (mRetainedBytes > budget || (budget == 0 && !mRetained.empty()))
+    {
+        DGL_Texture* texture = mRetained.back();
+        mRetained.pop_back();
+        mRetainedBytes -= mEntries[texture].mBytes;
+        Evict(texture, released);
+    }
+}
+
+//*************************************************************************************************
+void TextureCache::Evict(DGL_Texture* texture, std::vector<DGL_Texture*>& released)
+{
+    auto found = mEntries.find(texture);
+    mResidentBytes -= found->second.mBytes;
+    mTextures.erase(found->second.mKey);
+    mEntries.erase(found);
+
+    released.push_back(texture);
+    ++mEvictions;
+}
+
+} // namespace DGL
@@ -0,0 +1,115 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TextureCache.ixx
+// author:  Andy Ellinger
+// brief:   Header for sharing textures loaded from the same file
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+export module TextureCache;
+
+import Texture;
+
+namespace DGL
+{
+
+//------------------------------------------------------------------------------------ TextureCache
+
+// Keeps the textures loaded from files so loading the same file again with the same settings
+// returns the same texture instead of decoding it again. Each load adds a reference, and the
+// texture is only released when every reference has been freed. Textures with no references can
+// be kept for a while, up to a number of bytes, in case they are loaded again. The cache never
+// releases textures itself: textures it is done with are added to a list for the caller, which
+// can make sure they aren't being drawn first.
+export class TextureCache
+{
+public:
+    // Turns caching on or off. Textures already in the cache stay there until they are freed.
+    // Textures with no references are added to the list when caching is turned off.
+    void SetEnabled(bool enabled, std::vector<DGL_Texture*>& released);
+
+    // Sets how many bytes of textures with no references are kept. The oldest are added to the
+    // list until the rest fit.
+    void SetRetainedBytes(unsigned long long bytes, std::vector<DGL_Texture*>& released);
+
+    // Returns the texture loaded from the file with the settings and adds a reference to it, or
+    // null if it isn't in the cache. This counts a hit or a miss while caching is on.
+    DGL_Texture* Find(const char* fileName, const TextureLoadSettings& settings);
+
+    // Adds a texture just loaded from the file with the settings, with one reference, using the
+    // provided number of bytes of graphics card memory. Nothing is added while caching is off.
+    void Add(const char* fileName, const TextureLoadSettings& settings, DGL_Texture* texture,
+        unsigned long long bytes);
+
+    // Returns true if the texture is in the cache
+    bool Contains(const DGL_Texture* texture) const;
+
+    // Removes a reference from a texture in the cache and returns the number left. When none
+    // are left the texture is kept and any older textures that no longer fit are added to the
+    // list, or it is added to the list by itself if it is larger than the budget.
+    unsigned Release(DGL_Texture* texture, std::vector<DGL_Texture*>& released);
+
+    // Adds every texture with no references to the list
+    void Clear(std::vector<DGL_Texture*>& released);
+
+    // Adds every texture with no references to the list, and forgets the rest
+    void Reset(std::vector<DGL_Texture*>& released);
+
+    // Fills in the cache counters
+    void GetStats(DGL_TextureCacheStats* stats) const;
+
+    // Returns the graphics card memory used by all of the levels of the texture
+    static unsigned long long GetTextureBytes(const DGL_Texture* texture);
+
+    // Returns the key for the file and the settings. The path is made absolute and lowercase,
+    // since Windows file names aren't case sensitive, so different names for the same file match.
+    static std::string MakeKey(const char* fileName, const TextureLoadSettings& settings);
+
+private:
+    struct Entry
+    {
+        std::string mKey;
+        // The number of loads which haven't been freed
+        unsigned mReferences{ 0 };
+        // The graphics card memory used by all of the levels
+        unsigned long long mBytes{ 0 };
+        // Where the texture is in the retained list, if it has no references
+        std::list<DGL_Texture*>::iterator mRetained;
+    };
+
+    // Adds the oldest textures with no references to the list until the rest fit in the budget
+    void Trim(unsigned long long budget, std::vector<DGL_Texture*>& released);
+
+    // Removes the texture from the cache and adds it to the list. It must not be in the
+    // retained list.
+    void Evict(DGL_Texture* texture, std::vector<DGL_Texture*>& released);
+
+    // The textures in the cache
+    std::unordered_map<const DGL_Texture*, Entry> mEntries;
+    // The texture for each key
+    std::unordered_map<std::string, DGL_Texture*> mTextures;
+    // The textures with no references, from most to least recently freed
+    std::list<DGL_Texture*> mRetained;
+    // The graphics card memory used by all of the textures in the cache, and by the ones with
+    // no references
+    unsigned long long mResidentBytes{ 0 };
+    unsigned long long mRetainedBytes{ 0 };
+    // The most bytes of textures with no references to keep
+    unsigned long long mRetainedBudget{ 0 };
+    // The counters since Graphics was initialized
+    unsigned mHits{ 0 };
+    unsigned mMisses{ 0 };
+    unsigned mEvictions{ 0 };
+    // Tracks whether new loads are added to the cache
+    bool mEnabled{ false };
+};
+
+} // namespace DGL
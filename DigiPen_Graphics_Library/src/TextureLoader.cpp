@@ -0,0 +1,243 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TextureLoader.cpp
+// author:  Andy Ellinger
+// brief:   Loading textures from files on background threads
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <condition_variable>
+#include <d3d11.h>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+module TextureLoader;
+
+import Errors;
+import Mipmap;
+import Texture;
+import UploadQueue;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- TextureLoader
+
+//*************************************************************************************************
+DGL_Texture* TextureLoader::Load(const char* fileName, int priority,
+    const TextureLoadSettings& settings, DGL_TextureLoadCallback callback, void* userData)
+{
+    StartWorkers();
+
+    DGL_Texture* texture = new DGL_Texture;
+    texture->status = DGL_TS_LOADING;
+
+    // The workers already load several files at once, so each one compresses on its own thread
+    TextureLoadSettings jobSettings = settings;
+    jobSettings.mCompressThreads = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push({ texture, fileName, priority, mSequence++, jobSettings, callback, userData });
+    }
+    mWake.notify_one();
+
+    return texture;
+}
+
+//*************************************************************************************************
+void TextureLoader::FinishLoads(ID3D11Device* device, UploadQueue* uploads)
+{
+    // Take the finished results so the workers can keep adding to the list
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mResults.empty())
+            return;
+
+        results.swap(mResults);
+    }
+
+    for (Result& result : results)
+    {
+        DGL_Texture* texture = result.mJob.mTexture;
+
+        // Cancelled textures were freed by the user, so they are only deleted
+        bool cancelled;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            cancelled = mCancelled.erase(texture) != 0;
+        }
+        if (cancelled)
+        {
+            delete texture;
+            continue;
+        }
+
+        if (SUCCEEDED(result.mResult))
+        {
+            LARGE_INTEGER start, end;
+            QueryPerformanceCounter(&start);
+
+            // Move the new D3D objects into the texture the user already has
+            DGL_Texture* loaded = TextureManager::LoadTextureFromLevels(result.mLevels,
+                result.mFormat, result.mJob.mSettings.mMipmapMode, device, uploads);
+            if (loaded)
+            {
+                texture->texture = loaded->texture;
+                texture->texResourceView = loaded->texResourceView;
+                texture->textureSize = loaded->textureSize;
+                texture->status = DGL_TS_READY;
+                delete loaded;
+            }
+
+            QueryPerformanceCounter(&end);
+            mCreateTicks += end.QuadPart - start.QuadPart;
+        }
+        else
+        {
+            std::stringstream stream;
+            stream << "Failed to load texture from file \"" << result.mJob.mFileName << "\". ";
+            gError->SetError(stream.str(), result.mResult);
+        }
+
+        if (texture->status == DGL_TS_READY)
+            ++mLoaded;
+        else
+        {
+            texture->status = DGL_TS_FAILED;
+            ++mFailed;
+        }
+
+        if (result.mJob.mCallback)
+            result.mJob.mCallback(texture, texture->status, result.mJob.mUserData);
+    }
+}
+
+//*************************************************************************************************
+void TextureLoader::Cancel(DGL_Texture* texture)
+{
+    // The job is still in the queue, being decoded, or in the results, and it will be deleted
+    // when it reaches FinishLoads
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCancelled.insert(texture);
+}
+
+//*************************************************************************************************
+void TextureLoader::GetStats(DGL_TextureLoadStats* stats) const
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    stats->mWorkers = (unsigned)mWorkers.size();
+    stats->mPending = (unsigned)(mQueue.size() + mActiveJobs + mResults.size() - mCancelled.size());
+    stats->mLoaded = mLoaded;
+    stats->mFailed = mFailed;
+    stats->mDecodeSeconds = (double)mDecodeTicks / frequency.QuadPart;
+    stats->mCreateSeconds = (double)mCreateTicks / frequency.QuadPart;
+}
+
+//*************************************************************************************************
+void TextureLoader::Release()
+{
+    // Let the workers finish the files they are decoding, then stop them
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+
+    for (std::thread& worker : mWorkers)
+        worker.join();
+    mWorkers.clear();
+
+    // The graphics device is going away, so nothing else can finish
+    std::vector<DGL_Texture*> remaining;
+    for (; !mQueue.empty(); mQueue.pop())
+        remaining.push_back(mQueue.top().mTexture);
+    for (Result& result : mResults)
+        remaining.push_back(result.mJob.mTexture);
+
+    for (DGL_Texture* texture : remaining)
+    {
+        if (mCancelled.count(texture))
+            delete texture;
+        else
+            texture->status = DGL_TS_FAILED;
+    }
+
+    mResults.clear();
+    mCancelled.clear();
+    mStopping = false;
+}
+
+//*************************************************************************************************
+void TextureLoader::WorkerLoop()
+{
+    // Each thread that uses WIC needs the COM library
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        mWake.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+        if (mStopping)
+            break;
+
+        Result result;
+        result.mJob = mQueue.top();
+        mQueue.pop();
+
+        // Cancelled files aren't decoded, but still go to FinishLoads to be deleted
+        bool cancelled = mCancelled.count(result.mJob.mTexture) != 0;
+        ++mActiveJobs;
+        lock.unlock();
+
+        LARGE_INTEGER start, end;
+        QueryPerformanceCounter(&start);
+        if (!cancelled)
+        {
+            result.mResult = TextureManager::ReadLevels(result.mJob.mFileName.c_str(),
+                result.mJob.mSettings, result.mLevels, result.mFormat);
+        }
+        QueryPerformanceCounter(&end);
+
+        lock.lock();
+        --mActiveJobs;
+        mDecodeTicks += end.QuadPart - start.QuadPart;
+        mResults.push_back(std::move(result));
+    }
+
+    lock.unlock();
+    CoUninitialize();
+}
+
+//*************************************************************************************************
+void TextureLoader::StartWorkers()
+{
+    if (!mWorkers.empty())
+        return;
+
+    // Leave a core for the main thread
+    unsigned count = std::thread::hardware_concurrency();
+    if (count > 1)
+        --count;
+    if (count < 1)
+        count = 1;
+    if (count > max_workers)
+        count = max_workers;
+
+    for (unsigned i = 0; i < count; ++i)
+        mWorkers.emplace_back(&TextureLoader::WorkerLoop, this);
+}
+
+} // namespace DGL
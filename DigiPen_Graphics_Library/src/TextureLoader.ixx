@@ -0,0 +1,131 @@
+//-------------------------------------------------------------------------------------------------
+// file:    TextureLoader.ixx
+// author:  Andy Ellinger
+// brief:   Header for loading textures from files on background threads
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <condition_variable>
+#include <d3d11.h>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+export module TextureLoader;
+
+import Mipmap;
+import Texture;
+import UploadQueue;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- TextureLoader
+
+// Reads and decodes texture files on a pool of worker threads. The D3D texture is created later
+// on the main thread by FinishLoads, so the workers never use the graphics device or the error
+// handler. The DGL_Texture for each load is returned right away and filled in when it finishes.
+export class TextureLoader
+{
+public:
+    // Returns a new texture whose file will be decoded by the workers, which also build any
+    // smaller levels made on the CPU and compress them. Loads with a higher priority are started
+    // first, and loads with the same priority in the order they were added.
+    DGL_Texture* Load(const char* fileName, int priority, const TextureLoadSettings& settings,
+        DGL_TextureLoadCallback callback, void* userData);
+
+    // Creates the D3D textures for the files which have been decoded, and calls their callbacks.
+    // Only call this from the thread that owns the graphics device.
+    void FinishLoads(ID3D11Device* device, UploadQueue* uploads);
+
+    // Stops the load of the texture if it hasn't finished. The texture will be deleted by
+    // FinishLoads once no worker is using it.
+    void Cancel(DGL_Texture* texture);
+
+    // Fills in the load counters
+    void GetStats(DGL_TextureLoadStats* stats) const;
+
+    // Waits for the workers to stop, then marks any textures still loading as failed
+    void Release();
+
+    // The most worker threads to start. Decoding is mostly limited by the disk and memory, so
+    // more threads than this don't help.
+    static constexpr unsigned max_workers{ 4 };
+
+private:
+    // A file waiting to be decoded
+    struct Job
+    {
+        DGL_Texture* mTexture{ nullptr };
+        std::string mFileName;
+        int mPriority{ 0 };
+        // The order the job was added, to keep jobs with the same priority in order
+        unsigned long long mSequence{ 0 };
+        // How the smaller levels are made and compressed, saved when the load was started
+        TextureLoadSettings mSettings;
+        DGL_TextureLoadCallback mCallback{ nullptr };
+        void* mUserData{ nullptr };
+    };
+
+    // Puts the job with the highest priority first, then the job that was added first
+    struct JobOrder
+    {
+        bool operator()(const Job& left, const Job& right) const
+        {
+            if (left.mPriority != right.mPriority)
+                return left.mPriority < right.mPriority;
+            return left.mSequence > right.mSequence;
+        }
+    };
+
+    // A decoded file waiting for its D3D texture
+    struct Result
+    {
+        Job mJob;
+        std::vector<MipLevel> mLevels;
+        DXGI_FORMAT mFormat{ DXGI_FORMAT_R8G8B8A8_UNORM };
+        // The result from decoding the file
+        HRESULT mResult{ S_OK };
+    };
+
+    // Takes jobs from the queue and decodes them until the loader stops
+    void WorkerLoop();
+
+    // Starts the worker threads if they haven't been started
+    void StartWorkers();
+
+    // Protects everything below that the workers use
+    mutable std::mutex mMutex;
+    // Wakes the workers when a job is added or the loader stops
+    std::condition_variable mWake;
+    // The jobs waiting for a worker. Cancelled jobs stay in the queue and are skipped.
+    std::priority_queue<Job, std::vector<Job>, JobOrder> mQueue;
+    // The decoded files waiting for FinishLoads
+    std::vector<Result> mResults;
+    // The textures whose loads were cancelled and haven't been deleted yet
+    std::unordered_set<DGL_Texture*> mCancelled;
+    // The number of jobs being decoded right now
+    unsigned mActiveJobs{ 0 };
+    // Tracks whether the workers should stop
+    bool mStopping{ false };
+    // The number of jobs added, used to order jobs with the same priority
+    unsigned long long mSequence{ 0 };
+    // The performance counter ticks the workers have spent decoding
+    long long mDecodeTicks{ 0 };
+
+    // The worker threads, only used by the main thread
+    std::vector<std::thread> mWorkers;
+    // The counters for FinishLoads, only used by the main thread
+    unsigned mLoaded{ 0 };
+    unsigned mFailed{ 0 };
+    long long mCreateTicks{ 0 };
+};
+
+} // namespace DGL
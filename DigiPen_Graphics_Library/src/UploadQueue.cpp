@@ -0,0 +1,250 @@
+//-------------------------------------------------------------------------------------------------
+// file:    UploadQueue.cpp
+// author:  Andy Ellinger
+// brief:   Collecting resource uploads and sending them to the graphics card together
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <string.h>
+#include <vector>
+
+module UploadQueue;
+
+namespace DGL
+{
+
+//-------------------------------------------------------------------------------- D3DUploadContext
+
+//*************************************************************************************************
+void D3DUploadContext::Initialize(ID3D11DeviceContext* deviceContext)
+{
+    mDeviceContext = deviceContext;
+}
+
+//*************************************************************************************************
+void D3DUploadContext::UpdateSubresource(ID3D11Resource* resource, const D3D11_BOX* box,
+    const void* data, UINT rowPitch)
+{
+    mDeviceContext->UpdateSubresource(resource, 0, box, data, rowPitch, 0);
+}
+
+//*************************************************************************************************
+void D3DUploadContext::GenerateMips(ID3D11ShaderResourceView* view)
+{
+    mDeviceContext->GenerateMips(view);
+}
+
+//*************************************************************************************************
+void D3DUploadContext::AddRef(IUnknown* object)
+{
+    object->AddRef();
+}
+
+//*************************************************************************************************
+void D3DUploadContext::Release(IUnknown* object)
+{
+    object->Release();
+}
+
+//------------------------------------------------------------------------------------- UploadQueue
+
+//*************************************************************************************************
+void UploadQueue::Initialize(UploadContext* context)
+{
+    mContext = context;
+}
+
+//*************************************************************************************************
+void UploadQueue::Release()
+{
+    for (Upload& upload : mUploads)
+    {
+        if (upload.mResource)
+            mContext->Release(upload.mResource);
+        if (upload.mMipView)
+            mContext->Release(upload.mMipView);
+    }
+
+    mUploads.clear();
+    std::vector<char>().swap(mStaging);
+    mPendingUploads = 0;
+    mContext = nullptr;
+}
+
+//*************************************************************************************************
+void UploadQueue::SetBatching(bool enabled)
+{
+    if (!enabled)
+        Flush();
+
+    mBatching = enabled;
+}
+
+//*************************************************************************************************
+bool UploadQueue::IsBatching() const
+{
+    return mBatching;
+}
+
+//*************************************************************************************************
+void UploadQueue::UploadBuffer(ID3D11Buffer* buffer, unsigned offset, const void* data,
+    unsigned size)
+{
+    if (!mBatching)
+    {
+        D3D11_BOX box = { offset, 0, 0, offset + size, 1, 1 };
+        mContext->UpdateSubresource(buffer, &box, data, 0);
+        mTotalBytes += size;
+        return;
+    }
+
+    size_t stagingOffset = Stage(data, size);
+    ++mPendingUploads;
+
+    // Meshes created one after another usually get blocks right next to each other, and their
+    // data is next to each other in the staging list too, so they can be copied together
+    if (!mUploads.empty())
+    {
+        Upload& last = mUploads.back();
+        if (last.mResource == buffer && last.mRowPitch == 0 && last.mOffset + last.mSize == offset)
+        {
+            last.mSize += size;
+            return;
+        }
+    }
+
+    mContext->AddRef(buffer);
+    mUploads.push_back({ buffer, stagingOffset, offset, size, 0 });
+}
+
+//*************************************************************************************************
+void UploadQueue::UploadTexture(ID3D11Texture2D* texture, const void* data, unsigned rowPitch,
+    unsigned rowCount)
+{
+    if (!mBatching)
+    {
+        mContext->UpdateSubresource(texture, nullptr, data, rowPitch);
+        mTotalBytes += (unsigned long long)rowPitch * rowCount;
+        return;
+    }
+
+    unsigned size = rowPitch * rowCount;
+    size_t stagingOffset = Stage(data, size);
+    ++mPendingUploads;
+
+    mContext->AddRef(texture);
+    mUploads.push_back({ texture, stagingOffset, 0, size, rowPitch });
+}
+
+//*************************************************************************************************
+void UploadQueue::UploadTextureRegion(ID3D11Texture2D* texture, unsigned left, unsigned top,
+    unsigned width, unsigned height, const void* data, unsigned rowPitch)
+{
+    D3D11_BOX box = { left, top, 0, left + width, top + height, 1 };
+
+    if (!mBatching)
+    {
+        mContext->UpdateSubresource(texture, &box, data, rowPitch);
+        mTotalBytes += (unsigned long long)rowPitch * height;
+        return;
+    }
+
+    unsigned size = rowPitch * height;
+    size_t stagingOffset = Stage(data, size);
+    ++mPendingUploads;
+
+    mContext->AddRef(texture);
+    mUploads.push_back({ texture, stagingOffset, 0, size, rowPitch, box });
+}
+
+//*************************************************************************************************
+void UploadQueue::GenerateMips(ID3D11ShaderResourceView* view)
+{
+    if (!mBatching)
+    {
+        mContext->GenerateMips(view);
+        return;
+    }
+
+    // This goes in the list with the copies so it happens after the first level is filled in
+    ++mPendingUploads;
+    mContext->AddRef(view);
+    mUploads.push_back({ nullptr, 0, 0, 0, 0, { 0 }, view });
+}
+
+//*************************************************************************************************
+void UploadQueue::Flush()
+{
+    if (mUploads.empty())
+        return;
+
+    // Copy in the order the uploads were made, so a block that was freed and handed out again
+    // ends up with the newest data
+    unsigned long long bytes = 0;
+    for (Upload& upload : mUploads)
+    {
+        if (upload.mMipView)
+        {
+            mContext->GenerateMips(upload.mMipView);
+            mContext->Release(upload.mMipView);
+            continue;
+        }
+
+        const char* data = mStaging.data() + upload.mStagingOffset;
+        if (upload.mRowPitch)
+        {
+            const D3D11_BOX* box = upload.mBox.right ? &upload.mBox : nullptr;
+            mContext->UpdateSubresource(upload.mResource, box, data, upload.mRowPitch);
+        }
+        else
+        {
+            D3D11_BOX box = { upload.mOffset, 0, 0, upload.mOffset + upload.mSize, 1, 1 };
+            mContext->UpdateSubresource(upload.mResource, &box, data, 0);
+        }
+
+        bytes += upload.mSize;
+        mContext->Release(upload.mResource);
+    }
+
+    ++mFlushes;
+    mLastFlushUploads = mPendingUploads;
+    mLastFlushCopies = (unsigned)mUploads.size();
+    mLastFlushBytes = bytes;
+    mTotalBytes += bytes;
+
+    mUploads.clear();
+    mPendingUploads = 0;
+    if (mStaging.capacity() > max_kept_staging_bytes)
+        std::vector<char>().swap(mStaging);
+    else
+        mStaging.clear();
+}
+
+//*************************************************************************************************
+void UploadQueue::GetStats(DGL_UploadStats* stats) const
+{
+    stats->mPendingUploads = mPendingUploads;
+    stats->mPendingBytes = mStaging.size();
+    stats->mFlushes = mFlushes;
+    stats->mLastFlushUploads = mLastFlushUploads;
+    stats->mLastFlushCopies = mLastFlushCopies;
+    stats->mLastFlushBytes = mLastFlushBytes;
+    stats->mTotalBytes = mTotalBytes;
+}
+
+//*************************************************************************************************
+size_t UploadQueue::Stage(const void* data, unsigned size)
+{
+    size_t offset = mStaging.size();
+    mStaging.resize(offset + size);
+    memcpy(mStaging.data() + offset, data, size);
+
+    return offset;
+}
+
+} // namespace DGL
@@ -0,0 +1,149 @@
+//-------------------------------------------------------------------------------------------------
+// file:    UploadQueue.ixx
+// author:  Andy Ellinger
+// brief:   Header for collecting resource uploads and sending them to the graphics card together
+//
+// Copyright © 2024 DigiPen, All rights reserved.
+//-------------------------------------------------------------------------------------------------
+
+module;
+
+#include "DGL.h"
+#include <d3d11.h>
+#include <vector>
+
+export module UploadQueue;
+
+namespace DGL
+{
+
+//----------------------------------------------------------------------------------- UploadContext
+
+// The device context functions used to copy data to the graphics card. The upload queue only
+// talks to the device context through this, so it can be checked against a version that records
+// the calls. The queue also keeps its references to waiting resources through this, so the
+// recording version doesn't need real D3D objects.
+export class UploadContext
+{
+public:
+    virtual ~UploadContext() = default;
+
+    // Copies the data into the first level of the resource. The box can be null to fill the
+    // whole level, and the row pitch is only used for textures.
+    virtual void UpdateSubresource(ID3D11Resource* resource, const D3D11_BOX* box,
+        const void* data, UINT rowPitch) = 0;
+    virtual void GenerateMips(ID3D11ShaderResourceView* view) = 0;
+
+    virtual void AddRef(IUnknown* object) = 0;
+    virtual void Release(IUnknown* object) = 0;
+};
+
+//-------------------------------------------------------------------------------- D3DUploadContext
+
+// Passes the calls straight through to a D3D device context
+export class D3DUploadContext : public UploadContext
+{
+public:
+    // Sets the D3D device context to use
+    void Initialize(ID3D11DeviceContext* deviceContext);
+
+    void UpdateSubresource(ID3D11Resource* resource, const D3D11_BOX* box, const void* data,
+        UINT rowPitch) override;
+    void GenerateMips(ID3D11ShaderResourceView* view) override;
+
+    void AddRef(IUnknown* object) override;
+    void Release(IUnknown* object) override;
+
+private:
+    // The D3D device context object
+    ID3D11DeviceContext* mDeviceContext{ nullptr };
+};
+
+//------------------------------------------------------------------------------------- UploadQueue
+
+// Copies data into buffers and textures on the graphics card. While batching is on, the data is
+// saved in one large staging list instead, and everything is copied at the next flush. Uploads
+// into the same buffer which are right next to each other are combined into one copy.
+export class UploadQueue
+{
+public:
+    // Saves the context to copy with
+    void Initialize(UploadContext* context);
+
+    // Drops any uploads that haven't been copied yet
+    void Release();
+
+    // Turns batching on or off. Turning it off copies anything that is waiting.
+    void SetBatching(bool enabled);
+
+    // Returns true if uploads are being saved until the next flush
+    bool IsBatching() const;
+
+    // Copies the data into the buffer, starting at the offset in bytes
+    void UploadBuffer(ID3D11Buffer* buffer, unsigned offset, const void* data, unsigned size);
+
+    // Copies the rows of data into the first level of the texture
+    void UploadTexture(ID3D11Texture2D* texture, const void* data, unsigned rowPitch,
+        unsigned rowCount);
+
+    // Copies the rows of data into the area of the first level of the texture with its top left
+    // corner at the position
+    void UploadTextureRegion(ID3D11Texture2D* texture, unsigned left, unsigned top,
+        unsigned width, unsigned height, const void* data, unsigned rowPitch);
+
+    // Fills in the smaller levels of the texture from its first level, after any copies into it
+    // that are waiting. The texture must have been created for generating mipmaps.
+    void GenerateMips(ID3D11ShaderResourceView* view);
+
+    // Copies everything that is waiting
+    void Flush();
+
+    // Fills in the upload counters
+    void GetStats(DGL_UploadStats* stats) const;
+
+    // The largest staging list kept between flushes. A larger list is freed after it is copied,
+    // so loading one large level doesn't hold on to its memory.
+    static constexpr size_t max_kept_staging_bytes{ 16 * 1024 * 1024 };
+
+private:
+    // A copy waiting for the next flush
+    struct Upload
+    {
+        // The buffer or texture to copy into, which is kept alive until the copy is done
+        ID3D11Resource* mResource{ nullptr };
+        // The position in the staging list of the data
+        size_t mStagingOffset{ 0 };
+        // The position in bytes to copy to, for buffers
+        unsigned mOffset{ 0 };
+        // The number of bytes to copy
+        unsigned mSize{ 0 };
+        // The size in bytes of each row, for textures, or 0 for buffers
+        unsigned mRowPitch{ 0 };
+        // The area to copy to, for part of a texture, or all zero for the whole texture
+        D3D11_BOX mBox{ 0 };
+        // The texture to generate smaller levels for, instead of copying
+        ID3D11ShaderResourceView* mMipView{ nullptr };
+    };
+
+    // Adds the data to the staging list, returning its position in the list
+    size_t Stage(const void* data, unsigned size);
+
+    // Copies the data and keeps the resources
+    UploadContext* mContext{ nullptr };
+    // The data for all waiting uploads, one after another
+    std::vector<char> mStaging;
+    // The copies waiting for the next flush
+    std::vector<Upload> mUploads;
+    // Tracks whether uploads are saved until the next flush
+    bool mBatching{ false };
+    // The number of uploads waiting, before combining them
+    unsigned mPendingUploads{ 0 };
+    // The counters reported by GetStats
+    unsigned mFlushes{ 0 };
+    unsigned mLastFlushUploads{ 0 };
+    unsigned mLastFlushCopies{ 0 };
+    unsigned long long mLastFlushBytes{ 0 };
+    unsigned long long mTotalBytes{ 0 };
+};
+
+} // namespace DGL
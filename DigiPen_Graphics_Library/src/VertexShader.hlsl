@@ -9,16 +9,25 @@ struct vs_out {
     float4 color : COLOR0;
     float2 tex_coord : TEXCOORD0;
     float alpha : COLOR1;
+    // Custom pixel shaders can add this to their input to read the shader data
+    float shader_data : COLOR2;
 };
 
-cbuffer cbPerObject
+// Only changes when the camera or window changes
+cbuffer cbPerFrame : register(b0)
 {
     float4x4 worldViewProjection;
+};
+
+cbuffer cbPerObject : register(b1)
+{
     float4x4 transform;
     float4 tintColor;
     float2 texOffset;
     float alpha;
     float shaderData;
+    float2 texRectOffset;
+    float2 texRectScale;
 };
 
 vs_out vs_main(vs_in input) {
@@ -33,9 +42,11 @@ vs_out vs_main(vs_in input) {
     output.color.z = (input.color.z * input.color.w) + (tintColor.z * tintColor.w);
     output.color.w = (input.color.w * input.color.w) + (tintColor.w * tintColor.w);
 
-    output.tex_coord = input.tex_coord + texOffset;
+    // Textures in an atlas only use their part of the atlas page
+    output.tex_coord = texRectOffset + (input.tex_coord + texOffset) * texRectScale;
 
     output.alpha = alpha;
+    output.shader_data = shaderData;
 
     return output;
 }
@@ -0,0 +1,67 @@
+struct vs_in {
+    float2 position_local : POSITION;
+    float4 color : COLOR;
+    float2 tex_coord : TEX;
+};
+
+struct instance_in {
+    float4 transform_x : INSTANCE_TRANSFORM0;
+    float4 transform_y : INSTANCE_TRANSFORM1;
+    float4 tint_color : INSTANCE_TINT;
+    float2 tex_offset : INSTANCE_TEXOFFSET;
+    float shader_data : INSTANCE_DATA;
+};
+
+struct vs_out {
+    float4 position_clip : SV_POSITION; 
+    float4 color : COLOR0;
+    float2 tex_coord : TEXCOORD0;
+    float alpha : COLOR1;
+    // Custom pixel shaders can add this to their input to read the shader data
+    float shader_data : COLOR2;
+};
+
+// Only changes when the camera or window changes
+cbuffer cbPerFrame : register(b0)
+{
+    float4x4 worldViewProjection;
+};
+
+// Only the texture rect is used, everything else comes from the instance data
+cbuffer cbPerObject : register(b1)
+{
+    float4x4 transform;
+    float4 tintColor;
+    float2 texOffset;
+    float alpha;
+    float shaderData;
+    float2 texRectOffset;
+    float2 texRectScale;
+};
+
+vs_out vs_main(vs_in input, instance_in instance) {
+    vs_out output = (vs_out)0; // zero the memory first
+
+    // The transform rows hold the scale and rotation in xy, the position in z, 
+    // and the Z layer (first row) or alpha (second row) in w
+    float4 v = float4(
+        dot(instance.transform_x.xy, input.position_local) + instance.transform_x.z,
+        dot(instance.transform_y.xy, input.position_local) + instance.transform_y.z,
+        instance.transform_x.w,
+        1.0);
+    output.position_clip = mul(v, worldViewProjection);
+
+    float4 tint = instance.tint_color;
+    output.color.x = (input.color.x * input.color.w) + (tint.x * tint.w);
+    output.color.y = (input.color.y * input.color.w) + (tint.y * tint.w);
+    output.color.z = (input.color.z * input.color.w) + (tint.z * tint.w);
+    output.color.w = (input.color.w * input.color.w) + (tint.w * tint.w);
+
+    // Textures in an atlas only use their part of the atlas page
+    output.tex_coord = texRectOffset + (input.tex_coord + instance.tex_offset) * texRectScale;
+
+    output.alpha = instance.transform_y.w;
+    output.shader_data = instance.shader_data;
+
+    return output;
+}